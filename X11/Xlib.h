@@ -2629,6 +2629,19 @@ extern Status XGetGeometry(
     unsigned int*	/* depth_return */
 );
 
+extern Status XGetGeometries(
+    Display*		/* display */,
+    Drawable*		/* drawables */,
+    int			/* count */,
+    Window*		/* roots_return */,
+    int*		/* xs_return */,
+    int*		/* ys_return */,
+    unsigned int*	/* widths_return */,
+    unsigned int*	/* heights_return */,
+    unsigned int*	/* border_widths_return */,
+    unsigned int*	/* depths_return */
+);
+
 extern Status XGetIconName(
     Display*		/* display */,
     Window		/* w */,
@@ -2688,6 +2701,22 @@ extern int XGetWindowProperty(
     unsigned char**	/* prop_return */
 );
 
+extern Status XGetWindowProperties(
+    Display*		/* display */,
+    Window*		/* windows */,
+    Atom*		/* properties */,
+    int			/* count */,
+    long		/* long_offset */,
+    long		/* long_length */,
+    Bool		/* delete */,
+    Atom		/* req_type */,
+    Atom*		/* actual_types_return */,
+    int*		/* actual_formats_return */,
+    unsigned long*	/* nitems_return */,
+    unsigned long*	/* bytes_after_return */,
+    unsigned char**	/* props_return */
+);
+
 extern Status XGetWindowAttributes(
     Display*		/* display */,
     Window		/* w */,
@@ -3023,6 +3052,16 @@ extern Status XQueryTree(
     unsigned int*	/* nchildren_return */
 );
 
+extern Status XQueryTrees(
+    Display*		/* display */,
+    Window*		/* windows */,
+    int			/* count */,
+    Window*		/* roots_return */,
+    Window*		/* parents_return */,
+    Window**		/* children_return */,
+    unsigned int*	/* nchildren_return */
+);
+
 extern int XRaiseWindow(
     Display*		/* display */,
     Window		/* w */
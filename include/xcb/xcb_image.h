@@ -562,6 +562,136 @@ int xcb_image_shm_get (xcb_connection_t *      conn,
 		       uint32_t                plane_mask);
 
 
+/**
+ * @struct xcb_image_shm_pool_t
+ * An opaque pool of MIT Shm segments for images that are put or
+ * got repeatedly.
+ */
+typedef struct xcb_image_shm_pool_t xcb_image_shm_pool_t;
+
+/**
+ * Create a pool of shared memory segments.
+ * @param conn The connection to the X server.
+ * @return The new pool, or 0 if memory is exhausted.
+ *
+ * Segments are created on demand, attached to the server once, and
+ * kept for reuse when their images are released.  If the server lacks
+ * the MIT Shm extension or cannot attach our memory (for instance
+ * because it is remote), the pool hands out ordinary malloced images
+ * and transfers them with PutImage and GetImage instead.
+ *
+ * The pool must be destroyed with xcb_image_shm_pool_destroy().
+ * @ingroup xcb__image_t
+ */
+xcb_image_shm_pool_t *
+xcb_image_shm_pool_create (xcb_connection_t *conn);
+
+/**
+ * Destroy a pool of shared memory segments.
+ * @param pool The pool.
+ *
+ * This function detaches and frees every segment of @p pool.  Images
+ * obtained from the pool must be released first.
+ * @ingroup xcb__image_t
+ */
+void
+xcb_image_shm_pool_destroy (xcb_image_shm_pool_t *pool);
+
+/**
+ * Create a new image in connection-native format backed by the pool.
+ * @param pool The pool.
+ * @param width The width of the image, in pixels.
+ * @param height The height of the image, in pixels.
+ * @param format The format of the image.
+ * @param depth The depth of the image.
+ * @return The new image, or 0 on error.
+ *
+ * The image data lives in an idle segment of @p pool that is large
+ * enough, or in a new one.  The image must be released with
+ * xcb_image_shm_pool_release().
+ * @ingroup xcb__image_t
+ */
+xcb_image_t *
+xcb_image_shm_pool_image (xcb_image_shm_pool_t *  pool,
+			  uint16_t                width,
+			  uint16_t                height,
+			  xcb_image_format_t      format,
+			  uint8_t                 depth);
+
+/**
+ * Release an image obtained from a pool.
+ * @param pool The pool.
+ * @param image The image.
+ *
+ * This function destroys @p image and returns its segment to
+ * @p pool for reuse.
+ * @ingroup xcb__image_t
+ */
+void
+xcb_image_shm_pool_release (xcb_image_shm_pool_t *pool, xcb_image_t *image);
+
+/**
+ * Put a pool image onto a drawable.
+ * @param pool The pool.
+ * @param draw The destination drawable.
+ * @param gc The graphic context.
+ * @param image The image, from xcb_image_shm_pool_image().
+ * @param x The x coordinate of the destination, relative to the
+ * origin of the drawable.
+ * @param y The y coordinate of the destination, relative to the
+ * origin of the drawable.
+ *
+ * The whole of @p image is drawn with ShmPutImage, or with PutImage
+ * requests of at most the maximum request length if the image is not
+ * shared.  The server reads shared image data after this function
+ * returns: call xcb_image_shm_pool_wait() before changing it.
+ * @ingroup xcb__image_t
+ */
+void
+xcb_image_shm_pool_put (xcb_image_shm_pool_t *  pool,
+			xcb_drawable_t          draw,
+			xcb_gcontext_t          gc,
+			xcb_image_t *           image,
+			int16_t                 x,
+			int16_t                 y);
+
+/**
+ * Wait until the server has read a pool image.
+ * @param pool The pool.
+ * @param image The image, from xcb_image_shm_pool_image().
+ *
+ * This function returns once every xcb_image_shm_pool_put() of
+ * @p image has been processed, so that its data may be changed.
+ * @ingroup xcb__image_t
+ */
+void
+xcb_image_shm_pool_wait (xcb_image_shm_pool_t *pool, xcb_image_t *image);
+
+/**
+ * Read drawable contents into a pool image.
+ * @param pool The pool.
+ * @param draw The source drawable.
+ * @param image The image, from xcb_image_shm_pool_image().
+ * @param x The x coordinate of the upper-left corner of the
+ * rectangle, relative to the origin of the drawable.
+ * @param y The y coordinate of the upper-left corner of the
+ * rectangle, relative to the origin of the drawable.
+ * @param plane_mask The plane mask.
+ * @return 1 on success, 0 on error.
+ *
+ * This function fills @p image with ShmGetImage, or with GetImage if
+ * the image is not shared.
+ * @ingroup xcb__image_t
+ */
+int
+xcb_image_shm_pool_get (xcb_image_shm_pool_t *  pool,
+			xcb_drawable_t          draw,
+			xcb_image_t *           image,
+			int16_t                 x,
+			int16_t                 y,
+			uint32_t                plane_mask);
+
+
 /**
  * Create an image from user-supplied bitmap data.
  * @param data Image data in packed bitmap format.
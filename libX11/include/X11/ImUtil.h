@@ -27,4 +27,20 @@ extern void
 _XInitImageFuncPtrs(
     register XImage *image);
 
+extern void
+_XGetImageRow(
+    XImage *ximage,
+    int x,
+    int y,
+    unsigned int width,
+    CARD32 *pixels);
+
+extern void
+_XPutImageRow(
+    XImage *ximage,
+    int x,
+    int y,
+    unsigned int width,
+    _Xconst CARD32 *pixels);
+
 #endif /* _X11_IMUTIL_H_ */
@@ -205,6 +205,8 @@ struct _XDisplay
 
 	/* avoid recursion on requests sequence number synchronization */
 	Bool req_seq_syncing; /* requests syncing is in-progress */
+
+	struct _XKeycodeIndex *keycode_index; /* XKeysymToKeycode lookups */
 };
 
 #define XAllocIDs(dpy,ids,n) (*(dpy)->idlist_alloc)(dpy,ids,n)
@@ -762,6 +764,15 @@ extern void _XRead32(
 #define OneDataCard32(dpy,dstaddr,srcvar) \
   { *(CARD32 *)(dstaddr) = (srcvar); }
 
+/*
+ * One piece of request data for _XSendv, which writes it to the
+ * connection directly from the caller's memory.
+ */
+typedef struct _XDataVec {
+    _Xconst char *data;
+    long size;
+} _XDataVec;
+
 
 typedef struct _XInternalAsync {
     struct _XInternalAsync *next;
@@ -1039,6 +1050,11 @@ extern void _XSend(
     _Xconst char*	/* data */,
     long		/* size */
 );
+extern void _XSendv(
+    Display*		/* dpy */,
+    _Xconst _XDataVec*	/* vec */,
+    int			/* count */
+);
 extern Status _XReply(
     Display*	/* dpy */,
     xReply*	/* rep */,
@@ -53,6 +53,7 @@ THIS SOFTWARE.
 #  include <sys/stat.h>
 #  include <sys/mman.h>
 #  include <langinfo.h>
+#  include <stdint.h>
 #endif
 
 
@@ -62,8 +63,8 @@ THIS SOFTWARE.
 #define XIM_GLOBAL_CACHE_DIR "/var/cache/libx11/compose/"
 #define XIM_HOME_CACHE_DIR   "/.compose-cache/"
 #define XIM_CACHE_MAGIC      ('X' | 'i'<<8 | 'm'<<16 | 'C'<<24)
-#define XIM_CACHE_VERSION    4
-#define XIM_CACHE_TREE_ALIGNMENT 4
+#define XIM_CACHE_VERSION    5
+#define XIM_CACHE_TREE_ALIGNMENT 8
 
 #define XIM_HASH_PRIME_1 13
 #define XIM_HASH_PRIME_2 1234096939
@@ -77,6 +78,8 @@ struct _XimCacheStruct {
     DTStructIndex   wc;
     DTStructIndex   utf8;
     DTStructIndex   size;
+    DTStructIndex   sources;
+    INT32           nsources;
     DTIndex         top;
     DTIndex         treeused;
     DTCharIndex     mbused;
@@ -84,6 +87,17 @@ struct _XimCacheStruct {
     DTCharIndex     utf8used;
     char            fname[];
     /* char encoding[] */
+    /* char locale[] */
+};
+
+/* The Compose file and every file it includes, as they were when the cache
+ * was written.  The cache is only used while all of them still match. */
+struct _XimCacheSource {
+    int64_t         mtime;
+    int64_t         size;               /* -1 if the file did not exist */
+    int64_t         ino;
+    DTStructIndex   name;
+    INT32           pad;
 };
 
 static struct  _XimCacheStruct* _XimCache_mmap = NULL;
@@ -264,39 +278,114 @@ _XimLocalSetIMValues(
 
 #ifdef COMPOSECACHE
 
+static void
+_XimCacheStatSource(
+    const char             *name,
+    struct _XimCacheSource *s)
+{
+    struct stat st;
+
+    if (stat (name, &st) == -1) {
+	s->mtime = 0;
+	s->size  = -1;
+	s->ino   = 0;
+    } else {
+	s->mtime = st.st_mtime;
+	s->size  = st.st_size;
+	s->ino   = st.st_ino;
+    }
+}
+
+/* Checks that the cache was built for this file, encoding and locale. */
+static Bool
+_XimCacheMatches(
+    const struct _XimCacheStruct *m,
+    const char  *name,
+    const char  *encoding,
+    const char  *locale)
+{
+    const char *key[3];
+    const char *p   = m->fname;
+    const char *end = (const char *) m + m->sources;
+    int i;
+
+    key[0] = name;
+    key[1] = encoding;
+    key[2] = locale;
+    for (i = 0; i < 3; i++) {
+	size_t len = strlen (key[i]) + 1;
+	if ((size_t) (end - p) < len || memcmp (p, key[i], len) != 0)
+	    return False;
+	p += len;
+    }
+    return True;
+}
+
+/* Checks that none of the files the tree was parsed from has changed. */
+static Bool
+_XimCacheIsCurrent(
+    const struct _XimCacheStruct *m)
+{
+    const struct _XimCacheSource *s;
+    struct _XimCacheSource now;
+    int i;
+
+    s = (const struct _XimCacheSource *) ((const char *) m + m->sources);
+    for (i = 0; i < m->nsources; i++) {
+	const char *name = (const char *) m + s[i].name;
+	if (s[i].name < m->sources || s[i].name >= m->tree ||
+	    ! memchr (name, '\0', m->tree - s[i].name))
+	    return False;
+	_XimCacheStatSource (name, &now);
+	if (now.mtime != s[i].mtime || now.size != s[i].size ||
+	    now.ino != s[i].ino)
+	    return False;
+    }
+    return True;
+}
+
+static void
+_XimShareCachedDefaultTree(
+    Xim          im)
+{
+    _XimCachedDefaultTreeRefcount++;
+    memcpy (&im->private.local.base, &_XimCachedDefaultTreeBase,
+	    sizeof (_XimCachedDefaultTreeBase));
+    im->private.local.top = _XimCache_mmap->top;
+}
+
 static Bool
 _XimReadCachedDefaultTree(
     int          fd_cache,
     const char  *name,
     const char  *encoding,
-    DTStructIndex size)
+    const char  *locale,
+    off_t        size)
 {
     struct _XimCacheStruct* m;
-    int namelen = strlen (name) + 1;
-    int encodinglen = strlen (encoding) + 1;
 
+    if (size < (off_t) sizeof (struct _XimCacheStruct) || size > INT32_MAX)
+	return False;
     m = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd_cache, 0);
     if (m == NULL || m == MAP_FAILED)
         return False;
-    assert (m->id == XIM_CACHE_MAGIC);
-    assert (m->version == XIM_CACHE_VERSION);
-    if (size != m->size ||
-	size < sizeof (struct _XimCacheStruct) + namelen + encodinglen) {
+    if (m->id != XIM_CACHE_MAGIC || m->version != XIM_CACHE_VERSION ||
+	m->size != size || m->nsources < 1 ||
+	m->sources < (DTStructIndex) sizeof (struct _XimCacheStruct) ||
+	m->treeused < 0 || m->wcused < 0 || m->mbused < 0 || m->utf8used < 0 ||
+	m->tree < m->sources +
+		  m->nsources * (int64_t) sizeof (struct _XimCacheSource) ||
+	m->wc   != m->tree + m->treeused * (int64_t) sizeof (DefTree) ||
+	m->mb   != m->wc   + m->wcused   * (int64_t) sizeof (wchar_t) ||
+	m->utf8 != m->mb   + (int64_t) m->mbused ||
+	m->size != m->utf8 + (int64_t) m->utf8used ||
+	m->top < 0 || m->top >= m->treeused) {
 	fprintf (stderr, "Ignoring broken XimCache %s [%s]\n", name, encoding);
         munmap (m, size);
         return False;
     }
-    if (strncmp (name, m->fname, namelen) != 0) {
-	/* m->fname may *not* be terminated - but who cares here */
-	fprintf (stderr, "Filename hash clash - expected %s, got %s\n",
-		 name, m->fname);
-        munmap (m, size);
-        return False;
-    }
-    if (strncmp (encoding, m->fname + namelen, encodinglen) != 0) {
-	/* m->fname+namelen may *not* be terminated - but who cares here */
-	fprintf (stderr, "Enoding hash clash - expected %s, got %s\n",
-		 encoding, m->fname + namelen);
+    if (! _XimCacheMatches (m, name, encoding, locale) ||
+	! _XimCacheIsCurrent (m)) {
         munmap (m, size);
         return False;
     }
@@ -326,19 +415,21 @@ static unsigned int strToHash (
 
 
 /* Returns read-only fd of cache file, -1 if none.
- * Sets *res to cache filename if safe. Sets *size to file size of cache. */
+ * Sets *res to cache filename if safe. Sets *size to file size of cache.
+ * Creates the cache directory if it is missing and create is set. */
 static int _XimCachedFileName (
     const char *dir, const char *name,
-    const char *intname, const char *encoding,
-    uid_t uid, int isglobal, char **res, off_t *size)
+    const char *intname, const char *encoding, const char *locale,
+    uid_t uid, Bool create, char **res, off_t *size)
 {
     struct stat st_name, st;
     int    fd;
     unsigned int len, hash, hash2;
-    struct _XimCacheStruct *m;
     /* There are some races here with 'dir', but we are either in our own home
      * or the global cache dir, and not inside some public writable dir */
 /* fprintf (stderr, "XimCachedFileName for dir %s name %s intname %s encoding %s uid %d\n", dir, name, intname, encoding, uid); */
+    if (stat (dir, &st) == -1 && create)
+	mkdir (dir, 0700);
     if (stat (name, &st_name) == -1 || ! S_ISREG (st_name.st_mode)
        || stat (dir, &st) == -1 || ! S_ISDIR (st.st_mode) || st.st_uid != uid
        || (st.st_mode & 0022) != 0000) {
@@ -347,7 +438,8 @@ static int _XimCachedFileName (
     }
     len   = strlen (dir);
     hash  = strToHash (intname);
-    hash2 = strToHash (encoding);
+    hash2 = (strToHash (encoding) * XIM_HASH_PRIME_1 + strToHash (locale))
+	    % XIM_HASH_PRIME_2;
     *res  = Xmalloc (len + 1 + 27 + 1);  /* Max VERSION 9999 */
 
     if (len == 0 || dir [len-1] != '/')
@@ -370,8 +462,7 @@ static int _XimCachedFileName (
     *size = st.st_size;
 
     if (! S_ISREG (st.st_mode) || st.st_uid != uid
-       || (st.st_mode & 0022) != 0000 || st.st_mtime <= st_name.st_mtime
-       || (st.st_mtime < time (NULL) - 24*60*60 && ! isglobal)) {
+       || (st.st_mode & 0022) != 0000) {
 
        close (fd);
        if (unlink (*res) != 0) {
@@ -381,33 +472,6 @@ static int _XimCachedFileName (
        return -1;
     }
 
-    m = mmap (NULL, sizeof (struct _XimCacheStruct), PROT_READ, MAP_PRIVATE,
-	      fd, 0);
-    if (m == NULL || m == MAP_FAILED) {
-	close (fd);
-	Xfree (*res);
-	*res = NULL;
-        return -1;
-    }
-    if (*size < sizeof (struct _XimCacheStruct) || m->id != XIM_CACHE_MAGIC) {
-	munmap (m, sizeof (struct _XimCacheStruct));
-	close (fd);
-	fprintf (stderr, "Ignoring broken XimCache %s\n", *res);
-	Xfree (*res);
-	*res = NULL;
-        return -1;
-    }
-    if (m->version != XIM_CACHE_VERSION) {
-	munmap (m, sizeof (struct _XimCacheStruct));
-	close (fd);
-	if (unlink (*res) != 0) {
-	    Xfree (*res);
-	    *res = NULL;                /* cache is not safe */
-	}
-	return -1;
-    }
-    munmap (m, sizeof (struct _XimCacheStruct));
-
     return fd;
 }
 
@@ -416,15 +480,21 @@ static Bool _XimLoadCache (
     int         fd,
     const char *name,
     const char *encoding,
+    const char *locale,
     off_t       size,
     Xim         im)
 {
-    if (_XimCache_mmap ||
-       _XimReadCachedDefaultTree (fd, name, encoding, size)) {
-       _XimCachedDefaultTreeRefcount++;
-       memcpy (&im->private.local.base, &_XimCachedDefaultTreeBase,
-	       sizeof (_XimCachedDefaultTreeBase));
-       im->private.local.top = _XimCache_mmap->top;
+    /* Only one tree is kept mapped; replace it once nobody uses it. */
+    if (_XimCache_mmap) {
+	if (_XimCachedDefaultTreeRefcount > 0)
+	    return False;
+	munmap (_XimCache_mmap, _XimCache_mmap->size);
+	_XimCache_mmap = NULL;
+	_XimCachedDefaultTreeBase.tree = NULL;
+    }
+
+    if (_XimReadCachedDefaultTree (fd, name, encoding, locale, size)) {
+       _XimShareCachedDefaultTree (im);
        return True;
     }
 
@@ -432,36 +502,57 @@ static Bool _XimLoadCache (
 }
 
 
-static void
+/* Writes the tree to a temporary file and renames it over the cache, so
+ * that other processes never map a partially written cache. */
+static Bool
 _XimWriteCachedDefaultTree(
     const char *name,
+    const char *intname,
     const char *encoding,
+    const char *locale,
     const char *cachename,
     Xim                im)
 {
-    int   fd;
+    int   fd, i, nsources;
     FILE *fp;
+    char *tmpname, *include;
     struct _XimCacheStruct *m;
-    int   msize = (sizeof(struct _XimCacheStruct)
-		   + strlen(name) + strlen(encoding) + 2
-		   + XIM_CACHE_TREE_ALIGNMENT-1) & -XIM_CACHE_TREE_ALIGNMENT;
+    struct _XimCacheSource *s;
+    DTStructIndex names;
+    int   keysize = strlen(intname) + strlen(encoding) + strlen(locale) + 3;
+    int   msize;
     DefTreeBase *b = &im->private.local.base;
+    Bool  ok;
 
     if (! b->tree && ! (b->tree = Xcalloc (1, sizeof(DefTree))) )
-	return;
+	return False;
     if (! b->mb   && ! (b->mb   = Xmalloc (1)) )
-	return;
+	return False;
     if (! b->wc   && ! (b->wc   = Xmalloc (sizeof(wchar_t))) )
-	return;
+	return False;
     if (! b->utf8 && ! (b->utf8 = Xmalloc (1)) )
-	return;
+	return False;
 
     /* First entry is always unused */
     b->mb[0]   = 0;
     b->wc[0]   = 0;
     b->utf8[0] = 0;
 
+    /* The Compose file itself, then everything it included */
+    nsources = 1;
+    for (i = 0; i < im->private.local.includeslen; i++)
+	if (im->private.local.includes[i] == '\0')
+	    nsources++;
+
+    names = (sizeof(struct _XimCacheStruct) + keysize
+	     + XIM_CACHE_TREE_ALIGNMENT-1) & -XIM_CACHE_TREE_ALIGNMENT;
+    names += nsources * sizeof(struct _XimCacheSource);
+    msize = (names + strlen(name) + 1 + im->private.local.includeslen
+	     + XIM_CACHE_TREE_ALIGNMENT-1) & -XIM_CACHE_TREE_ALIGNMENT;
+
     m = Xcalloc (1, msize);
+    if (! m)
+	return False;
     m->id       = XIM_CACHE_MAGIC;
     m->version  = XIM_CACHE_VERSION;
     m->top      = im->private.local.top;
@@ -469,37 +560,67 @@ _XimWriteCachedDefaultTree(
     m->mbused   = b->mbused;
     m->wcused   = b->wcused;
     m->utf8used = b->utf8used;
+    m->sources  = names - nsources * sizeof(struct _XimCacheSource);
+    m->nsources = nsources;
     /* Tree first, then wide chars, then the rest due to alignment */
     m->tree     = msize;
     m->wc       = msize   + sizeof (DefTree) * m->treeused;
     m->mb       = m->wc   + sizeof (wchar_t) * m->wcused;
     m->utf8     = m->mb   +                    m->mbused;
     m->size     = m->utf8 +                    m->utf8used;
-    strcpy (m->fname, name);
-    strcpy (m->fname+strlen(name)+1, encoding);
-
-    /* This STILL might be racy on NFS */
-    if ( (fd = _XOpenFileMode (cachename, O_WRONLY | O_CREAT | O_EXCL,
+    strcpy (m->fname, intname);
+    strcpy (m->fname+strlen(intname)+1, encoding);
+    strcpy (m->fname+strlen(intname)+strlen(encoding)+2, locale);
+
+    s = (struct _XimCacheSource *) ((char *) m + m->sources);
+    s[0].name = names;
+    strcpy ((char *) m + names, name);
+    _XimCacheStatSource (name, &s[0]);
+    names += strlen(name) + 1;
+    memcpy ((char *) m + names, im->private.local.includes,
+	    im->private.local.includeslen);
+    include = im->private.local.includes;
+    for (i = 1; i < nsources; i++) {
+	s[i].name = names;
+	_XimCacheStatSource (include, &s[i]);
+	names   += strlen(include) + 1;
+	include += strlen(include) + 1;
+    }
+
+    tmpname = Xmalloc (strlen(cachename) + 1 + 20 + 1);
+    if (! tmpname) {
+	Xfree(m);
+	return False;
+    }
+    sprintf (tmpname, "%s.%ld", cachename, (long) getpid ());
+    unlink (tmpname);
+    if ( (fd = _XOpenFileMode (tmpname, O_WRONLY | O_CREAT | O_EXCL,
 			       0600)) < 0) {
+       Xfree(tmpname);
        Xfree(m);
-       return;
+       return False;
     }
     if (! (fp = fdopen (fd, "wb")) ) {
        close (fd);
+       unlink (tmpname);
+       Xfree(tmpname);
        Xfree(m);
-       return;
+       return False;
     }
     fwrite (m, msize, 1, fp);
-    fwrite (im->private.local.base.tree, sizeof(DefTree), m->treeused, fp);
-    fwrite (im->private.local.base.wc,   sizeof(wchar_t), m->wcused,   fp);
-    fwrite (im->private.local.base.mb,   1,               m->mbused,   fp);
-    fwrite (im->private.local.base.utf8, 1,               m->utf8used, fp);
-    if (fclose (fp) != 0)
-	unlink (cachename);
-    _XimCache_mmap = m;
-    memcpy (&_XimCachedDefaultTreeBase, &im->private.local.base,
-	    sizeof (_XimCachedDefaultTreeBase));
+    fwrite (b->tree, sizeof(DefTree), m->treeused, fp);
+    fwrite (b->wc,   sizeof(wchar_t), m->wcused,   fp);
+    fwrite (b->mb,   1,               m->mbused,   fp);
+    fwrite (b->utf8, 1,               m->utf8used, fp);
+    ok = ! ferror (fp);
+    if (fclose (fp) != 0 || ! ok || rename (tmpname, cachename) != 0) {
+	unlink (tmpname);
+	ok = False;
+    }
 /* fprintf (stderr, "wrote tree %s size %ld to %s\n", name, m->size, cachename); */
+    Xfree(tmpname);
+    Xfree(m);
+    return ok;
 }
 
 #endif
@@ -519,6 +640,7 @@ _XimCreateDefaultTree(
     int   hl = home ? strlen (home) : 0;
 #ifdef COMPOSECACHE
     const char *encoding = nl_langinfo (CODESET);
+    const char *locale = im->core.lcd->core->name;
     uid_t euid = geteuid ();
     gid_t egid = getegid ();
     int   cachefd = -1;
@@ -562,11 +684,22 @@ _XimCreateDefaultTree(
 	}
     }
 
+    /* Another XOpenIM in this process already mapped this tree */
+    if (intname && _XimCache_mmap &&
+	_XimCacheMatches (_XimCache_mmap, intname, encoding, locale) &&
+	_XimCacheIsCurrent (_XimCache_mmap)) {
+	_XimShareCachedDefaultTree (im);
+	Xfree (tmpcachedir);
+	Xfree (tmpname);
+	return;
+    }
+
     if (! cachedir) {
 	cachefd = _XimCachedFileName (XIM_GLOBAL_CACHE_DIR, name, intname,
-				      encoding, 0, 1, &cachename, &size);
+				      encoding, locale, 0, False,
+				      &cachename, &size);
 	if (cachefd != -1) {
-	    if (_XimLoadCache (cachefd, intname, encoding, size, im)) {
+	    if (_XimLoadCache (cachefd, intname, encoding, locale, size, im)) {
 	        Xfree (tmpcachedir);
 		Xfree (tmpname);
 		Xfree (cachename);
@@ -580,16 +713,18 @@ _XimCreateDefaultTree(
     }
 
     if (getuid () == euid && getgid () == egid && euid != 0 && home) {
+	Bool create = False;
 
 	if (! cachedir) {
 	    tmpcachedir = cachedir = Xmalloc (hl+strlen(XIM_HOME_CACHE_DIR)+1);
 	    strcpy (cachedir, home);
 	    strcat (cachedir, XIM_HOME_CACHE_DIR);
+	    create = True;
 	}
 	cachefd = _XimCachedFileName (cachedir, name, intname, encoding,
-				      euid, 0, &cachename, &size);
+				      locale, euid, create, &cachename, &size);
 	if (cachefd != -1) {
-	    if (_XimLoadCache (cachefd, intname, encoding, size, im)) {
+	    if (_XimLoadCache (cachefd, intname, encoding, locale, size, im)) {
 	        Xfree (tmpcachedir);
 		Xfree (tmpname);
 		Xfree (cachename);
@@ -611,12 +746,28 @@ _XimCreateDefaultTree(
     fclose(fp);
 
 #ifdef COMPOSECACHE
+    /* Switch to the mapped copy, so that its pages are shared with every
+     * other process using the same cache. */
     if (cachename) {
 	assert (euid != 0);
-	_XimWriteCachedDefaultTree (intname, encoding, cachename, im);
+	if (_XimWriteCachedDefaultTree (name, intname, encoding, locale,
+					cachename, im) &&
+	    (cachefd = _XOpenFile (cachename, O_RDONLY)) != -1) {
+	    DefTreeBase parsed = im->private.local.base;
+	    struct stat st;
+
+	    if (fstat (cachefd, &st) != -1 &&
+		_XimLoadCache (cachefd, intname, encoding, locale,
+			       st.st_size, im))
+		XimFreeDefaultTree (&parsed);
+	    close (cachefd);
+	}
     }
 #endif
 
+    Xfree (im->private.local.includes);
+    im->private.local.includes = NULL;
+    im->private.local.includeslen = 0;
     Xfree (tmpcachedir);
     Xfree (tmpname);
     Xfree (cachename);
@@ -402,6 +402,26 @@ end:
    return ret;
 }
 
+/*
+ * Remembers a file pulled in by "include", so that a compose cache built
+ * from this tree can tell when one of them changes.  Files that cannot be
+ * opened are recorded as well, since creating them changes the tree.
+ */
+static void
+addinclude(Xim im, const char *filename)
+{
+    int len = strlen(filename) + 1;
+    char *includes;
+
+    includes = Xrealloc(im->private.local.includes,
+                        im->private.local.includeslen + len);
+    if (includes == NULL)
+        return;
+    memcpy(includes + im->private.local.includeslen, filename, len);
+    im->private.local.includes = includes;
+    im->private.local.includeslen += len;
+}
+
 #ifndef MB_LEN_MAX
 #define MB_LEN_MAX 6
 #endif
@@ -500,6 +520,7 @@ parseline(
                 goto error;
             if ((filename = TransFileName(im, tokenbuf)) == NULL)
                 goto error;
+            addinclude(im, filename);
             infp = _XFopenFile(filename, "r");
             Xfree(filename);
             if (infp == NULL)
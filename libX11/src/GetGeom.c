@@ -61,3 +61,110 @@ Status XGetGeometry (
     return (1);
 }
 
+
+typedef struct {
+    uint64_t start_seq;
+    uint64_t stop_seq;
+    Window *roots;
+    int *xs;
+    int *ys;
+    unsigned int *widths;
+    unsigned int *heights;
+    unsigned int *borderWidths;
+    unsigned int *depths;
+    int replies;
+} _XGetGeomsState;
+
+static
+Bool _XGetGeomsHandler(
+    register Display *dpy,
+    register xReply *rep,
+    char *buf,
+    int len,
+    XPointer data)
+{
+    register _XGetGeomsState *state;
+    xGetGeometryReply replbuf;
+    register xGetGeometryReply *repl;
+    int i;
+    uint64_t last_request_read = X_DPY_GET_LAST_REQUEST_READ(dpy);
+
+    state = (_XGetGeomsState *)data;
+    if (last_request_read < state->start_seq ||
+	last_request_read > state->stop_seq)
+	return False;
+    if (rep->generic.type == X_Error)
+	return False;
+    i = (int)(last_request_read - state->start_seq);
+    repl = (xGetGeometryReply *)
+	_XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+			(SIZEOF(xGetGeometryReply) - SIZEOF(xReply)) >> 2,
+			True);
+    state->roots[i] = repl->root;
+    state->xs[i] = cvtINT16toInt (repl->x);
+    state->ys[i] = cvtINT16toInt (repl->y);
+    state->widths[i] = repl->width;
+    state->heights[i] = repl->height;
+    state->borderWidths[i] = repl->borderWidth;
+    state->depths[i] = repl->depth;
+    state->replies++;
+    return True;
+}
+
+/*
+ * XGetGeometry for count drawables, with one round trip for all of them.
+ * Entries whose request failed are zeroed, and the return value is zero.
+ */
+Status XGetGeometries (
+    register Display *dpy,
+    Drawable *drawables,
+    int count,
+    Window *roots, /* RETURN */
+    int *xs,
+    int *ys,  /* RETURN */
+    unsigned int *widths,
+    unsigned int *heights,
+    unsigned int *borderWidths,
+    unsigned int *depths)  /* RETURN */
+{
+    _XAsyncHandler async;
+    _XGetGeomsState async_state;
+    xGetInputFocusReply rep;
+    register xResourceReq *req;
+    _X_UNUSED register xReq *sync;
+    int i;
+
+    for (i = 0; i < count; i++) {
+	roots[i] = None;
+	xs[i] = ys[i] = 0;
+	widths[i] = heights[i] = borderWidths[i] = depths[i] = 0;
+    }
+    if (count <= 0)
+	return (1);
+
+    LockDisplay(dpy);
+    async_state.start_seq = X_DPY_GET_REQUEST(dpy) + 1;
+    async_state.roots = roots;
+    async_state.xs = xs;
+    async_state.ys = ys;
+    async_state.widths = widths;
+    async_state.heights = heights;
+    async_state.borderWidths = borderWidths;
+    async_state.depths = depths;
+    async_state.replies = 0;
+    async.next = dpy->async_handlers;
+    async.handler = _XGetGeomsHandler;
+    async.data = (XPointer)&async_state;
+    dpy->async_handlers = &async;
+    for (i = 0; i < count; i++) {
+	GetResReq(GetGeometry, drawables[i], req);
+    }
+    async_state.stop_seq = X_DPY_GET_REQUEST(dpy);
+    /* every geometry reply reaches the handler before this one */
+    GetEmptyReq(GetInputFocus, sync);
+    (void) _XReply (dpy, (xReply *)&rep, 0, xTrue);
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    return (async_state.replies == count);
+}
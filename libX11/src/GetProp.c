@@ -144,3 +144,178 @@ XGetWindowProperty(
     return(Success);
 }
 
+
+typedef struct {
+    uint64_t start_seq;
+    uint64_t stop_seq;
+    Atom *types;
+    int *formats;
+    unsigned long *nitems;
+    unsigned long *bytesafter;
+    unsigned char **props;
+    int replies;
+    Status status;
+} _XGetPropsState;
+
+static
+Bool _XGetPropsHandler(
+    register Display *dpy,
+    register xReply *rep,
+    char *buf,
+    int len,
+    XPointer data)
+{
+    register _XGetPropsState *state;
+    xGetPropertyReply replbuf;
+    register xGetPropertyReply *repl;
+    unsigned char *prop = NULL;
+    unsigned long nbytes = 0, netbytes = 0;
+    int i, format;
+    uint64_t last_request_read = X_DPY_GET_LAST_REQUEST_READ(dpy);
+
+    state = (_XGetPropsState *)data;
+    if (last_request_read < state->start_seq ||
+	last_request_read > state->stop_seq)
+	return False;
+    if (rep->generic.type == X_Error) {
+	state->status = 0;
+	return False;
+    }
+    /* one GetProperty per entry, so the sequence number is the index */
+    i = (int)(last_request_read - state->start_seq);
+    repl = (xGetPropertyReply *)
+	_XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+			(SIZEOF(xGetPropertyReply) - SIZEOF(xReply)) >> 2,
+			False);
+    state->replies++;
+    if (repl->propertyType != None) {
+	format = repl->format;
+	/* same limits and layout as XGetWindowProperty */
+	if (repl->nItems >= (INT_MAX >> 4))
+	    format = -1;
+	switch (format) {
+	  case 8:
+	    nbytes = netbytes = repl->nItems;
+	    break;
+	  case 16:
+	    nbytes = repl->nItems * sizeof (short);
+	    netbytes = repl->nItems << 1;
+	    break;
+	  case 32:
+	    nbytes = repl->nItems * sizeof (long);
+	    netbytes = repl->nItems << 2;
+	    break;
+	  default:
+	    {
+		xError error = {0};
+
+		error.type = X_Error;
+		error.sequenceNumber = (CARD16)(last_request_read & 0xffff);
+		error.majorCode = X_GetProperty;
+		error.minorCode = 0;
+		error.errorCode = BadImplementation;
+		_XError(dpy, &error);
+	    }
+	    break;
+	}
+	if (format > 0)
+	    prop = Xmalloc (nbytes + 1);
+	_XGetAsyncData(dpy, (char *) prop, buf, len,
+		       SIZEOF(xGetPropertyReply), prop ? netbytes : 0,
+		       repl->length << 2);
+	if (!prop) {
+	    state->status = 0;
+	    return True;
+	}
+#ifdef LONG64
+	if (format == 32) {
+	    register int *ibuf = (int *)prop + repl->nItems;
+	    register long *lbuf = (long *)prop + repl->nItems;
+	    register unsigned long n = repl->nItems;
+
+	    while (n-- > 0)
+		*--lbuf = *--ibuf;
+	}
+#endif
+	prop[nbytes] = '\0';
+    }
+    state->types[i] = repl->propertyType;
+    state->formats[i] = repl->format;
+    state->nitems[i] = repl->nItems;
+    state->bytesafter[i] = repl->bytesAfter;
+    state->props[i] = prop;
+    return True;
+}
+
+/*
+ * Fetch count properties at once, properties[i] of windows[i], with the
+ * same offset, length, delete and req_type for all of them.  Every
+ * GetProperty goes out before any reply is read, so a scan of many
+ * windows costs one round trip.  Entries whose request failed are left
+ * as None with no data, and the return value is zero.
+ */
+Status
+XGetWindowProperties(
+    register Display *dpy,
+    Window *windows,
+    Atom *properties,
+    int count,
+    long offset,
+    long length,
+    Bool delete,
+    Atom req_type,
+    Atom *actual_types,		/* RETURN */
+    int *actual_formats,	/* RETURN */
+    unsigned long *nitems,	/* RETURN */
+    unsigned long *bytesafter,	/* RETURN */
+    unsigned char **props)	/* RETURN */
+{
+    _XAsyncHandler async;
+    _XGetPropsState async_state;
+    xGetInputFocusReply rep;
+    register xGetPropertyReq *req;
+    _X_UNUSED register xReq *sync;
+    int i;
+
+    for (i = 0; i < count; i++) {
+	actual_types[i] = None;
+	actual_formats[i] = 0;
+	nitems[i] = bytesafter[i] = 0L;
+	props[i] = (unsigned char *) NULL;
+    }
+    if (count <= 0)
+	return 1;
+
+    LockDisplay(dpy);
+    async_state.start_seq = X_DPY_GET_REQUEST(dpy) + 1;
+    async_state.types = actual_types;
+    async_state.formats = actual_formats;
+    async_state.nitems = nitems;
+    async_state.bytesafter = bytesafter;
+    async_state.props = props;
+    async_state.replies = 0;
+    async_state.status = 1;
+    async.next = dpy->async_handlers;
+    async.handler = _XGetPropsHandler;
+    async.data = (XPointer)&async_state;
+    dpy->async_handlers = &async;
+    for (i = 0; i < count; i++) {
+	GetReq (GetProperty, req);
+	req->window = windows[i];
+	req->property = properties[i];
+	req->type = req_type;
+	req->delete = delete;
+	req->longOffset = offset;
+	req->longLength = length;
+    }
+    async_state.stop_seq = X_DPY_GET_REQUEST(dpy);
+    /* every property reply reaches the handler before this one */
+    GetEmptyReq(GetInputFocus, sync);
+    (void) _XReply (dpy, (xReply *)&rep, 0, xTrue);
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    if (async_state.replies != count)
+	async_state.status = 0;
+    return async_state.status;
+}
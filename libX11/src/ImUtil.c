@@ -818,13 +818,287 @@ static int _XPutPixel1 (
 	}
 }
 
+/*
+ * Row access
+ *
+ * Reads or writes width pixels of one scanline, starting at (x, y), as
+ * normalized pixel values.  ZPixmap images of 8, 16, 24 and 32 bits per
+ * pixel and single plane bitmaps of any unit, byte and bit order are
+ * converted here a whole row at a time; other images, and images whose
+ * get_pixel or put_pixel has been replaced, go through XGetPixel and
+ * XPutPixel.
+ */
+
+static Bool
+_XRowGetPixelOk(XImage *ximage)
+{
+	return (ximage->f.get_pixel == _XGetPixel ||
+		ximage->f.get_pixel == _XGetPixel1 ||
+		ximage->f.get_pixel == _XGetPixel8 ||
+		ximage->f.get_pixel == _XGetPixel16 ||
+		ximage->f.get_pixel == _XGetPixel32);
+}
+
+static Bool
+_XRowPutPixelOk(XImage *ximage)
+{
+	return (ximage->f.put_pixel == _XPutPixel ||
+		ximage->f.put_pixel == _XPutPixel1 ||
+		ximage->f.put_pixel == _XPutPixel8 ||
+		ximage->f.put_pixel == _XPutPixel16 ||
+		ximage->f.put_pixel == _XPutPixel32);
+}
+
+/*
+ * Locates bit x of a single plane scanline: the byte offset of its unit
+ * within the line and the bit within that unit, counted from the least
+ * significant end as the unit is laid out in memory.
+ */
+#define XYBIT(ximage, x, byte, bit) \
+{ \
+	int _unit = (ximage)->bitmap_unit, _b = (x) + (ximage)->xoffset; \
+	int _k = _b % _unit; \
+	if ((ximage)->bitmap_bit_order == MSBFirst) \
+	    _k = _unit - 1 - _k; \
+	byte = (_b - _b % _unit) >> 3; \
+	byte += ((ximage)->byte_order == MSBFirst) ? \
+		((_unit >> 3) - 1 - (_k >> 3)) : (_k >> 3); \
+	bit = _k & 7; \
+}
+
+/* True when the bits of a single plane scanline can be addressed by byte. */
+#define XYBYTES(ximage) \
+	((ximage)->bitmap_unit == 8 || \
+	 (ximage)->byte_order == (ximage)->bitmap_bit_order)
+
+void
+_XGetImageRow(
+    XImage *ximage,
+    int x,
+    int y,
+    unsigned int width,
+    CARD32 *pixels)
+{
+	unsigned char *addr;
+	CARD32 mask = 0xffffffff;
+	unsigned int i;
+	int byte, bit;
+
+	if (!_XRowGetPixelOk(ximage))
+	    goto slow;
+	addr = (unsigned char *)ximage->data + (long) y * ximage->bytes_per_line;
+	if ((ximage->bits_per_pixel | ximage->depth) == 1) {
+	    if (XYBYTES(ximage)) {
+		int shift = ximage->bitmap_bit_order == MSBFirst ? 7 : 0;
+		for (i = 0, byte = x + ximage->xoffset; i < width; i++, byte++)
+		    pixels[i] = (addr[byte >> 3] >> ((byte & 7) ^ shift)) & 1;
+		return;
+	    }
+	    for (i = 0; i < width; i++) {
+		XYBIT(ximage, x + (int) i, byte, bit);
+		pixels[i] = (addr[byte] >> bit) & 1;
+	    }
+	    return;
+	}
+	if (ximage->format != ZPixmap)
+	    goto slow;
+	if (ximage->depth < 32 && ximage->bits_per_pixel != ximage->depth)
+	    mask = low_bits_table[ximage->depth];
+	switch (ximage->bits_per_pixel) {
+	case 8:
+	    addr += x;
+	    for (i = 0; i < width; i++)
+		pixels[i] = addr[i] & mask;
+	    return;
+	case 16:
+	    addr += x * 2;
+	    if (ximage->byte_order == MSBFirst)
+		for (i = 0; i < width; i++, addr += 2)
+		    pixels[i] = (addr[0] << 8 | addr[1]) & mask;
+	    else
+		for (i = 0; i < width; i++, addr += 2)
+		    pixels[i] = (addr[1] << 8 | addr[0]) & mask;
+	    return;
+	case 24:
+	    addr += x * 3;
+	    if (ximage->byte_order == MSBFirst)
+		for (i = 0; i < width; i++, addr += 3)
+		    pixels[i] = ((CARD32) addr[0] << 16 | addr[1] << 8 | addr[2]) & mask;
+	    else
+		for (i = 0; i < width; i++, addr += 3)
+		    pixels[i] = ((CARD32) addr[2] << 16 | addr[1] << 8 | addr[0]) & mask;
+	    return;
+	case 32:
+	    addr += x * 4;
+	    if (*((const char *)&byteorderpixel) == ximage->byte_order) {
+		memcpy(pixels, addr, width * 4);
+		if (mask != 0xffffffff)
+		    for (i = 0; i < width; i++)
+			pixels[i] &= mask;
+	    } else if (ximage->byte_order == MSBFirst)
+		for (i = 0; i < width; i++, addr += 4)
+		    pixels[i] = ((CARD32) addr[0] << 24 | (CARD32) addr[1] << 16 |
+				 addr[2] << 8 | addr[3]) & mask;
+	    else
+		for (i = 0; i < width; i++, addr += 4)
+		    pixels[i] = ((CARD32) addr[3] << 24 | (CARD32) addr[2] << 16 |
+				 addr[1] << 8 | addr[0]) & mask;
+	    return;
+	}
+slow:
+	for (i = 0; i < width; i++)
+	    pixels[i] = XGetPixel(ximage, x + (int) i, y);
+}
+
+void
+_XPutImageRow(
+    XImage *ximage,
+    int x,
+    int y,
+    unsigned int width,
+    _Xconst CARD32 *pixels)
+{
+	unsigned char *addr;
+	unsigned int i;
+	int byte, bit;
+
+	if (!_XRowPutPixelOk(ximage))
+	    goto slow;
+	addr = (unsigned char *)ximage->data + (long) y * ximage->bytes_per_line;
+	if ((ximage->bits_per_pixel | ximage->depth) == 1) {
+	    if (XYBYTES(ximage)) {
+		int shift = ximage->bitmap_bit_order == MSBFirst ? 7 : 0;
+		for (i = 0, byte = x + ximage->xoffset; i < width; i++, byte++) {
+		    bit = (byte & 7) ^ shift;
+		    if (pixels[i] & 1)
+			addr[byte >> 3] |= 1 << bit;
+		    else
+			addr[byte >> 3] &= ~(1 << bit);
+		}
+		return;
+	    }
+	    for (i = 0; i < width; i++) {
+		XYBIT(ximage, x + (int) i, byte, bit);
+		if (pixels[i] & 1)
+		    addr[byte] |= 1 << bit;
+		else
+		    addr[byte] &= ~(1 << bit);
+	    }
+	    return;
+	}
+	if (ximage->format != ZPixmap)
+	    goto slow;
+	switch (ximage->bits_per_pixel) {
+	case 8:
+	    addr += x;
+	    for (i = 0; i < width; i++)
+		addr[i] = pixels[i];
+	    return;
+	case 16:
+	    addr += x * 2;
+	    if (ximage->byte_order == MSBFirst)
+		for (i = 0; i < width; i++, addr += 2) {
+		    addr[0] = pixels[i] >> 8;
+		    addr[1] = pixels[i];
+		}
+	    else
+		for (i = 0; i < width; i++, addr += 2) {
+		    addr[0] = pixels[i];
+		    addr[1] = pixels[i] >> 8;
+		}
+	    return;
+	case 24:
+	    addr += x * 3;
+	    if (ximage->byte_order == MSBFirst)
+		for (i = 0; i < width; i++, addr += 3) {
+		    addr[0] = pixels[i] >> 16;
+		    addr[1] = pixels[i] >> 8;
+		    addr[2] = pixels[i];
+		}
+	    else
+		for (i = 0; i < width; i++, addr += 3) {
+		    addr[0] = pixels[i];
+		    addr[1] = pixels[i] >> 8;
+		    addr[2] = pixels[i] >> 16;
+		}
+	    return;
+	case 32:
+	    addr += x * 4;
+	    if (*((const char *)&byteorderpixel) == ximage->byte_order)
+		memcpy(addr, pixels, width * 4);
+	    else if (ximage->byte_order == MSBFirst)
+		for (i = 0; i < width; i++, addr += 4) {
+		    addr[0] = pixels[i] >> 24;
+		    addr[1] = pixels[i] >> 16;
+		    addr[2] = pixels[i] >> 8;
+		    addr[3] = pixels[i];
+		}
+	    else
+		for (i = 0; i < width; i++, addr += 4) {
+		    addr[0] = pixels[i];
+		    addr[1] = pixels[i] >> 8;
+		    addr[2] = pixels[i] >> 16;
+		    addr[3] = pixels[i] >> 24;
+		}
+	    return;
+	}
+slow:
+	for (i = 0; i < width; i++)
+	    XPutPixel(ximage, x + (int) i, y, pixels[i]);
+}
+
+/*
+ * Copies a width by height block of pixels between two images of the same
+ * depth, a row at a time.  Scanlines with the same ZPixmap layout on both
+ * sides are copied as bytes.
+ */
+
+#define ROW_PIXELS 256
+
+static void
+_XCopyImageRows(
+    XImage *src,
+    int sx,
+    int sy,
+    XImage *dst,
+    int dx,
+    int dy,
+    unsigned int width,
+    unsigned int height)
+{
+	CARD32 pixels[ROW_PIXELS];
+	unsigned int row, col, n;
+	int bpp = src->bits_per_pixel;
+
+	if (src->format == ZPixmap && dst->format == ZPixmap &&
+	    bpp == dst->bits_per_pixel && (bpp & 7) == 0 &&
+	    src->depth == bpp && dst->depth == bpp &&
+	    (bpp == 8 || src->byte_order == dst->byte_order) &&
+	    _XRowGetPixelOk(src) && _XRowPutPixelOk(dst)) {
+	    for (row = 0; row < height; row++)
+		memcpy(dst->data + (long) (dy + row) * dst->bytes_per_line +
+			   dx * (bpp >> 3),
+		       src->data + (long) (sy + row) * src->bytes_per_line +
+			   sx * (bpp >> 3),
+		       width * (bpp >> 3));
+	    return;
+	}
+	for (row = 0; row < height; row++) {
+	    for (col = 0; col < width; col += n) {
+		n = width - col < ROW_PIXELS ? width - col : ROW_PIXELS;
+		_XGetImageRow(src, sx + col, sy + row, n, pixels);
+		_XPutImageRow(dst, dx + col, dy + row, n, pixels);
+	    }
+	}
+}
+
 /*
  * SubImage
  *
  * Creates a new image that is a subsection of an existing one.
  * Allocates the memory necessary for the new XImage data structure.
- * Pointer to new image is returned.  The algorithm used is repetitive
- * calls to get and put pixel.
+ * Pointer to new image is returned.  The pixels are copied a scanline at
+ * a time with _XCopyImageRows.
  *
  */
 
@@ -838,8 +1112,6 @@ static XImage *_XSubImage (
 {
 	register XImage *subimage;
 	int dsize;
-	register int row, col;
-	register unsigned long pixel;
 	char *data;
 
 	if ((subimage = Xcalloc (1, sizeof (XImage))) == NULL)
@@ -883,12 +1155,7 @@ static XImage *_XSubImage (
 	if (height > ximage->height - y ) height = ximage->height - y;
 	if (width > ximage->width - x ) width = ximage->width - x;
 
-	for (row = y; row < (y + height); row++) {
-	    for (col = x; col < (x + width); col++) {
-		pixel = XGetPixel(ximage, col, row);
-		XPutPixel(subimage, (col - x), (row - y), pixel);
-	    }
-	}
+	_XCopyImageRows(ximage, x, y, subimage, 0, 0, width, height);
 	return subimage;
 }
 
@@ -922,8 +1189,6 @@ int _XSetImage(
     register int x,
     register int y)
 {
-	register unsigned long pixel;
-	register int row, col;
 	int width, height, startrow, startcol;
 	if (x < 0) {
 	    startcol = -x;
@@ -942,13 +1207,10 @@ int _XSetImage(
 	if (srcimg->height < height)
 	    height = srcimg->height;
 
-	/* this is slow, will do better later */
-	for (row = startrow; row < height; row++) {
-	    for (col = startcol; col < width; col++) {
-		pixel = XGetPixel(srcimg, col, row);
-		XPutPixel(dstimg, x + col, y + row, pixel);
-	    }
-	}
+	if (startrow < height && startcol < width)
+	    _XCopyImageRows(srcimg, startcol, startrow, dstimg,
+			    x + startcol, y + startrow,
+			    width - startcol, height - startrow);
 	return 1;
 }
 
@@ -9,10 +9,53 @@
 extern const unsigned char _XkeyTable[];
 #endif
 
+/*
+ * Slot of a key with hash h and bucket displacement d in the perfect hash
+ * tables of ks_tables.h; util/makekeys.c builds them with a copy of this.
+ */
+static _X_INLINE unsigned int
+_XKeysymHashSlot(unsigned int h, unsigned int d, unsigned int size)
+{
+    h = (h + d) * 0x9e3779b1U;
+    return (h ^ (h >> 15)) % size;
+}
+
 extern int
 _XKeyInitialize(
     Display *dpy);
 
+/* XKeysymToKeycode index, open addressed by keysym; see KeyBind.c */
+typedef struct {
+    KeySym keysym;
+    KeyCode keycode;		/* 0 for an empty slot */
+} _XKeycodeIndexEntry;
+
+struct _XKeycodeIndex {
+    Bool xkb;			/* built from the XKB map */
+    unsigned int mask;		/* number of slots - 1 */
+    _XKeycodeIndexEntry *entries;
+};
+
+extern struct _XKeycodeIndex *
+_XCreateKeycodeIndex(
+    int max_entries,
+    Bool xkb);
+
+extern void
+_XKeycodeIndexAdd(
+    struct _XKeycodeIndex *index,
+    KeySym ks,
+    KeyCode kc);
+
+extern KeyCode
+_XKeycodeIndexLookup(
+    struct _XKeycodeIndex *index,
+    KeySym ks);
+
+extern void
+_XFreeKeycodeIndex(
+    Display *dpy);
+
 extern XrmDatabase
 _XInitKeysymDB(
         void);
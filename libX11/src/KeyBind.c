@@ -128,15 +128,107 @@ XKeycodeToKeysym(Display *dpy,
     return KeyCodetoKeySym(dpy, kc, col);
 }
 
+/*
+ * Keysym to keycode index
+ *
+ * XKeysymToKeycode returns the first keycode found scanning the keyboard
+ * map a column at a time.  The index records that keycode for every keysym
+ * in the map, keeping the first one added, so callers fill it in scan
+ * order.  It is built on first use from either the core or the XKB map,
+ * and dropped under the display lock whenever that map is reloaded.
+ */
+
+static unsigned int
+KeycodeIndexHash(KeySym ks)
+{
+    CARD32 h = (CARD32) ks * 2654435761U;
+
+    return h ^ (h >> 16);
+}
+
+struct _XKeycodeIndex *
+_XCreateKeycodeIndex(int max_entries, Bool xkb)
+{
+    struct _XKeycodeIndex *index;
+    unsigned int size = 16;
+
+    while (size < (unsigned int) max_entries * 2)
+	size <<= 1;
+    index = Xmalloc(sizeof(struct _XKeycodeIndex) +
+		    size * sizeof(_XKeycodeIndexEntry));
+    if (!index)
+	return NULL;
+    index->xkb = xkb;
+    index->mask = size - 1;
+    index->entries = (_XKeycodeIndexEntry *) (index + 1);
+    memset(index->entries, 0, size * sizeof(_XKeycodeIndexEntry));
+    return index;
+}
+
+void
+_XKeycodeIndexAdd(struct _XKeycodeIndex *index, KeySym ks, KeyCode kc)
+{
+    unsigned int i = KeycodeIndexHash(ks) & index->mask;
+
+    while (index->entries[i].keycode) {
+	if (index->entries[i].keysym == ks)
+	    return;
+	i = (i + 1) & index->mask;
+    }
+    index->entries[i].keysym = ks;
+    index->entries[i].keycode = kc;
+}
+
+KeyCode
+_XKeycodeIndexLookup(struct _XKeycodeIndex *index, KeySym ks)
+{
+    unsigned int i = KeycodeIndexHash(ks) & index->mask;
+
+    while (index->entries[i].keycode) {
+	if (index->entries[i].keysym == ks)
+	    return index->entries[i].keycode;
+	i = (i + 1) & index->mask;
+    }
+    return 0;
+}
+
+void
+_XFreeKeycodeIndex(Display *dpy)
+{
+    Xfree(dpy->keycode_index);
+    dpy->keycode_index = NULL;
+}
+
 KeyCode
 XKeysymToKeycode(
     Display *dpy,
     KeySym ks)
 {
     register int i, j;
+    KeyCode kc;
 
     if ((! dpy->keysyms) && (! _XKeyInitialize(dpy)))
 	return (KeyCode) 0;
+    LockDisplay(dpy);
+    if (dpy->keycode_index && dpy->keycode_index->xkb)
+	_XFreeKeycodeIndex(dpy);
+    if (!dpy->keycode_index && dpy->keysyms) {
+	dpy->keycode_index = _XCreateKeycodeIndex(
+	    (dpy->max_keycode - dpy->min_keycode + 1) *
+	    dpy->keysyms_per_keycode, False);
+	if (dpy->keycode_index)
+	    for (j = 0; j < dpy->keysyms_per_keycode; j++)
+		for (i = dpy->min_keycode; i <= dpy->max_keycode; i++)
+		    _XKeycodeIndexAdd(dpy->keycode_index,
+				      KeyCodetoKeySym(dpy, (KeyCode) i, j),
+				      (KeyCode) i);
+    }
+    if (dpy->keycode_index) {
+	kc = _XKeycodeIndexLookup(dpy->keycode_index, ks);
+	UnlockDisplay(dpy);
+	return kc;
+    }
+    UnlockDisplay(dpy);
     for (j = 0; j < dpy->keysyms_per_keycode; j++) {
 	for (i = dpy->min_keycode; i <= dpy->max_keycode; i++) {
 	    if (KeyCodetoKeySym(dpy, (KeyCode) i, j) == ks)
@@ -237,6 +329,9 @@ XRefreshKeyboardMapping(register XMappingEvent *event)
 	     Xfree (event->display->keysyms);
 	     event->display->keysyms = NULL;
 	}
+	if (event->display->keycode_index &&
+	    !event->display->keycode_index->xkb)
+	    _XFreeKeycodeIndex(event->display);
 	UnlockDisplay(event->display);
     }
     if(event->request == MappingModifier) {
@@ -275,6 +370,8 @@ _XKeyInitialize(
 	Xfree (dpy->keysyms);
 	dpy->keysyms = keysyms;
 	dpy->keysyms_per_keycode = per;
+	if (dpy->keycode_index && !dpy->keycode_index->xkb)
+	    _XFreeKeycodeIndex(dpy);
 	if (dpy->modifiermap)
 	    ResetModMap(dpy);
 
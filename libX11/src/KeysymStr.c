@@ -83,21 +83,14 @@ char *XKeysymToString(KeySym ks)
 	unsigned char val2 = (ks >> 16) & 0xff;
 	unsigned char val3 = (ks >> 8) & 0xff;
 	unsigned char val4 = ks & 0xff;
-	int i = ks % VTABLESIZE;
-	int h = i + 1;
-	int n = VMAXHASH;
-	int idx;
-	while ((idx = hashKeysym[i]))
+	int idx = hashKeysym[_XKeysymHashSlot(ks, displaceKeysym[ks % VBUCKETS],
+					      VTABLESIZE)];
+	if (idx)
 	{
 	    const unsigned char *entry = &_XkeyTable[idx];
 	    if ((entry[0] == val1) && (entry[1] == val2) &&
                 (entry[2] == val3) && (entry[3] == val4))
 		return ((char *)entry + 4);
-	    if (!--n)
-		break;
-	    i += h;
-	    if (i >= VTABLESIZE)
-		i -= VTABLESIZE;
 	}
     }
 
@@ -34,6 +34,7 @@ in this Software without prior written authorization from The Open Group.
 #include <stdio.h>
 #include <unistd.h>
 #include "Xintconn.h"
+#include "Key.h"
 
 #ifdef XKB
 #include "XKBlib.h"
@@ -661,6 +662,7 @@ void _XFreeDisplayStructure(Display *dpy)
 	Xfree (dpy->vendor);
 	Xfree (dpy->buffer);
 	Xfree (dpy->keysyms);
+	_XFreeKeycodeIndex(dpy);
 	Xfree (dpy->xdefaults);
 	Xfree (dpy->error_vec);
 
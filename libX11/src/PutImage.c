@@ -129,6 +129,204 @@ _XReverse_Bytes(
     return 0;
 }
 
+/*
+ * Row kernels for the swap functions below.  Each one converts n bytes of
+ * whole units from src to dest, where n is a multiple of the unit size:
+ * the bytes of each unit are permuted (reversed in pairs, in quads, or by
+ * 16-bit halves) and the bits of every byte are optionally reversed, or
+ * their nibbles exchanged.  The swap functions keep handling the partial
+ * unit at the end of the last scanline themselves.
+ *
+ * Where the compiler targets SSE2 the bulk of a row is done sixteen bytes
+ * at a time; GCC-compatible x86 builds also carry AVX2 versions, chosen at
+ * run time, which use byte shuffles for both the permutation and the bit
+ * reversal and also cover the three-byte swap.
+ */
+
+#define PERM_NONE	0
+#define PERM_TWO	1
+#define PERM_FOUR	2
+#define PERM_WORDS	3
+#define PERM_THREE	4
+
+#define BITS_KEEP	0
+#define BITS_REVERSE	1
+#define BITS_NIBBLES	2
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SSE2_SWAP
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define USE_AVX2_SWAP
+#include <immintrin.h>
+#endif
+#endif
+
+#ifdef USE_SSE2_SWAP
+static _X_INLINE __m128i
+sse2_swap(__m128i x, int perm, int bits)
+{
+    if (perm == PERM_TWO || perm == PERM_FOUR)
+	x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    if (perm == PERM_FOUR || perm == PERM_WORDS)
+	x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1)),
+				_MM_SHUFFLE(2, 3, 0, 1));
+    if (bits != BITS_KEEP) {
+	/* 16-bit shifts; the masks drop what crosses into the other byte */
+	x = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(x, 4), _mm_set1_epi8(0x0f)),
+			 _mm_and_si128(_mm_slli_epi16(x, 4), _mm_set1_epi8((char)0xf0)));
+	if (bits == BITS_REVERSE) {
+	    x = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(x, 2), _mm_set1_epi8(0x33)),
+			     _mm_and_si128(_mm_slli_epi16(x, 2), _mm_set1_epi8((char)0xcc)));
+	    x = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(x, 1), _mm_set1_epi8(0x55)),
+			     _mm_and_si128(_mm_slli_epi16(x, 1), _mm_set1_epi8((char)0xaa)));
+	}
+    }
+    return x;
+}
+#endif
+
+#ifdef USE_AVX2_SWAP
+static const char avx2_perm_masks[5][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+    { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+    { 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 },
+    { 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -1, -1, -1, -1 }
+};
+
+/* reversed low nibble in the high half of the byte, and the other way */
+static const char avx2_rev_lo[16] = {
+    0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0,
+    0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0
+};
+static const char avx2_rev_hi[16] = {
+    0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe,
+    0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf
+};
+
+__attribute__((target("avx2")))
+static long
+avx2_swap_run(
+    const unsigned char *src,
+    unsigned char *dest,
+    long n,
+    int perm,
+    int bits)
+{
+    __m256i mask = _mm256_broadcastsi128_si256(
+	_mm_loadu_si128((const __m128i *) avx2_perm_masks[perm]));
+    __m256i rev_lo = _mm256_broadcastsi128_si256(
+	_mm_loadu_si128((const __m128i *) avx2_rev_lo));
+    __m256i rev_hi = _mm256_broadcastsi128_si256(
+	_mm_loadu_si128((const __m128i *) avx2_rev_hi));
+    __m256i low = _mm256_set1_epi8(0x0f);
+    long i = 0;
+
+    if (perm == PERM_THREE) {
+	/* four pixels per sixteen byte load, the last four bytes are junk */
+	for (; i + 16 <= n; i += 12) {
+	    __m128i x = _mm_loadu_si128((const __m128i *) (src + i));
+	    x = _mm_shuffle_epi8(x, _mm256_castsi256_si128(mask));
+	    _mm_storeu_si128((__m128i *) (dest + i), x);
+	}
+	return i;
+    }
+    for (; i + 32 <= n; i += 32) {
+	__m256i x = _mm256_loadu_si256((const __m256i *) (src + i));
+	if (perm != PERM_NONE)
+	    x = _mm256_shuffle_epi8(x, mask);
+	if (bits == BITS_REVERSE)
+	    x = _mm256_or_si256(
+		_mm256_shuffle_epi8(rev_lo, _mm256_and_si256(x, low)),
+		_mm256_shuffle_epi8(rev_hi,
+				    _mm256_and_si256(_mm256_srli_epi16(x, 4), low)));
+	else if (bits == BITS_NIBBLES)
+	    x = _mm256_or_si256(
+		_mm256_and_si256(_mm256_srli_epi16(x, 4), low),
+		_mm256_andnot_si256(low, _mm256_slli_epi16(x, 4)));
+	_mm256_storeu_si256((__m256i *) (dest + i), x);
+    }
+    return i;
+}
+
+static int
+have_avx2(void)
+{
+    static int avx2 = -1;
+
+    if (avx2 < 0) {
+	__builtin_cpu_init();
+	avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+    }
+    return avx2;
+}
+#endif
+
+static _X_INLINE void
+swap_run(
+    const unsigned char *src,
+    unsigned char *dest,
+    long n,
+    int perm,
+    int bits)
+{
+    const unsigned char *rev = bits == BITS_NIBBLES ? _reverse_nibs : _reverse_byte;
+    long i = 0;
+
+#ifdef USE_AVX2_SWAP
+    if (n >= 32 && have_avx2())
+	i = avx2_swap_run(src, dest, n, perm, bits);
+#endif
+#ifdef USE_SSE2_SWAP
+    if (perm != PERM_THREE)
+	for (; i + 16 <= n; i += 16)
+	    _mm_storeu_si128((__m128i *) (dest + i),
+			     sse2_swap(_mm_loadu_si128((const __m128i *) (src + i)),
+				       perm, bits));
+#endif
+    switch (perm) {
+    case PERM_NONE:
+	for (; i < n; i++)
+	    dest[i] = rev[src[i]];
+	break;
+    case PERM_TWO:
+	for (; i < n; i += 2) {
+	    unsigned char c = src[i];
+	    dest[i] = bits ? rev[src[i + 1]] : src[i + 1];
+	    dest[i + 1] = bits ? rev[c] : c;
+	}
+	break;
+    case PERM_THREE:
+	for (; i < n; i += 3) {
+	    unsigned char c = src[i];
+	    dest[i] = src[i + 2];
+	    dest[i + 1] = src[i + 1];
+	    dest[i + 2] = c;
+	}
+	break;
+    case PERM_FOUR:
+	for (; i < n; i += 4) {
+	    unsigned char c0 = src[i], c1 = src[i + 1];
+	    dest[i] = bits ? rev[src[i + 3]] : src[i + 3];
+	    dest[i + 1] = bits ? rev[src[i + 2]] : src[i + 2];
+	    dest[i + 2] = bits ? rev[c1] : c1;
+	    dest[i + 3] = bits ? rev[c0] : c0;
+	}
+	break;
+    case PERM_WORDS:
+	for (; i < n; i += 4) {
+	    unsigned char c0 = src[i], c1 = src[i + 1];
+	    dest[i] = bits ? rev[src[i + 2]] : src[i + 2];
+	    dest[i + 1] = bits ? rev[src[i + 3]] : src[i + 3];
+	    dest[i + 2] = bits ? rev[c0] : c0;
+	    dest[i + 3] = bits ? rev[c1] : c1;
+	}
+	break;
+    }
+}
+
 
 /* XXX the following functions are declared int instead of void because various
  * compilers and lints complain about later initialization of SwapFunc and/or
@@ -164,7 +362,7 @@ SwapTwoBytes (
     int half_order)
 {
     long length = ROUNDUP(srclen, 2);
-    register long h, n;
+    register long h;
 
     srcinc -= length;
     destinc -= length;
@@ -176,10 +374,9 @@ SwapTwoBytes (
 	    else
 		*(dest + length + 1) = *(src + length);
 	}
-	for (n = length; n > 0; n -= 2, src += 2) {
-	    *dest++ = *(src + 1);
-	    *dest++ = *src;
-	}
+	swap_run(src, dest, length, PERM_TWO, BITS_KEEP);
+	src += length;
+	dest += length;
     }
 }
 
@@ -192,7 +389,7 @@ SwapThreeBytes (
     int byte_order)
 {
     long length = ((srclen + 2) / 3) * 3;
-    register long h, n;
+    register long h;
 
     srcinc -= length;
     destinc -= length;
@@ -206,11 +403,9 @@ SwapThreeBytes (
 	    else
 		*(dest + length + 2) = *(src + length);
 	}
-	for (n = length; n > 0; n -= 3, src += 3) {
-	    *dest++ = *(src + 2);
-	    *dest++ = *(src + 1);
-	    *dest++ = *src;
-	}
+	swap_run(src, dest, length, PERM_THREE, BITS_KEEP);
+	src += length;
+	dest += length;
     }
 }
 
@@ -223,7 +418,7 @@ SwapFourBytes (
     int half_order)
 {
     long length = ROUNDUP(srclen, 4);
-    register long h, n;
+    register long h;
 
     srcinc -= length;
     destinc -= length;
@@ -241,12 +436,9 @@ SwapFourBytes (
 	    if (half_order == LSBFirst)
 		*(dest + length + 3) = *(src + length);
 	}
-	for (n = length; n > 0; n -= 4, src += 4) {
-	    *dest++ = *(src + 3);
-	    *dest++ = *(src + 2);
-	    *dest++ = *(src + 1);
-	    *dest++ = *src;
-	}
+	swap_run(src, dest, length, PERM_FOUR, BITS_KEEP);
+	src += length;
+	dest += length;
     }
 }
 
@@ -259,7 +451,7 @@ SwapWords (
     int half_order)
 {
     long length = ROUNDUP(srclen, 4);
-    register long h, n;
+    register long h;
 
     srcinc -= length;
     destinc -= length;
@@ -277,12 +469,9 @@ SwapWords (
 	    if (half_order == LSBFirst)
 		*(dest + length + 2) = *(src + length);
 	}
-	for (n = length; n > 0; n -= 4, src += 2) {
-	    *dest++ = *(src + 2);
-	    *dest++ = *(src + 3);
-	    *dest++ = *src++;
-	    *dest++ = *src++;
-	}
+	swap_run(src, dest, length, PERM_WORDS, BITS_KEEP);
+	src += length;
+	dest += length;
     }
 }
 
@@ -293,14 +482,10 @@ SwapNibbles(
     long srclen, long srcinc, long destinc,
     unsigned int height)
 {
-    register long h, n;
-    register const unsigned char *rev = _reverse_nibs;
+    register long h;
 
-    srcinc -= srclen;
-    destinc -= srclen;
     for (h = height; --h >= 0; src += srcinc, dest += destinc)
-	for (n = srclen; --n >= 0; )
-	    *dest++ = rev[*src++];
+	swap_run(src, dest, srclen, PERM_NONE, BITS_NIBBLES);
 }
 
 static void
@@ -342,14 +527,10 @@ SwapBits(
     unsigned int height,
     int half_order)
 {
-    register long h, n;
-    register const unsigned char *rev = _reverse_byte;
+    register long h;
 
-    srcinc -= srclen;
-    destinc -= srclen;
     for (h = height; --h >= 0; src += srcinc, dest += destinc)
-	for (n = srclen; --n >= 0; )
-	    *dest++ = rev[*src++];
+	swap_run(src, dest, srclen, PERM_NONE, BITS_REVERSE);
 }
 
 static void
@@ -361,7 +542,7 @@ SwapBitsAndTwoBytes(
     int half_order)
 {
     long length = ROUNDUP(srclen, 2);
-    register long h, n;
+    register long h;
     register const unsigned char *rev = _reverse_byte;
 
     srcinc -= length;
@@ -374,10 +555,9 @@ SwapBitsAndTwoBytes(
 	    else
 		*(dest + length + 1) = rev[*(src + length)];
 	}
-	for (n = length; n > 0; n -= 2, src += 2) {
-	    *dest++ = rev[*(src + 1)];
-	    *dest++ = rev[*src];
-	}
+	swap_run(src, dest, length, PERM_TWO, BITS_REVERSE);
+	src += length;
+	dest += length;
     }
 }
 
@@ -390,7 +570,7 @@ SwapBitsAndFourBytes(
     int half_order)
 {
     long length = ROUNDUP(srclen, 4);
-    register long h, n;
+    register long h;
     register const unsigned char *rev = _reverse_byte;
 
     srcinc -= length;
@@ -409,12 +589,9 @@ SwapBitsAndFourBytes(
 	    if (half_order == LSBFirst)
 		*(dest + length + 3) = rev[*(src + length)];
 	}
-	for (n = length; n > 0; n -= 4, src += 4) {
-	    *dest++ = rev[*(src + 3)];
-	    *dest++ = rev[*(src + 2)];
-	    *dest++ = rev[*(src + 1)];
-	    *dest++ = rev[*src];
-	}
+	swap_run(src, dest, length, PERM_FOUR, BITS_REVERSE);
+	src += length;
+	dest += length;
     }
 }
 
@@ -427,7 +604,7 @@ SwapBitsAndWords(
     int half_order)
 {
     long length = ROUNDUP(srclen, 4);
-    register long h, n;
+    register long h;
     register const unsigned char *rev = _reverse_byte;
 
     srcinc -= length;
@@ -446,12 +623,9 @@ SwapBitsAndWords(
 	    if (half_order == LSBFirst)
 		*(dest + length + 2) = rev[*(src + length)];
 	}
-	for (n = length; n > 0; n -= 4, src += 2) {
-	    *dest++ = rev[*(src + 2)];
-	    *dest++ = rev[*(src + 3)];
-	    *dest++ = rev[*src++];
-	    *dest++ = rev[*src++];
-	}
+	swap_run(src, dest, length, PERM_WORDS, BITS_REVERSE);
+	src += length;
+	dest += length;
     }
 }
 
@@ -599,6 +773,10 @@ static int const HalfOrderWord[12] = {
 		     + (((bitmap_bit_order == MSBFirst) ? 0 : 3)		\
 		     + ((byte_order == MSBFirst) ? 0 : 6)))
 
+/* Rows at least this long are sent straight from the image with _XSendv
+ * when they need no swapping; shorter ones are cheaper to copy. */
+#define MIN_VEC_ROW 256
+
 /* Cancel a GetReq operation, before doing _XSend or Data */
 
 #define UnGetReq(name)\
@@ -798,6 +976,35 @@ SendZImage(
     }
 
     length = ROUNDUP(length, 4);
+
+    /* The scanlines are not contiguous in the image, but need no swapping:
+     * send each one from where it is, followed by its padding. */
+    if (((image->byte_order == dpy->byte_order) ||
+	 (image->bits_per_pixel == 8)) &&
+	(bytes_per_src >= MIN_VEC_ROW) &&
+	((dpy->bufptr + length) > dpy->bufmax)) {
+	static char const pad[4];
+	long pad_length = bytes_per_dest - bytes_per_src;
+	int nvec = pad_length ? 2 * req->height : req->height;
+	_XDataVec *vec;
+	int i;
+
+	if ((vec = (_XDataVec *)
+	     _XAllocScratch(dpy, nvec * sizeof(_XDataVec))) != NULL) {
+	    for (i = 0; i < nvec; src += image->bytes_per_line) {
+		vec[i].data = (char *)src;
+		vec[i++].size = bytes_per_src;
+		if (pad_length) {
+		    vec[i].data = pad;
+		    vec[i++].size = pad_length;
+		}
+	    }
+	    _XSendv(dpy, vec, nvec);
+	    Xfree(shifted_src);
+	    return;
+	}
+    }
+
     if ((dpy->bufptr + length) <= dpy->bufmax)
 	dest = (unsigned char *)dpy->bufptr;
     else
@@ -978,8 +1185,9 @@ XPutImage (
 	    }
 	if (dest_bits_per_pixel != image->bits_per_pixel) {
 	    XImage img;
-	    register long i, j;
-	    /* XXX slow, but works */
+	    CARD32 pixels[256];
+	    long i, j, n;
+	    /* convert through a row of normalized pixels */
 	    img.width = width;
 	    img.height = height;
 	    img.xoffset = 0;
@@ -996,10 +1204,13 @@ XPutImage (
 	    if (img.data == NULL)
 		return 0;
 	    _XInitImageFuncPtrs(&img);
-	    for (j = height; --j >= 0; )
-		for (i = width; --i >= 0; )
-		    XPutPixel(&img, i, j, XGetPixel(image, req_xoffset + i,
-						    req_yoffset + j));
+	    for (j = 0; j < height; j++)
+		for (i = 0; i < width; i += n) {
+		    n = width - i < 256 ? width - i : 256;
+		    _XGetImageRow(image, req_xoffset + i, req_yoffset + j,
+				  (unsigned int) n, pixels);
+		    _XPutImageRow(&img, i, j, (unsigned int) n, pixels);
+		}
 	    LockDisplay(dpy);
 	    FlushGC(dpy, gc);
 	    PutSubImage(dpy, d, gc, &img, 0, 0, x, y,
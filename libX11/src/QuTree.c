@@ -70,3 +70,127 @@ Status XQueryTree (
     return (1);
 }
 
+
+typedef struct {
+    uint64_t start_seq;
+    uint64_t stop_seq;
+    Window *roots;
+    Window *parents;
+    Window **children;
+    unsigned int *nchildren;
+    int replies;
+    Status status;
+} _XQueryTreesState;
+
+static
+Bool _XQueryTreesHandler(
+    register Display *dpy,
+    register xReply *rep,
+    char *buf,
+    int len,
+    XPointer data)
+{
+    register _XQueryTreesState *state;
+    xQueryTreeReply replbuf;
+    register xQueryTreeReply *repl;
+    Window *children = (Window *) NULL;
+    int i;
+    uint64_t last_request_read = X_DPY_GET_LAST_REQUEST_READ(dpy);
+
+    state = (_XQueryTreesState *)data;
+    if (last_request_read < state->start_seq ||
+	last_request_read > state->stop_seq)
+	return False;
+    if (rep->generic.type == X_Error) {
+	state->status = 0;
+	return False;
+    }
+    i = (int)(last_request_read - state->start_seq);
+    repl = (xQueryTreeReply *)
+	_XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+			(SIZEOF(xQueryTreeReply) - SIZEOF(xReply)) >> 2,
+			False);
+    state->replies++;
+    if (repl->nChildren != 0) {
+	children = Xmallocarray(repl->nChildren, sizeof(Window));
+	_XGetAsyncData(dpy, (char *) children, buf, len,
+		       SIZEOF(xQueryTreeReply),
+		       children ? repl->nChildren << 2 : 0,
+		       repl->length << 2);
+	if (!children) {
+	    state->status = 0;
+	    return True;
+	}
+#ifdef LONG64
+	{
+	    register CARD32 *ibuf = (CARD32 *)children + repl->nChildren;
+	    register Window *wbuf = children + repl->nChildren;
+	    register unsigned long n = repl->nChildren;
+
+	    while (n-- > 0)
+		*--wbuf = *--ibuf;
+	}
+#endif
+    }
+    state->roots[i] = repl->root;
+    state->parents[i] = repl->parent;
+    state->children[i] = children;
+    state->nchildren[i] = repl->nChildren;
+    return True;
+}
+
+/*
+ * XQueryTree for count windows, with one round trip for all of them.
+ * Entries whose request failed have no children, and the return value
+ * is zero.  Each children array is freed with XFree.
+ */
+Status XQueryTrees (
+    register Display *dpy,
+    Window *windows,
+    int count,
+    Window *roots,	/* RETURN */
+    Window *parents,	/* RETURN */
+    Window **children,	/* RETURN */
+    unsigned int *nchildren)  /* RETURN */
+{
+    _XAsyncHandler async;
+    _XQueryTreesState async_state;
+    xGetInputFocusReply rep;
+    register xResourceReq *req;
+    _X_UNUSED register xReq *sync;
+    int i;
+
+    for (i = 0; i < count; i++) {
+	roots[i] = parents[i] = None;
+	children[i] = (Window *) NULL;
+	nchildren[i] = 0;
+    }
+    if (count <= 0)
+	return (1);
+
+    LockDisplay(dpy);
+    async_state.start_seq = X_DPY_GET_REQUEST(dpy) + 1;
+    async_state.roots = roots;
+    async_state.parents = parents;
+    async_state.children = children;
+    async_state.nchildren = nchildren;
+    async_state.replies = 0;
+    async_state.status = 1;
+    async.next = dpy->async_handlers;
+    async.handler = _XQueryTreesHandler;
+    async.data = (XPointer)&async_state;
+    dpy->async_handlers = &async;
+    for (i = 0; i < count; i++) {
+	GetResReq(QueryTree, windows[i], req);
+    }
+    async_state.stop_seq = X_DPY_GET_REQUEST(dpy);
+    /* every tree reply reaches the handler before this one */
+    GetEmptyReq(GetInputFocus, sync);
+    (void) _XReply (dpy, (xReply *)&rep, 0, xTrue);
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    if (async_state.replies != count)
+	async_state.status = 0;
+    return async_state.status;
+}
@@ -75,27 +75,26 @@ _XInitKeysymDB(void)
 KeySym
 XStringToKeysym(_Xconst char *s)
 {
-    register int i, n;
-    int h;
+    register int i;
     register Signature sig = 0;
+    register unsigned int h = 5381 + KHASHSEED;
     register const char *p = s;
     register int c;
     register int idx;
     const unsigned char *entry;
-    unsigned char sig1, sig2;
     KeySym val;
 
-    while ((c = *p++))
+    while ((c = *p++)) {
 	sig = (sig << 1) + c;
-    i = sig % KTABLESIZE;
-    h = i + 1;
-    sig1 = (sig >> 8) & 0xff;
-    sig2 = sig & 0xff;
-    n = KMAXHASH;
-    while ((idx = hashString[i]))
+	h = (h * 33) ^ (unsigned char) c;
+    }
+    /* every name in the table has a slot of its own */
+    idx = hashString[_XKeysymHashSlot(h, displaceString[h % KBUCKETS],
+				      KTABLESIZE)];
+    if (idx)
     {
 	entry = &_XkeyTable[idx];
-	if ((entry[0] == sig1) && (entry[1] == sig2) &&
+	if ((entry[0] == ((sig >> 8) & 0xff)) && (entry[1] == (sig & 0xff)) &&
 	    !strcmp(s, (const char *)entry + 6))
 	{
 	    val = (entry[2] << 24) | (entry[3] << 16) |
@@ -104,11 +103,6 @@ XStringToKeysym(_Xconst char *s)
 		val = XK_VoidSymbol;
 	    return val;
 	}
-	if (!--n)
-	    break;
-	i += h;
-	if (i >= KTABLESIZE)
-	    i -= KTABLESIZE;
     }
 
     if (!initialized)
@@ -171,10 +171,14 @@ typedef struct _NTable {
 typedef struct _LTable {
     NTableRec		table;
     VEntry		*buckets;
+    unsigned long	filter;		/* QuarkBit of every value name */
 } LTableRec, *LTable;
 
 #define LeafHash(le,q) (le)->buckets[(q) & (le)->table.mask]
 
+/* a leaf table can only hold q if its filter has this bit set */
+#define QuarkBit(q) (1UL << ((unsigned long)(q) % (sizeof(unsigned long) << 3)))
+
 /* An XrmDatabase just holds a pointer to the first top-level table.
  * The type name is no longer descriptive, but better to not change
  * the Xresource.h header file.  This type also gets used to define
@@ -185,11 +189,30 @@ typedef struct _XrmHashBucketRec {
     NTable table;
     XPointer mbstate;
     XrmMethods methods;
+    struct _SCacheEntry **scache;	/* recent search lists, or NULL */
 #ifdef XTHREADS
     LockInfoRec linfo;
 #endif
 } XrmHashBucketRec;
 
+/* A search list computed earlier, with the names and classes it was
+ * computed for.  The list, including its NULL terminator, follows the
+ * structure, then the names, then the classes.  Any change to the
+ * database drops all of them.
+ */
+typedef struct _SCacheEntry {
+    unsigned long	hash;		/* SearchHash of names and classes */
+    int			depth;		/* number of names */
+    int			length;		/* list entries, without the NULL */
+} SCacheEntryRec, *SCacheEntry;
+
+#define SCacheList(se) ((LTable *)((se) + 1))
+#define SCacheNames(se) ((XrmQuarkList)(SCacheList(se) + (se)->length + 1))
+#define SCacheClasses(se) (SCacheNames(se) + (se)->depth)
+
+/* number of search lists remembered per database */
+#define SCACHE_SIZE 256
+
 /* closure used in get/put resource */
 typedef struct _VClosure {
     XrmRepresentation	*type;		/* type of value */
@@ -234,8 +257,9 @@ typedef Bool (*getNTableEProcp)(
     register int        level,
     EClosure            closure);
 
-/* predicate to determine when to resize a hash table */
-#define GrowthPred(n,m) ((unsigned)(n) > (((m) + 1) << 2))
+/* predicate to determine when to resize a hash table; tables are
+ * looked up far more often than they are built, so keep chains short */
+#define GrowthPred(n,m) ((unsigned)(n) > ((m) + 1))
 
 #define GROW(prev) \
     if (GrowthPred((*prev)->entries, (*prev)->mask)) \
@@ -499,6 +523,7 @@ static XrmDatabase NewDatabase(void)
     if (db) {
 	_XCreateMutex(&db->linfo);
 	db->table = (NTable)NULL;
+	db->scache = (SCacheEntry *)NULL;
 	db->mbstate = (XPointer)NULL;
 	db->methods = _XrmInitParseInfo(&db->mbstate);
 	if (!db->methods)
@@ -507,6 +532,20 @@ static XrmDatabase NewDatabase(void)
     return db;
 }
 
+/* forget all remembered search lists, the database is changing */
+static void FlushSearchLists(
+    XrmDatabase db)
+{
+    int i;
+
+    if (!db->scache)
+	return;
+    for (i = 0; i < SCACHE_SIZE; i++)
+	Xfree(db->scache[i]);
+    Xfree(db->scache);
+    db->scache = (SCacheEntry *)NULL;
+}
+
 /* move all values from ftable to ttable, and free ftable's buckets.
  * ttable is guaranteed empty to start with.
  */
@@ -618,6 +657,7 @@ static void MergeValues(
     ttable = (LTable)*pprev;
     if (ftable->table.hasloose)
 	ttable->table.hasloose = 1;
+    ttable->filter |= ftable->filter;
     for (i = ftable->table.mask, bucket = ftable->buckets;
 	 i >= 0;
 	 i--, bucket++) {
@@ -768,6 +808,8 @@ void XrmCombineDatabase(
     } else if (from) {
 	_XLockMutex(&from->linfo);
 	_XLockMutex(&(*into)->linfo);
+	FlushSearchLists(from);
+	FlushSearchLists(*into);
 	if ((ftable = from->table)) {
 	    prev = &(*into)->table;
 	    ttable = *prev;
@@ -846,6 +888,7 @@ static void PutEntry(
 	    return; \
         } \
 	((LTable)table)->buckets = (VEntry *)nprev; \
+	((LTable)table)->filter = 0; \
     } \
     *nprev = (NTable)NULL; \
     table->next = *prev; \
@@ -853,6 +896,7 @@ static void PutEntry(
 
     if (!db || !*quarks)
 	return;
+    FlushSearchLists(db);
     table = *(prev = &db->table);
     /* if already at leaf, bump to the leaf table */
     if (!quarks[1] && table && !table->leaf)
@@ -979,6 +1023,7 @@ static void PutEntry(
     /* save a copy of the value */
     memcpy(RawValue(entry), (char *)value->addr, value->size);
     (*pprev)->entries++;
+    ((LTable)*pprev)->filter |= QuarkBit(q);
     /* this is a new leaf, need to remember it for search lists */
     if (q > maxResourceQuark) {
 	unsigned oldsize = (maxResourceQuark + 1) >> 3;
@@ -2252,6 +2297,66 @@ static Bool SearchNEntry(
     return False;
 }
 
+static unsigned long SearchHash(
+    XrmNameList		names,
+    XrmClassList	classes,
+    int			depth)
+{
+    unsigned long hash = depth;
+
+    while (--depth >= 0)
+	hash = (hash * 31 + *names++) * 31 + *classes++;
+    return hash;
+}
+
+/* find the remembered search list for exactly these names and classes */
+static SCacheEntry FindSearchList(
+    XrmDatabase		db,
+    XrmNameList		names,
+    XrmClassList	classes,
+    int			depth,
+    unsigned long	hash)
+{
+    SCacheEntry se;
+
+    if (!db->scache || !(se = db->scache[hash % SCACHE_SIZE]))
+	return (SCacheEntry)NULL;
+    if (se->hash != hash || se->depth != depth ||
+	memcmp(SCacheNames(se), names, depth * sizeof(XrmQuark)) ||
+	memcmp(SCacheClasses(se), classes, depth * sizeof(XrmQuark)))
+	return (SCacheEntry)NULL;
+    return se;
+}
+
+static void SaveSearchList(
+    XrmDatabase		db,
+    XrmNameList		names,
+    XrmClassList	classes,
+    int			depth,
+    unsigned long	hash,
+    LTable		*list,
+    int			length)
+{
+    SCacheEntry se, *slot;
+
+    if (!db->scache &&
+	!(db->scache = Xcalloc(SCACHE_SIZE, sizeof(SCacheEntry))))
+	return;
+    se = Xmalloc(sizeof(SCacheEntryRec) + (length + 1) * sizeof(LTable) +
+		 2 * depth * sizeof(XrmQuark));
+    if (!se)
+	return;
+    se->hash = hash;
+    se->depth = depth;
+    se->length = length;
+    memcpy(SCacheList(se), list, (length + 1) * sizeof(LTable));
+    memcpy(SCacheNames(se), names, depth * sizeof(XrmQuark));
+    memcpy(SCacheClasses(se), classes, depth * sizeof(XrmQuark));
+    slot = &db->scache[hash % SCACHE_SIZE];
+    Xfree(*slot);
+    *slot = se;
+}
+
 Bool XrmQGetSearchList(
     XrmDatabase     db,
     XrmNameList	    names,
@@ -2261,6 +2366,9 @@ Bool XrmQGetSearchList(
 {
     register NTable	table;
     SClosureRec		closure;
+    SCacheEntry		se;
+    unsigned long	hash;
+    int			depth;
 
     if (listLength <= 0)
 	return False;
@@ -2269,6 +2377,18 @@ Bool XrmQGetSearchList(
     closure.limit = listLength - 2;
     if (db) {
 	_XLockMutex(&db->linfo);
+	for (depth = 0; names[depth]; depth++)
+	    ;
+	hash = SearchHash(names, classes, depth);
+	if ((se = FindSearchList(db, names, classes, depth, hash))) {
+	    /* same outcome as searching again: fails only if too long */
+	    Bool fits = se->length < listLength;
+	    if (fits)
+		memcpy(searchList, SCacheList(se),
+		       (se->length + 1) * sizeof(LTable));
+	    _XUnlockMutex(&db->linfo);
+	    return fits;
+	}
 	table = db->table;
 	if (*names) {
 	    if (table && !table->leaf) {
@@ -2291,7 +2411,11 @@ Bool XrmQGetSearchList(
 		return False;
 	    }
 	}
+	closure.list[closure.idx + 1] = (LTable)NULL;
+	SaveSearchList(db, names, classes, depth, hash,
+		       closure.list, closure.idx + 1);
 	_XUnlockMutex(&db->linfo);
+	return True;
     }
     closure.list[closure.idx + 1] = (LTable)NULL;
     return True;
@@ -2310,23 +2434,27 @@ Bool XrmQGetSearchResource(
     int flags;
 
 /* find tight or loose entry */
-#define VTIGHTLOOSE(q) \
-    entry = LeafHash(table, q); \
-    while (entry && entry->name != q) \
-	entry = entry->next; \
-    if (entry) \
-	break
+#define VTIGHTLOOSE(q,bit) \
+    if (table->filter & bit) { \
+	entry = LeafHash(table, q); \
+	while (entry && entry->name != q) \
+	    entry = entry->next; \
+	if (entry) \
+	    break; \
+    }
 
 /* find loose entry */
-#define VLOOSE(q) \
-    entry = LeafHash(table, q); \
-    while (entry && entry->name != q) \
-	entry = entry->next; \
-    if (entry) { \
-	if (!entry->tight) \
-	    break; \
-	if ((entry = entry->next) && entry->name == q) \
-	    break; \
+#define VLOOSE(q,bit) \
+    if (table->filter & bit) { \
+	entry = LeafHash(table, q); \
+	while (entry && entry->name != q) \
+	    entry = entry->next; \
+	if (entry) { \
+	    if (!entry->tight) \
+		break; \
+	    if ((entry = entry->next) && entry->name == q) \
+		break; \
+	} \
     }
 
     list = (LTable *)searchList;
@@ -2341,26 +2469,29 @@ Bool XrmQGetSearchResource(
 	table = (LTable)NULL;
     } else if (flags == 3) {
 	/* both name and class */
+	unsigned long namebit = QuarkBit(name), classbit = QuarkBit(class);
 	while ((table = *list++)) {
 	    if (table != LOOSESEARCH) {
-		VTIGHTLOOSE(name);  /* do name, tight and loose */
-		VTIGHTLOOSE(class); /* do class, tight and loose */
+		VTIGHTLOOSE(name, namebit);   /* do name, tight and loose */
+		VTIGHTLOOSE(class, classbit); /* do class, tight and loose */
 	    } else {
 		table = *list++;
-		VLOOSE(name);  /* do name, loose only */
-		VLOOSE(class); /* do class, loose only */
+		VLOOSE(name, namebit);   /* do name, loose only */
+		VLOOSE(class, classbit); /* do class, loose only */
 	    }
 	}
     } else {
 	/* just one of name or class */
+	unsigned long namebit;
 	if (flags == 1)
 	    name = class;
+	namebit = QuarkBit(name);
 	while ((table = *list++)) {
 	    if (table != LOOSESEARCH) {
-		VTIGHTLOOSE(name); /* tight and loose */
+		VTIGHTLOOSE(name, namebit); /* tight and loose */
 	    } else {
 		table = *list++;
-		VLOOSE(name); /* loose only */
+		VLOOSE(name, namebit); /* loose only */
 	    }
 	}
     }
@@ -2397,13 +2528,13 @@ static Bool GetVEntry(
 
     /* try name first */
     q = *names;
-    entry = LeafHash(table, q);
+    entry = (table->filter & QuarkBit(q)) ? LeafHash(table, q) : NULL;
     while (entry && entry->name != q)
 	entry = entry->next;
     if (!entry) {
 	/* not found, try class */
 	q = *classes;
-	entry = LeafHash(table, q);
+	entry = (table->filter & QuarkBit(q)) ? LeafHash(table, q) : NULL;
 	while (entry && entry->name != q)
 	    entry = entry->next;
 	if (!entry)
@@ -2432,7 +2563,7 @@ static Bool GetLooseVEntry(
 
 #define VLOOSE(ename) \
     q = ename; \
-    entry = LeafHash(table, q); \
+    entry = (table->filter & QuarkBit(q)) ? LeafHash(table, q) : NULL; \
     while (entry && entry->name != q) \
 	entry = entry->next; \
     if (entry && entry->tight && (entry = entry->next) && entry->name != q) \
@@ -2651,6 +2782,7 @@ void XrmDestroyDatabase(
 
     if (db) {
 	_XLockMutex(&db->linfo);
+	FlushSearchLists(db);
 	for (next = db->table; (table = next); ) {
 	    next = table->next;
 	    if (table->leaf)
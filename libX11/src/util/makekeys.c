@@ -52,15 +52,112 @@ static struct info {
     KeySym	val;
 } info[KTNUM];
 
-#define MIN_REHASH 15
-#define MATCHES 10
-
-static char tab[KTNUM];
-static unsigned short offsets[KTNUM];
+/* table slots per key, as a fraction: 5/4 */
+#define SLOTS(n) ((n) + (n) / 4 + 1)
+/* keys per displacement bucket */
+#define BUCKET_KEYS 4
+#define MAX_SEED 64
+
+static unsigned short offsets[SLOTS(KTNUM)];
+static unsigned short displace[KTNUM];
+static int slots[SLOTS(KTNUM)];
 static unsigned short indexes[KTNUM];
-static KeySym values[KTNUM];
 static int ksnum = 0;
 
+/* Must match _XKeysymHashSlot in ../Key.h. */
+static unsigned int
+hash_slot(Signature h, unsigned int d, unsigned int size)
+{
+    h = (h + d) * 0x9e3779b1U;
+    return (h ^ (h >> 15)) % size;
+}
+
+static int bucket_count[KTNUM];
+
+static int
+larger_bucket(const void *a, const void *b)
+{
+    int na = bucket_count[*(const int *) a], nb = bucket_count[*(const int *) b];
+
+    if (na != nb)
+	return nb - na;
+    return *(const int *) a - *(const int *) b;
+}
+
+/*
+ * Builds a perfect hash over n distinct hash values: key i lives in slot
+ * hash_slot(hashes[i], disp[hashes[i] % buckets], size), and no two
+ * keys share a slot.  slot_keys[] receives the key index plus one for every
+ * used slot and zero elsewhere.  The buckets are placed largest first,
+ * each with the smallest displacement that fits all of its keys into free
+ * slots.  Returns 0 if some bucket can't be placed.
+ */
+static int
+build_perfect_hash(const Signature *hashes, int n, int *size_out,
+		   int *buckets_out, unsigned short *disp, int *slot_keys)
+{
+    static int first[KTNUM], next[KTNUM], order[KTNUM];
+    int size = SLOTS(n), buckets = n / BUCKET_KEYS + 1;
+    int b, i, j, k, d;
+
+    for (b = 0; b < buckets; b++) {
+	first[b] = -1;
+	bucket_count[b] = 0;
+	disp[b] = 0;
+	order[b] = b;
+    }
+    for (i = 0; i < n; i++) {
+	b = hashes[i] % buckets;
+	next[i] = first[b];
+	first[b] = i;
+	bucket_count[b]++;
+    }
+    qsort(order, buckets, sizeof(int), larger_bucket);
+    for (i = 0; i < size; i++)
+	slot_keys[i] = 0;
+
+    for (k = 0; k < buckets && bucket_count[order[k]]; k++) {
+	b = order[k];
+	for (d = 0; d < 0x10000; d++) {
+	    for (i = first[b]; i >= 0; i = next[i]) {
+		unsigned int s = hash_slot(hashes[i], d, size);
+		if (slot_keys[s])
+		    break;
+		slot_keys[s] = i + 1;
+	    }
+	    if (i < 0)
+		break;
+	    /* undo the keys placed before the collision */
+	    for (j = first[b]; j != i; j = next[j])
+		slot_keys[hash_slot(hashes[j], d, size)] = 0;
+	}
+	if (d == 0x10000)
+	    return 0;
+	disp[b] = d;
+    }
+    *size_out = size;
+    *buckets_out = buckets;
+    return 1;
+}
+
+static void
+print_shorts(const char *name, const char *size_name,
+	     const unsigned short *values, int n)
+{
+    int i;
+
+    printf("static const unsigned short %s[%s] = {\n", name, size_name);
+    for (i = 0; i < n;) {
+	printf("0x%.4x", values[i]);
+	i++;
+	if (i == n)
+	    break;
+	printf((i & 7) ? ", " : ",\n");
+    }
+    printf("\n");
+    printf("};\n");
+}
+
 static int
 parse_line(const char *buf, char *key, KeySym *val, char *prefix)
 {
@@ -107,16 +204,16 @@ parse_line(const char *buf, char *key, KeySym *val, char *prefix)
 int
 main(int argc, char *argv[])
 {
-    int max_rehash;
     Signature sig;
-    int i, j, k, l, z;
+    Signature *hashes;
+    int *keys;
+    int nkeys;
+    unsigned int seed;
+    int ktable_size, kbuckets, vtable_size, vbuckets;
+    int i, j, k, l;
     FILE *fptr;
     char *name;
     char c;
-    int first;
-    int best_max_rehash;
-    int best_z = 0;
-    int num_found;
     KeySym val;
     char key[128], prefix[128];
     static char buf[1024];
@@ -162,47 +259,43 @@ main(int argc, char *argv[])
     printf("/* Do not edit. */\n");
     printf("\n");
 
-    best_max_rehash = ksnum;
-    num_found = 0;
-    for (z = ksnum; z < KTNUM; z++) {
-	max_rehash = 0;
-	for (name = &tab[0], i = z; --i >= 0;)
-		*name++ = 0;
+    /*
+     * The name table: every name gets its own slot, so XStringToKeysym
+     * hashes the name once and compares it with a single entry.  Later
+     * definitions of a name already seen are dropped; the first one was
+     * the one found before as well.
+     */
+    hashes = calloc(ksnum, sizeof(Signature));
+    keys = calloc(ksnum, sizeof(*keys));
+    if (!hashes || !keys) {
+	fprintf(stderr, "makekeys: out of memory!\n");
+	exit(1);
+    }
+    for (seed = 0; ; seed++) {
+	nkeys = 0;
 	for (i = 0; i < ksnum; i++) {
-	    name = info[i].name;
-	    sig = 0;
-	    while ((c = *name++))
-		sig = (sig << 1) + c;
-	    first = j = sig % z;
-	    for (k = 0; tab[j]; k++) {
-		j += first + 1;
-		if (j >= z)
-		    j -= z;
-		if (j == first)
-		    goto next1;
-	    }
-	    tab[j] = 1;
-	    if (k > max_rehash)
-		max_rehash = k;
+	    Signature h = 5381 + seed;
+
+	    for (j = 0; j < i; j++)
+		if (strcmp(info[j].name, info[i].name) == 0)
+		    break;
+	    if (j < i)
+		continue;
+	    for (name = info[i].name; (c = *name++); )
+		h = (h * 33) ^ (unsigned char) c;
+	    hashes[nkeys] = h;
+	    keys[nkeys] = i;
+	    nkeys++;
 	}
-	if (max_rehash < MIN_REHASH) {
-	    if (max_rehash < best_max_rehash) {
-		best_max_rehash = max_rehash;
-		best_z = z;
-	    }
-	    num_found++;
-	    if (num_found >= MATCHES)
-		break;
+	if (build_perfect_hash(hashes, nkeys, &ktable_size, &kbuckets,
+			       displace, slots))
+	    break;
+	if (seed == MAX_SEED) {
+	    fprintf(stderr, "makekeys: failed to build the name hash!\n");
+	    exit(1);
 	}
-next1:	;
     }
 
-    z = best_z;
-    if (z == 0) {
-	fprintf(stderr, "makekeys: failed to find small enough hash!\n"
-		"Try increasing KTNUM in makekeys.c\n");
-	exit(1);
-    }
     printf("#ifdef NEEDKTABLE\n");
     printf("const unsigned char _XkeyTable[] = {\n");
     printf("0,\n");
@@ -212,13 +305,6 @@ next1:	;
 	sig = 0;
 	while ((c = *name++))
 	    sig = (sig << 1) + c;
-	first = j = sig % z;
-	while (offsets[j]) {
-	    j += first + 1;
-	    if (j >= z)
-		j -= z;
-	}
-	offsets[j] = k;
 	indexes[i] = k;
 	val = info[i].val;
 	printf("0x%.2"PRIx32", 0x%.2"PRIx32", 0x%.2lx, 0x%.2lx, 0x%.2lx, 0x%.2lx, ",
@@ -231,94 +317,45 @@ next1:	;
     }
     printf("};\n");
     printf("\n");
-    printf("#define KTABLESIZE %d\n", z);
-    printf("#define KMAXHASH %d\n", best_max_rehash + 1);
-    printf("\n");
-    printf("static const unsigned short hashString[KTABLESIZE] = {\n");
-    for (i = 0; i < z;) {
-	printf("0x%.4x", offsets[i]);
-	i++;
-	if (i == z)
-	    break;
-	printf((i & 7) ? ", " : ",\n");
-    }
+    for (i = 0; i < ktable_size; i++)
+	offsets[i] = slots[i] ? indexes[keys[slots[i] - 1]] : 0;
+    printf("#define KHASHSEED %uU\n", seed);
+    printf("#define KTABLESIZE %d\n", ktable_size);
+    printf("#define KBUCKETS %d\n", kbuckets);
     printf("\n");
-    printf("};\n");
+    print_shorts("hashString", "KTABLESIZE", offsets, ktable_size);
+    print_shorts("displaceString", "KBUCKETS", displace, kbuckets);
     printf("#endif /* NEEDKTABLE */\n");
 
-    best_max_rehash = ksnum;
-    num_found = 0;
-    for (z = ksnum; z < KTNUM; z++) {
-	max_rehash = 0;
-	for (name = tab, i = z; --i >= 0;)
-		*name++ = 0;
-	for (i = 0; i < ksnum; i++) {
-	    val = info[i].val;
-	    first = j = val % z;
-	    for (k = 0; tab[j]; k++) {
-		if (values[j] == val)
-		    goto skip1;
-		j += first + 1;
-		if (j >= z)
-		    j -= z;
-		if (j == first)
-		    goto next2;
-	    }
-	    tab[j] = 1;
-	    values[j] = val;
-	    if (k > max_rehash)
-		max_rehash = k;
-skip1:	;
-	}
-	if (max_rehash < MIN_REHASH) {
-	    if (max_rehash < best_max_rehash) {
-		best_max_rehash = max_rehash;
-		best_z = z;
-	    }
-	    num_found++;
-	    if (num_found >= MATCHES)
+    /*
+     * The keysym table: one slot per distinct value, pointing at the
+     * first name defined for it.
+     */
+    nkeys = 0;
+    for (i = 0; i < ksnum; i++) {
+	for (j = 0; j < nkeys; j++)
+	    if (info[keys[j]].val == info[i].val)
 		break;
-	}
-next2:	;
+	if (j < nkeys)
+	    continue;
+	hashes[nkeys] = info[i].val;
+	keys[nkeys] = i;
+	nkeys++;
     }
-
-    z = best_z;
-    if (z == 0) {
-	fprintf(stderr, "makekeys: failed to find small enough hash!\n"
-		"Try increasing KTNUM in makekeys.c\n");
+    if (!build_perfect_hash(hashes, nkeys, &vtable_size, &vbuckets,
+			    displace, slots)) {
+	fprintf(stderr, "makekeys: failed to build the keysym hash!\n");
 	exit(1);
     }
-    for (i = z; --i >= 0;)
-	offsets[i] = 0;
-    for (i = 0; i < ksnum; i++) {
-	val = info[i].val;
-	first = j = val % z;
-	while (offsets[j]) {
-	    if (values[j] == val)
-		goto skip2;
-	    j += first + 1;
-	    if (j >= z)
-		j -= z;
-	}
-	offsets[j] = indexes[i] + 2;
-	values[j] = val;
-skip2:	;
-    }
+    for (i = 0; i < vtable_size; i++)
+	offsets[i] = slots[i] ? indexes[keys[slots[i] - 1]] + 2 : 0;
     printf("\n");
     printf("#ifdef NEEDVTABLE\n");
-    printf("#define VTABLESIZE %d\n", z);
-    printf("#define VMAXHASH %d\n", best_max_rehash + 1);
-    printf("\n");
-    printf("static const unsigned short hashKeysym[VTABLESIZE] = {\n");
-    for (i = 0; i < z;) {
-	printf("0x%.4x", offsets[i]);
-	i++;
-	if (i == z)
-	    break;
-	printf((i & 7) ? ", " : ",\n");
-    }
+    printf("#define VTABLESIZE %d\n", vtable_size);
+    printf("#define VBUCKETS %d\n", vbuckets);
     printf("\n");
-    printf("};\n");
+    print_shorts("hashKeysym", "VTABLESIZE", offsets, vtable_size);
+    print_shorts("displaceKeysym", "VBUCKETS", displace, vbuckets);
     printf("#endif /* NEEDVTABLE */\n");
 
     exit(0);
@@ -445,25 +445,36 @@ void _XReadEvents(Display *dpy)
 		_XIOError(dpy);
 }
 
+/* Pieces of client data written per xcb_writev call by _XSendv, besides
+ * the output buffer and the padding. */
+#define SENDV_CHUNK 128
+
 /*
- * _XSend - Flush the buffer and send the client data. 32 bit word aligned
- * transmission is used, if size is not 0 mod 4, extra bytes are transmitted.
+ * _XSendv - Flush the buffer and send the client data held in the pieces
+ * of vec, in order, without copying them. 32 bit word aligned
+ * transmission is used, if the total size is not 0 mod 4, extra bytes are
+ * transmitted.
  *
  * Note that the connection must not be read from once the data currently
  * in the buffer has been written.
  */
-void _XSend(Display *dpy, const char *data, long size)
+void _XSendv(Display *dpy, _Xconst _XDataVec *vec, int count)
 {
 	static const xReq dummy_request;
 	static char const pad[3];
-	struct iovec vec[3];
+	struct iovec iov[SENDV_CHUNK + 2];
 	uint64_t requests;
 	uint64_t dpy_request;
 	_XExtension *ext;
 	xcb_connection_t *c = dpy->xcb->connection;
+	long size = 0;
+	int i, n;
 	if(dpy->flags & XlibDisplayIOError)
 		return;
 
+	for(i = 0; i < count; ++i)
+		size += vec[i].size;
+
 	if(dpy->bufptr == dpy->buffer && !size)
 		return;
 
@@ -484,23 +495,41 @@ void _XSend(Display *dpy, const char *data, long size)
 	requests = dpy_request - dpy->xcb->last_flushed;
 	dpy->xcb->last_flushed = dpy_request;
 
-	vec[0].iov_base = dpy->buffer;
-	vec[0].iov_len = dpy->bufptr - dpy->buffer;
-	vec[1].iov_base = (char *)data;
-	vec[1].iov_len = size;
-	vec[2].iov_base = (char *)pad;
-	vec[2].iov_len = -size & 3;
-
-	for(ext = dpy->flushes; ext; ext = ext->next_flush)
+	iov[0].iov_base = dpy->buffer;
+	iov[0].iov_len = dpy->bufptr - dpy->buffer;
+	n = 1;
+	i = 0;
+	for(;;)
 	{
-		int i;
-		for(i = 0; i < 3; ++i)
-			if(vec[i].iov_len)
-				ext->before_flush(dpy, &ext->codes, vec[i].iov_base, vec[i].iov_len);
-	}
+		int j;
+		for(; i < count && n <= SENDV_CHUNK; ++i)
+		{
+			iov[n].iov_base = (char *)vec[i].data;
+			iov[n].iov_len = vec[i].size;
+			++n;
+		}
+		if(i == count)
+		{
+			iov[n].iov_base = (char *)pad;
+			iov[n].iov_len = -size & 3;
+			++n;
+		}
 
-	if(xcb_writev(c, vec, 3, requests) < 0)
-		_XIOError(dpy);
+		for(ext = dpy->flushes; ext; ext = ext->next_flush)
+			for(j = 0; j < n; ++j)
+				if(iov[j].iov_len)
+					ext->before_flush(dpy, &ext->codes, iov[j].iov_base, iov[j].iov_len);
+
+		/* The socket stays ours between calls, so the pieces of a long
+		 * vector go out back to back; only the first call accounts
+		 * for the requests. */
+		if(xcb_writev(c, iov, n, requests) < 0)
+			_XIOError(dpy);
+		if(i == count)
+			break;
+		requests = 0;
+		n = 0;
+	}
 	dpy->bufptr = dpy->buffer;
 	dpy->last_req = (char *) &dummy_request;
 
@@ -509,6 +538,21 @@ void _XSend(Display *dpy, const char *data, long size)
 	_XSetSeqSyncFunction(dpy);
 }
 
+/*
+ * _XSend - Flush the buffer and send the client data. 32 bit word aligned
+ * transmission is used, if size is not 0 mod 4, extra bytes are transmitted.
+ *
+ * Note that the connection must not be read from once the data currently
+ * in the buffer has been written.
+ */
+void _XSend(Display *dpy, const char *data, long size)
+{
+	_XDataVec vec;
+	vec.data = data;
+	vec.size = size;
+	_XSendv(dpy, &vec, 1);
+}
+
 /*
  * _XFlush - Flush the X request buffer.  If the buffer is empty, no
  * action is taken.
@@ -68,6 +68,7 @@ from The Open Group.
 
 #include <X11/extensions/XKBproto.h>
 #include "XKBlibint.h"
+#include "Key.h"
 
 #define AllMods (ShiftMask|LockMask|ControlMask| \
                  Mod1Mask|Mod2Mask|Mod3Mask|Mod4Mask|Mod5Mask)
@@ -181,11 +182,39 @@ KeyCode
 XKeysymToKeycode(Display *dpy, KeySym ks)
 {
     register int i, j, gotOne;
+    KeyCode kc;
 
     if (_XkbUnavailable(dpy))
         return _XKeysymToKeycode(dpy, ks);
     _XkbCheckPendingRefresh(dpy, dpy->xkb_info);
 
+    LockDisplay(dpy);
+    if (dpy->keycode_index && !dpy->keycode_index->xkb)
+        _XFreeKeycodeIndex(dpy);
+    if (!dpy->keycode_index && dpy->xkb_info->desc &&
+        dpy->xkb_info->desc->map) {
+        XkbDescRec *xkb = dpy->xkb_info->desc;
+
+        dpy->keycode_index = _XCreateKeycodeIndex(xkb->map->num_syms, True);
+        /* same order as the scan below */
+        for (j = 0, gotOne = (dpy->keycode_index != NULL); gotOne; j++) {
+            gotOne = 0;
+            for (i = dpy->min_keycode; i <= dpy->max_keycode; i++) {
+                if (j < (int) XkbKeyNumSyms(xkb, i)) {
+                    gotOne = 1;
+                    _XKeycodeIndexAdd(dpy->keycode_index,
+                                      XkbKeySym(xkb, i, j), (KeyCode) i);
+                }
+            }
+        }
+    }
+    if (dpy->keycode_index) {
+        kc = _XKeycodeIndexLookup(dpy->keycode_index, ks);
+        UnlockDisplay(dpy);
+        return kc;
+    }
+    UnlockDisplay(dpy);
+
     j = 0;
     do {
         register XkbDescRec *xkb = dpy->xkb_info->desc;
@@ -585,6 +614,8 @@ _XkbReloadDpy(Display *dpy)
         oldDeviceID = xkbi->desc->device_spec;
         XkbFreeKeyboard(xkbi->desc, XkbAllComponentsMask, True);
         xkbi->desc = NULL;
+        if (dpy->keycode_index && dpy->keycode_index->xkb)
+            _XFreeKeycodeIndex(dpy);
         xkbi->flags &= ~(XkbMapPending | XkbXlibNewKeyboard);
         xkbi->changes.changed = 0;
     }
@@ -59,6 +59,7 @@ THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include "Xlibint.h"
 #include <X11/extensions/XKBproto.h>
 #include "XKBlibint.h"
+#include "Key.h"
 
 static Status
 _XkbReadKeyTypes(XkbReadBufferPtr buf, XkbDescPtr xkb, xkbGetMapReply *rep)
@@ -521,6 +522,10 @@ _XkbReadGetMapReply(Display *dpy,
         xkb->device_spec = rep->deviceID;
     if (rep->maxKeyCode < rep->minKeyCode)
         return BadImplementation;
+    /* the keysyms of the display's own keyboard are about to change */
+    if (dpy->xkb_info && xkb == dpy->xkb_info->desc &&
+        dpy->keycode_index && dpy->keycode_index->xkb)
+        _XFreeKeycodeIndex(dpy);
     xkb->min_key_code = rep->minKeyCode;
     xkb->max_key_code = rep->maxKeyCode;
 
@@ -82,6 +82,10 @@ typedef struct _XimLocalPrivateRec {
 	XIC		 current_ic;
 	DefTreeBase	 base;
 	DTIndex          top;
+
+	/* Files named by "include" while parsing, NUL separated */
+	char		*includes;
+	int		 includeslen;
 } XimLocalPrivateRec;
 
 typedef struct _XicThaiPart {
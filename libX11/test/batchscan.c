@@ -0,0 +1,174 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Times a pager-style scan of every top-level window: QueryTree,
+ * GetGeometry and WM_NAME for each, first one call at a time and then
+ * with XQueryTrees, XGetGeometries and XGetWindowProperties.  The client
+ * talks to the stand-in server through a relay that delays each direction
+ * by half the given round trip time.  With -b, every window whose id ends
+ * in 0x7f raises BadWindow.  Fails if the two scans disagree.
+ *
+ * usage: batchscan [-b] [windows] [rtt in ms] [display]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include "standin.h"
+
+#define MAX_WINDOWS	4096
+
+static Window windows[MAX_WINDOWS], roots[MAX_WINDOWS], parents[MAX_WINDOWS];
+static Window *children[MAX_WINDOWS];
+static unsigned int nchildren[MAX_WINDOWS];
+static int xs[MAX_WINDOWS], ys[MAX_WINDOWS];
+static unsigned int widths[MAX_WINDOWS], heights[MAX_WINDOWS];
+static unsigned int border_widths[MAX_WINDOWS], depths[MAX_WINDOWS];
+static Atom properties[MAX_WINDOWS], types[MAX_WINDOWS];
+static int formats[MAX_WINDOWS];
+static unsigned long nitems[MAX_WINDOWS], bytes_after[MAX_WINDOWS];
+static unsigned char *props[MAX_WINDOWS];
+
+static int errors;
+
+static int
+CountError(Display *dpy, XErrorEvent *ev)
+{
+    errors++;
+    return 0;
+}
+
+/* Sums what the scan found, so the two scans can be compared */
+static unsigned long
+Scan(Display *dpy, int n, Bool batched)
+{
+    unsigned long sum = 0;
+    int i;
+
+    if (batched) {
+	XQueryTrees(dpy, windows, n, roots, parents, children, nchildren);
+	XGetGeometries(dpy, windows, n, roots, xs, ys, widths, heights,
+		       border_widths, depths);
+	XGetWindowProperties(dpy, windows, properties, n, 0, 64, False,
+			     AnyPropertyType, types, formats, nitems,
+			     bytes_after, props);
+    } else {
+	for (i = 0; i < n; i++) {
+	    XQueryTree(dpy, windows[i], &roots[i], &parents[i],
+		       &children[i], &nchildren[i]);
+	    depths[i] = 0;
+	    XGetGeometry(dpy, windows[i], &roots[i], &xs[i], &ys[i],
+			 &widths[i], &heights[i], &border_widths[i],
+			 &depths[i]);
+	    props[i] = NULL;
+	    XGetWindowProperty(dpy, windows[i], properties[i], 0, 64, False,
+			       AnyPropertyType, &types[i], &formats[i],
+			       &nitems[i], &bytes_after[i], &props[i]);
+	}
+    }
+    for (i = 0; i < n; i++) {
+	if (children[i]) {
+	    sum += nchildren[i] + children[i][nchildren[i] - 1];
+	    XFree(children[i]);
+	    children[i] = NULL;
+	}
+	if (depths[i])
+	    sum += xs[i] + widths[i] + depths[i];
+	if (props[i]) {
+	    sum += nitems[i] + props[i][nitems[i] - 1];
+	    XFree(props[i]);
+	    props[i] = NULL;
+	}
+    }
+    return sum;
+}
+
+int
+main(int argc, char **argv)
+{
+    StandinConfig config = { LSBFirst, LSBFirst, 32, 0 };
+    int n = 500, display = 77, i, batched, scan_errors[2];
+    unsigned long sums[2];
+    double rtt = 0, t;
+    pid_t server, relay;
+    Display *dpy;
+
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+	config.bad_windows = 1;
+	argc--, argv++;
+    }
+    if (argc > 1)
+	n = atoi(argv[1]);
+    if (argc > 2)
+	rtt = atof(argv[2]) / 1e3;
+    if (argc > 3)
+	display = atoi(argv[3]);
+    if (n < 1 || n > MAX_WINDOWS) {
+	fprintf(stderr, "windows must be from 1 to %d\n", MAX_WINDOWS);
+	return 1;
+    }
+
+    if ((server = StandinStart(display, &config)) < 0)
+	return 1;
+    if ((relay = StandinProxy(display + 1, display, rtt / 2)) < 0) {
+	StandinStop(server);
+	return 1;
+    }
+    if (!(dpy = XOpenDisplay(NULL))) {
+	fprintf(stderr, "can't connect to the stand-in server\n");
+	StandinStop(relay);
+	StandinStop(server);
+	return 1;
+    }
+    XSetErrorHandler(CountError);
+    for (i = 0; i < n; i++) {
+	windows[i] = 0x400000 + i;
+	properties[i] = XA_WM_NAME;
+    }
+
+    printf("%d windows, %g ms round trip\n", n, rtt * 1e3);
+    for (batched = 0; batched < 2; batched++) {
+	errors = 0;
+	t = StandinNow();
+	sums[batched] = Scan(dpy, n, batched);
+	t = StandinNow() - t;
+	scan_errors[batched] = errors;
+	printf("%-8s %10.2f ms  %d errors\n", batched ? "batched" : "serial",
+	       t * 1e3, errors);
+    }
+    XCloseDisplay(dpy);
+    StandinStop(relay);
+    StandinStop(server);
+
+    if (sums[0] != sums[1] || scan_errors[0] != scan_errors[1]) {
+	printf("the serial and batched scans disagree\n");
+	return 1;
+    }
+    return 0;
+}
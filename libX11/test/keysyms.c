@@ -0,0 +1,208 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Times XStringToKeysym and XKeysymToString over every keysym defined in
+ * the given headers, in a shuffled order, and XKeysymToKeycode against the
+ * stand-in server's keymap.  With -v, also prints every lookup so the
+ * output of two libraries can be compared.
+ *
+ * usage: keysyms [-v] [display] [header ...]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include "standin.h"
+
+#define MAX_KEYSYMS	8192
+
+static char *names[MAX_KEYSYMS];
+static KeySym keysyms[MAX_KEYSYMS];
+static int nkeysyms;
+
+/* Reads the XK_ definitions of a keysym header */
+static void
+ReadHeader(const char *file)
+{
+    char line[512], name[256];
+    unsigned long value;
+    FILE *fp = fopen(file, "r");
+
+    if (!fp) {
+	perror(file);
+	return;
+    }
+    while (fgets(line, sizeof(line), fp) && nkeysyms < MAX_KEYSYMS - 2) {
+	char *p;
+
+	if (sscanf(line, "#define %255s 0x%lx", name, &value) != 2 ||
+	    !(p = strstr(name, "XK_")))
+	    continue;
+	memmove(p, p + 3, strlen(p + 3) + 1);
+	names[nkeysyms] = strdup(name);
+	keysyms[nkeysyms++] = value;
+    }
+    fclose(fp);
+}
+
+/* Best time per call in ns, over 20 runs of 20 passes */
+static double
+TimeStringToKeysym(unsigned long *sum)
+{
+    double best = 0;
+    int run, pass, i;
+
+    for (run = 0; run < 20; run++) {
+	double start = StandinNow(), t;
+
+	for (pass = 0; pass < 20; pass++)
+	    for (i = 0; i < nkeysyms; i++)
+		*sum += XStringToKeysym(names[i]);
+	t = (StandinNow() - start) / (20.0 * nkeysyms) * 1e9;
+	if (run == 0 || t < best)
+	    best = t;
+    }
+    return best;
+}
+
+static double
+TimeKeysymToString(const KeySym *keysym, int n, unsigned long *sum)
+{
+    double best = 0;
+    int run, pass, i;
+
+    for (run = 0; run < 20; run++) {
+	double start = StandinNow(), t;
+
+	for (pass = 0; pass < 20; pass++)
+	    for (i = 0; i < n; i++)
+		*sum += (unsigned long) XKeysymToString(keysym[i]);
+	t = (StandinNow() - start) / (20.0 * n) * 1e9;
+	if (run == 0 || t < best)
+	    best = t;
+    }
+    return best;
+}
+
+int
+main(int argc, char **argv)
+{
+    /* keysyms in and out of the stand-in's keymap, and NoSymbol */
+    static const KeySym probes[] = {
+	'a', 'q', 'Z', 0xff05, 0xff27, 0x1000000 + 13 * 14, 0xffbe, 0x20ac, 0
+    };
+    static const KeySym unknown[] = {
+	0x7fffffe, 0x1ff, 0x1234, 0xfe00, 0x1008fffe, 0xff3f, 0x5ff, 0x9ff
+    };
+    StandinConfig config = { LSBFirst, LSBFirst, 32, 0 };
+    unsigned long sum = 0;
+    int verbose = 0, display = 77;
+    Display *dpy;
+    pid_t server;
+    double start, t;
+    int i, n;
+
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) {
+	verbose = 1;
+	argc--, argv++;
+    }
+    if (argc > 1)
+	display = atoi(argv[1]);
+    if (argc > 2)
+	for (i = 2; i < argc; i++)
+	    ReadHeader(argv[i]);
+    else {
+	ReadHeader("/usr/include/X11/keysymdef.h");
+	ReadHeader("/usr/include/X11/XF86keysym.h");
+    }
+    if (!nkeysyms) {
+	fprintf(stderr, "no keysyms found\n");
+	return 1;
+    }
+    names[nkeysyms] = "NotAKeysymName";
+    keysyms[nkeysyms++] = NoSymbol;
+    names[nkeysyms] = "U20AC";
+    keysyms[nkeysyms++] = 0x10020ac;
+
+    if (verbose)
+	for (i = 0; i < nkeysyms; i++) {
+	    char *s = XKeysymToString(keysyms[i]);
+
+	    printf("%s 0x%lx 0x%lx %s\n", names[i], XStringToKeysym(names[i]),
+		   keysyms[i], s ? s : "(null)");
+	}
+
+    /* a fixed shuffle, so the tables aren't walked in order */
+    srand(1);
+    for (i = nkeysyms - 1; i > 0; i--) {
+	int j = rand() % (i + 1);
+	char *name = names[i];
+	KeySym keysym = keysyms[i];
+
+	names[i] = names[j];
+	keysyms[i] = keysyms[j];
+	names[j] = name;
+	keysyms[j] = keysym;
+    }
+    printf("%d keysyms\n", nkeysyms);
+    printf("XStringToKeysym               %7.1f ns\n",
+	   TimeStringToKeysym(&sum));
+    printf("XKeysymToString               %7.1f ns\n",
+	   TimeKeysymToString(keysyms, nkeysyms, &sum));
+    printf("XKeysymToString, unknown      %7.1f ns\n",
+	   TimeKeysymToString(unknown, 8, &sum));
+
+    if ((server = StandinStart(display, &config)) < 0)
+	return 1;
+    if (!(dpy = XOpenDisplay(NULL))) {
+	fprintf(stderr, "can't connect to the stand-in server\n");
+	StandinStop(server);
+	return 1;
+    }
+    if (verbose)
+	for (i = 0; i < 0x10000; i++) {
+	    KeyCode keycode = XKeysymToKeycode(dpy, i);
+
+	    if (keycode)
+		printf("keysym 0x%x keycode %d\n", i, keycode);
+	}
+    start = StandinNow();
+    n = 0;
+    do {
+	for (i = 0; i < 9; i++)
+	    sum += XKeysymToKeycode(dpy, probes[i]);
+	n += 9;
+    } while ((t = StandinNow() - start) < 0.5);
+    printf("XKeysymToKeycode              %7.1f ns\n", t / n * 1e9);
+    XCloseDisplay(dpy);
+    StandinStop(server);
+
+    /* keep the lookups from being optimized away */
+    return sum == 1;
+}
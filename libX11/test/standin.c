@@ -0,0 +1,581 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <X11/X.h>
+#include <X11/Xproto.h>
+#include <X11/Xatom.h>
+#include "standin.h"
+
+#define ROOT_WINDOW	0x100
+#define ROOT_VISUAL	0x21
+#define RID_BASE	0x00400000
+#define RID_MASK	0x001fffff
+
+static int
+ReadAll(int fd, void *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len) {
+	ssize_t r = read(fd, (char *) buf + done, len - done);
+
+	if (r < 0 && errno == EINTR)
+	    continue;
+	if (r <= 0)
+	    return 0;
+	done += r;
+    }
+    return 1;
+}
+
+static int
+WriteAll(int fd, const void *buf, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len) {
+	ssize_t r = write(fd, (const char *) buf + done, len - done);
+
+	if (r < 0 && errno == EINTR)
+	    continue;
+	if (r <= 0)
+	    return 0;
+	done += r;
+    }
+    return 1;
+}
+
+static void
+SocketPath(struct sockaddr_un *addr, int display)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    snprintf(addr->sun_path, sizeof(addr->sun_path),
+	     "/tmp/.X11-unix/X%d", display);
+}
+
+/* Listens on display :display, refusing to take over a live server. */
+static int
+Listen(int display)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    SocketPath(&addr, display);
+    mkdir("/tmp/.X11-unix", 01777);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+	return -1;
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+	fprintf(stderr, "display :%d is in use\n", display);
+	close(fd);
+	return -1;
+    }
+    close(fd);
+    unlink(addr.sun_path);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 ||
+	bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+	listen(fd, 1) < 0) {
+	perror("stand-in");
+	if (fd >= 0)
+	    close(fd);
+	return -1;
+    }
+    return fd;
+}
+
+/* Accepts the one connection this process serves. */
+static int
+AcceptOne(int listen_fd, int display)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    do
+	fd = accept(listen_fd, NULL, NULL);
+    while (fd < 0 && errno == EINTR);
+    close(listen_fd);
+    SocketPath(&addr, display);
+    unlink(addr.sun_path);
+    return fd;
+}
+
+static void
+SetDisplay(int display)
+{
+    char name[16];
+
+    snprintf(name, sizeof(name), ":%d", display);
+    setenv("DISPLAY", name, 1);
+    unsetenv("XAUTHORITY");
+}
+
+static size_t
+BuildSetup(char *buf, const StandinConfig *config)
+{
+    static const char vendor[] = "Stand-in";
+    static const CARD8 depths[][2] = { { 1, 1 }, { 8, 8 }, { 24, 32 } };
+    xConnSetupPrefix *prefix = (xConnSetupPrefix *) buf;
+    xConnSetup *setup = (xConnSetup *) (prefix + 1);
+    xPixmapFormat *format;
+    xWindowRoot *root;
+    xDepth *depth;
+    xVisualType *visual;
+    char *p;
+    int i;
+
+    memset(buf, 0, 512);
+    prefix->success = xTrue;
+    prefix->majorVersion = X_PROTOCOL;
+    prefix->minorVersion = X_PROTOCOL_REVISION;
+    setup->ridBase = RID_BASE;
+    setup->ridMask = RID_MASK;
+    setup->nbytesVendor = sizeof(vendor) - 1;
+    setup->maxRequestSize = 0xffff;
+    setup->numRoots = 1;
+    setup->numFormats = 3;
+    setup->imageByteOrder = config->image_byte_order;
+    setup->bitmapBitOrder = config->bitmap_bit_order;
+    setup->bitmapScanlineUnit = config->bitmap_unit;
+    setup->bitmapScanlinePad = 32;
+    setup->minKeyCode = 8;
+    setup->maxKeyCode = 255;
+    p = (char *) (setup + 1);
+    memcpy(p, vendor, sizeof(vendor) - 1);
+    p += (sizeof(vendor) - 1 + 3) & ~3;
+
+    format = (xPixmapFormat *) p;
+    for (i = 0; i < 3; i++, format++) {
+	format->depth = depths[i][0];
+	format->bitsPerPixel = depths[i][1];
+	format->scanLinePad = 32;
+    }
+
+    root = (xWindowRoot *) format;
+    root->windowId = ROOT_WINDOW;
+    root->defaultColormap = 0x20;
+    root->whitePixel = 0xffffff;
+    root->pixWidth = 3840;
+    root->pixHeight = 2160;
+    root->mmWidth = 800;
+    root->mmHeight = 450;
+    root->minInstalledMaps = root->maxInstalledMaps = 1;
+    root->rootVisualID = ROOT_VISUAL;
+    root->backingStore = NotUseful;
+    root->rootDepth = 24;
+    root->nDepths = 2;
+
+    depth = (xDepth *) (root + 1);
+    depth->depth = 24;
+    depth->nVisuals = 1;
+    visual = (xVisualType *) (depth + 1);
+    visual->visualID = ROOT_VISUAL;
+    visual->class = TrueColor;
+    visual->bitsPerRGB = 8;
+    visual->colormapEntries = 256;
+    visual->redMask = 0xff0000;
+    visual->greenMask = 0x00ff00;
+    visual->blueMask = 0x0000ff;
+    depth = (xDepth *) (visual + 1);
+    depth->depth = 1;
+
+    p = (char *) (depth + 1);
+    prefix->length = (p - (char *) setup) >> 2;
+    return p - buf;
+}
+
+/* The keysyms of keycode, column by column, with some of them missing. */
+static void
+KeymapRow(int keycode, CARD32 *row)
+{
+    memset(row, 0, 4 * sizeof(CARD32));
+    if (keycode % 11 == 0)
+	return;
+    row[0] = 'a' + keycode % 26;
+    if (keycode % 3)
+	row[1] = 'A' + keycode % 26;
+    if (keycode % 5 == 0)
+	row[2] = 0xff00 + keycode % 40;
+    if (keycode % 7 == 0)
+	row[3] = 0x1000000 + keycode * 13;
+}
+
+static int
+IsClientWindow(CARD32 window)
+{
+    return (window & ~RID_MASK) == RID_BASE;
+}
+
+static int
+SendError(int fd, int code, CARD16 sequence, CARD32 id, int major)
+{
+    xError err;
+
+    memset(&err, 0, sizeof(err));
+    err.type = X_Error;
+    err.errorCode = code;
+    err.sequenceNumber = sequence;
+    err.resourceID = id;
+    err.majorCode = major;
+    return WriteAll(fd, &err, sizeof(err));
+}
+
+/*
+ * Answers one request.  req holds as much of it as fits, which is all of
+ * every request that gets a reply.
+ */
+static int
+Reply(int fd, const StandinConfig *config, CARD16 sequence,
+      const xReq *req, CARD32 *atom)
+{
+    union {
+	xGenericReply generic;
+	xGetInputFocusReply focus;
+	xInternAtomReply atom;
+	xQueryExtensionReply extension;
+	xGetModifierMappingReply modmap;
+	xGetKeyboardMappingReply keymap;
+	xQueryTreeReply tree;
+	xGetGeometryReply geometry;
+	xGetPropertyReply property;
+	char bytes[32];
+    } rep;
+    char data[64];
+    size_t n = 0;
+    CARD32 window = ((const xResourceReq *) req)->id;
+
+    memset(&rep, 0, sizeof(rep));
+    rep.generic.type = X_Reply;
+    rep.generic.sequenceNumber = sequence;
+    switch (req->reqType) {
+    case X_GetInputFocus:
+	rep.focus.focus = PointerRoot;
+	break;
+    case X_InternAtom:
+	rep.atom.atom = (*atom)++;
+	break;
+    case X_QueryExtension:
+	rep.extension.present = xFalse;
+	break;
+    case X_GetModifierMapping:
+	rep.modmap.numKeyPerModifier = 1;
+	n = 8;
+	memset(data, 0, n);
+	break;
+    case X_GetKeyboardMapping: {
+	const xGetKeyboardMappingReq *kreq =
+	    (const xGetKeyboardMappingReq *) req;
+	CARD32 *keysyms = calloc(kreq->count, 4 * sizeof(CARD32));
+	int i, ok;
+
+	if (!keysyms)
+	    return 0;
+	for (i = 0; i < kreq->count; i++)
+	    KeymapRow(kreq->firstKeyCode + i, keysyms + 4 * i);
+	rep.keymap.keySymsPerKeyCode = 4;
+	rep.keymap.length = 4 * kreq->count;
+	ok = WriteAll(fd, &rep, sizeof(rep)) &&
+	    WriteAll(fd, keysyms, 16 * kreq->count);
+	free(keysyms);
+	return ok;
+    }
+    case X_QueryTree:
+    case X_GetGeometry:
+    case X_GetProperty:
+	if (config->bad_windows && (window & 0xff) == 0x7f)
+	    return SendError(fd, BadWindow, sequence, window, req->reqType);
+	if (req->reqType == X_QueryTree) {
+	    CARD32 *children = (CARD32 *) data;
+	    int i;
+
+	    rep.tree.root = ROOT_WINDOW;
+	    rep.tree.parent = IsClientWindow(window) ? ROOT_WINDOW : None;
+	    if (IsClientWindow(window)) {
+		rep.tree.nChildren = 3;
+		for (i = 0; i < 3; i++)
+		    children[i] = window * 4 + i;
+		n = 12;
+	    }
+	} else if (req->reqType == X_GetGeometry) {
+	    rep.geometry.depth = 24;
+	    rep.geometry.root = ROOT_WINDOW;
+	    if (IsClientWindow(window)) {
+		rep.geometry.x = window & 0xff;
+		rep.geometry.y = 7;
+		rep.geometry.width = 640;
+		rep.geometry.height = 480;
+		rep.geometry.borderWidth = 1;
+	    } else {
+		rep.geometry.width = 3840;
+		rep.geometry.height = 2160;
+	    }
+	} else if (IsClientWindow(window)) {
+	    const xGetPropertyReq *preq = (const xGetPropertyReq *) req;
+	    size_t len = snprintf(data, sizeof(data), "window-%08x",
+				  (unsigned) window);
+	    size_t offset = 4 * (size_t) preq->longOffset;
+
+	    if (offset > len)
+		return SendError(fd, BadValue, sequence, preq->longOffset,
+				 req->reqType);
+	    n = len - offset;
+	    if (n > 4 * (size_t) preq->longLength)
+		n = 4 * (size_t) preq->longLength;
+	    memmove(data, data + offset, n);
+	    rep.property.format = 8;
+	    rep.property.propertyType = XA_STRING;
+	    rep.property.nItems = n;
+	    rep.property.bytesAfter = len - offset - n;
+	}
+	break;
+    default:
+	return 1;
+    }
+    rep.generic.length = (n + 3) >> 2;
+    memset(data + n, 0, (-n) & 3);
+    return WriteAll(fd, &rep, sizeof(rep)) &&
+	WriteAll(fd, data, (n + 3) & ~3);
+}
+
+static void
+Serve(int fd, const StandinConfig *config)
+{
+    xConnClientPrefix client;
+    char buf[65536];
+    CARD16 sequence = 0;
+    CARD32 atom = 1000;
+    size_t len;
+
+    if (!ReadAll(fd, &client, sizeof(client)) ||
+	!ReadAll(fd, buf, ((client.nbytesAuthProto + 3) & ~3) +
+		 ((client.nbytesAuthString + 3) & ~3)))
+	return;
+    len = BuildSetup(buf, config);
+    if (!WriteAll(fd, buf, len))
+	return;
+
+    for (;;) {
+	xReq *req = (xReq *) buf;
+	size_t left, keep;
+
+	if (!ReadAll(fd, req, sz_xReq))
+	    return;
+	left = 4 * (size_t) req->length;
+	if (left < sz_xReq)
+	    return;
+	left -= sz_xReq;
+	keep = left < sizeof(buf) - sz_xReq ? left : sizeof(buf) - sz_xReq;
+	if (!ReadAll(fd, buf + sz_xReq, keep))
+	    return;
+	/* the rest only ever holds image data, which nothing looks at */
+	for (left -= keep; left > 0; left -= keep) {
+	    keep = left < sizeof(buf) / 2 ? left : sizeof(buf) / 2;
+	    if (!ReadAll(fd, buf + sizeof(buf) / 2, keep))
+		return;
+	}
+	if (!Reply(fd, config, ++sequence, req, &atom))
+	    return;
+    }
+}
+
+pid_t
+StandinStart(int display, const StandinConfig *config)
+{
+    int listen_fd = Listen(display);
+    pid_t pid;
+
+    if (listen_fd < 0)
+	return -1;
+    pid = fork();
+    if (pid == 0) {
+	int fd = AcceptOne(listen_fd, display);
+
+	if (fd >= 0)
+	    Serve(fd, config);
+	_exit(0);
+    }
+    close(listen_fd);
+    if (pid > 0)
+	SetDisplay(display);
+    return pid;
+}
+
+typedef struct _Chunk {
+    struct _Chunk *next;
+    double due;
+    size_t len, done;
+    char data[];
+} Chunk;
+
+typedef struct {
+    int from, to;
+    Chunk *head, **tail;
+} Direction;
+
+static int
+Relay(Direction *dir, int readable, double delay)
+{
+    Chunk *chunk;
+
+    if (readable) {
+	char buf[65536];
+	ssize_t r = read(dir->from, buf, sizeof(buf));
+
+	if (r <= 0)
+	    return r < 0 && (errno == EAGAIN || errno == EINTR);
+	chunk = malloc(sizeof(*chunk) + r);
+	if (!chunk)
+	    return 0;
+	chunk->next = NULL;
+	chunk->due = StandinNow() + delay;
+	chunk->len = r;
+	chunk->done = 0;
+	memcpy(chunk->data, buf, r);
+	*dir->tail = chunk;
+	dir->tail = &chunk->next;
+    }
+    while ((chunk = dir->head) && chunk->due <= StandinNow()) {
+	ssize_t w = write(dir->to, chunk->data + chunk->done,
+			  chunk->len - chunk->done);
+
+	if (w < 0)
+	    return errno == EAGAIN || errno == EINTR;
+	chunk->done += w;
+	if (chunk->done < chunk->len)
+	    break;
+	dir->head = chunk->next;
+	if (!dir->head)
+	    dir->tail = &dir->head;
+	free(chunk);
+    }
+    return 1;
+}
+
+static void
+Proxy(int client, int server, double delay)
+{
+    Direction dirs[2] = {
+	{ client, server, NULL, NULL }, { server, client, NULL, NULL }
+    };
+    int i;
+
+    for (i = 0; i < 2; i++) {
+	dirs[i].tail = &dirs[i].head;
+	fcntl(dirs[i].from, F_SETFL, O_NONBLOCK);
+    }
+    for (;;) {
+	struct timeval tv, *timeout = NULL;
+	fd_set readable;
+	double wait = -1;
+
+	FD_ZERO(&readable);
+	for (i = 0; i < 2; i++) {
+	    FD_SET(dirs[i].from, &readable);
+	    if (dirs[i].head) {
+		double left = dirs[i].head->due - StandinNow();
+
+		if (left < 0)
+		    left = 0;
+		if (wait < 0 || left < wait)
+		    wait = left;
+	    }
+	}
+	/* select, unlike poll, can wait for less than a millisecond */
+	if (wait >= 0) {
+	    tv.tv_sec = (time_t) wait;
+	    tv.tv_usec = (long) ((wait - tv.tv_sec) * 1e6);
+	    timeout = &tv;
+	}
+	if (select((client > server ? client : server) + 1, &readable,
+		   NULL, NULL, timeout) < 0) {
+	    if (errno == EINTR)
+		continue;
+	    return;
+	}
+	for (i = 0; i < 2; i++)
+	    if (!Relay(&dirs[i], FD_ISSET(dirs[i].from, &readable), delay))
+		return;
+    }
+}
+
+pid_t
+StandinProxy(int display, int server, double delay)
+{
+    int listen_fd = Listen(display);
+    pid_t pid;
+
+    if (listen_fd < 0)
+	return -1;
+    pid = fork();
+    if (pid == 0) {
+	int client = AcceptOne(listen_fd, display);
+	int upstream = socket(AF_UNIX, SOCK_STREAM, 0);
+	struct sockaddr_un addr;
+
+	SocketPath(&addr, server);
+	if (client >= 0 && upstream >= 0 &&
+	    connect(upstream, (struct sockaddr *) &addr, sizeof(addr)) == 0)
+	    Proxy(client, upstream, delay);
+	_exit(0);
+    }
+    close(listen_fd);
+    if (pid > 0)
+	SetDisplay(display);
+    return pid;
+}
+
+void
+StandinStop(pid_t pid)
+{
+    if (pid <= 0)
+	return;
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+}
+
+double
+StandinNow(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
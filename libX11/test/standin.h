@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * A scripted stand-in for an X server, for benchmarking Xlib without one.
+ * It serves a single client over a local socket, offers no extensions and
+ * answers only the requests the benchmarks make:
+ *
+ *  - GetInputFocus, InternAtom and GetModifierMapping;
+ *  - GetKeyboardMapping, with a fixed four column keymap;
+ *  - QueryTree, GetGeometry and GetProperty on client windows, with
+ *    made-up but deterministic contents.
+ *
+ * Every other request is read and dropped without a reply.
+ */
+
+#ifndef _STANDIN_H_
+#define _STANDIN_H_
+
+#include <sys/types.h>
+
+typedef struct {
+    int image_byte_order;	/* LSBFirst or MSBFirst */
+    int bitmap_bit_order;	/* LSBFirst or MSBFirst */
+    int bitmap_unit;		/* 8, 16 or 32 */
+    int bad_windows;		/* windows ending in 0x7f raise BadWindow */
+} StandinConfig;
+
+/*
+ * Forks a server for one connection on display :display and points
+ * DISPLAY at it.  Returns the server's pid, or -1 on failure.
+ */
+extern pid_t StandinStart(int display, const StandinConfig *config);
+
+/*
+ * Forks a relay that accepts one connection on display :display, passes
+ * it on to display :server and holds everything it relays in either
+ * direction for delay seconds.  Points DISPLAY at the relay.
+ */
+extern pid_t StandinProxy(int display, int server, double delay);
+
+/* Stops a server or relay started above. */
+extern void StandinStop(pid_t pid);
+
+/* Monotonic time in seconds. */
+extern double StandinNow(void);
+
+#endif /* _STANDIN_H_ */
@@ -0,0 +1,257 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Times XPutImage through every cell of PutImage.c's SwapFunction table:
+ * a 3840x2160 bitmap in each of the 12 unit, byte order and bit order
+ * formats is sent to stand-in servers set up with each of the 12 formats.
+ * Then times byte-swapped and bpp-converting ZPixmap puts, and XSubImage,
+ * at 4K and 1080p.
+ *
+ * usage: swapcells [display]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include "standin.h"
+
+#define WIDTH	3840
+#define HEIGHT	2160
+
+static const char *const Order[] = { "L", "M" };
+
+/* The order of PutImage.c's ComposeIndex */
+static void
+Format(int index, int *unit, int *bit_order, int *byte_order)
+{
+    static const int units[] = { 8, 16, 32 };
+
+    *unit = units[index % 3];
+    *bit_order = (index / 3) % 2 ? LSBFirst : MSBFirst;
+    *byte_order = index / 6 ? LSBFirst : MSBFirst;
+}
+
+static void
+FormatName(int index, char *name)
+{
+    int unit, bit_order, byte_order;
+
+    Format(index, &unit, &bit_order, &byte_order);
+    sprintf(name, "%d%s%c", unit / 8, Order[byte_order],
+	    bit_order == MSBFirst ? 'm' : 'l');
+}
+
+static Display *
+Connect(int display, const StandinConfig *config, pid_t *server)
+{
+    Display *dpy;
+
+    *server = StandinStart(display, config);
+    if (*server < 0)
+	return NULL;
+    dpy = XOpenDisplay(NULL);
+    if (!dpy) {
+	StandinStop(*server);
+	fprintf(stderr, "can't connect to the stand-in server\n");
+    }
+    return dpy;
+}
+
+static void
+Disconnect(Display *dpy, pid_t server)
+{
+    XCloseDisplay(dpy);
+    StandinStop(server);
+}
+
+/* Seconds per put of image, over enough puts to take a quarter second */
+static double
+TimePut(Display *dpy, XImage *image, int width, int height)
+{
+    GC gc = DefaultGC(dpy, DefaultScreen(dpy));
+    Window root = DefaultRootWindow(dpy);
+    double start, elapsed;
+    int n = 0;
+
+    XPutImage(dpy, root, gc, image, 0, 0, 0, 0, width, height);
+    XSync(dpy, False);
+    start = StandinNow();
+    do {
+	XPutImage(dpy, root, gc, image, 0, 0, 0, 0, width, height);
+	XSync(dpy, False);
+	n++;
+    } while ((elapsed = StandinNow() - start) < 0.25);
+    return elapsed / n;
+}
+
+static XImage *
+CreateImage(Display *dpy, int format, int depth, int bits_per_pixel,
+	    int width, int height)
+{
+    XImage *image;
+    char *data;
+    long i, size;
+
+    image = XCreateImage(dpy, DefaultVisual(dpy, DefaultScreen(dpy)), depth,
+			 format, 0, NULL, width, height, 32, 0);
+    if (!image)
+	return NULL;
+    if (format == ZPixmap && bits_per_pixel != image->bits_per_pixel) {
+	image->bits_per_pixel = bits_per_pixel;
+	image->bytes_per_line = ((width * bits_per_pixel + 31) / 32) * 4;
+    }
+    size = (long) image->bytes_per_line * height;
+    if (format != ZPixmap)
+	size *= depth;
+    data = malloc(size);
+    if (!data) {
+	XDestroyImage(image);
+	return NULL;
+    }
+    for (i = 0; i < size; i++)
+	data[i] = (char) (i * 2654435761u >> 13);
+    image->data = data;
+    return image;
+}
+
+static int
+Cells(int display)
+{
+    double times[12][12];
+    char name[8];
+    int server_index, image_index;
+
+    for (server_index = 0; server_index < 12; server_index++) {
+	StandinConfig config = { 0 };
+	XImage *image;
+	Display *dpy;
+	pid_t server;
+
+	Format(server_index, &config.bitmap_unit, &config.bitmap_bit_order,
+	       &config.image_byte_order);
+	if (!(dpy = Connect(display, &config, &server)))
+	    return 1;
+	image = CreateImage(dpy, XYBitmap, 1, 1, WIDTH, HEIGHT);
+	if (!image) {
+	    Disconnect(dpy, server);
+	    return 1;
+	}
+	for (image_index = 0; image_index < 12; image_index++) {
+	    Format(image_index, &image->bitmap_unit, &image->bitmap_bit_order,
+		   &image->byte_order);
+	    times[image_index][server_index] =
+		TimePut(dpy, image, WIDTH, HEIGHT);
+	}
+	XDestroyImage(image);
+	Disconnect(dpy, server);
+    }
+
+    printf("XYBitmap %dx%d puts, GB/s; rows are the image format, "
+	   "columns the server's\n     ", WIDTH, HEIGHT);
+    for (server_index = 0; server_index < 12; server_index++) {
+	FormatName(server_index, name);
+	printf(" %5s", name);
+    }
+    printf("\n");
+    for (image_index = 0; image_index < 12; image_index++) {
+	FormatName(image_index, name);
+	printf("%-5s", name);
+	for (server_index = 0; server_index < 12; server_index++)
+	    printf(" %5.2f", WIDTH / 8.0 * HEIGHT /
+		   times[image_index][server_index] * 1e-9);
+	printf("\n");
+    }
+    return 0;
+}
+
+static int
+Pixmaps(int display)
+{
+    StandinConfig config = { 0 };
+    XImage *image;
+    Display *dpy;
+    pid_t server;
+    double start, t;
+    int byte_order, i, n;
+
+    config.image_byte_order = LSBFirst;
+    config.bitmap_bit_order = LSBFirst;
+    config.bitmap_unit = 32;
+    if (!(dpy = Connect(display, &config, &server)))
+	return 1;
+
+    printf("\nZPixmap puts to an LSBFirst server\n");
+    for (byte_order = LSBFirst; byte_order <= MSBFirst; byte_order++) {
+	if (!(image = CreateImage(dpy, ZPixmap, 24, 32, WIDTH, HEIGHT)))
+	    break;
+	image->byte_order = byte_order;
+	t = TimePut(dpy, image, WIDTH, HEIGHT);
+	printf("  %dx%d 32 bpp %s       %7.1f fps\n", WIDTH, HEIGHT,
+	       byte_order == LSBFirst ? "LSBFirst" : "MSBFirst", 1 / t);
+	XDestroyImage(image);
+    }
+    if ((image = CreateImage(dpy, ZPixmap, 24, 24, 1920, 1080))) {
+	t = TimePut(dpy, image, 1920, 1080);
+	printf("  1920x1080 24 -> 32 bpp     %7.2f ms\n", t * 1e3);
+
+	start = StandinNow();
+	for (n = 0; (t = StandinNow() - start) < 0.25; n++) {
+	    for (i = 0; i < 4; i++) {
+		XImage *sub = XSubImage(image, i, i, 1920 - 4, 1080 - 4);
+
+		if (sub)
+		    XDestroyImage(sub);
+	    }
+	}
+	printf("  1920x1080 XSubImage 24 bpp %7.2f ms\n", t / (4 * n) * 1e3);
+	XDestroyImage(image);
+    }
+    if ((image = CreateImage(dpy, XYBitmap, 1, 1, 1920, 1080))) {
+	start = StandinNow();
+	for (n = 0; (t = StandinNow() - start) < 0.25; n++) {
+	    for (i = 0; i < 4; i++) {
+		XImage *sub = XSubImage(image, i, i, 1920 - 4, 1080 - 4);
+
+		if (sub)
+		    XDestroyImage(sub);
+	    }
+	}
+	printf("  1920x1080 XSubImage bitmap %7.2f ms\n", t / (4 * n) * 1e3);
+	XDestroyImage(image);
+    }
+    Disconnect(dpy, server);
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    int display = argc > 1 ? atoi(argv[1]) : 77;
+
+    return Cells(display) || Pixmaps(display);
+}
@@ -0,0 +1,287 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Times the resource lookups of a toolkit application starting up.  A
+ * Motif-style app-defaults database of some ten thousand lines is generated
+ * and loaded, then every widget of a 2000 widget tree and of 20 dialogs
+ * gets its search list and looks up each of its resources through it, as
+ * Xt does, plus the two XrmQGetResource lookups the converters make.  The
+ * dialogs are then created again, and one search list is fetched over and
+ * over.  Each time is the best of the given number of runs.
+ *
+ * usage: xrmstartup [runs]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/Xresource.h>
+#include "standin.h"
+
+static const char *const Resources[] = {
+    "foreground", "background", "fontList", "marginWidth", "marginHeight",
+    "shadowThickness", "highlightThickness", "labelString", "borderWidth",
+    "alignment", "width", "height", "sensitive", "traversalOn",
+    "navigationType", "accelerator", "mnemonic", "topShadowColor",
+    "bottomShadowColor", "armColor", "x", "y", "depth", "colormap",
+    "screen", "mappedWhenManaged", "ancestorSensitive", "translations",
+    "accelerators", "borderColor", "borderPixmap", "backgroundPixmap",
+    "destroyCallback", "userData", "unitType", "helpCallback",
+    "horizDistance", "vertDistance", "fromHoriz", "fromVert", "label",
+    "font", "cursor", "shapeStyle", "displayList", "internalWidth",
+};
+#define NRESOURCES	(sizeof(Resources) / sizeof(Resources[0]))
+/* the resources the app-defaults set */
+#define NSET		20
+
+static const char *const Classes[] = {
+    "XmPushButton", "XmLabel", "XmTextField", "XmToggleButton", "XmForm",
+    "XmRowColumn", "XmPanedWindow", "XmMainWindow", "XmDialogShell",
+};
+#define NCLASSES	(sizeof(Classes) / sizeof(Classes[0]))
+
+static XrmQuark qnames[NRESOURCES], qclasses[NRESOURCES];
+static XrmQuark qfont, qFont, qcustomization, qCustomization;
+static XrmHashTable list[4096];
+static long found;
+
+/* A fixed sequence, so every run builds the same database */
+static unsigned int
+Random(unsigned int *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 16;
+}
+
+static void
+Add(char **p, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start(args, fmt);
+    *p += vsprintf(*p, fmt, args);
+    va_end(args);
+}
+
+/* The app-defaults, in the style of a large Motif application */
+static char *
+AppDefaults(void)
+{
+    char *text = malloc(1 << 20), *p = text;
+    unsigned int seed = 1;
+    int i, j, r, k;
+
+    if (!text)
+	return NULL;
+    for (r = 0; r < NSET; r++) {
+	Add(&p, "*%s:\tdefault\n", Resources[r]);
+	Add(&p, "Big*%s:\tapp\n", Resources[r]);
+	Add(&p, "Big*tool*%s:\ttool\n", Resources[r]);
+    }
+    for (k = 0; k < (int) NCLASSES; k++)
+	for (r = 0; r < NSET; r++)
+	    Add(&p, "*%s.%s:\tclass\n", Classes[k], Resources[r]);
+    for (i = 0; i < 6; i++)
+	for (j = 0; j < 5; j++)
+	    Add(&p, "Big.main.pane%d*form%d*background:\tform\n", i, j);
+    /* about half of each button's resources are set for it alone */
+    for (i = 0; i < 6 * 5 * 4 * 8; i++)
+	for (r = 0; r < NSET; r++)
+	    if (Random(&seed) & 1) {
+		char path[64];
+
+		snprintf(path, sizeof(path),
+			 "Big.main.pane%d.form%d.row%d.button%d",
+			 i / 160, i / 32 % 5, i / 8 % 4, i % 8);
+		Add(&p, "%s.%s:\tbutton\n", path, Resources[r]);
+	    }
+    for (i = 0; i < 20 * 15; i++)
+	for (r = 0; r < NSET; r++)
+	    if (Random(&seed) % 16 == 0)
+		Add(&p, "Big.dialog%d.form.field%d.%s:\tfield\n",
+		    i / 15, i % 15, Resources[r]);
+    *p = '\0';
+    return text;
+}
+
+static void
+Widget(XrmDatabase db, XrmNameList names, XrmClassList classes)
+{
+    XrmQuark n[2], c[2], n2[3], c2[3];
+    XrmRepresentation type;
+    XrmValue value;
+    unsigned int i;
+
+    if (!XrmQGetSearchList(db, names, classes, list, 4096))
+	abort();
+    for (i = 0; i < NRESOURCES; i++)
+	found += XrmQGetSearchResource(list, qnames[i], qclasses[i],
+				       &type, &value);
+    n[0] = qfont;
+    c[0] = qFont;
+    n[1] = c[1] = NULLQUARK;
+    found += XrmQGetResource(db, n, c, &type, &value);
+    n2[0] = names[0];
+    c2[0] = classes[0];
+    n2[1] = qcustomization;
+    c2[1] = qCustomization;
+    n2[2] = c2[2] = NULLQUARK;
+    found += XrmQGetResource(db, n2, c2, &type, &value);
+}
+
+static void
+Level(XrmQuark *n, XrmQuark *c, int depth, const char *name, int index,
+      const char *class)
+{
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), index < 0 ? "%s" : "%s%d", name, index);
+    n[depth] = XrmStringToQuark(buf);
+    c[depth] = XrmStringToQuark(class);
+    n[depth + 1] = c[depth + 1] = NULLQUARK;
+}
+
+static void
+Tree(XrmDatabase db)
+{
+    XrmQuark n[16], c[16];
+    int i, j, k, l;
+
+    Level(n, c, 0, "big", -1, "Big");
+    Level(n, c, 1, "main", -1, "XmMainWindow");
+    Widget(db, n, c);
+    for (i = 0; i < 6; i++) {
+	Level(n, c, 2, "pane", i, "XmPanedWindow");
+	Widget(db, n, c);
+	for (j = 0; j < 5; j++) {
+	    Level(n, c, 3, "form", j, "XmForm");
+	    Widget(db, n, c);
+	    for (k = 0; k < 4; k++) {
+		Level(n, c, 4, "row", k, "XmRowColumn");
+		Widget(db, n, c);
+		for (l = 0; l < 8; l++) {
+		    Level(n, c, 5, "button", l,
+			  l & 1 ? "XmPushButton" : "XmToggleButton");
+		    Widget(db, n, c);
+		    Level(n, c, 6, "label", -1, "XmLabel");
+		    Widget(db, n, c);
+		}
+	    }
+	}
+    }
+}
+
+static void
+Dialogs(XrmDatabase db)
+{
+    XrmQuark n[8], c[8];
+    int i, j;
+
+    Level(n, c, 0, "big", -1, "Big");
+    for (i = 0; i < 20; i++) {
+	Level(n, c, 1, "dialog", i, "XmDialogShell");
+	Level(n, c, 2, "form", -1, "XmForm");
+	Widget(db, n, c);
+	for (j = 0; j < 15; j++) {
+	    Level(n, c, 3, "field", j, "XmTextField");
+	    Widget(db, n, c);
+	}
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    double load = 0, tree = 0, again = 0, repeat = 0;
+    int runs = argc > 1 ? atoi(argv[1]) : 20, run, i;
+    XrmQuark n[8], c[8];
+    unsigned int r;
+    char *text;
+    long lines = 0;
+
+    XrmInitialize();
+    for (r = 0; r < NRESOURCES; r++) {
+	char class[64];
+
+	snprintf(class, sizeof(class), "%s", Resources[r]);
+	class[0] -= 'a' - 'A';
+	qnames[r] = XrmStringToQuark(Resources[r]);
+	qclasses[r] = XrmStringToQuark(class);
+    }
+    qfont = XrmStringToQuark("xtDefaultFont");
+    qFont = XrmStringToQuark("XtDefaultFont");
+    qcustomization = XrmStringToQuark("customization");
+    qCustomization = XrmStringToQuark("Customization");
+    if (!(text = AppDefaults()))
+	return 1;
+    for (i = 0; text[i]; i++)
+	lines += text[i] == '\n';
+
+    for (run = 0; run < runs; run++) {
+	XrmDatabase db;
+	double t0, t1, t2, t3, t4;
+
+	t0 = StandinNow();
+	db = XrmGetStringDatabase(text);
+	XrmPutLineResource(&db, "*customization: -color");
+	t1 = StandinNow();
+	found = 0;
+	Tree(db);
+	Dialogs(db);
+	t2 = StandinNow();
+	/* pop the dialogs down and up again */
+	Dialogs(db);
+	t3 = StandinNow();
+	Level(n, c, 0, "big", -1, "Big");
+	Level(n, c, 1, "dialog", 3, "XmDialogShell");
+	Level(n, c, 2, "form", -1, "XmForm");
+	Level(n, c, 3, "field", 4, "XmTextField");
+	for (i = 0; i < 10000; i++)
+	    XrmQGetSearchList(db, n, c, list, 4096);
+	t4 = StandinNow();
+	XrmDestroyDatabase(db);
+
+	if (run == 0 || t1 - t0 < load)
+	    load = t1 - t0;
+	if (run == 0 || t2 - t1 < tree)
+	    tree = t2 - t1;
+	if (run == 0 || t3 - t2 < again)
+	    again = t3 - t2;
+	if (run == 0 || t4 - t3 < repeat)
+	    repeat = t4 - t3;
+    }
+    printf("%ld lines of app-defaults, %ld resources found\n", lines, found);
+    printf("load                     %8.3f ms\n", load * 1e3);
+    printf("widget tree and dialogs  %8.3f ms\n", tree * 1e3);
+    printf("dialogs, created again   %8.3f ms\n", again * 1e3);
+    printf("repeated search list     %8.1f ns\n", repeat / 10000 * 1e9);
+    free(text);
+    return 0;
+}
@@ -137,6 +137,19 @@ FT_Library ftypeLibrary;
 
 static FTFacePtr faceTable[NUMFACEBUCKETS];
 
+/* Upper bound on the bitmap memory held by rasterised glyphs of all
+   instances.  Least recently used glyphs beyond it are dropped back
+   to metrics-only and rasterised again on demand. */
+#ifndef FT_GLYPH_CACHE_SIZE
+#define FT_GLYPH_CACHE_SIZE (8 * 1024 * 1024)
+#endif
+
+static FTGlyphCacheEntryRec glyphCache = { &glyphCache, &glyphCache };
+static unsigned long glyphCacheSize = 0;
+/* Glyphs handed out since the epoch was last bumped may still be in
+   use by the caller, so they are never evicted. */
+static unsigned long glyphCacheEpoch = 1;
+
 static unsigned
 hash(char *string)
 {
@@ -435,6 +448,7 @@ FreeTypeOpenInstance(FTInstancePtr *instance_return, FTFacePtr face,
     instance->bmfmt = *bmfmt;
     instance->glyphs = NULL;
     instance->available = NULL;
+    instance->cached = NULL;
 
     if( 0 <= tmp_ttcap->forceConstantSpacingEnd )
 	instance->nglyphs = 2 * instance->face->face->num_glyphs;
@@ -536,6 +550,110 @@ FreeTypeOpenInstance(FTInstancePtr *instance_return, FTFacePtr face,
     return Successful;
 }
 
+static unsigned long
+FTGlyphBitmapSize(FTInstancePtr instance, CharInfoPtr g)
+{
+    int wd, ht, bpr;
+
+    wd = g->metrics.rightSideBearing - g->metrics.leftSideBearing;
+    ht = g->metrics.ascent + g->metrics.descent;
+    if(wd <= 0) wd = 1;
+    if(ht <= 0) ht = 1;
+    bpr = (((wd + (instance->bmfmt.glyph<<3) - 1) >> 3) &
+           -instance->bmfmt.glyph);
+    return (unsigned long)ht * bpr;
+}
+
+static void
+FTGlyphCacheUnlink(FTGlyphCacheEntryPtr entry)
+{
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->prev = entry->next = NULL;
+    glyphCacheSize -= entry->size;
+}
+
+static void
+FTGlyphCacheLink(FTGlyphCacheEntryPtr entry)
+{
+    entry->next = glyphCache.next;
+    entry->prev = &glyphCache;
+    glyphCache.next->prev = entry;
+    glyphCache.next = entry;
+    entry->epoch = glyphCacheEpoch;
+}
+
+static void
+FTGlyphCacheTrim(void)
+{
+    FTGlyphCacheEntryPtr entry;
+    FTInstancePtr instance;
+
+    while(glyphCacheSize > FT_GLYPH_CACHE_SIZE) {
+        entry = glyphCache.prev;
+        /* The list is in LRU order, so everything left is in use. */
+        if(entry == &glyphCache || entry->epoch == glyphCacheEpoch)
+            break;
+        instance = entry->instance;
+        free(instance->glyphs[entry->segment][entry->offset].bits);
+        instance->glyphs[entry->segment][entry->offset].bits = NULL;
+        instance->available[entry->segment][entry->offset] =
+            FT_AVAILABLE_METRICS;
+        FTGlyphCacheUnlink(entry);
+    }
+}
+
+static void
+FTGlyphCacheTouch(FTInstancePtr instance, int segment, int offset)
+{
+    FTGlyphCacheEntryPtr entry;
+
+    if(instance->cached == NULL || instance->cached[segment] == NULL)
+        return;
+    entry = &instance->cached[segment][offset];
+    if(entry->next == NULL)
+        return;
+    /* The head may still carry the epoch of an earlier request. */
+    entry->epoch = glyphCacheEpoch;
+    if(entry == glyphCache.next)
+        return;
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    FTGlyphCacheLink(entry);
+}
+
+/* Account for a freshly rasterised glyph.  If the bookkeeping cannot
+   be allocated the glyph simply stays resident, as it did before. */
+static void
+FTGlyphCacheAdd(FTInstancePtr instance, int segment, int offset)
+{
+    FTGlyphCacheEntryPtr entry;
+
+    if(instance->cached == NULL) {
+        instance->cached = calloc(iceil(instance->nglyphs, FONTSEGMENTSIZE),
+                                  sizeof(FTGlyphCacheEntryPtr));
+        if(instance->cached == NULL)
+            return;
+    }
+    if(instance->cached[segment] == NULL) {
+        instance->cached[segment] = calloc(FONTSEGMENTSIZE,
+                                           sizeof(FTGlyphCacheEntryRec));
+        if(instance->cached[segment] == NULL)
+            return;
+    }
+
+    entry = &instance->cached[segment][offset];
+    entry->instance = instance;
+    entry->segment = segment;
+    entry->offset = offset;
+    entry->size = FTGlyphBitmapSize(instance,
+                                    &instance->glyphs[segment][offset]);
+    FTGlyphCacheLink(entry);
+    glyphCacheSize += entry->size;
+
+    FTGlyphCacheTrim();
+}
+
 static void
 FreeTypeFreeInstance(FTInstancePtr instance)
 {
@@ -570,6 +688,18 @@ FreeTypeFreeInstance(FTInstancePtr instance)
         if(instance->forceConstantMetrics) {
             free(instance->forceConstantMetrics);
         }
+        if(instance->cached) {
+            for(i = 0; i < iceil(instance->nglyphs, FONTSEGMENTSIZE); i++) {
+                if(instance->cached[i]) {
+                    for(j = 0; j < FONTSEGMENTSIZE; j++) {
+                        if(instance->cached[i][j].next)
+                            FTGlyphCacheUnlink(&instance->cached[i][j]);
+                    }
+                    free(instance->cached[i]);
+                }
+            }
+            free(instance->cached);
+        }
         if(instance->glyphs) {
             for(i = 0; i < iceil(instance->nglyphs, FONTSEGMENTSIZE); i++) {
                 if(instance->glyphs[i]) {
@@ -669,6 +799,7 @@ FreeTypeInstanceGetGlyph(unsigned idx, int flags, CharInfoPtr *g, FTInstancePtr
     }
 
     if((*available)[segment][offset] == FT_AVAILABLE_RASTERISED) {
+	FTGlyphCacheTouch(instance, segment, offset);
 	*g = &(*glyphs)[segment][offset];
 	return Successful;
     }
@@ -687,6 +818,7 @@ FreeTypeInstanceGetGlyph(unsigned idx, int flags, CharInfoPtr *g, FTInstancePtr
     }
     if(xrc == Successful) {
         (*available)[segment][offset] = FT_AVAILABLE_RASTERISED;
+	FTGlyphCacheAdd(instance, segment, offset);
 	/* return the glyph */
         *g = &(*glyphs)[segment][offset];
     }
@@ -2254,6 +2386,8 @@ FreeTypeSetUpTTCap( char *fileName, FontScalablePtr vals,
     ret->vl_slant=0;
     ret->lsbShiftOfBitmapAutoItalic=0;
     ret->rsbShiftOfBitmapAutoItalic=0;
+    ret->prefetchBegin = -1;
+    ret->prefetchEnd = -1;
     /* face number */
     {
 	char *beginptr=NULL,*endptr;
@@ -2659,6 +2793,22 @@ FreeTypeSetUpTTCap( char *fileName, FontScalablePtr vals,
         }
     }
 
+    /* glyphs to rasterise as soon as the font is opened */
+    if ( 1 ){
+        unsigned short first_col=0,last_col=0x00ff;
+        unsigned short first_row=0,last_row=0x00ff;
+        if (SPropRecValList_search_record(&listPropRecVal,
+                                           &contRecValue,
+                                           "PrefetchCodeRange")) {
+            if ( restrict_code_range_by_str(1,&first_col, &first_row,
+                                            &last_col, &last_row,
+                                            SPropContainer_value_str(contRecValue)) == 1 ) {
+              ret->prefetchBegin = (int)( first_row<<8 | first_col );
+              ret->prefetchEnd = (int)( last_row<<8 | last_col );
+            }
+        }
+    }
+
     if (SPropRecValList_search_record(&listPropRecVal,
                                       &contRecValue,
                                       "FontProperties")) {
@@ -3118,6 +3268,36 @@ is_matrix_unit(FontScalablePtr vals)
 /* Do all the real work for OpenFont or FontInfo */
 /* xf->info is only accessed through info, and xf might be null */
 
+/* Rasterise a range of glyphs ahead of the first request for them.
+   This stops early rather than evicting glyphs already in the cache. */
+static void
+FreeTypePrefetchGlyphs(FTFontPtr font, int first, int last)
+{
+    struct TTCapInfo *ttcap = &font->instance->ttcap;
+    CharInfoPtr g;
+    int code, flags;
+
+    glyphCacheEpoch++;
+    for(code = first; code <= last; code++) {
+        if(glyphCacheSize >= FT_GLYPH_CACHE_SIZE)
+            break;
+        flags = 0;
+        if ( !(ttcap->flags & TTCAP_FORCE_C_OUTSIDE) ) {
+            if ( code <= ttcap->forceConstantSpacingEnd
+                 && ttcap->forceConstantSpacingBegin <= code )
+                flags |= FT_FORCE_CONSTANT_SPACING;
+        }
+        else {
+            if ( code <= ttcap->forceConstantSpacingEnd
+                 || ttcap->forceConstantSpacingBegin <= code )
+                flags |= FT_FORCE_CONSTANT_SPACING;
+        }
+        if(FreeTypeFontGetGlyph(code, flags, &g, font) != Successful)
+            break;
+    }
+    glyphCacheEpoch++;
+}
+
 static int
 FreeTypeLoadXFont(char *fileName,
                   FontScalablePtr vals, FontPtr xf, FontInfoPtr info,
@@ -3620,6 +3800,10 @@ FreeTypeLoadXFont(char *fileName,
         }
     }
 
+    if(xf && 0 <= tmp_ttcap.prefetchBegin)
+        FreeTypePrefetchGlyphs(font, tmp_ttcap.prefetchBegin,
+                               tmp_ttcap.prefetchEnd);
+
  quit:
     if ( dynStrTTCapCodeRange ) free(dynStrTTCapCodeRange);
     if ( dynStrFTFileName ) free(dynStrFTFileName);
@@ -3706,6 +3890,9 @@ FreeTypeGetGlyphs(FontPtr pFont, unsigned long count, unsigned char *chars,
     ttcap = &tf->instance->ttcap;
     gp = glyphs;
 
+    /* Glyphs returned by earlier calls may now be evicted. */
+    glyphCacheEpoch++;
+
     while (count-- > 0) {
         switch (charEncoding) {
         case Linear8Bit: case TwoD8Bit:
@@ -110,8 +110,23 @@ struct TTCapInfo {
     double vl_slant;
     int lsbShiftOfBitmapAutoItalic;
     int rsbShiftOfBitmapAutoItalic;
+    int prefetchBegin;
+    int prefetchEnd;
 };
 
+/* Rasterised glyphs of all instances are linked into a single LRU
+   list so that the total amount of bitmap memory can be bounded.  An
+   entry refers to its glyph by instance, segment and offset. */
+typedef struct _FTGlyphCacheEntry {
+    struct _FTGlyphCacheEntry *prev;
+    struct _FTGlyphCacheEntry *next;
+    struct _FTInstance *instance;
+    int segment;
+    int offset;
+    unsigned long size;         /* bytes of bitmap data */
+    unsigned long epoch;        /* last request that used the glyph */
+} FTGlyphCacheEntryRec, *FTGlyphCacheEntryPtr;
+
 /* An instance builds on a face by specifying the transformation
    matrix.  Multiple fonts may share the same instance. */
 
@@ -135,6 +150,7 @@ typedef struct _FTInstance {
     unsigned nglyphs;
     CharInfoPtr *glyphs;        /* glyphs and available are used in parallel */
     int **available;
+    FTGlyphCacheEntryPtr *cached; /* LRU entries, parallel to glyphs */
     struct TTCapInfo ttcap;
     int refcount;
     struct _FTInstance *next;   /* link to next instance */
@@ -93,6 +93,7 @@ static SPropertyRecord const validRecords[] =
     { "VeryLazyBitmapWidthScale", eRecTypeDouble  },
     { "ForceConstantSpacingCodeRange", eRecTypeString },
     { "ForceConstantSpacingMetrics", eRecTypeString },
+    { "PrefetchCodeRange",      eRecTypeString  },
     { "Dummy",                  eRecTypeVoid    }
 };
 static int const
@@ -117,7 +118,8 @@ static struct {
     { "eb", "EmbeddedBitmap" },
     { "hi", "Hinting" },
     { "fc", "ForceConstantSpacingCodeRange" },
-    { "fm", "ForceConstantSpacingMetrics" }
+    { "fm", "ForceConstantSpacingMetrics" },
+    { "pf", "PrefetchCodeRange" }
 };
 static int const
 numOfCorrespondRelations
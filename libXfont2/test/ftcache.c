@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the FreeType glyph cache never evicts a glyph that was handed
+ * out during the current request, in particular one that was already at
+ * the head of the LRU list when the request touched it.  The cache is
+ * shrunk to two glyphs and driven directly, without rasterising.
+ */
+
+/* An 8x16 glyph with byte padding */
+#define GLYPH_BYTES 16
+#define NGLYPHS 4
+
+#define FT_GLYPH_CACHE_SIZE (2 * GLYPH_BYTES)
+#include "../src/FreeType/ftfuncs.c"
+
+#include <assert.h>
+#include <stdarg.h>
+
+/*
+ * The test is linked against the few library sources ftfuncs.c needs
+ * rather than libXfont2 itself, so it stands in for src/stubs here.
+ */
+void
+ErrorF(const char *f, ...)
+{
+    va_list ap;
+
+    va_start(ap, f);
+    vfprintf(stderr, f, ap);
+    va_end(ap);
+}
+
+Atom
+MakeAtom(const char *string, unsigned len, int makeit)
+{
+    return __libxfont_internal__MakeAtom(string, len, makeit);
+}
+
+unsigned long
+__GetServerGeneration(void)
+{
+    return 1;
+}
+
+static void
+rasterise(FTInstancePtr instance, int offset)
+{
+    CharInfoPtr g = &instance->glyphs[0][offset];
+
+    g->metrics.leftSideBearing = 0;
+    g->metrics.rightSideBearing = 8;
+    g->metrics.ascent = 12;
+    g->metrics.descent = 4;
+    g->bits = calloc(1, GLYPH_BYTES);
+    assert(g->bits);
+    instance->available[0][offset] = FT_AVAILABLE_RASTERISED;
+    FTGlyphCacheAdd(instance, 0, offset);
+}
+
+static int
+resident(FTInstancePtr instance, int offset)
+{
+    return instance->available[0][offset] == FT_AVAILABLE_RASTERISED &&
+        instance->glyphs[0][offset].bits != NULL;
+}
+
+static void
+touched_head_survives_trim(void)
+{
+    CharInfoPtr glyphs[1];
+    int *available[1];
+    FTInstanceRec instance;
+    int i;
+
+    memset(&instance, 0, sizeof(instance));
+    instance.bmfmt.glyph = 1;
+    instance.nglyphs = NGLYPHS;
+    instance.glyphs = glyphs;
+    instance.available = available;
+    glyphs[0] = calloc(FONTSEGMENTSIZE, sizeof(CharInfoRec));
+    available[0] = calloc(FONTSEGMENTSIZE, sizeof(int));
+    assert(glyphs[0] && available[0]);
+
+    /* An earlier request leaves glyph 1 at the head of the list */
+    glyphCacheEpoch++;
+    rasterise(&instance, 0);
+    rasterise(&instance, 1);
+    assert(glyphCache.next == &instance.cached[0][1]);
+
+    /* This request hands out the head first, then needs two more glyphs,
+       which pushes the cache over its limit twice */
+    glyphCacheEpoch++;
+    FTGlyphCacheTouch(&instance, 0, 1);
+    rasterise(&instance, 2);
+    assert(!resident(&instance, 0));
+    rasterise(&instance, 3);
+    assert(resident(&instance, 1));
+    assert(resident(&instance, 2));
+    assert(resident(&instance, 3));
+
+    /* The next request may evict all of them again */
+    glyphCacheEpoch++;
+    FTGlyphCacheTouch(&instance, 0, 3);
+    rasterise(&instance, 0);
+    assert(!resident(&instance, 1));
+    assert(!resident(&instance, 2));
+    assert(glyphCacheSize == FT_GLYPH_CACHE_SIZE);
+
+    for (i = 0; i < NGLYPHS; i++) {
+        if (instance.cached[0][i].next)
+            FTGlyphCacheUnlink(&instance.cached[0][i]);
+        free(glyphs[0][i].bits);
+    }
+    free(instance.cached[0]);
+    free(instance.cached);
+    free(glyphs[0]);
+    free(available[0]);
+}
+
+int
+main(void)
+{
+    touched_head_survives_trim();
+    return 0;
+}
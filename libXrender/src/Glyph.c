@@ -106,8 +106,25 @@ XRenderAddGlyphs (Display	*dpy,
     len = (nglyphs * (SIZEOF (xGlyphInfo) + 4) + nbyte_images) >> 2;
     SetReqLen(req, len, len);
     Data32 (dpy, (long *) gids, nglyphs * 4);
-    Data16 (dpy, (short *) glyphs, nglyphs * SIZEOF (xGlyphInfo));
-    Data (dpy, images, nbyte_images);
+    /*
+     * Large glyph images go out straight from the caller's memory,
+     * together with the glyph metrics, in a single write.
+     */
+    if (dpy->bufptr + nglyphs * SIZEOF (xGlyphInfo) + nbyte_images > dpy->bufmax)
+    {
+	_XDataVec vec[2];
+
+	vec[0].data = (_Xconst char *) glyphs;
+	vec[0].size = nglyphs * SIZEOF (xGlyphInfo);
+	vec[1].data = images;
+	vec[1].size = nbyte_images;
+	_XSendv (dpy, vec, 2);
+    }
+    else
+    {
+	Data16 (dpy, (short *) glyphs, nglyphs * SIZEOF (xGlyphInfo));
+	Data (dpy, images, nbyte_images);
+    }
     UnlockDisplay(dpy);
     SyncHandle();
 }
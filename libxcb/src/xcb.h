@@ -603,6 +603,20 @@ xcb_connection_t *xcb_connect_to_display_with_auth_info(const char *display, xcb
  */
 uint32_t xcb_generate_id(xcb_connection_t *c);
 
+/**
+ * @brief Returns an XID for reuse by xcb_generate_id().
+ * @param c The connection.
+ * @param id An XID from xcb_generate_id() whose object has been freed.
+ *
+ * Call this after sending the request that frees the object, such as
+ * xcb_free_pixmap.  Recycled XIDs are handed out again before new ones,
+ * which lets clients that create and free many objects keep within
+ * their XID range instead of asking the server for more.  The server
+ * may still send events naming the old object after the XID has been
+ * reused.
+ */
+void xcb_recycle_id(xcb_connection_t *c, uint32_t id);
+
 
 /**
  * @}
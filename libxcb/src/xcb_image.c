@@ -30,6 +30,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#ifndef _WIN32
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
 
 #include <xcb/xcb.h>
 #include <xcb/shm.h>
@@ -531,6 +535,345 @@ xcb_image_shm_get (xcb_connection_t *      conn,
 }
 
 
+/*
+ * Shm segment pool
+ */
+
+/* Idle segments kept attached for reuse. */
+#define SHM_POOL_IDLE 4
+
+typedef struct shm_pool_segment_t shm_pool_segment_t;
+
+struct shm_pool_segment_t {
+  shm_pool_segment_t *          next;
+  xcb_shm_segment_info_t        info;
+  uint32_t                      size;
+  int                           busy;    /* held by an image */
+  int                           fenced;  /* a ShmPutImage may still read it */
+  xcb_get_input_focus_cookie_t  fence;
+};
+
+struct xcb_image_shm_pool_t {
+  xcb_connection_t *    conn;
+  int                   shared;  /* 1 yes, 0 no, -1 not tried yet */
+  shm_pool_segment_t *  segments;
+};
+
+
+xcb_image_shm_pool_t *
+xcb_image_shm_pool_create (xcb_connection_t *conn)
+{
+  xcb_image_shm_pool_t *  pool = malloc(sizeof(*pool));
+
+  if (!pool)
+      return 0;
+  pool->conn = conn;
+  pool->segments = 0;
+#ifdef _WIN32
+  pool->shared = 0;
+#else
+  {
+      const xcb_query_extension_reply_t *  ext;
+
+      ext = xcb_get_extension_data(conn, &xcb_shm_id);
+      pool->shared = ext && ext->present ? -1 : 0;
+  }
+#endif
+  return pool;
+}
+
+
+/* Wait until the server has read everything queued from the segment. */
+static void
+shm_pool_wait_fence (xcb_image_shm_pool_t *pool, shm_pool_segment_t *seg)
+{
+  if (!seg->fenced)
+      return;
+  free(xcb_get_input_focus_reply(pool->conn, seg->fence, 0));
+  seg->fenced = 0;
+}
+
+
+static void
+shm_pool_segment_destroy (xcb_image_shm_pool_t *pool, shm_pool_segment_t *seg)
+{
+#ifndef _WIN32
+  shm_pool_wait_fence(pool, seg);
+  xcb_shm_detach(pool->conn, seg->info.shmseg);
+  shmdt(seg->info.shmaddr);
+#endif
+  free(seg);
+}
+
+
+void
+xcb_image_shm_pool_destroy (xcb_image_shm_pool_t *pool)
+{
+  shm_pool_segment_t *  seg;
+
+  if (!pool)
+      return;
+  while ((seg = pool->segments)) {
+      pool->segments = seg->next;
+      shm_pool_segment_destroy(pool, seg);
+  }
+  free(pool);
+}
+
+
+static shm_pool_segment_t *
+shm_pool_segment_create (xcb_image_shm_pool_t *pool, uint32_t size)
+{
+#ifdef _WIN32
+  return 0;
+#else
+  shm_pool_segment_t *   seg;
+  xcb_generic_error_t *  err;
+  int                    shmid;
+  void *                 addr;
+  uint32_t               id;
+
+  /* Round up so that segments can be reused for nearby sizes. */
+  if (size > UINT32_MAX - 0xffff)
+      return 0;
+  size = (size + 0xffff) & ~0xffff;
+  id = xcb_generate_id(pool->conn);
+  if (id == (uint32_t) -1)
+      return 0;
+  seg = malloc(sizeof(*seg));
+  if (!seg)
+      return 0;
+  shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+  if (shmid == -1) {
+      free(seg);
+      return 0;
+  }
+  addr = shmat(shmid, 0, 0);
+  if (addr == (void *) -1) {
+      shmctl(shmid, IPC_RMID, 0);
+      free(seg);
+      return 0;
+  }
+  err = xcb_request_check(pool->conn,
+			  xcb_shm_attach_checked(pool->conn, id, shmid, 0));
+  /* Once attached, the segment goes away with the last detach. */
+  shmctl(shmid, IPC_RMID, 0);
+  if (err) {
+      /* The server cannot see our memory, e.g. it is remote. */
+      free(err);
+      shmdt(addr);
+      free(seg);
+      pool->shared = 0;
+      return 0;
+  }
+  pool->shared = 1;
+  seg->info.shmseg = id;
+  seg->info.shmid = shmid;
+  seg->info.shmaddr = addr;
+  seg->size = size;
+  seg->busy = 0;
+  seg->fenced = 0;
+  seg->next = pool->segments;
+  pool->segments = seg;
+  return seg;
+#endif
+}
+
+
+/* The idle segment that fits @p size most tightly, or a new one. */
+static shm_pool_segment_t *
+shm_pool_acquire (xcb_image_shm_pool_t *pool, uint32_t size)
+{
+  shm_pool_segment_t *  best = 0;
+  shm_pool_segment_t *  seg;
+
+  if (!pool->shared)
+      return 0;
+  for (seg = pool->segments; seg; seg = seg->next)
+      if (!seg->busy && seg->size >= size &&
+	  (!best || seg->size < best->size))
+	  best = seg;
+  if (!best)
+      best = shm_pool_segment_create(pool, size);
+  if (!best)
+      return 0;
+  shm_pool_wait_fence(pool, best);
+  best->busy = 1;
+  return best;
+}
+
+
+static shm_pool_segment_t *
+shm_pool_find (xcb_image_shm_pool_t *pool, xcb_image_t *image)
+{
+  shm_pool_segment_t *  seg;
+
+  for (seg = pool->segments; seg; seg = seg->next)
+      if (seg->busy && seg->info.shmaddr == image->data)
+	  return seg;
+  return 0;
+}
+
+
+xcb_image_t *
+xcb_image_shm_pool_image (xcb_image_shm_pool_t *  pool,
+			  uint16_t                width,
+			  uint16_t                height,
+			  xcb_image_format_t      format,
+			  uint8_t                 depth)
+{
+  xcb_image_t *         image;
+  shm_pool_segment_t *  seg;
+
+  image = xcb_image_create_native(pool->conn, width, height, format, depth,
+				  0, ~0, 0);
+  if (!image)
+      return 0;
+  seg = shm_pool_acquire(pool, image->size);
+  if (seg) {
+      image->data = seg->info.shmaddr;
+      return image;
+  }
+  image->base = malloc(image->size);
+  image->data = image->base;
+  if (!image->data) {
+      free(image);
+      return 0;
+  }
+  return image;
+}
+
+
+void
+xcb_image_shm_pool_release (xcb_image_shm_pool_t *pool, xcb_image_t *image)
+{
+  shm_pool_segment_t *   seg = shm_pool_find(pool, image);
+  shm_pool_segment_t **  prev;
+  shm_pool_segment_t *   s;
+  int                    idle = 0;
+
+  xcb_image_destroy(image);
+  if (!seg)
+      return;
+  seg->busy = 0;
+  for (s = pool->segments; s; s = s->next)
+      idle += !s->busy;
+  if (idle <= SHM_POOL_IDLE)
+      return;
+  for (prev = &pool->segments; *prev != seg; prev = &(*prev)->next)
+      ;
+  *prev = seg->next;
+  shm_pool_segment_destroy(pool, seg);
+}
+
+
+void
+xcb_image_shm_pool_wait (xcb_image_shm_pool_t *pool, xcb_image_t *image)
+{
+  shm_pool_segment_t *  seg = shm_pool_find(pool, image);
+
+  if (seg)
+      shm_pool_wait_fence(pool, seg);
+}
+
+
+/* PutImage split into row strips that fit the maximum request length. */
+static void
+put_image_strips (xcb_connection_t *  conn,
+		  xcb_drawable_t      draw,
+		  xcb_gcontext_t      gc,
+		  xcb_image_t *       image,
+		  int16_t             x,
+		  int16_t             y)
+{
+  uint32_t  max = xcb_get_maximum_request_length(conn) * 4;
+  uint32_t  rows;
+  uint32_t  row;
+
+  /* Leave room for the header and a BIG-REQUESTS length. */
+  max -= sizeof(xcb_put_image_request_t) + 4;
+  rows = max / image->stride;
+  if (image->size <= max || rows == 0 ||
+      (image->format != XCB_IMAGE_FORMAT_Z_PIXMAP && image->depth > 1)) {
+      xcb_image_put(conn, draw, gc, image, x, y, 0);
+      return;
+  }
+  for (row = 0; row < image->height; row += rows) {
+      if (rows > image->height - row)
+	  rows = image->height - row;
+      xcb_put_image(conn, image->format, draw, gc,
+		    image->width, rows,
+		    x, y + row,
+		    0, image->depth,
+		    rows * image->stride,
+		    image->data + row * image->stride);
+  }
+}
+
+
+void
+xcb_image_shm_pool_put (xcb_image_shm_pool_t *  pool,
+			xcb_drawable_t          draw,
+			xcb_gcontext_t          gc,
+			xcb_image_t *           image,
+			int16_t                 x,
+			int16_t                 y)
+{
+  shm_pool_segment_t *  seg = shm_pool_find(pool, image);
+
+  if (!seg) {
+      put_image_strips(pool->conn, draw, gc, image, x, y);
+      return;
+  }
+  xcb_shm_put_image(pool->conn, draw, gc,
+		    image->width, image->height,
+		    0, 0, image->width, image->height,
+		    x, y,
+		    image->depth, image->format,
+		    0,
+		    seg->info.shmseg, 0);
+  /* The server has read the segment once it answers a later request;
+   * only the newest fence matters. */
+  if (seg->fenced)
+      xcb_discard_reply(pool->conn, seg->fence.sequence);
+  seg->fence = xcb_get_input_focus(pool->conn);
+  seg->fenced = 1;
+}
+
+
+int
+xcb_image_shm_pool_get (xcb_image_shm_pool_t *  pool,
+			xcb_drawable_t          draw,
+			xcb_image_t *           image,
+			int16_t                 x,
+			int16_t                 y,
+			uint32_t                plane_mask)
+{
+  shm_pool_segment_t *        seg = shm_pool_find(pool, image);
+  xcb_get_image_cookie_t      cookie;
+  xcb_get_image_reply_t *     reply;
+
+  if (seg) {
+      shm_pool_wait_fence(pool, seg);
+      return xcb_image_shm_get(pool->conn, draw, image, seg->info,
+			       x, y, plane_mask);
+  }
+  cookie = xcb_get_image(pool->conn, image->format, draw,
+			 x, y, image->width, image->height, plane_mask);
+  reply = xcb_get_image_reply(pool->conn, cookie, 0);
+  if (!reply)
+      return 0;
+  if (reply->depth != image->depth ||
+      xcb_get_image_data_length(reply) != image->size) {
+      free(reply);
+      return 0;
+  }
+  memcpy(image->data, xcb_get_image_data(reply), image->size);
+  free(reply);
+  return 1;
+}
+
+
 static uint32_t
 xy_image_byte (xcb_image_t *image, uint32_t x)
 {
@@ -916,6 +1259,274 @@ conversion_byte_swap(xcb_image_t *src, xcb_image_t *dst)
     }
 }
 
+/*
+ * Row converters for z-pixmaps of 8, 16, 24 and 32 bits per pixel.
+ * They give the same pixels as xcb_image_get_pixel() followed by
+ * xcb_image_put_pixel(), so values are truncated to, or zero extended
+ * from, the destination's pixel size.  Rows go through a small buffer
+ * of host-order pixels; pairs of 24 and 32 bit formats are done four
+ * pixels at a time with one byte shuffle where the CPU has SSSE3, and
+ * byte swaps of 16 and 32 bit pixels use SSE2 otherwise.
+ */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SSE2_CONVERT
+#include <emmintrin.h>
+#if defined(__SSSE3__) || defined(__AVX__)
+#define USE_SSSE3_CONVERT
+#define TARGET_SSSE3
+#include <tmmintrin.h>
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define USE_SSSE3_CONVERT
+#define CHECK_SSSE3_CONVERT
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#include <immintrin.h>
+#endif
+#endif
+
+#define CONVERT_BLOCK 64
+
+typedef struct {
+  uint8_t  src_bpp;
+  uint8_t  dst_bpp;
+  int      src_msb;
+  int      dst_msb;
+  int      shuffle;	/* four pixels per SSSE3 byte shuffle */
+  int8_t   mask[16];	/* the shuffle, -1 clears the byte */
+} row_converter_t;
+
+static void
+load_pixels (const uint8_t *src, uint32_t *pixels, uint32_t n,
+	     uint8_t bpp, int msb)
+{
+  uint32_t i;
+
+  switch (bpp) {
+  case 8:
+      for (i = 0; i < n; i++)
+	  pixels[i] = src[i];
+      break;
+  case 16:
+      if (msb)
+	  for (i = 0; i < n; i++, src += 2)
+	      pixels[i] = (src[0] << 8) | src[1];
+      else
+	  for (i = 0; i < n; i++, src += 2)
+	      pixels[i] = src[0] | (src[1] << 8);
+      break;
+  case 24:
+      if (msb)
+	  for (i = 0; i < n; i++, src += 3)
+	      pixels[i] = (src[0] << 16) | (src[1] << 8) | src[2];
+      else
+	  for (i = 0; i < n; i++, src += 3)
+	      pixels[i] = src[0] | (src[1] << 8) | (src[2] << 16);
+      break;
+  case 32:
+      if (msb)
+	  for (i = 0; i < n; i++, src += 4)
+	      pixels[i] = ((uint32_t)src[0] << 24) | (src[1] << 16) |
+			  (src[2] << 8) | src[3];
+      else
+	  for (i = 0; i < n; i++, src += 4)
+	      pixels[i] = src[0] | (src[1] << 8) | (src[2] << 16) |
+			  ((uint32_t)src[3] << 24);
+      break;
+  }
+}
+
+static void
+store_pixels (uint8_t *dst, const uint32_t *pixels, uint32_t n,
+	      uint8_t bpp, int msb)
+{
+  uint32_t i;
+
+  switch (bpp) {
+  case 8:
+      for (i = 0; i < n; i++)
+	  dst[i] = pixels[i];
+      break;
+  case 16:
+      if (msb)
+	  for (i = 0; i < n; i++, dst += 2) {
+	      dst[0] = pixels[i] >> 8;
+	      dst[1] = pixels[i];
+	  }
+      else
+	  for (i = 0; i < n; i++, dst += 2) {
+	      dst[0] = pixels[i];
+	      dst[1] = pixels[i] >> 8;
+	  }
+      break;
+  case 24:
+      if (msb)
+	  for (i = 0; i < n; i++, dst += 3) {
+	      dst[0] = pixels[i] >> 16;
+	      dst[1] = pixels[i] >> 8;
+	      dst[2] = pixels[i];
+	  }
+      else
+	  for (i = 0; i < n; i++, dst += 3) {
+	      dst[0] = pixels[i];
+	      dst[1] = pixels[i] >> 8;
+	      dst[2] = pixels[i] >> 16;
+	  }
+      break;
+  case 32:
+      if (msb)
+	  for (i = 0; i < n; i++, dst += 4) {
+	      dst[0] = pixels[i] >> 24;
+	      dst[1] = pixels[i] >> 16;
+	      dst[2] = pixels[i] >> 8;
+	      dst[3] = pixels[i];
+	  }
+      else
+	  for (i = 0; i < n; i++, dst += 4) {
+	      dst[0] = pixels[i];
+	      dst[1] = pixels[i] >> 8;
+	      dst[2] = pixels[i] >> 16;
+	      dst[3] = pixels[i] >> 24;
+	  }
+      break;
+  }
+}
+
+#ifdef USE_SSSE3_CONVERT
+#ifdef CHECK_SSSE3_CONVERT
+static int
+have_ssse3 (void)
+{
+  static int ssse3 = -1;
+
+  if (ssse3 < 0) {
+      __builtin_cpu_init();
+      ssse3 = __builtin_cpu_supports("ssse3") ? 1 : 0;
+  }
+  return ssse3;
+}
+#else
+#define have_ssse3() 1
+#endif
+
+/* Converts whole groups of four pixels while the sixteen byte loads
+ * and stores stay inside the rows; returns the pixels done. */
+TARGET_SSSE3
+static uint32_t
+ssse3_convert_run (const row_converter_t *conv,
+		   const uint8_t *src, uint32_t src_bytes,
+		   uint8_t *dst, uint32_t dst_bytes,
+		   uint32_t width)
+{
+  __m128i   mask = _mm_loadu_si128((const __m128i *) conv->mask);
+  uint32_t  sb = conv->src_bpp >> 3;
+  uint32_t  db = conv->dst_bpp >> 3;
+  uint32_t  x;
+
+  for (x = 0; x + 4 <= width &&
+	   x * sb + 16 <= src_bytes && x * db + 16 <= dst_bytes; x += 4) {
+      __m128i p = _mm_loadu_si128((const __m128i *) (src + x * sb));
+      _mm_storeu_si128((__m128i *) (dst + x * db), _mm_shuffle_epi8(p, mask));
+  }
+  return x;
+}
+#endif
+
+#ifdef USE_SSE2_CONVERT
+/* Byte swaps 16 or 32 bit pixels sixteen bytes at a time; returns the
+ * pixels done. */
+static uint32_t
+sse2_swap_run (const uint8_t *src, uint8_t *dst, uint32_t width, uint8_t bpp)
+{
+  uint32_t  n = width * (bpp >> 3);
+  uint32_t  i;
+
+  for (i = 0; i + 16 <= n; i += 16) {
+      __m128i p = _mm_loadu_si128((const __m128i *) (src + i));
+      p = _mm_or_si128(_mm_slli_epi16(p, 8), _mm_srli_epi16(p, 8));
+      if (bpp == 32)
+	  p = _mm_shufflehi_epi16(_mm_shufflelo_epi16(p, _MM_SHUFFLE(2, 3, 0, 1)),
+				  _MM_SHUFFLE(2, 3, 0, 1));
+      _mm_storeu_si128((__m128i *) (dst + i), p);
+  }
+  return i / (bpp >> 3);
+}
+#endif
+
+static void
+row_converter_init (row_converter_t *conv, xcb_image_t *src, xcb_image_t *dst)
+{
+  int  sb = src->bpp >> 3, db = dst->bpp >> 3;
+  int  p, k;
+
+  conv->src_bpp = src->bpp;
+  conv->dst_bpp = dst->bpp;
+  conv->src_msb = src->byte_order == XCB_IMAGE_ORDER_MSB_FIRST;
+  conv->dst_msb = dst->byte_order == XCB_IMAGE_ORDER_MSB_FIRST;
+  conv->shuffle = 0;
+#ifdef USE_SSSE3_CONVERT
+  conv->shuffle = sb >= 3 && db >= 3 && have_ssse3();
+#endif
+  /* byte k of output pixel p holds the byte of the same
+   * significance from input pixel p, or zero */
+  memset(conv->mask, -1, sizeof(conv->mask));
+  for (p = 0; p < 4; p++) {
+      for (k = 0; k < db; k++) {
+	  int sig = conv->dst_msb ? db - 1 - k : k;
+	  if (sig < sb)
+	      conv->mask[p * db + k] =
+		  p * sb + (conv->src_msb ? sb - 1 - sig : sig);
+      }
+  }
+}
+
+static void
+convert_row (const row_converter_t *conv,
+	     const uint8_t *src, uint32_t src_bytes,
+	     uint8_t *dst, uint32_t dst_bytes,
+	     uint32_t width)
+{
+  uint32_t  pixels[CONVERT_BLOCK];
+  uint32_t  sb = conv->src_bpp >> 3;
+  uint32_t  db = conv->dst_bpp >> 3;
+  uint32_t  x = 0;
+
+  if (sb == db && (sb == 1 || conv->src_msb == conv->dst_msb)) {
+      memcpy(dst, src, width * sb);
+      return;
+  }
+#ifdef USE_SSSE3_CONVERT
+  if (conv->shuffle)
+      x = ssse3_convert_run(conv, src, src_bytes, dst, dst_bytes, width);
+  else
+#endif
+#ifdef USE_SSE2_CONVERT
+  if (sb == db && sb != 3 && conv->src_msb != conv->dst_msb)
+      x = sse2_swap_run(src, dst, width, conv->src_bpp);
+#endif
+  while (x < width) {
+      uint32_t n = width - x < CONVERT_BLOCK ? width - x : CONVERT_BLOCK;
+      load_pixels(src + x * sb, pixels, n, conv->src_bpp, conv->src_msb);
+      store_pixels(dst + x * db, pixels, n, conv->dst_bpp, conv->dst_msb);
+      x += n;
+  }
+}
+
+/* src and dst are z-pixmaps of 8 or more bits per pixel */
+static void
+convert_z_image (xcb_image_t *src, xcb_image_t *dst)
+{
+  row_converter_t  conv;
+  uint32_t         y;
+
+  row_converter_init(&conv, src, dst);
+  for (y = 0; y < src->height; y++)
+      convert_row(&conv,
+		  src->data + y * src->stride, src->size - y * src->stride,
+		  dst->data + y * dst->stride, dst->size - y * dst->stride,
+		  src->width);
+}
+
 xcb_image_t *
 xcb_image_convert (xcb_image_t *  src,
 		   xcb_image_t *  dst)
@@ -944,6 +1555,8 @@ xcb_image_convert (xcb_image_t *  src,
 	(ef == XCB_IMAGE_FORMAT_Z_PIXMAP ||
 	 src->bit_order == dst->bit_order)) {
       memcpy(dst->data, src->data, src->size);
+    } else if (ef == XCB_IMAGE_FORMAT_Z_PIXMAP && src->bpp >= 8) {
+      convert_z_image(src, dst);
     } else {
       int	bitswap = 0;
       int	nibbleswap = 0;
@@ -962,12 +1575,17 @@ xcb_image_convert (xcb_image_t *  src,
 		  height, byteswap, bitswap, nibbleswap);
     }
   }
+  else if (ef == XCB_IMAGE_FORMAT_Z_PIXMAP &&
+	   effective_format(dst->format, dst->bpp) == XCB_IMAGE_FORMAT_Z_PIXMAP &&
+	   src->bpp >= 8 && dst->bpp >= 8)
+  {
+    convert_z_image(src, dst);
+  }
   else
   {
     uint32_t            x;
     uint32_t            y;
-    /* General case: Slow pixel copy. Should we optimize
-       Z24<->Z32 copies of either endianness? */
+    /* General case: Slow pixel copy. */
     for (y = 0; y < src->height; y++) {
 	for (x = 0; x < src->width; x++) {
 	    uint32_t  pixel = xcb_image_get_pixel(src, x, y);
@@ -1002,6 +1620,16 @@ xcb_image_subimage(xcb_image_t *  image,
 			      base, bytes, data);
     if (!result)
 	return 0;
+    if (effective_format(image->format, image->bpp) == XCB_IMAGE_FORMAT_Z_PIXMAP &&
+	image->bpp >= 8) {
+	uint32_t  bytes_per_pixel = image->bpp >> 3;
+
+	for (j = 0; j < height; j++)
+	    memcpy(result->data + j * result->stride,
+		   image->data + (y + j) * image->stride + x * bytes_per_pixel,
+		   width * bytes_per_pixel);
+	return result;
+    }
     /* XXX FIXME  For now, lose on performance. Sorry. */
     for (j = 0; j < height; j++) {
 	for (i = 0; i < width; i++) {
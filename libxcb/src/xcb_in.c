@@ -83,6 +83,18 @@ struct reply_list {
     struct reply_list *next;
 };
 
+/* Every event, error and reply is allocated together with the list node
+ * that queues it: the node lives after the packet data, so each packet
+ * costs one malloc() and the free() the caller does on the packet
+ * releases the node too. */
+union packet_node {
+    struct event_list event;
+    struct reply_list reply;
+};
+
+#define PACKET_NODE_OFFSET(size) \
+    (((size) + sizeof(union packet_node) - 1) & ~(uint64_t) (sizeof(union packet_node) - 1))
+
 typedef struct pending_reply {
     uint64_t first_request;
     uint64_t last_request;
@@ -175,15 +187,15 @@ static int read_packet(xcb_connection_t *c)
     int nfd = 0;         /* Number of file descriptors attached to the reply */
     uint64_t bufsize;
     void *buf;
+    union packet_node *node;
     pending_reply *pend = 0;
-    struct event_list *event;
 
     /* Wait for there to be enough data for us to read a whole packet */
     if(c->in.queue_len < length)
         return 0;
 
     /* Get the response type, length, and sequence number. */
-    memcpy(&genrep, c->in.queue, sizeof(genrep));
+    memcpy(&genrep, c->in.queue + c->in.queue_start, sizeof(genrep));
 
     /* Compute 32-bit sequence number of this packet. */
     if((genrep.response_type & 0x7f) != XCB_KEYMAP_NOTIFY)
@@ -214,6 +226,7 @@ static int read_packet(xcb_connection_t *c)
             c->in.pending_replies = oldpend->next;
             if(!oldpend->next)
                 c->in.pending_replies_tail = &c->in.pending_replies;
+            _xcb_map_remove(c->in.pending_index, oldpend->first_request);
             free(oldpend);
         }
 
@@ -238,7 +251,7 @@ static int read_packet(xcb_connection_t *c)
     {
         if(pend && pend->workaround == WORKAROUND_GLX_GET_FB_CONFIGS_BUG)
         {
-            uint32_t *p = (uint32_t *) c->in.queue;
+            uint32_t *p = (uint32_t *) (c->in.queue + c->in.queue_start);
             genrep.length = p[2] * p[3] * 2;
         }
         length += genrep.length * 4;
@@ -256,7 +269,7 @@ static int read_packet(xcb_connection_t *c)
     bufsize = length + eventlength + nfd * sizeof(int)  +
         (genrep.response_type == XCB_REPLY ? 0 : sizeof(uint32_t));
     if (bufsize < INT32_MAX)
-        buf = malloc((size_t) bufsize);
+        buf = malloc((size_t) PACKET_NODE_OFFSET(bufsize) + sizeof(union packet_node));
     else
         buf = NULL;
     if(!buf)
@@ -301,17 +314,13 @@ static int read_packet(xcb_connection_t *c)
     if(genrep.response_type != XCB_REPLY)
         ((xcb_generic_event_t *) buf)->full_sequence = c->in.request_read;
 
+    node = (union packet_node *) ((char *) buf + PACKET_NODE_OFFSET(bufsize));
+
     /* reply, or checked error */
     if( genrep.response_type == XCB_REPLY ||
        (genrep.response_type == XCB_ERROR && pend && (pend->flags & XCB_REQUEST_CHECKED)))
     {
-        struct reply_list *cur = malloc(sizeof(struct reply_list));
-        if(!cur)
-        {
-            _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
-            free(buf);
-            return 0;
-        }
+        struct reply_list *cur = &node->reply;
         cur->reply = buf;
         cur->next = 0;
         *c->in.current_reply_tail = cur;
@@ -322,19 +331,12 @@ static int read_packet(xcb_connection_t *c)
     }
 
     /* event, or unchecked error */
-    event = malloc(sizeof(struct event_list));
-    if(!event)
-    {
-        _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
-        free(buf);
-        return 0;
-    }
-    event->event = buf;
-    event->next = 0;
+    node->event.event = buf;
+    node->event.next = 0;
 
-    if (!event_special(c, event)) {
-        *c->in.events_tail = event;
-        c->in.events_tail = &event->next;
+    if (!event_special(c, &node->event)) {
+        *c->in.events_tail = &node->event;
+        c->in.events_tail = &node->event.next;
         pthread_cond_signal(&c->in.event_cond);
     }
     return 1; /* I have something for you... */
@@ -350,7 +352,6 @@ static xcb_generic_event_t *get_event(xcb_connection_t *c)
     c->in.events = cur->next;
     if(!cur->next)
         c->in.events_tail = &c->in.events;
-    free(cur);
     return ret;
 }
 
@@ -361,7 +362,6 @@ static void free_reply_list(struct reply_list *head)
         struct reply_list *cur = head;
         head = cur->next;
         free(cur->reply);
-        free(cur);
     }
 }
 
@@ -453,8 +453,6 @@ static int poll_for_reply(xcb_connection_t *c, uint64_t request, void **reply, x
         }
         else
             *reply = head->reply;
-
-        free(head);
     }
 
     return 1;
@@ -581,6 +579,12 @@ static void insert_pending_discard(xcb_connection_t *c, pending_reply **prev_nex
     pend->last_request = seq;
     pend->workaround = 0;
     pend->flags = XCB_REQUEST_DISCARD_REPLY;
+    if(!_xcb_map_put(c->in.pending_index, seq, pend))
+    {
+        free(pend);
+        _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
+        return;
+    }
     pend->next = *prev_next;
     *prev_next = pend;
 
@@ -591,6 +595,7 @@ static void insert_pending_discard(xcb_connection_t *c, pending_reply **prev_nex
 static void discard_reply(xcb_connection_t *c, uint64_t request)
 {
     void *reply;
+    pending_reply *pend;
     pending_reply **prev_pend;
 
     /* Free any replies or errors that we've already read. Stop if
@@ -602,21 +607,25 @@ static void discard_reply(xcb_connection_t *c, uint64_t request)
     if(XCB_SEQUENCE_COMPARE(request, <=, c->in.request_completed))
         return;
 
-    /* Walk the list of pending requests. Mark the first match for deletion. */
-    for(prev_pend = &c->in.pending_replies; *prev_pend; prev_pend = &(*prev_pend)->next)
+    /* Look the request up among the pending requests. Mark it for deletion. */
+    pend = _xcb_map_get(c->in.pending_index, request);
+    if(pend && pend->first_request == request)
     {
-        if(XCB_SEQUENCE_COMPARE((*prev_pend)->first_request, >, request))
-            break;
-
-        if((*prev_pend)->first_request == request)
-        {
-            /* Pending reply found. Mark for discard: */
-            (*prev_pend)->flags |= XCB_REQUEST_DISCARD_REPLY;
-            return;
-        }
+        pend->flags |= XCB_REQUEST_DISCARD_REPLY;
+        return;
     }
 
-    /* Pending reply not found (likely due to _unchecked request). Create one: */
+    /* Pending reply not found (likely due to _unchecked request). Create
+     * one, keeping the list in request order. Requests are usually
+     * discarded in the order they were sent, so try the tail first. */
+    prev_pend = c->in.pending_replies_tail;
+    if(prev_pend != &c->in.pending_replies &&
+       XCB_SEQUENCE_COMPARE(container_of(prev_pend, pending_reply, next)->first_request, >, request))
+    {
+        for(prev_pend = &c->in.pending_replies; *prev_pend; prev_pend = &(*prev_pend)->next)
+            if(XCB_SEQUENCE_COMPARE((*prev_pend)->first_request, >, request))
+                break;
+    }
     insert_pending_discard(c, prev_pend, request);
 }
 
@@ -758,7 +767,6 @@ static xcb_generic_event_t *get_special_event(xcb_connection_t *c,
         event = events->event;
         if (!(se->events = events->next))
             se->events_tail = &se->events;
-        free (events);
     }
     return event;
 }
@@ -866,7 +874,6 @@ xcb_unregister_for_special_event(xcb_connection_t *c,
             for (events = se->events; events; events = next) {
                 next = events->next;
                 free (events->event);
-                free (events);
             }
             pthread_cond_destroy(&se->special_event_cond);
             free (se);
@@ -884,6 +891,7 @@ int _xcb_in_init(_xcb_in *in)
         return 0;
     in->reading = 0;
 
+    in->queue_start = 0;
     in->queue_len = 0;
 
     in->request_read = 0;
@@ -893,6 +901,10 @@ int _xcb_in_init(_xcb_in *in)
     if(!in->replies)
         return 0;
 
+    in->pending_index = _xcb_map_new();
+    if(!in->pending_index)
+        return 0;
+
     in->current_reply_tail = &in->current_reply;
     in->events_tail = &in->events;
     in->pending_replies_tail = &in->pending_replies;
@@ -910,7 +922,6 @@ void _xcb_in_destroy(_xcb_in *in)
         struct event_list *e = in->events;
         in->events = e->next;
         free(e->event);
-        free(e);
     }
     while(in->pending_replies)
     {
@@ -918,6 +929,7 @@ void _xcb_in_destroy(_xcb_in *in)
         in->pending_replies = pend->next;
         free(pend);
     }
+    _xcb_map_delete(in->pending_index, 0);
 }
 
 void _xcb_in_wake_up_next_reader(xcb_connection_t *c)
@@ -945,6 +957,12 @@ int _xcb_in_expect_reply(xcb_connection_t *c, uint64_t request, enum workarounds
     pend->workaround = workaround;
     pend->flags = flags;
     pend->next = 0;
+    if(!_xcb_map_put(c->in.pending_index, request, pend))
+    {
+        free(pend);
+        _xcb_conn_shutdown(c, XCB_CONN_CLOSED_MEM_INSUFFICIENT);
+        return 0;
+    }
     *c->in.pending_replies_tail = pend;
     c->in.pending_replies_tail = &pend->next;
     return 1;
@@ -970,6 +988,7 @@ void _xcb_in_replies_done(xcb_connection_t *c)
                     prev_next = &(*prev_next)->next;
                 *prev_next = NULL;
                 c->in.pending_replies_tail = prev_next;
+                _xcb_map_remove(c->in.pending_index, pend->first_request);
                 free(pend);
             }
         }
@@ -979,11 +998,12 @@ void _xcb_in_replies_done(xcb_connection_t *c)
 int _xcb_in_read(xcb_connection_t *c)
 {
     int n;
+    int queue_end = c->in.queue_start + c->in.queue_len;
 
 #if HAVE_SENDMSG
     struct iovec    iov = {
-        .iov_base = c->in.queue + c->in.queue_len,
-        .iov_len = sizeof(c->in.queue) - c->in.queue_len,
+        .iov_base = c->in.queue + queue_end,
+        .iov_len = sizeof(c->in.queue) - queue_end,
     };
     union {
         struct cmsghdr cmsghdr;
@@ -1009,7 +1029,7 @@ int _xcb_in_read(xcb_connection_t *c)
         return 0;
     }
 #else
-    n = recv(c->fd, c->in.queue + c->in.queue_len, sizeof(c->in.queue) - c->in.queue_len, 0);
+    n = recv(c->fd, c->in.queue + queue_end, sizeof(c->in.queue) - queue_end, 0);
 #endif
     if(n > 0) {
 #if HAVE_SENDMSG
@@ -1029,6 +1049,13 @@ int _xcb_in_read(xcb_connection_t *c)
     }
     while(read_packet(c))
         /* empty */;
+    /* read_packet consumes the queue from the front without moving what
+     * is left, so move a trailing partial packet down once per read. */
+    if(c->in.queue_start)
+    {
+        memmove(c->in.queue, c->in.queue + c->in.queue_start, c->in.queue_len);
+        c->in.queue_start = 0;
+    }
 #if HAVE_SENDMSG
     if (c->in.in_fd.nfd) {
         c->in.in_fd.nfd -= c->in.in_fd.ifd;
@@ -1066,9 +1093,9 @@ int _xcb_in_read_block(xcb_connection_t *c, void *buf, int len)
     if(len < done)
         done = len;
 
-    memcpy(buf, c->in.queue, done);
+    memcpy(buf, c->in.queue + c->in.queue_start, done);
     c->in.queue_len -= done;
-    memmove(c->in.queue, c->in.queue + done, c->in.queue_len);
+    c->in.queue_start = c->in.queue_len ? c->in.queue_start + done : 0;
 
     if(len > done)
     {
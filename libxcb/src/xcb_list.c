@@ -23,7 +23,7 @@
  * authorization from the authors.
  */
 
-/* A generic implementation of a list of void-pointers. */
+/* A map from unsigned int keys to void-pointers. */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -34,6 +34,14 @@
 #include "xcb.h"
 #include "xcbint.h"
 
+/* The keys are request sequence numbers, which are mostly consecutive,
+ * so they serve as their own hash: a bucket is picked by the low bits
+ * of the key, and the table doubles whenever it holds more entries
+ * than buckets, which keeps chains short however many requests are
+ * outstanding. */
+
+#define INITIAL_BUCKETS 16
+
 typedef struct node {
     struct node *next;
     unsigned int key;
@@ -41,10 +49,38 @@ typedef struct node {
 } node;
 
 struct _xcb_map {
-    node *head;
-    node **tail;
+    node **buckets;
+    unsigned int mask;
+    unsigned int count;
 };
 
+static int grow(_xcb_map *list)
+{
+    unsigned int size = (list->mask + 1) * 2, i;
+    node **buckets = calloc(size, sizeof(node *));
+    if(!buckets)
+        return 0;
+    for(i = 0; i <= list->mask; ++i)
+    {
+        node *cur = list->buckets[i];
+        while(cur)
+        {
+            node *next = cur->next;
+            node **prev = &buckets[cur->key & (size - 1)];
+            /* Keep entries with equal keys in insertion order. */
+            while(*prev)
+                prev = &(*prev)->next;
+            cur->next = 0;
+            *prev = cur;
+            cur = next;
+        }
+    }
+    free(list->buckets);
+    list->buckets = buckets;
+    list->mask = size - 1;
+    return 1;
+}
+
 /* Private interface */
 
 _xcb_map *_xcb_map_new(void)
@@ -53,50 +89,73 @@ _xcb_map *_xcb_map_new(void)
     list = malloc(sizeof(_xcb_map));
     if(!list)
         return 0;
-    list->head = 0;
-    list->tail = &list->head;
+    list->buckets = calloc(INITIAL_BUCKETS, sizeof(node *));
+    if(!list->buckets)
+    {
+        free(list);
+        return 0;
+    }
+    list->mask = INITIAL_BUCKETS - 1;
+    list->count = 0;
     return list;
 }
 
 void _xcb_map_delete(_xcb_map *list, xcb_list_free_func_t do_free)
 {
+    unsigned int i;
     if(!list)
         return;
-    while(list->head)
-    {
-        node *cur = list->head;
-        if(do_free)
-            do_free(cur->data);
-        list->head = cur->next;
-        free(cur);
-    }
+    for(i = 0; i <= list->mask; ++i)
+        while(list->buckets[i])
+        {
+            node *cur = list->buckets[i];
+            if(do_free)
+                do_free(cur->data);
+            list->buckets[i] = cur->next;
+            free(cur);
+        }
+    free(list->buckets);
     free(list);
 }
 
 int _xcb_map_put(_xcb_map *list, unsigned int key, void *data)
 {
-    node *cur = malloc(sizeof(node));
+    node **prev;
+    node *cur;
+    if(list->count > list->mask)
+        grow(list); /* a full table is only slower, so ignore failure */
+    cur = malloc(sizeof(node));
     if(!cur)
         return 0;
     cur->key = key;
     cur->data = data;
     cur->next = 0;
-    *list->tail = cur;
-    list->tail = &cur->next;
+    for(prev = &list->buckets[key & list->mask]; *prev; prev = &(*prev)->next)
+        /* empty */;
+    *prev = cur;
+    ++list->count;
     return 1;
 }
 
+void *_xcb_map_get(_xcb_map *list, unsigned int key)
+{
+    node *cur;
+    for(cur = list->buckets[key & list->mask]; cur; cur = cur->next)
+        if(cur->key == key)
+            return cur->data;
+    return 0;
+}
+
 void *_xcb_map_remove(_xcb_map *list, unsigned int key)
 {
     node **cur;
-    for(cur = &list->head; *cur; cur = &(*cur)->next)
+    for(cur = &list->buckets[key & list->mask]; *cur; cur = &(*cur)->next)
         if((*cur)->key == key)
         {
             node *tmp = *cur;
             void *ret = (*cur)->data;
             *cur = (*cur)->next;
-            if(!*cur)
-                list->tail = cur;
+            --list->count;
 
             free(tmp);
             return ret;
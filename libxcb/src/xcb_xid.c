@@ -36,6 +36,102 @@
 #include "xcbint.h"
 #include "xc_misc.h"
 
+/* The next range is asked for when an eighth of this one, and at
+ * least this many IDs, are left. */
+#define XID_PREFETCH 256
+
+/* XID_READY once XC-MISC is known to be there. */
+enum { XID_IDLE, XID_QUERYING, XID_READY, XID_FETCHING, XID_NO_XC_MISC };
+
+/* Recycled IDs inside a new range would be handed out twice. */
+static void drop_free_ids_in_range(xcb_connection_t *c)
+{
+    uint32_t mask = c->setup->resource_id_mask;
+    int i, n = 0;
+    for(i = 0; i < c->xid.free_count; ++i)
+    {
+        uint32_t id = c->xid.free_ids[i] & mask;
+        if(id < (c->xid.last & mask) || id > (c->xid.max & mask))
+            c->xid.free_ids[n++] = c->xid.free_ids[i];
+    }
+    c->xid.free_count = n;
+}
+
+static void set_prefetch_at(xcb_connection_t *c)
+{
+    c->xid.prefetch_at = (c->xid.max - c->xid.last) / c->xid.inc / 8;
+    if(c->xid.prefetch_at < XID_PREFETCH)
+        c->xid.prefetch_at = XID_PREFETCH;
+}
+
+/* Asks for the next range while some IDs of this one are left. */
+static void prefetch_range(xcb_connection_t *c)
+{
+    const xcb_query_extension_reply_t *xc_misc_reply;
+    if((c->xid.max - c->xid.last) / c->xid.inc > c->xid.prefetch_at)
+        return;
+    switch(c->xid.prefetch)
+    {
+    case XID_IDLE:
+        /* Both requests are flushed so the replies are in by the time
+         * they are needed. */
+        xcb_prefetch_extension_data(c, &xcb_xc_misc_id);
+        xcb_flush(c);
+        c->xid.prefetch = XID_QUERYING;
+        break;
+    case XID_QUERYING:
+        if((c->xid.max - c->xid.last) / c->xid.inc > c->xid.prefetch_at / 2)
+            break;
+        xc_misc_reply = xcb_get_extension_data(c, &xcb_xc_misc_id);
+        if(!xc_misc_reply || !xc_misc_reply->present)
+        {
+            c->xid.prefetch = XID_NO_XC_MISC;
+            break;
+        }
+        /* fall through */
+    case XID_READY:
+        /* The ID this call returns has not been used in a request yet,
+         * so the server may still count it as free. */
+        c->xid.prefetch_sequence = xcb_xc_misc_get_xid_range(c).sequence;
+        c->xid.prefetch_tail = c->xid.last;
+        xcb_flush(c);
+        c->xid.prefetch = XID_FETCHING;
+        break;
+    }
+}
+
+/* Takes the prefetched range, less the IDs the server still saw as
+ * free because this range had not handed them out, or had only just
+ * handed them out, when the request was sent. */
+static xcb_xc_misc_get_xid_range_reply_t *prefetched_range(xcb_connection_t *c)
+{
+    xcb_xc_misc_get_xid_range_cookie_t cookie = { c->xid.prefetch_sequence };
+    xcb_xc_misc_get_xid_range_reply_t *range;
+    uint32_t mask = c->setup->resource_id_mask;
+    uint32_t first, last, tail = c->xid.prefetch_tail & mask;
+    uint32_t max = c->xid.max & mask;
+
+    range = xcb_xc_misc_get_xid_range_reply(c, cookie, 0);
+    if(!range || range->count == 0 || (range->start_id == 0 && range->count == 1))
+        goto fail;
+    first = range->start_id & mask;
+    last = first + (range->count - 1) * c->xid.inc;
+    if(last < tail || first > max)
+        return range;
+    if(first >= tail && last <= max)
+        goto fail;
+    if(first >= tail || (last > max && last - max > tail - first))
+        first = max + c->xid.inc;
+    else
+        last = tail - c->xid.inc;
+    range->start_id = first | c->xid.base;
+    range->count = (last - first) / c->xid.inc + 1;
+    return range;
+fail:
+    free(range);
+    return 0;
+}
+
 /* Public interface */
 
 uint32_t xcb_generate_id(xcb_connection_t *c)
@@ -44,28 +140,45 @@ uint32_t xcb_generate_id(xcb_connection_t *c)
     if(c->has_error)
         return -1;
     pthread_mutex_lock(&c->xid.lock);
+    /* A range request in flight may count recycled IDs as free. */
+    if(c->xid.free_count && c->xid.prefetch != XID_FETCHING)
+    {
+        ret = c->xid.free_ids[--c->xid.free_count];
+        pthread_mutex_unlock(&c->xid.lock);
+        return ret;
+    }
     if(c->xid.last >= c->xid.max - c->xid.inc + 1)
     {
-        xcb_xc_misc_get_xid_range_reply_t *range;
+        xcb_xc_misc_get_xid_range_reply_t *range = 0;
         assert(c->xid.last == c->xid.max);
         if (c->xid.last == 0) {
             /* finish setting up initial range */
             c->xid.max = c->setup->resource_id_mask;
+            set_prefetch_at(c);
         } else {
-            /* check for extension */
-            const xcb_query_extension_reply_t *xc_misc_reply =
-              xcb_get_extension_data(c, &xcb_xc_misc_id);
-            if (!xc_misc_reply) {
-                pthread_mutex_unlock(&c->xid.lock);
-                return -1;
+            if(c->xid.prefetch == XID_FETCHING)
+            {
+                range = prefetched_range(c);
+                c->xid.prefetch = XID_READY;
+            }
+            if(!range)
+            {
+                /* check for extension */
+                const xcb_query_extension_reply_t *xc_misc_reply =
+                  xcb_get_extension_data(c, &xcb_xc_misc_id);
+                if (!xc_misc_reply || !xc_misc_reply->present) {
+                    pthread_mutex_unlock(&c->xid.lock);
+                    return -1;
+                }
+                /* get new range */
+                range = xcb_xc_misc_get_xid_range_reply(c,
+                          xcb_xc_misc_get_xid_range(c), 0);
             }
-            /* get new range */
-            range = xcb_xc_misc_get_xid_range_reply(c,
-                      xcb_xc_misc_get_xid_range(c), 0);
             /* XXX The latter disjunct is what the server returns
                when it is out of XIDs.  Sweet. */
             if(!range || (range->start_id == 0 && range->count == 1))
             {
+                free(range);
                 pthread_mutex_unlock(&c->xid.lock);
                 return -1;
             }
@@ -73,15 +186,49 @@ uint32_t xcb_generate_id(xcb_connection_t *c)
             c->xid.last = range->start_id;
             c->xid.max = range->start_id + (range->count - 1) * c->xid.inc;
             free(range);
+            drop_free_ids_in_range(c);
+            set_prefetch_at(c);
+            c->xid.prefetch = XID_READY;
         }
     } else {
         c->xid.last += c->xid.inc;
+        if(c->xid.prefetch != XID_NO_XC_MISC)
+            prefetch_range(c);
     }
     ret = c->xid.last | c->xid.base;
     pthread_mutex_unlock(&c->xid.lock);
     return ret;
 }
 
+void xcb_recycle_id(xcb_connection_t *c, uint32_t id)
+{
+    uint32_t mask = c->setup->resource_id_mask;
+    uint32_t low = id & mask;
+    if(c->has_error || !id || (id & ~mask) != c->xid.base)
+        return;
+    pthread_mutex_lock(&c->xid.lock);
+    /* IDs the current range has yet to hand out need not be kept. */
+    if(low > (c->xid.last & mask) && low <= (c->xid.max & mask))
+    {
+        pthread_mutex_unlock(&c->xid.lock);
+        return;
+    }
+    if(c->xid.free_count == c->xid.free_size)
+    {
+        int size = c->xid.free_size ? c->xid.free_size * 2 : 64;
+        uint32_t *ids = realloc(c->xid.free_ids, size * sizeof(*ids));
+        if(!ids)
+        {
+            pthread_mutex_unlock(&c->xid.lock);
+            return;
+        }
+        c->xid.free_ids = ids;
+        c->xid.free_size = size;
+    }
+    c->xid.free_ids[c->xid.free_count++] = id;
+    pthread_mutex_unlock(&c->xid.lock);
+}
+
 /* Private interface */
 
 int _xcb_xid_init(xcb_connection_t *c)
@@ -92,11 +239,17 @@ int _xcb_xid_init(xcb_connection_t *c)
     c->xid.max = 0;
     c->xid.base = c->setup->resource_id_base;
     c->xid.inc = c->setup->resource_id_mask & -(c->setup->resource_id_mask);
+    c->xid.free_ids = 0;
+    c->xid.free_count = 0;
+    c->xid.free_size = 0;
+    c->xid.prefetch = XID_IDLE;
+    c->xid.prefetch_at = XID_PREFETCH;
     return 1;
 }
 
 void _xcb_xid_destroy(xcb_connection_t *c)
 {
+    free(c->xid.free_ids);
     if (!c->xid.lock)
       return; /* mutex was not initialised yet */
     pthread_mutex_destroy(&c->xid.lock);
@@ -74,6 +74,7 @@ typedef struct _xcb_map _xcb_map;
 _xcb_map *_xcb_map_new(void);
 void _xcb_map_delete(_xcb_map *q, xcb_list_free_func_t do_free);
 int _xcb_map_put(_xcb_map *q, unsigned int key, void *data);
+void *_xcb_map_get(_xcb_map *q, unsigned int key);
 void *_xcb_map_remove(_xcb_map *q, unsigned int key);
 
 
@@ -125,11 +126,16 @@ int _xcb_out_flush_to(xcb_connection_t *c, uint64_t request);
 
 /* xcb_in.c */
 
+#ifndef XCB_IN_QUEUE_SIZE
+#define XCB_IN_QUEUE_SIZE 16384
+#endif
+
 typedef struct _xcb_in {
     pthread_cond_t event_cond;
     int reading;
 
-    char queue[4096];
+    char queue[XCB_IN_QUEUE_SIZE];
+    int queue_start;
     int queue_len;
 
     uint64_t request_expected;
@@ -146,6 +152,7 @@ typedef struct _xcb_in {
 
     struct pending_reply *pending_replies;
     struct pending_reply **pending_replies_tail;
+    _xcb_map *pending_index;
 #if HAVE_SENDMSG
     _xcb_fd in_fd;
 #endif
@@ -172,6 +179,13 @@ typedef struct _xcb_xid {
     uint32_t base;
     uint32_t max;
     uint32_t inc;
+    uint32_t *free_ids; /* recycled, handed out before the range */
+    int free_count;
+    int free_size;
+    int prefetch; /* state of the request for the next range */
+    uint32_t prefetch_at; /* IDs left when the next range is asked for */
+    unsigned int prefetch_sequence;
+    uint32_t prefetch_tail; /* first ID not yet used when it was sent */
 } _xcb_xid;
 
 int _xcb_xid_init(xcb_connection_t *c);
@@ -0,0 +1,214 @@
+/*
+ * Measures how fast libxcb takes events and replies off the wire. A
+ * thread on the other end of a socketpair stands in for the server: it
+ * answers the connection setup, floods the client with MotionNotify
+ * events, then replies to every GetInputFocus request it receives.
+ * The replies are measured with all of the requests in flight at once,
+ * and are collected in order, in reverse order and through
+ * xcb_discard_reply().
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "xcb.h"
+
+#define N_EVENTS	2000000
+#define EVENT_BATCH	128
+#define N_REPLIES	100000
+
+static int read_all(int fd, void *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		ssize_t ret = read(fd, (char *) buf + done, len - done);
+		if(ret <= 0)
+			return 0;
+		done += ret;
+	}
+	return 1;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		ssize_t ret = write(fd, (const char *) buf + done, len - done);
+		if(ret <= 0)
+			return 0;
+		done += ret;
+	}
+	return 1;
+}
+
+static void *server(void *arg)
+{
+	int fd = *(int *) arg;
+	uint8_t setup_request[12];
+	uint8_t setup[32];
+	uint8_t events[EVENT_BATCH][32];
+	uint16_t sequence = 0;
+	int i;
+
+	/* No authorization is sent, so the request is just the fixed part. */
+	if(!read_all(fd, setup_request, sizeof(setup_request)))
+		return 0;
+
+	/* A successful setup with no vendor string, formats or screens. */
+	memset(setup, 0, sizeof(setup));
+	setup[0] = 1;
+	*(uint16_t *) &setup[2] = 11;
+	*(uint16_t *) &setup[6] = (sizeof(setup) - 8) / 4;
+	*(uint32_t *) &setup[12] = 0x00200000;
+	*(uint32_t *) &setup[16] = 0x001fffff;
+	*(uint16_t *) &setup[26] = 0xffff;
+	if(!write_all(fd, setup, sizeof(setup)))
+		return 0;
+
+	memset(events, 0, sizeof(events));
+	for(i = 0; i < EVENT_BATCH; i++)
+		events[i][0] = XCB_MOTION_NOTIFY;
+	for(i = 0; i < N_EVENTS; i += EVENT_BATCH)
+		if(!write_all(fd, events, sizeof(events)))
+			return 0;
+
+	for(;;)
+	{
+		uint8_t request[4], reply[32];
+		uint32_t length;
+
+		if(!read_all(fd, request, sizeof(request)))
+			break;
+		++sequence;
+		length = *(uint16_t *) &request[2] * 4;
+		while(length > 4)
+		{
+			uint8_t skip[256];
+			uint32_t n = length - 4 < sizeof(skip) ? length - 4 : sizeof(skip);
+			if(!read_all(fd, skip, n))
+				return 0;
+			length -= n;
+		}
+		if(request[0] != XCB_GET_INPUT_FOCUS)
+			continue;
+
+		memset(reply, 0, sizeof(reply));
+		reply[0] = 1;
+		*(uint16_t *) &reply[2] = sequence;
+		if(!write_all(fd, reply, sizeof(reply)))
+			break;
+	}
+	return 0;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+enum collect { IN_ORDER, REVERSE, DISCARD, DISCARD_UNCHECKED };
+
+static const char *const collect_names[] = {
+	"in order", "reverse", "discard", "discard unchecked"
+};
+
+/* Nanoseconds per reply, or a negative value if one went missing. */
+static double bench_replies(xcb_connection_t *c, enum collect collect)
+{
+	static xcb_get_input_focus_cookie_t cookies[N_REPLIES];
+	xcb_get_input_focus_reply_t *reply;
+	double start;
+	int i;
+
+	start = now();
+	for(i = 0; i < N_REPLIES; i++)
+	{
+		if(collect == DISCARD_UNCHECKED)
+			cookies[i] = xcb_get_input_focus_unchecked(c);
+		else
+			cookies[i] = xcb_get_input_focus(c);
+	}
+
+	for(i = 0; i < N_REPLIES; i++)
+	{
+		if(collect == DISCARD || collect == DISCARD_UNCHECKED)
+		{
+			xcb_discard_reply(c, cookies[i].sequence);
+			continue;
+		}
+		reply = xcb_get_input_focus_reply(c,
+			cookies[collect == REVERSE ? N_REPLIES - 1 - i : i], 0);
+		if(!reply)
+			return -1;
+		free(reply);
+	}
+
+	/* Wait for the discarded replies to go by. */
+	reply = xcb_get_input_focus_reply(c, xcb_get_input_focus(c), 0);
+	if(!reply)
+		return -1;
+	free(reply);
+
+	return (now() - start) / N_REPLIES * 1e9;
+}
+
+int main(void)
+{
+	xcb_connection_t *c;
+	pthread_t thread;
+	int fds[2];
+	double start, elapsed;
+	int i;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+	{
+		perror("socketpair");
+		return 1;
+	}
+	pthread_create(&thread, 0, server, &fds[1]);
+
+	c = xcb_connect_to_fd(fds[0], 0);
+	if(xcb_connection_has_error(c))
+	{
+		fprintf(stderr, "connection setup failed\n");
+		return 1;
+	}
+
+	start = now();
+	for(i = 0; i < N_EVENTS; i++)
+	{
+		xcb_generic_event_t *event = xcb_wait_for_event(c);
+		if(!event)
+		{
+			fprintf(stderr, "connection lost after %d events\n", i);
+			return 1;
+		}
+		free(event);
+	}
+	elapsed = now() - start;
+	printf("events: %8.1f ns per event\n", elapsed / N_EVENTS * 1e9);
+
+	for(i = IN_ORDER; i <= DISCARD_UNCHECKED; i++)
+	{
+		double t = bench_replies(c, i);
+		if(t < 0)
+		{
+			fprintf(stderr, "missing reply\n");
+			return 1;
+		}
+		printf("%d replies, %s: %8.1f ns per reply\n",
+		       N_REPLIES, collect_names[i], t);
+	}
+
+	xcb_disconnect(c);
+	close(fds[1]);
+	pthread_join(thread, 0);
+	return 0;
+}
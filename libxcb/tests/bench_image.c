@@ -0,0 +1,435 @@
+/*
+ * Measures xcb_image format conversion and the shm pool. Conversions
+ * run between 4K images of the usual depths and byte orders. For the
+ * pool, a thread on the other end of a socketpair stands in for a
+ * local server with MIT-SHM and BIG-REQUESTS: it attaches the client's
+ * segments and copies image data between them or the wire and a 4K
+ * framebuffer. Frames are put and got through a pool that shares
+ * memory, one whose server lacks MIT-SHM and one whose server refuses
+ * to attach, and the frames that come back are checked.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/socket.h>
+#include <xcb/xcb.h>
+#include <xcb/xcb_aux.h>
+#include <xcb/xcb_image.h>
+
+#define WIDTH		3840
+#define HEIGHT		2160
+#define ROOT		0x100
+#define SHM_MAJOR	130
+#define BIGREQ_MAJOR	131
+#define BENCH_TIME	1.0
+
+enum server_mode { SHM, NO_SHM, ATTACH_FAILS };
+
+static const char *const mode_names[] = {
+	"shm", "no MIT-SHM", "attach fails"
+};
+
+struct server_args {
+	int fd;
+	enum server_mode mode;
+};
+
+static uint8_t framebuffer[WIDTH * HEIGHT * 4];
+
+static int read_all(int fd, void *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		ssize_t ret = read(fd, (char *) buf + done, len - done);
+		if(ret <= 0)
+			return 0;
+		done += ret;
+	}
+	return 1;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		ssize_t ret = write(fd, (const char *) buf + done, len - done);
+		if(ret <= 0)
+			return 0;
+		done += ret;
+	}
+	return 1;
+}
+
+/* A 24-bit TrueColor root with 1 and 24 bit pixmap formats. */
+static size_t make_setup(uint8_t *setup)
+{
+	size_t n = 40;
+
+	memset(setup, 0, 256);
+	setup[0] = 1;
+	*(uint16_t *) &setup[2] = 11;
+	*(uint32_t *) &setup[12] = 0x00200000;
+	*(uint32_t *) &setup[16] = 0x001fffff;
+	*(uint16_t *) &setup[26] = 0xffff;
+	setup[28] = 1;
+	setup[29] = 2;
+	setup[32] = 32;
+	setup[33] = 32;
+
+	setup[n] = 1; setup[n + 1] = 1; setup[n + 2] = 32;
+	n += 8;
+	setup[n] = 24; setup[n + 1] = 32; setup[n + 2] = 32;
+	n += 8;
+
+	*(uint32_t *) &setup[n] = ROOT;
+	*(uint16_t *) &setup[n + 20] = WIDTH;
+	*(uint16_t *) &setup[n + 22] = HEIGHT;
+	*(uint32_t *) &setup[n + 32] = ROOT + 1;
+	setup[n + 38] = 24;
+	setup[n + 39] = 1;
+	n += 40;
+	setup[n] = 24;
+	*(uint16_t *) &setup[n + 2] = 1;
+	n += 8;
+	*(uint32_t *) &setup[n] = ROOT + 1;
+	setup[n + 4] = XCB_VISUAL_CLASS_TRUE_COLOR;
+	setup[n + 5] = 8;
+	*(uint16_t *) &setup[n + 6] = 256;
+	*(uint32_t *) &setup[n + 8] = 0xff0000;
+	*(uint32_t *) &setup[n + 12] = 0xff00;
+	*(uint32_t *) &setup[n + 16] = 0xff;
+	n += 24;
+
+	*(uint16_t *) &setup[6] = (n - 8) / 4;
+	return n;
+}
+
+static int send_reply(int fd, uint8_t *reply, uint16_t sequence,
+		const void *data, uint32_t length)
+{
+	reply[0] = 1;
+	*(uint16_t *) &reply[2] = sequence;
+	*(uint32_t *) &reply[4] = length / 4;
+	return write_all(fd, reply, 32) && write_all(fd, data, length);
+}
+
+static int send_error(int fd, uint8_t code, uint16_t sequence,
+		uint8_t major, uint16_t minor)
+{
+	uint8_t error[32];
+	memset(error, 0, sizeof(error));
+	error[1] = code;
+	*(uint16_t *) &error[2] = sequence;
+	*(uint16_t *) &error[8] = minor;
+	error[10] = major;
+	return write_all(fd, error, sizeof(error));
+}
+
+static void copy_rect(uint8_t *dst, size_t dst_stride,
+		const uint8_t *src, size_t src_stride, int rows)
+{
+	int y;
+	for(y = 0; y < rows; y++)
+		memcpy(dst + y * dst_stride, src + y * src_stride, dst_stride);
+}
+
+static void *server(void *arg)
+{
+	struct server_args *args = arg;
+	int fd = args->fd;
+	uint8_t setup[256], reply[32];
+	uint8_t *request = malloc(17 << 20);
+	void *segments[16] = { 0 };
+	uint16_t sequence = 0;
+	int big = 0;
+
+	/* No authorization is sent, so the request is just the fixed part. */
+	if(!request || !read_all(fd, setup, 12))
+		return 0;
+	if(!write_all(fd, setup, make_setup(setup)))
+		return 0;
+
+	for(;;)
+	{
+		uint32_t length;
+		uint8_t *req = request;
+
+		if(!read_all(fd, request, 4))
+			break;
+		++sequence;
+		length = *(uint16_t *) &request[2] * 4;
+		if(length == 0 && big)
+		{
+			/* Drop the extended length so fields sit where usual. */
+			if(!read_all(fd, &length, 4))
+				break;
+			length = length * 4 - 4;
+		}
+		if(length > (17 << 20) || !read_all(fd, request + 4, length - 4))
+			break;
+		memset(reply, 0, sizeof(reply));
+
+		if(req[0] == XCB_QUERY_EXTENSION)
+		{
+			uint16_t name_len = *(uint16_t *) &req[4];
+			if(name_len == 7 && !memcmp(req + 8, "MIT-SHM", 7) &&
+					args->mode != NO_SHM)
+				reply[9] = SHM_MAJOR;
+			else if(name_len == 12 && !memcmp(req + 8, "BIG-REQUESTS", 12))
+				reply[9] = BIGREQ_MAJOR;
+			reply[8] = reply[9] != 0;
+			if(!send_reply(fd, reply, sequence, 0, 0))
+				break;
+		}
+		else if(req[0] == BIGREQ_MAJOR)
+		{
+			big = 1;
+			*(uint32_t *) &reply[8] = 0x400000;
+			if(!send_reply(fd, reply, sequence, 0, 0))
+				break;
+		}
+		else if(req[0] == SHM_MAJOR && req[1] == XCB_SHM_ATTACH)
+		{
+			uint32_t seg = *(uint32_t *) &req[4] & 15;
+			void *addr = (void *) -1;
+			if(args->mode != ATTACH_FAILS)
+				addr = shmat(*(uint32_t *) &req[8], 0, 0);
+			if(addr == (void *) -1)
+			{
+				if(!send_error(fd, XCB_ACCESS, sequence, req[0], req[1]))
+					break;
+				continue;
+			}
+			segments[seg] = addr;
+		}
+		else if(req[0] == SHM_MAJOR && req[1] == XCB_SHM_DETACH)
+		{
+			uint32_t seg = *(uint32_t *) &req[4] & 15;
+			shmdt(segments[seg]);
+			segments[seg] = 0;
+		}
+		else if(req[0] == SHM_MAJOR && req[1] == XCB_SHM_PUT_IMAGE)
+		{
+			uint8_t *src = segments[*(uint32_t *) &req[32] & 15];
+			uint16_t width = *(uint16_t *) &req[12];
+			uint16_t y = *(uint16_t *) &req[26];
+			uint16_t rows = *(uint16_t *) &req[22];
+			copy_rect(framebuffer + y * WIDTH * 4, width * 4,
+					src + *(uint32_t *) &req[36], width * 4, rows);
+		}
+		else if(req[0] == SHM_MAJOR && req[1] == XCB_SHM_GET_IMAGE)
+		{
+			uint8_t *dst = segments[*(uint32_t *) &req[24] & 15];
+			uint16_t width = *(uint16_t *) &req[12];
+			uint16_t y = *(uint16_t *) &req[10];
+			uint16_t rows = *(uint16_t *) &req[14];
+			copy_rect(dst + *(uint32_t *) &req[28], width * 4,
+					framebuffer + y * WIDTH * 4, WIDTH * 4, rows);
+			reply[1] = 24;
+			*(uint32_t *) &reply[8] = ROOT + 1;
+			*(uint32_t *) &reply[12] = width * rows * 4;
+			if(!send_reply(fd, reply, sequence, 0, 0))
+				break;
+		}
+		else if(req[0] == XCB_PUT_IMAGE)
+		{
+			uint16_t width = *(uint16_t *) &req[12];
+			uint16_t rows = *(uint16_t *) &req[14];
+			uint16_t y = *(uint16_t *) &req[18];
+			copy_rect(framebuffer + y * WIDTH * 4, width * 4,
+					req + 24, width * 4, rows);
+		}
+		else if(req[0] == XCB_GET_IMAGE)
+		{
+			uint16_t y = *(uint16_t *) &req[10];
+			uint16_t width = *(uint16_t *) &req[12];
+			uint16_t rows = *(uint16_t *) &req[14];
+			reply[1] = 24;
+			*(uint32_t *) &reply[8] = ROOT + 1;
+			if(width == WIDTH)
+			{
+				if(!send_reply(fd, reply, sequence,
+						framebuffer + y * WIDTH * 4, rows * WIDTH * 4))
+					break;
+			}
+			else if(!send_reply(fd, reply, sequence, 0, 0))
+				break;
+		}
+		else if(req[0] == XCB_GET_INPUT_FOCUS)
+		{
+			if(!send_reply(fd, reply, sequence, 0, 0))
+				break;
+		}
+	}
+	free(request);
+	return 0;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct conversion {
+	const char *name;
+	uint8_t src_bpp, src_depth;
+	xcb_image_order_t src_order;
+	uint8_t dst_bpp, dst_depth;
+	xcb_image_order_t dst_order;
+};
+
+static const struct conversion conversions[] = {
+	{ "32 bpp, swap bytes", 32, 24, XCB_IMAGE_ORDER_LSB_FIRST,
+		32, 24, XCB_IMAGE_ORDER_MSB_FIRST },
+	{ "24 bpp, swap bytes", 24, 24, XCB_IMAGE_ORDER_LSB_FIRST,
+		24, 24, XCB_IMAGE_ORDER_MSB_FIRST },
+	{ "16 bpp, swap bytes", 16, 16, XCB_IMAGE_ORDER_LSB_FIRST,
+		16, 16, XCB_IMAGE_ORDER_MSB_FIRST },
+	{ "32 to 24 bpp", 32, 24, XCB_IMAGE_ORDER_LSB_FIRST,
+		24, 24, XCB_IMAGE_ORDER_LSB_FIRST },
+	{ "24 to 32 bpp, swap bytes", 24, 24, XCB_IMAGE_ORDER_LSB_FIRST,
+		32, 24, XCB_IMAGE_ORDER_MSB_FIRST },
+};
+
+/* Milliseconds per 4K conversion. */
+static double bench_conversion(const struct conversion *conv)
+{
+	xcb_image_t *src, *dst;
+	double start, elapsed;
+	uint32_t i;
+	int n = 0;
+
+	src = xcb_image_create(WIDTH, HEIGHT, XCB_IMAGE_FORMAT_Z_PIXMAP, 32,
+			conv->src_depth, conv->src_bpp, 0,
+			conv->src_order, XCB_IMAGE_ORDER_MSB_FIRST, 0, 0, 0);
+	dst = xcb_image_create(WIDTH, HEIGHT, XCB_IMAGE_FORMAT_Z_PIXMAP, 32,
+			conv->dst_depth, conv->dst_bpp, 0,
+			conv->dst_order, XCB_IMAGE_ORDER_MSB_FIRST, 0, 0, 0);
+	if(!src || !dst)
+		return -1;
+	for(i = 0; i < src->size; i++)
+		src->data[i] = i * 7 + (i >> 12);
+
+	start = now();
+	do {
+		if(!xcb_image_convert(src, dst))
+			return -1;
+		n++;
+		elapsed = now() - start;
+	} while(elapsed < BENCH_TIME);
+
+	xcb_image_destroy(src);
+	xcb_image_destroy(dst);
+	return elapsed / n * 1e3;
+}
+
+/* Frames per second put to, then got from, the server. */
+static int bench_pool(enum server_mode mode, double *put_fps, double *get_fps)
+{
+	struct server_args args;
+	xcb_connection_t *c;
+	xcb_image_shm_pool_t *pool;
+	xcb_image_t *out, *in;
+	pthread_t thread;
+	int fds[2], n, ok = 1;
+	double start, elapsed;
+	uint32_t i;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+	{
+		perror("socketpair");
+		return 0;
+	}
+	args.fd = fds[1];
+	args.mode = mode;
+	pthread_create(&thread, 0, server, &args);
+
+	c = xcb_connect_to_fd(fds[0], 0);
+	if(xcb_connection_has_error(c))
+	{
+		fprintf(stderr, "connection setup failed\n");
+		return 0;
+	}
+	xcb_prefetch_extension_data(c, &xcb_shm_id);
+	pool = xcb_image_shm_pool_create(c);
+	out = xcb_image_shm_pool_image(pool, WIDTH, HEIGHT,
+			XCB_IMAGE_FORMAT_Z_PIXMAP, 24);
+	in = xcb_image_shm_pool_image(pool, WIDTH, HEIGHT,
+			XCB_IMAGE_FORMAT_Z_PIXMAP, 24);
+	if(!out || !in)
+		return 0;
+
+	start = now();
+	n = 0;
+	do {
+		xcb_image_shm_pool_wait(pool, out);
+		for(i = 0; i < out->size; i += 4096)
+			out->data[i] = n;
+		xcb_image_shm_pool_put(pool, ROOT, 0, out, 0, 0);
+		xcb_aux_sync(c);
+		n++;
+		elapsed = now() - start;
+	} while(elapsed < BENCH_TIME);
+	*put_fps = n / elapsed;
+
+	start = now();
+	n = 0;
+	do {
+		ok &= xcb_image_shm_pool_get(pool, ROOT, in, 0, 0, ~0);
+		n++;
+		elapsed = now() - start;
+	} while(elapsed < BENCH_TIME);
+	*get_fps = n / elapsed;
+
+	if(!ok || memcmp(in->data, out->data, out->size))
+		ok = 0;
+	xcb_image_shm_pool_release(pool, out);
+	xcb_image_shm_pool_release(pool, in);
+	xcb_image_shm_pool_destroy(pool);
+	xcb_disconnect(c);
+	pthread_join(thread, 0);
+	close(fds[1]);
+	return ok;
+}
+
+int main(void)
+{
+	size_t i;
+	int failed = 0;
+
+	for(i = 0; i < sizeof(conversions) / sizeof(*conversions); i++)
+	{
+		double t = bench_conversion(&conversions[i]);
+		if(t < 0)
+		{
+			printf("convert %-26s failed\n", conversions[i].name);
+			failed = 1;
+			continue;
+		}
+		printf("convert %-26s %7.2f ms per 4K frame\n",
+				conversions[i].name, t);
+	}
+
+	for(i = SHM; i <= ATTACH_FAILS; i++)
+	{
+		double put_fps, get_fps;
+		if(!bench_pool(i, &put_fps, &get_fps))
+		{
+			printf("pool, %-13s failed\n", mode_names[i]);
+			failed = 1;
+			continue;
+		}
+		printf("pool, %-13s put %7.1f, get %7.1f 4K frames per second\n",
+				mode_names[i], put_fps, get_fps);
+	}
+	return failed;
+}
@@ -0,0 +1,269 @@
+/*
+ * Measures XID allocation under resource churn. A thread on the other
+ * end of a socketpair stands in for the server: it hands out a small
+ * XID space, tracks which XIDs name live pixmaps, answers XC-MISC
+ * GetXIDRange with the highest free run after a delay that stands for
+ * the round trip, and counts CreatePixmap requests whose XID is still
+ * in use. The client keeps a fixed number of pixmaps alive, freeing
+ * the oldest for every one it creates, with and without recycling the
+ * freed XIDs.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "xcb.h"
+#include "xc_misc.h"
+
+#define ID_BASE		0x00200000
+#define ID_MASK		0x0000ffff
+#define XC_MISC_MAJOR	130
+#define LIVE		1000
+#define N_CHURN		1000000
+#define RANGE_DELAY_US	2000
+
+struct server_stats {
+	int ranges;
+	int reused;
+};
+
+struct churn_stats {
+	double total;		/* ns per pixmap */
+	double generate;	/* ms spent in xcb_generate_id() */
+	double longest;		/* us for the slowest call */
+	struct server_stats server;
+};
+
+struct server_args {
+	int fd;
+	struct server_stats stats;
+};
+
+static int read_all(int fd, void *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		ssize_t ret = read(fd, (char *) buf + done, len - done);
+		if(ret <= 0)
+			return 0;
+		done += ret;
+	}
+	return 1;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	size_t done = 0;
+	while(done < len)
+	{
+		ssize_t ret = write(fd, (const char *) buf + done, len - done);
+		if(ret <= 0)
+			return 0;
+		done += ret;
+	}
+	return 1;
+}
+
+/* The highest run of free XIDs, as a start and a count. This includes
+ * IDs the client has handed out but not yet used in a request, which a
+ * real server returns as well. */
+static void free_range(const uint8_t *used, uint32_t *start, uint32_t *count)
+{
+	uint32_t id = ID_MASK;
+	*start = *count = 0;
+	while(id > 0 && used[id])
+		id--;
+	while(id > 0 && !used[id])
+	{
+		*start = id--;
+		++*count;
+	}
+}
+
+static void *server(void *arg)
+{
+	struct server_args *args = arg;
+	int fd = args->fd;
+	uint8_t setup_request[12];
+	uint8_t setup[40];
+	uint8_t *used = calloc(ID_MASK + 1, 1);
+	uint8_t buf[65536];
+	size_t len = 0, pos = 0;
+	uint16_t sequence = 0;
+
+	/* No authorization is sent, so the request is just the fixed part. */
+	if(!used || !read_all(fd, setup_request, sizeof(setup_request)))
+		return 0;
+
+	/* A setup with no vendor string, formats or screens. */
+	memset(setup, 0, sizeof(setup));
+	setup[0] = 1;
+	*(uint16_t *) &setup[2] = 11;
+	*(uint16_t *) &setup[6] = (sizeof(setup) - 8) / 4;
+	*(uint32_t *) &setup[12] = ID_BASE;
+	*(uint32_t *) &setup[16] = ID_MASK;
+	*(uint16_t *) &setup[26] = 0xffff;
+	if(!write_all(fd, setup, sizeof(setup)))
+		return 0;
+
+	for(;;)
+	{
+		uint8_t *request, reply[32];
+		uint32_t length, id;
+
+		/* Read as much as there is, so as to keep up with the client. */
+		if(len - pos < 4 || len - pos < *(uint16_t *) &buf[pos + 2] * 4u)
+		{
+			ssize_t ret;
+			memmove(buf, buf + pos, len - pos);
+			len -= pos;
+			pos = 0;
+			ret = read(fd, buf + len, sizeof(buf) - len);
+			if(ret <= 0)
+				break;
+			len += ret;
+			continue;
+		}
+		request = buf + pos;
+		length = *(uint16_t *) &request[2] * 4;
+		if(length < 4)
+			break;
+		pos += length;
+		++sequence;
+		memset(reply, 0, sizeof(reply));
+		reply[0] = 1;
+		*(uint16_t *) &reply[2] = sequence;
+		id = *(uint32_t *) &request[4] & ID_MASK;
+
+		switch(request[0])
+		{
+		case XCB_CREATE_PIXMAP:
+			if(used[id])
+				args->stats.reused++;
+			used[id] = 1;
+			break;
+		case XCB_FREE_PIXMAP:
+			used[id] = 0;
+			break;
+		case XCB_QUERY_EXTENSION:
+			if(*(uint16_t *) &request[4] == 7 && !memcmp(request + 8, "XC-MISC", 7))
+			{
+				reply[8] = 1;
+				reply[9] = XC_MISC_MAJOR;
+			}
+			if(!write_all(fd, reply, sizeof(reply)))
+				return 0;
+			break;
+		case XC_MISC_MAJOR:
+			if(request[1] != XCB_XC_MISC_GET_XID_RANGE)
+				break;
+			args->stats.ranges++;
+			free_range(used, (uint32_t *) &reply[8], (uint32_t *) &reply[12]);
+			*(uint32_t *) &reply[8] |= ID_BASE;
+			usleep(RANGE_DELAY_US);
+			if(!write_all(fd, reply, sizeof(reply)))
+				return 0;
+			break;
+		case XCB_GET_INPUT_FOCUS:
+			if(!write_all(fd, reply, sizeof(reply)))
+				return 0;
+			break;
+		}
+	}
+	free(used);
+	return 0;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Returns 0 if an XID ran out. */
+static int bench_churn(int recycle, struct churn_stats *stats)
+{
+	static uint32_t live[LIVE];
+	struct server_args args;
+	xcb_connection_t *c;
+	pthread_t thread;
+	int fds[2], i;
+	double start, t;
+
+	if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+	{
+		perror("socketpair");
+		return 0;
+	}
+	memset(stats, 0, sizeof(*stats));
+	memset(&args, 0, sizeof(args));
+	args.fd = fds[1];
+	pthread_create(&thread, 0, server, &args);
+
+	c = xcb_connect_to_fd(fds[0], 0);
+	if(xcb_connection_has_error(c))
+	{
+		fprintf(stderr, "connection setup failed\n");
+		return 0;
+	}
+
+	start = now();
+	for(i = 0; i < N_CHURN; i++)
+	{
+		uint32_t *slot = &live[i % LIVE];
+		if(i >= LIVE)
+		{
+			xcb_free_pixmap(c, *slot);
+			if(recycle)
+				xcb_recycle_id(c, *slot);
+		}
+		t = now();
+		*slot = xcb_generate_id(c);
+		t = now() - t;
+		stats->generate += t;
+		if(t > stats->longest)
+			stats->longest = t;
+		if(*slot == (uint32_t) -1)
+			return 0;
+		xcb_create_pixmap(c, 24, *slot, 0x100, 1, 1);
+	}
+	free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), 0));
+	stats->total = (now() - start) / N_CHURN * 1e9;
+	stats->generate *= 1e3;
+	stats->longest *= 1e6;
+
+	xcb_disconnect(c);
+	pthread_join(thread, 0);
+	close(fds[1]);
+	stats->server = args.stats;
+	return 1;
+}
+
+int main(void)
+{
+	int recycle, failed = 0;
+
+	for(recycle = 0; recycle <= 1; recycle++)
+	{
+		const char *name = recycle ? "recycling:" : "no recycling:";
+		struct churn_stats stats;
+		if(!bench_churn(recycle, &stats))
+		{
+			printf("churn, %-13s XIDs ran out\n", name);
+			failed = 1;
+			continue;
+		}
+		printf("churn, %-13s %7.1f ns per pixmap, %6.2f ms in xcb_generate_id, "
+				"longest %7.1f us\n", name, stats.total, stats.generate,
+				stats.longest);
+		printf("       %-13s %3d GetXIDRange, %d XIDs in use handed out\n",
+				"", stats.server.ranges, stats.server.reused);
+		failed |= stats.server.reused != 0;
+	}
+	return failed;
+}
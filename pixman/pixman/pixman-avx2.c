@@ -0,0 +1,1533 @@
+/*
+ * Copyright © 2008 Rodrigo Kumpera
+ * Copyright © 2008 André Tupinambá
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Red Hat not be used in advertising or
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.  Red Hat makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+ * AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING
+ * OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ *
+ * Based on pixman-sse2.c; the arithmetic is kept bit-exact with the
+ * SSE2 and C implementations, only the vector width changes.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include "pixman-private.h"
+#include "pixman-combine32.h"
+#include "pixman-inlines.h"
+
+/* ------------------------------------------------------------------
+ * Helpers
+ *
+ * Most functions below work on eight packed a8r8g8b8 pixels held in
+ * one 256 bit register and unpack to 16 bits per channel internally.
+ * Partial vectors at the end of a scanline are handled with masked
+ * loads and stores, so there are no scalar tails for 32 bpp data.
+ */
+
+static const int32_t tail_masks[16] =
+{
+    -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  0,  0,  0,  0,  0,  0,  0
+};
+
+/* Mask selecting the first n (0 <= n <= 8) 32 bit lanes */
+static force_inline __m256i
+tail_mask (int n)
+{
+    return _mm256_loadu_si256 ((const __m256i *)(tail_masks + 8 - n));
+}
+
+static force_inline __m256i
+load_8x32 (const uint32_t *p, int n)
+{
+    if (n >= 8)
+	return _mm256_loadu_si256 ((const __m256i *)p);
+
+    return _mm256_maskload_epi32 ((const int *)p, tail_mask (n));
+}
+
+static force_inline void
+store_8x32 (uint32_t *p, __m256i data, int n)
+{
+    if (n >= 8)
+	_mm256_storeu_si256 ((__m256i *)p, data);
+    else
+	_mm256_maskstore_epi32 ((int *)p, tail_mask (n), data);
+}
+
+/* Loads n (0 <= n <= 8) a8 values and widens them to one value per
+ * 32 bit lane.
+ */
+static force_inline __m256i
+load_8x8 (const uint8_t *p, int n)
+{
+    uint64_t m = 0;
+
+    memcpy (&m, p, n >= 8 ? 8 : n);
+
+    return _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *)&m));
+}
+
+static force_inline __m256i
+unpack_lo_256 (__m256i data)
+{
+    return _mm256_unpacklo_epi8 (data, _mm256_setzero_si256 ());
+}
+
+static force_inline __m256i
+unpack_hi_256 (__m256i data)
+{
+    return _mm256_unpackhi_epi8 (data, _mm256_setzero_si256 ());
+}
+
+static force_inline __m256i
+pix_multiply_16x16 (__m256i data, __m256i alpha)
+{
+    return _mm256_mulhi_epu16 (
+	_mm256_adds_epu16 (_mm256_mullo_epi16 (data, alpha),
+			   _mm256_set1_epi16 (0x0080)),
+	_mm256_set1_epi16 (0x0101));
+}
+
+/* Per channel x * y / 255 of two packed vectors */
+static force_inline __m256i
+pix_multiply_8x32 (__m256i x, __m256i y)
+{
+    __m256i lo = pix_multiply_16x16 (unpack_lo_256 (x), unpack_lo_256 (y));
+    __m256i hi = pix_multiply_16x16 (unpack_hi_256 (x), unpack_hi_256 (y));
+
+    return _mm256_packus_epi16 (lo, hi);
+}
+
+static force_inline __m256i
+pix_add_multiply_8x32 (__m256i x, __m256i a, __m256i y, __m256i b)
+{
+    return _mm256_adds_epu8 (pix_multiply_8x32 (x, a),
+			     pix_multiply_8x32 (y, b));
+}
+
+static force_inline __m256i
+expand_alpha_8x32 (__m256i data)
+{
+    const __m256i shuffle = _mm256_setr_epi8 (
+	3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15,
+	3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+
+    return _mm256_shuffle_epi8 (data, shuffle);
+}
+
+/* Replicates an a8 value held in each 32 bit lane to all four bytes */
+static force_inline __m256i
+expand_a8_8x32 (__m256i data)
+{
+    return _mm256_mullo_epi32 (data, _mm256_set1_epi32 (0x01010101));
+}
+
+static force_inline __m256i
+negate_8x32 (__m256i data)
+{
+    return _mm256_xor_si256 (data, _mm256_set1_epi32 (-1));
+}
+
+static force_inline int
+is_opaque_8x32 (__m256i x)
+{
+    __m256i ffs = _mm256_cmpeq_epi8 (x, _mm256_set1_epi32 (-1));
+
+    return (_mm256_movemask_epi8 (ffs) & 0x88888888) == 0x88888888;
+}
+
+static force_inline int
+is_zero_8x32 (__m256i x)
+{
+    return _mm256_testz_si256 (x, x);
+}
+
+static force_inline int
+is_transparent_8x32 (__m256i x)
+{
+    return _mm256_testz_si256 (x, _mm256_set1_epi32 (0xff000000));
+}
+
+static force_inline __m256i
+over_8x32 (__m256i src, __m256i alpha, __m256i dst)
+{
+    return _mm256_adds_epu8 (
+	src, pix_multiply_8x32 (dst, negate_8x32 (alpha)));
+}
+
+static force_inline __m256i
+combine8 (const uint32_t *ps, const uint32_t *pm, int n)
+{
+    __m256i s = load_8x32 (ps, n);
+
+    if (pm)
+    {
+	__m256i m = load_8x32 (pm, n);
+
+	if (is_transparent_8x32 (m))
+	    return _mm256_setzero_si256 ();
+
+	s = pix_multiply_8x32 (s, expand_alpha_8x32 (m));
+    }
+
+    return s;
+}
+
+/* ------------------------------------------------------------------
+ * Unified combiners
+ */
+
+static force_inline __m256i
+core_combine_over_u_8x32 (__m256i s, __m256i d)
+{
+    if (is_opaque_8x32 (s))
+	return s;
+    else if (is_zero_8x32 (s))
+	return d;
+
+    return over_8x32 (s, expand_alpha_8x32 (s), d);
+}
+
+static force_inline __m256i
+core_combine_over_reverse_u_8x32 (__m256i s, __m256i d)
+{
+    return over_8x32 (d, expand_alpha_8x32 (d), s);
+}
+
+static force_inline __m256i
+core_combine_in_u_8x32 (__m256i s, __m256i d)
+{
+    return pix_multiply_8x32 (s, expand_alpha_8x32 (d));
+}
+
+static force_inline __m256i
+core_combine_in_reverse_u_8x32 (__m256i s, __m256i d)
+{
+    return pix_multiply_8x32 (d, expand_alpha_8x32 (s));
+}
+
+static force_inline __m256i
+core_combine_out_u_8x32 (__m256i s, __m256i d)
+{
+    return pix_multiply_8x32 (s, negate_8x32 (expand_alpha_8x32 (d)));
+}
+
+static force_inline __m256i
+core_combine_out_reverse_u_8x32 (__m256i s, __m256i d)
+{
+    return pix_multiply_8x32 (d, negate_8x32 (expand_alpha_8x32 (s)));
+}
+
+static force_inline __m256i
+core_combine_atop_u_8x32 (__m256i s, __m256i d)
+{
+    return pix_add_multiply_8x32 (
+	s, expand_alpha_8x32 (d),
+	d, negate_8x32 (expand_alpha_8x32 (s)));
+}
+
+static force_inline __m256i
+core_combine_atop_reverse_u_8x32 (__m256i s, __m256i d)
+{
+    return pix_add_multiply_8x32 (
+	s, negate_8x32 (expand_alpha_8x32 (d)),
+	d, expand_alpha_8x32 (s));
+}
+
+static force_inline __m256i
+core_combine_xor_u_8x32 (__m256i s, __m256i d)
+{
+    return pix_add_multiply_8x32 (
+	s, negate_8x32 (expand_alpha_8x32 (d)),
+	d, negate_8x32 (expand_alpha_8x32 (s)));
+}
+
+static force_inline __m256i
+core_combine_add_u_8x32 (__m256i s, __m256i d)
+{
+    return _mm256_adds_epu8 (s, d);
+}
+
+#define AVX2_COMBINE_U(name)						\
+static void								\
+avx2_combine_ ## name ## _u (pixman_implementation_t *imp,		\
+			     pixman_op_t              op,		\
+			     uint32_t *               pd,		\
+			     const uint32_t *         ps,		\
+			     const uint32_t *         pm,		\
+			     int                      w)		\
+{									\
+    while (w > 0)							\
+    {									\
+	__m256i s = combine8 (ps, pm, w);				\
+	__m256i d = load_8x32 (pd, w);					\
+									\
+	store_8x32 (pd, core_combine_ ## name ## _u_8x32 (s, d), w);	\
+									\
+	pd += 8;							\
+	ps += 8;							\
+	if (pm)								\
+	    pm += 8;							\
+	w -= 8;								\
+    }									\
+}
+
+AVX2_COMBINE_U (over)
+AVX2_COMBINE_U (over_reverse)
+AVX2_COMBINE_U (in)
+AVX2_COMBINE_U (in_reverse)
+AVX2_COMBINE_U (out)
+AVX2_COMBINE_U (out_reverse)
+AVX2_COMBINE_U (atop)
+AVX2_COMBINE_U (atop_reverse)
+AVX2_COMBINE_U (xor)
+AVX2_COMBINE_U (add)
+
+/* ------------------------------------------------------------------
+ * Composite fast paths
+ */
+
+static void
+avx2_composite_over_8888_8888 (pixman_implementation_t *imp,
+			       pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	avx2_combine_over_u (imp, op, dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+avx2_composite_add_8888_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	avx2_combine_add_u (imp, op, dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+avx2_composite_src_x888_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line, *dst;
+    uint32_t    *src_line, *src;
+    int32_t w;
+    int dst_stride, src_stride;
+    const __m256i alpha = _mm256_set1_epi32 (0xff000000);
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+	w = width;
+
+	while (w >= 32)
+	{
+	    __m256i s0 = _mm256_loadu_si256 ((__m256i *)(src +  0));
+	    __m256i s1 = _mm256_loadu_si256 ((__m256i *)(src +  8));
+	    __m256i s2 = _mm256_loadu_si256 ((__m256i *)(src + 16));
+	    __m256i s3 = _mm256_loadu_si256 ((__m256i *)(src + 24));
+
+	    _mm256_storeu_si256 ((__m256i *)(dst +  0), _mm256_or_si256 (s0, alpha));
+	    _mm256_storeu_si256 ((__m256i *)(dst +  8), _mm256_or_si256 (s1, alpha));
+	    _mm256_storeu_si256 ((__m256i *)(dst + 16), _mm256_or_si256 (s2, alpha));
+	    _mm256_storeu_si256 ((__m256i *)(dst + 24), _mm256_or_si256 (s3, alpha));
+
+	    dst += 32;
+	    src += 32;
+	    w -= 32;
+	}
+
+	while (w > 0)
+	{
+	    store_8x32 (dst, _mm256_or_si256 (load_8x32 (src, w), alpha), w);
+
+	    dst += 8;
+	    src += 8;
+	    w -= 8;
+	}
+    }
+}
+
+static void
+avx2_composite_over_n_8888 (pixman_implementation_t *imp,
+			    pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t    *dst_line, *dst;
+    int32_t w;
+    int dst_stride;
+    __m256i vsrc, valpha;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    if (src == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    vsrc = _mm256_set1_epi32 (src);
+    valpha = expand_alpha_8x32 (vsrc);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	w = width;
+
+	while (w > 0)
+	{
+	    store_8x32 (dst, over_8x32 (vsrc, valpha, load_8x32 (dst, w)), w);
+
+	    dst += 8;
+	    w -= 8;
+	}
+    }
+}
+
+static void
+avx2_composite_over_n_8_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t *dst_line, *dst;
+    uint8_t *mask_line, *mask;
+    int dst_stride, mask_stride;
+    int32_t w;
+    __m256i vsrc, valpha;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    if (src == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    vsrc = _mm256_set1_epi32 (src);
+    valpha = expand_alpha_8x32 (vsrc);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	mask = mask_line;
+	mask_line += mask_stride;
+	w = width;
+
+	while (w > 0)
+	{
+	    __m256i m = load_8x8 (mask, w);
+
+	    if (!is_zero_8x32 (m))
+	    {
+		__m256i d;
+
+		m = expand_a8_8x32 (m);
+
+		if ((src >> 24) == 0xff && is_opaque_8x32 (m))
+		{
+		    d = vsrc;
+		}
+		else
+		{
+		    d = over_8x32 (pix_multiply_8x32 (vsrc, m),
+				   pix_multiply_8x32 (valpha, m),
+				   load_8x32 (dst, w));
+		}
+
+		store_8x32 (dst, d, w);
+	    }
+
+	    dst += 8;
+	    mask += 8;
+	    w -= 8;
+	}
+    }
+}
+
+static void
+avx2_composite_over_8888_n_8888 (pixman_implementation_t *imp,
+				 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line, *dst;
+    uint32_t    *src_line, *src;
+    uint32_t mask;
+    int32_t w;
+    int dst_stride, src_stride;
+    __m256i vmask;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    mask = _pixman_image_get_solid (imp, mask_image, PIXMAN_a8r8g8b8);
+
+    vmask = expand_alpha_8x32 (_mm256_set1_epi32 (mask));
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+	w = width;
+
+	while (w > 0)
+	{
+	    __m256i s = load_8x32 (src, w);
+
+	    if (!is_zero_8x32 (s))
+	    {
+		s = pix_multiply_8x32 (s, vmask);
+
+		store_8x32 (dst, over_8x32 (s, expand_alpha_8x32 (s),
+					    load_8x32 (dst, w)), w);
+	    }
+
+	    dst += 8;
+	    src += 8;
+	    w -= 8;
+	}
+    }
+}
+
+static force_inline void
+composite_over_8888_8_8888_line (uint32_t       *dst,
+				 const uint32_t *src,
+				 const uint8_t  *mask,
+				 int32_t         w,
+				 uint32_t        src_or)
+{
+    const __m256i vor = _mm256_set1_epi32 (src_or);
+
+    while (w > 0)
+    {
+	__m256i m = load_8x8 (mask, w);
+
+	if (!is_zero_8x32 (m))
+	{
+	    __m256i s = _mm256_or_si256 (load_8x32 (src, w), vor);
+
+	    s = pix_multiply_8x32 (s, expand_a8_8x32 (m));
+
+	    store_8x32 (dst, core_combine_over_u_8x32 (
+			    s, load_8x32 (dst, w)), w);
+	}
+
+	dst += 8;
+	src += 8;
+	mask += 8;
+	w -= 8;
+    }
+}
+
+static void
+avx2_composite_over_8888_8_8888 (pixman_implementation_t *imp,
+				 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *src_line;
+    uint32_t    *dst_line;
+    uint8_t     *mask_line;
+    int dst_stride, mask_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	composite_over_8888_8_8888_line (
+	    dst_line, src_line, mask_line, width, 0);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+	mask_line += mask_stride;
+    }
+}
+
+static void
+avx2_composite_over_x888_8_8888 (pixman_implementation_t *imp,
+				 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *src_line;
+    uint32_t    *dst_line;
+    uint8_t     *mask_line;
+    int dst_stride, mask_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	composite_over_8888_8_8888_line (
+	    dst_line, src_line, mask_line, width, 0xff000000);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+	mask_line += mask_stride;
+    }
+}
+
+static void
+avx2_composite_add_8_8 (pixman_implementation_t *imp,
+			pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t     *dst_line, *dst;
+    uint8_t     *src_line, *src;
+    int dst_stride, src_stride;
+    int32_t w;
+    uint16_t t;
+
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint8_t, src_stride, src_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	src = src_line;
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+	w = width;
+
+	while (w >= 32)
+	{
+	    __m256i s = _mm256_loadu_si256 ((__m256i *)src);
+	    __m256i d = _mm256_loadu_si256 ((__m256i *)dst);
+
+	    _mm256_storeu_si256 ((__m256i *)dst, _mm256_adds_epu8 (s, d));
+
+	    dst += 32;
+	    src += 32;
+	    w -= 32;
+	}
+
+	/* Whole pixels of the tail go through the 32 bit combiner */
+	avx2_combine_add_u (imp, op,
+			    (uint32_t *)dst, (uint32_t *)src, NULL, w >> 2);
+
+	dst += w & ~3;
+	src += w & ~3;
+
+	w &= 3;
+
+	while (w)
+	{
+	    t = (*dst) + (*src++);
+	    *dst++ = t | (0 - (t >> 8));
+	    w--;
+	}
+    }
+}
+
+static void
+avx2_composite_in_n_8_8 (pixman_implementation_t *imp,
+			 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t     *dst_line, *dst;
+    uint8_t     *mask_line, *mask;
+    int dst_stride, mask_stride;
+    uint32_t src, srca;
+    uint16_t t;
+    int32_t w;
+    __m256i valpha;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+    srca = src >> 24;
+
+    valpha = _mm256_set1_epi16 (srca);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	mask = mask_line;
+	mask_line += mask_stride;
+	w = width;
+
+	while (w >= 32)
+	{
+	    __m256i m = _mm256_loadu_si256 ((__m256i *)mask);
+	    __m256i d = _mm256_loadu_si256 ((__m256i *)dst);
+	    __m256i lo, hi;
+
+	    lo = pix_multiply_16x16 (valpha, unpack_lo_256 (m));
+	    hi = pix_multiply_16x16 (valpha, unpack_hi_256 (m));
+	    lo = pix_multiply_16x16 (lo, unpack_lo_256 (d));
+	    hi = pix_multiply_16x16 (hi, unpack_hi_256 (d));
+
+	    _mm256_storeu_si256 ((__m256i *)dst, _mm256_packus_epi16 (lo, hi));
+
+	    mask += 32;
+	    dst += 32;
+	    w -= 32;
+	}
+
+	while (w)
+	{
+	    uint8_t m = MUL_UN8 (srca, *mask++, t);
+
+	    *dst = MUL_UN8 (m, *dst, t);
+	    dst++;
+	    w--;
+	}
+    }
+}
+
+/* ------------------------------------------------------------------
+ * Nearest scaling
+ */
+
+/* Fetches the next n (1 <= n <= 8) nearest neighbour source pixels,
+ * advancing vx the same way as the scalar scanlines do. A full block
+ * that cannot wrap around the repeat boundary is fetched with a single
+ * gather.
+ */
+static force_inline __m256i
+fetch_nearest_8 (const uint32_t *ps,
+		 pixman_fixed_t *vx_,
+		 pixman_fixed_t  unit_x,
+		 pixman_fixed_t  src_width_fixed,
+		 int             n)
+{
+    pixman_fixed_t vx = *vx_;
+    uint32_t tmp[8];
+    int i;
+
+    if (n >= 8 && vx < 0 && (int64_t) vx + 8 * (int64_t) unit_x < 0)
+    {
+	__m256i x = _mm256_add_epi32 (
+	    _mm256_set1_epi32 (vx),
+	    _mm256_mullo_epi32 (_mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7),
+				_mm256_set1_epi32 (unit_x)));
+
+	*vx_ = vx + 8 * unit_x;
+
+	return _mm256_i32gather_epi32 (
+	    (const int *)ps, _mm256_srai_epi32 (x, 16), 4);
+    }
+
+    for (i = 0; i < n && i < 8; i++)
+    {
+	tmp[i] = *(ps + pixman_fixed_to_int (vx));
+	vx += unit_x;
+	while (vx >= 0)
+	    vx -= src_width_fixed;
+    }
+
+    *vx_ = vx;
+
+    return load_8x32 (tmp, n);
+}
+
+static force_inline void
+scaled_nearest_scanline_avx2_8888_8888_OVER (uint32_t*       pd,
+					     const uint32_t* ps,
+					     int32_t         w,
+					     pixman_fixed_t  vx,
+					     pixman_fixed_t  unit_x,
+					     pixman_fixed_t  src_width_fixed,
+					     pixman_bool_t   fully_transparent_src)
+{
+    if (fully_transparent_src)
+	return;
+
+    while (w > 0)
+    {
+	__m256i s = fetch_nearest_8 (ps, &vx, unit_x, src_width_fixed, w);
+
+	if (!is_zero_8x32 (s))
+	    store_8x32 (pd, core_combine_over_u_8x32 (s, load_8x32 (pd, w)), w);
+
+	pd += 8;
+	w -= 8;
+    }
+}
+
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_cover_OVER,
+		       scaled_nearest_scanline_avx2_8888_8888_OVER,
+		       uint32_t, uint32_t, COVER)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_none_OVER,
+		       scaled_nearest_scanline_avx2_8888_8888_OVER,
+		       uint32_t, uint32_t, NONE)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_pad_OVER,
+		       scaled_nearest_scanline_avx2_8888_8888_OVER,
+		       uint32_t, uint32_t, PAD)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_normal_OVER,
+		       scaled_nearest_scanline_avx2_8888_8888_OVER,
+		       uint32_t, uint32_t, NORMAL)
+
+static force_inline void
+scaled_nearest_scanline_avx2_8888_8888_SRC (uint32_t*       pd,
+					    const uint32_t* ps,
+					    int32_t         w,
+					    pixman_fixed_t  vx,
+					    pixman_fixed_t  unit_x,
+					    pixman_fixed_t  src_width_fixed,
+					    pixman_bool_t   fully_transparent_src)
+{
+    if (fully_transparent_src)
+    {
+	memset (pd, 0, w * sizeof (uint32_t));
+	return;
+    }
+
+    while (w > 0)
+    {
+	store_8x32 (pd, fetch_nearest_8 (ps, &vx, unit_x, src_width_fixed, w), w);
+
+	pd += 8;
+	w -= 8;
+    }
+}
+
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_cover_SRC,
+		       scaled_nearest_scanline_avx2_8888_8888_SRC,
+		       uint32_t, uint32_t, COVER)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_none_SRC,
+		       scaled_nearest_scanline_avx2_8888_8888_SRC,
+		       uint32_t, uint32_t, NONE)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_pad_SRC,
+		       scaled_nearest_scanline_avx2_8888_8888_SRC,
+		       uint32_t, uint32_t, PAD)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_normal_SRC,
+		       scaled_nearest_scanline_avx2_8888_8888_SRC,
+		       uint32_t, uint32_t, NORMAL)
+
+static force_inline void
+scaled_nearest_scanline_avx2_x888_8888_SRC (uint32_t*       pd,
+					    const uint32_t* ps,
+					    int32_t         w,
+					    pixman_fixed_t  vx,
+					    pixman_fixed_t  unit_x,
+					    pixman_fixed_t  src_width_fixed,
+					    pixman_bool_t   fully_transparent_src)
+{
+    const __m256i alpha = _mm256_set1_epi32 (0xff000000);
+
+    while (w > 0)
+    {
+	__m256i s = fetch_nearest_8 (ps, &vx, unit_x, src_width_fixed, w);
+
+	store_8x32 (pd, _mm256_or_si256 (s, alpha), w);
+
+	pd += 8;
+	w -= 8;
+    }
+}
+
+FAST_NEAREST_MAINLOOP (avx2_x888_8888_cover_SRC,
+		       scaled_nearest_scanline_avx2_x888_8888_SRC,
+		       uint32_t, uint32_t, COVER)
+FAST_NEAREST_MAINLOOP (avx2_x888_8888_pad_SRC,
+		       scaled_nearest_scanline_avx2_x888_8888_SRC,
+		       uint32_t, uint32_t, PAD)
+FAST_NEAREST_MAINLOOP (avx2_x888_8888_normal_SRC,
+		       scaled_nearest_scanline_avx2_x888_8888_SRC,
+		       uint32_t, uint32_t, NORMAL)
+
+/* ------------------------------------------------------------------
+ * Bilinear scaling
+ */
+
+/* Horizontal interpolation of two pixels: one per 128 bit lane, with
+ * the left and right pixel in the low and high half of the lane, each
+ * channel already interpolated vertically.
+ */
+static force_inline __m256i
+bilinear_horizontal_2 (__m256i lr, __m256i wh)
+{
+    __m256i rl = _mm256_shuffle_epi32 (lr, _MM_SHUFFLE (1, 0, 3, 2));
+
+    return _mm256_srli_epi32 (
+	_mm256_madd_epi16 (_mm256_unpacklo_epi16 (lr, rl), wh),
+	BILINEAR_INTERPOLATION_BITS * 2);
+}
+
+/* Interpolates the eight pixels at the positions in vx, which are
+ * relative to src_top and src_bottom.
+ */
+static force_inline __m256i
+bilinear_interpolate_8 (const uint32_t *src_top,
+			const uint32_t *src_bottom,
+			__m256i         vx,
+			__m256i         wt,
+			__m256i         wb)
+{
+    const __m256i zero = _mm256_setzero_si256 ();
+    __m256i idx = _mm256_srai_epi32 (vx, 16);
+    __m128i idx0 = _mm256_castsi256_si128 (idx);
+    __m128i idx1 = _mm256_extracti128_si256 (idx, 1);
+    __m256i wx, wh, t0, t1, b0, b1, a0, a1, a2, a3;
+
+    /* Each 64 bit gather fetches a left/right pair of pixels */
+    t0 = _mm256_i32gather_epi64 ((const long long *)src_top, idx0, 4);
+    t1 = _mm256_i32gather_epi64 ((const long long *)src_top, idx1, 4);
+    b0 = _mm256_i32gather_epi64 ((const long long *)src_bottom, idx0, 4);
+    b1 = _mm256_i32gather_epi64 ((const long long *)src_bottom, idx1, 4);
+
+    /* Horizontal weights: iw in the low and w in the high 16 bits */
+    wx = _mm256_and_si256 (
+	_mm256_srli_epi32 (vx, 16 - BILINEAR_INTERPOLATION_BITS),
+	_mm256_set1_epi32 (BILINEAR_INTERPOLATION_RANGE - 1));
+    wh = _mm256_or_si256 (
+	_mm256_sub_epi32 (_mm256_set1_epi32 (BILINEAR_INTERPOLATION_RANGE), wx),
+	_mm256_slli_epi32 (wx, 16));
+
+    /* Vertical interpolation; lanes hold pixels (0, 2), (1, 3),
+     * (4, 6) and (5, 7) respectively.
+     */
+    a0 = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpacklo_epi8 (t0, zero), wt),
+			   _mm256_mullo_epi16 (_mm256_unpacklo_epi8 (b0, zero), wb));
+    a1 = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpackhi_epi8 (t0, zero), wt),
+			   _mm256_mullo_epi16 (_mm256_unpackhi_epi8 (b0, zero), wb));
+    a2 = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpacklo_epi8 (t1, zero), wt),
+			   _mm256_mullo_epi16 (_mm256_unpacklo_epi8 (b1, zero), wb));
+    a3 = _mm256_add_epi16 (_mm256_mullo_epi16 (_mm256_unpackhi_epi8 (t1, zero), wt),
+			   _mm256_mullo_epi16 (_mm256_unpackhi_epi8 (b1, zero), wb));
+
+    a0 = bilinear_horizontal_2 (a0, _mm256_permutevar8x32_epi32 (
+				    wh, _mm256_setr_epi32 (0, 0, 0, 0, 2, 2, 2, 2)));
+    a1 = bilinear_horizontal_2 (a1, _mm256_permutevar8x32_epi32 (
+				    wh, _mm256_setr_epi32 (1, 1, 1, 1, 3, 3, 3, 3)));
+    a2 = bilinear_horizontal_2 (a2, _mm256_permutevar8x32_epi32 (
+				    wh, _mm256_setr_epi32 (4, 4, 4, 4, 6, 6, 6, 6)));
+    a3 = bilinear_horizontal_2 (a3, _mm256_permutevar8x32_epi32 (
+				    wh, _mm256_setr_epi32 (5, 5, 5, 5, 7, 7, 7, 7)));
+
+    /* Pack to bytes; the 64 bit quarters then hold pixels
+     * (0, 1), (4, 5), (2, 3), (6, 7).
+     */
+    a0 = _mm256_packus_epi16 (_mm256_packs_epi32 (a0, a1),
+			      _mm256_packs_epi32 (a2, a3));
+
+    return _mm256_permute4x64_epi64 (a0, _MM_SHUFFLE (3, 1, 2, 0));
+}
+
+#define BILINEAR_DECLARE_VARIABLES_AVX2					\
+    const __m256i vwt = _mm256_set1_epi16 (wt);				\
+    const __m256i vwb = _mm256_set1_epi16 (wb);				\
+    const __m256i vux8 = _mm256_set1_epi32 (unit_x * 8);			\
+    __m256i vx = _mm256_add_epi32 (						\
+	_mm256_set1_epi32 (vx_),					\
+	_mm256_mullo_epi32 (_mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7),	\
+			    _mm256_set1_epi32 (unit_x)))
+
+/* For a partial block, the unused lanes repeat the first position so
+ * that the gathers stay within the scanline.
+ */
+#define BILINEAR_INTERPOLATE_EIGHT_PIXELS_AVX2(pix, n)			\
+do {									\
+    __m256i pos = vx;							\
+    if ((n) < 8)							\
+    {									\
+	pos = _mm256_blendv_epi8 (					\
+	    _mm256_permutevar8x32_epi32 (vx, _mm256_setzero_si256 ()),	\
+	    vx, tail_mask (n));						\
+    }									\
+    pix = bilinear_interpolate_8 (src_top, src_bottom, pos, vwt, vwb);	\
+    vx = _mm256_add_epi32 (vx, vux8);					\
+} while (0)
+
+static force_inline void
+scaled_bilinear_scanline_avx2_8888_8888_SRC (uint32_t *       dst,
+					     const uint32_t * mask,
+					     const uint32_t * src_top,
+					     const uint32_t * src_bottom,
+					     int32_t          w,
+					     int              wt,
+					     int              wb,
+					     pixman_fixed_t   vx_,
+					     pixman_fixed_t   unit_x,
+					     pixman_fixed_t   max_vx,
+					     pixman_bool_t    zero_src)
+{
+    BILINEAR_DECLARE_VARIABLES_AVX2;
+
+    while (w > 0)
+    {
+	__m256i s;
+
+	BILINEAR_INTERPOLATE_EIGHT_PIXELS_AVX2 (s, w);
+	store_8x32 (dst, s, w);
+
+	dst += 8;
+	w -= 8;
+    }
+}
+
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_cover_SRC,
+			       scaled_bilinear_scanline_avx2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       COVER, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_pad_SRC,
+			       scaled_bilinear_scanline_avx2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       PAD, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_none_SRC,
+			       scaled_bilinear_scanline_avx2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       NONE, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_normal_SRC,
+			       scaled_bilinear_scanline_avx2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       NORMAL, FLAG_NONE)
+
+static force_inline void
+scaled_bilinear_scanline_avx2_x888_8888_SRC (uint32_t *       dst,
+					     const uint32_t * mask,
+					     const uint32_t * src_top,
+					     const uint32_t * src_bottom,
+					     int32_t          w,
+					     int              wt,
+					     int              wb,
+					     pixman_fixed_t   vx_,
+					     pixman_fixed_t   unit_x,
+					     pixman_fixed_t   max_vx,
+					     pixman_bool_t    zero_src)
+{
+    BILINEAR_DECLARE_VARIABLES_AVX2;
+    const __m256i alpha = _mm256_set1_epi32 (0xff000000);
+
+    while (w > 0)
+    {
+	__m256i s;
+
+	BILINEAR_INTERPOLATE_EIGHT_PIXELS_AVX2 (s, w);
+	store_8x32 (dst, _mm256_or_si256 (s, alpha), w);
+
+	dst += 8;
+	w -= 8;
+    }
+}
+
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_x888_8888_cover_SRC,
+			       scaled_bilinear_scanline_avx2_x888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       COVER, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_x888_8888_pad_SRC,
+			       scaled_bilinear_scanline_avx2_x888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       PAD, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_x888_8888_normal_SRC,
+			       scaled_bilinear_scanline_avx2_x888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       NORMAL, FLAG_NONE)
+
+static force_inline void
+scaled_bilinear_scanline_avx2_8888_8888_OVER (uint32_t *       dst,
+					      const uint32_t * mask,
+					      const uint32_t * src_top,
+					      const uint32_t * src_bottom,
+					      int32_t          w,
+					      int              wt,
+					      int              wb,
+					      pixman_fixed_t   vx_,
+					      pixman_fixed_t   unit_x,
+					      pixman_fixed_t   max_vx,
+					      pixman_bool_t    zero_src)
+{
+    BILINEAR_DECLARE_VARIABLES_AVX2;
+
+    while (w > 0)
+    {
+	__m256i s;
+
+	BILINEAR_INTERPOLATE_EIGHT_PIXELS_AVX2 (s, w);
+
+	if (!is_zero_8x32 (s))
+	    store_8x32 (dst, core_combine_over_u_8x32 (s, load_8x32 (dst, w)), w);
+
+	dst += 8;
+	w -= 8;
+    }
+}
+
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_cover_OVER,
+			       scaled_bilinear_scanline_avx2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       COVER, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_pad_OVER,
+			       scaled_bilinear_scanline_avx2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       PAD, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_none_OVER,
+			       scaled_bilinear_scanline_avx2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       NONE, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (avx2_8888_8888_normal_OVER,
+			       scaled_bilinear_scanline_avx2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       NORMAL, FLAG_NONE)
+
+static const pixman_fast_path_t avx2_fast_paths[] =
+{
+    /* PIXMAN_OP_OVER */
+    PIXMAN_STD_FAST_PATH (OVER, solid, null, a8r8g8b8, avx2_composite_over_n_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, null, x8r8g8b8, avx2_composite_over_n_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, null, a8b8g8r8, avx2_composite_over_n_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, null, x8b8g8r8, avx2_composite_over_n_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, x8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8r8g8b8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8r8g8b8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8b8g8r8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8b8g8r8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, a8, x8r8g8b8, avx2_composite_over_8888_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, a8, a8r8g8b8, avx2_composite_over_8888_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, a8, x8b8g8r8, avx2_composite_over_8888_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, a8, a8b8g8r8, avx2_composite_over_8888_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, x8r8g8b8, a8, x8r8g8b8, avx2_composite_over_x888_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, x8r8g8b8, a8, a8r8g8b8, avx2_composite_over_x888_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, x8b8g8r8, a8, x8b8g8r8, avx2_composite_over_x888_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, x8b8g8r8, a8, a8b8g8r8, avx2_composite_over_x888_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, solid, a8r8g8b8, avx2_composite_over_8888_n_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, solid, x8r8g8b8, avx2_composite_over_8888_n_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, solid, a8b8g8r8, avx2_composite_over_8888_n_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, solid, x8b8g8r8, avx2_composite_over_8888_n_8888),
+
+    /* PIXMAN_OP_ADD */
+    PIXMAN_STD_FAST_PATH (ADD, a8, null, a8, avx2_composite_add_8_8),
+    PIXMAN_STD_FAST_PATH (ADD, a8r8g8b8, null, a8r8g8b8, avx2_composite_add_8888_8888),
+    PIXMAN_STD_FAST_PATH (ADD, a8b8g8r8, null, a8b8g8r8, avx2_composite_add_8888_8888),
+
+    /* PIXMAN_OP_SRC */
+    PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, a8r8g8b8, avx2_composite_src_x888_8888),
+    PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, a8b8g8r8, avx2_composite_src_x888_8888),
+
+    /* PIXMAN_OP_IN */
+    PIXMAN_STD_FAST_PATH (IN, solid, a8, a8, avx2_composite_in_n_8_8),
+
+    SIMPLE_NEAREST_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, avx2_8888_8888),
+
+    SIMPLE_NEAREST_FAST_PATH (SRC, x8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (SRC, a8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (SRC, x8b8g8r8, x8b8g8r8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (SRC, a8b8g8r8, x8b8g8r8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (SRC, a8r8g8b8, a8r8g8b8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (SRC, a8b8g8r8, a8b8g8r8, avx2_8888_8888),
+
+    SIMPLE_NEAREST_FAST_PATH_COVER  (SRC, x8r8g8b8, a8r8g8b8, avx2_x888_8888),
+    SIMPLE_NEAREST_FAST_PATH_COVER  (SRC, x8b8g8r8, a8b8g8r8, avx2_x888_8888),
+    SIMPLE_NEAREST_FAST_PATH_PAD    (SRC, x8r8g8b8, a8r8g8b8, avx2_x888_8888),
+    SIMPLE_NEAREST_FAST_PATH_PAD    (SRC, x8b8g8r8, a8b8g8r8, avx2_x888_8888),
+    SIMPLE_NEAREST_FAST_PATH_NORMAL (SRC, x8r8g8b8, a8r8g8b8, avx2_x888_8888),
+    SIMPLE_NEAREST_FAST_PATH_NORMAL (SRC, x8b8g8r8, a8b8g8r8, avx2_x888_8888),
+
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, a8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, x8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, a8b8g8r8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, x8b8g8r8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, x8b8g8r8, x8b8g8r8, avx2_8888_8888),
+
+    SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, x8r8g8b8, a8r8g8b8, avx2_x888_8888),
+    SIMPLE_BILINEAR_FAST_PATH_COVER  (SRC, x8b8g8r8, a8b8g8r8, avx2_x888_8888),
+    SIMPLE_BILINEAR_FAST_PATH_PAD    (SRC, x8r8g8b8, a8r8g8b8, avx2_x888_8888),
+    SIMPLE_BILINEAR_FAST_PATH_PAD    (SRC, x8b8g8r8, a8b8g8r8, avx2_x888_8888),
+    SIMPLE_BILINEAR_FAST_PATH_NORMAL (SRC, x8r8g8b8, a8r8g8b8, avx2_x888_8888),
+    SIMPLE_BILINEAR_FAST_PATH_NORMAL (SRC, x8b8g8r8, a8b8g8r8, avx2_x888_8888),
+
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, avx2_8888_8888),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, avx2_8888_8888),
+
+    { PIXMAN_OP_NONE },
+};
+
+/* ------------------------------------------------------------------
+ * Iterators
+ */
+
+static uint32_t *
+avx2_fetch_x8r8g8b8 (pixman_iter_t *iter, const uint32_t *mask)
+{
+    int w = iter->width;
+    uint32_t *dst = iter->buffer;
+    uint32_t *src = (uint32_t *)iter->bits;
+    const __m256i alpha = _mm256_set1_epi32 (0xff000000);
+
+    iter->bits += iter->stride;
+
+    while (w > 0)
+    {
+	store_8x32 (dst, _mm256_or_si256 (load_8x32 (src, w), alpha), w);
+
+	dst += 8;
+	src += 8;
+	w -= 8;
+    }
+
+    return iter->buffer;
+}
+
+typedef struct
+{
+    pixman_fixed_t	x;
+    pixman_fixed_t	y;
+    uint32_t		alpha;
+} scaled_info_t;
+
+static void
+avx2_scaled_iter_fini (pixman_iter_t *iter)
+{
+    free (iter->data);
+}
+
+static uint32_t *
+avx2_fetch_nearest_cover (pixman_iter_t *iter, const uint32_t *mask)
+{
+    scaled_info_t *info = iter->data;
+    bits_image_t *image = &iter->image->bits;
+    pixman_fixed_t ux = image->common.transform->matrix[0][0];
+    const uint32_t *row =
+	image->bits + pixman_fixed_to_int (info->y) * image->rowstride;
+    const __m256i alpha = _mm256_set1_epi32 (info->alpha);
+    const __m256i vux8 = _mm256_set1_epi32 (ux * 8);
+    uint32_t *dst = iter->buffer;
+    int w = iter->width;
+    __m256i vx;
+
+    vx = _mm256_add_epi32 (
+	_mm256_set1_epi32 (info->x),
+	_mm256_mullo_epi32 (_mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7),
+			    _mm256_set1_epi32 (ux)));
+
+    while (w > 0)
+    {
+	__m256i idx = _mm256_srai_epi32 (vx, 16);
+	__m256i s;
+
+	if (w >= 8)
+	{
+	    s = _mm256_i32gather_epi32 ((const int *)row, idx, 4);
+	}
+	else
+	{
+	    s = _mm256_mask_i32gather_epi32 (
+		_mm256_setzero_si256 (), (const int *)row, idx,
+		tail_mask (w), 4);
+	}
+
+	store_8x32 (dst, _mm256_or_si256 (s, alpha), w);
+
+	vx = _mm256_add_epi32 (vx, vux8);
+	dst += 8;
+	w -= 8;
+    }
+
+    info->y += image->common.transform->matrix[1][1];
+
+    return iter->buffer;
+}
+
+static uint32_t *
+avx2_fetch_bilinear_cover (pixman_iter_t *iter, const uint32_t *mask)
+{
+    scaled_info_t *info = iter->data;
+    bits_image_t *image = &iter->image->bits;
+    pixman_fixed_t unit_x = image->common.transform->matrix[0][0];
+    pixman_fixed_t vx_ = info->x;
+    int y0 = pixman_fixed_to_int (info->y);
+    int wb = pixman_fixed_to_bilinear_weight (info->y);
+    int wt = BILINEAR_INTERPOLATION_RANGE - wb;
+    const uint32_t *src_top = image->bits + y0 * image->rowstride;
+    const uint32_t *src_bottom = src_top;
+    const __m256i alpha = _mm256_set1_epi32 (info->alpha);
+    uint32_t *dst = iter->buffer;
+    int w = iter->width;
+    BILINEAR_DECLARE_VARIABLES_AVX2;
+
+    /* The bottom line has no weight when y is on a sample, and it may
+     * then be outside of the image.
+     */
+    if (wb)
+	src_bottom += image->rowstride;
+
+    while (w > 0)
+    {
+	__m256i s;
+
+	BILINEAR_INTERPOLATE_EIGHT_PIXELS_AVX2 (s, w);
+	store_8x32 (dst, _mm256_or_si256 (s, alpha), w);
+
+	dst += 8;
+	w -= 8;
+    }
+
+    info->y += image->common.transform->matrix[1][1];
+
+    return iter->buffer;
+}
+
+static void
+avx2_scaled_cover_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *iter_info)
+{
+    pixman_bool_t bilinear = iter_info->image_flags & FAST_PATH_BILINEAR_FILTER;
+    scaled_info_t *info;
+    pixman_vector_t v;
+
+    /* Reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (iter->image->common.transform, &v))
+	goto fail;
+
+    info = malloc (sizeof (*info));
+    if (!info)
+	goto fail;
+
+    if (bilinear)
+    {
+	info->x = v.vector[0] - pixman_fixed_1 / 2;
+	info->y = v.vector[1] - pixman_fixed_1 / 2;
+	iter->get_scanline = avx2_fetch_bilinear_cover;
+    }
+    else
+    {
+	/* Round down to closest integer, ensuring that 0.5 rounds to 0 */
+	info->x = v.vector[0] - pixman_fixed_e;
+	info->y = v.vector[1] - pixman_fixed_e;
+	iter->get_scanline = avx2_fetch_nearest_cover;
+    }
+
+    info->alpha =
+	PIXMAN_FORMAT_A (iter->image->bits.format) ? 0 : 0xff000000;
+
+    iter->fini = avx2_scaled_iter_fini;
+    iter->data = info;
+    return;
+
+fail:
+    /* Something went wrong, either a bad matrix or OOM; in such cases,
+     * we don't guarantee any particular rendering.
+     */
+    _pixman_log_error (
+	FUNC, "Allocation failure or bad matrix, skipping rendering\n");
+
+    iter->get_scanline = _pixman_iter_get_scanline_noop;
+    iter->fini = NULL;
+}
+
+/* Narrow pipeline dithering, see _pixman_dither_get_narrow_factors().
+ * Wide destinations are left to the SSE2 implementation.
+ */
+static void
+avx2_dither_write_back_narrow (pixman_iter_t *iter)
+{
+    bits_image_t *image = &iter->image->bits;
+    uint32_t *buffer = iter->buffer;
+    int width = iter->width;
+    uint16_t row[DITHER_ROW_LENGTH];
+    uint16_t mul[4], scale[4];
+    __m256i mul_16, scale_16;
+    int i;
+
+    _pixman_bits_image_get_dither_row (image, iter->x, iter->y, row);
+    _pixman_dither_get_narrow_factors (image->format, mul, scale);
+
+    mul_16 = _mm256_set_epi16 (
+	mul[3], mul[2], mul[1], mul[0], mul[3], mul[2], mul[1], mul[0],
+	mul[3], mul[2], mul[1], mul[0], mul[3], mul[2], mul[1], mul[0]);
+    scale_16 = _mm256_set_epi16 (
+	scale[3], scale[2], scale[1], scale[0],
+	scale[3], scale[2], scale[1], scale[0],
+	scale[3], scale[2], scale[1], scale[0],
+	scale[3], scale[2], scale[1], scale[0]);
+
+    for (i = 0; i < width; i += 8)
+    {
+	__m256i s, lo, hi, d, d_lo, d_hi;
+	int n = width - i;
+
+	/* floor (threshold * 255 / 8192) of pixel k in 32 bit lane k,
+	 * then repeated for the four channels of the unpacked pixels
+	 */
+	d = _mm256_cvtepu16_epi32 (
+	    _mm_loadu_si128 ((const __m128i *)(row + i % DITHER_ROW_LENGTH)));
+	d = _mm256_mulhi_epu16 (d, _mm256_set1_epi32 (255 * 8));
+	d = _mm256_or_si256 (d, _mm256_slli_epi32 (d, 16));
+	d_lo = _mm256_unpacklo_epi32 (d, d);
+	d_hi = _mm256_unpackhi_epi32 (d, d);
+
+	s = load_8x32 (buffer + i, n);
+	lo = unpack_lo_256 (s);
+	hi = unpack_hi_256 (s);
+
+	lo = _mm256_add_epi16 (_mm256_mullo_epi16 (lo, mul_16), d_lo);
+	hi = _mm256_add_epi16 (_mm256_mullo_epi16 (hi, mul_16), d_hi);
+
+	/* x / 255 == (x * 0x8081) >> 23 for all 16 bit x */
+	lo = _mm256_srli_epi16 (
+	    _mm256_mulhi_epu16 (lo, _mm256_set1_epi16 (0x8081)), 7);
+	hi = _mm256_srli_epi16 (
+	    _mm256_mulhi_epu16 (hi, _mm256_set1_epi16 (0x8081)), 7);
+
+	lo = _mm256_mullo_epi16 (lo, scale_16);
+	hi = _mm256_mullo_epi16 (hi, scale_16);
+
+	store_8x32 (buffer + i, _mm256_packus_epi16 (lo, hi), n);
+    }
+
+    image->store_scanline_32 (image, iter->x, iter->y, width, buffer);
+
+    iter->y++;
+}
+
+static void
+avx2_dither_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *iter_info)
+{
+    _pixman_bits_image_dest_iter_init (iter->image, iter);
+
+    iter->write_back = avx2_dither_write_back_narrow;
+}
+
+#define IMAGE_FLAGS							\
+    (FAST_PATH_STANDARD_FLAGS | FAST_PATH_ID_TRANSFORM |		\
+     FAST_PATH_BITS_IMAGE | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)
+
+#define NEAREST_COVER_FLAGS						\
+    (FAST_PATH_STANDARD_FLAGS | FAST_PATH_SCALE_TRANSFORM |		\
+     FAST_PATH_NEAREST_FILTER | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)
+
+#define BILINEAR_COVER_FLAGS						\
+    (FAST_PATH_STANDARD_FLAGS | FAST_PATH_SCALE_TRANSFORM |		\
+     FAST_PATH_BILINEAR_FILTER | FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR)
+
+static const pixman_iter_info_t avx2_iters[] =
+{
+    { PIXMAN_x8r8g8b8, IMAGE_FLAGS, ITER_NARROW,
+      _pixman_iter_init_bits_stride, avx2_fetch_x8r8g8b8, NULL
+    },
+    { PIXMAN_a8r8g8b8, NEAREST_COVER_FLAGS, ITER_NARROW | ITER_SRC,
+      avx2_scaled_cover_iter_init, NULL, NULL
+    },
+    { PIXMAN_x8r8g8b8, NEAREST_COVER_FLAGS, ITER_NARROW | ITER_SRC,
+      avx2_scaled_cover_iter_init, NULL, NULL
+    },
+    { PIXMAN_a8r8g8b8, BILINEAR_COVER_FLAGS, ITER_NARROW | ITER_SRC,
+      avx2_scaled_cover_iter_init, NULL, NULL
+    },
+    { PIXMAN_x8r8g8b8, BILINEAR_COVER_FLAGS, ITER_NARROW | ITER_SRC,
+      avx2_scaled_cover_iter_init, NULL, NULL
+    },
+    { PIXMAN_any, FAST_PATH_NO_ALPHA_MAP | FAST_PATH_DITHER, ITER_NARROW | ITER_DEST,
+      avx2_dither_iter_init, NULL, NULL
+    },
+    { PIXMAN_null },
+};
+
+#if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback)
+{
+    pixman_implementation_t *imp = _pixman_implementation_create (fallback, avx2_fast_paths);
+
+    imp->combine_32[PIXMAN_OP_OVER] = avx2_combine_over_u;
+    imp->combine_32[PIXMAN_OP_OVER_REVERSE] = avx2_combine_over_reverse_u;
+    imp->combine_32[PIXMAN_OP_IN] = avx2_combine_in_u;
+    imp->combine_32[PIXMAN_OP_IN_REVERSE] = avx2_combine_in_reverse_u;
+    imp->combine_32[PIXMAN_OP_OUT] = avx2_combine_out_u;
+    imp->combine_32[PIXMAN_OP_OUT_REVERSE] = avx2_combine_out_reverse_u;
+    imp->combine_32[PIXMAN_OP_ATOP] = avx2_combine_atop_u;
+    imp->combine_32[PIXMAN_OP_ATOP_REVERSE] = avx2_combine_atop_reverse_u;
+    imp->combine_32[PIXMAN_OP_XOR] = avx2_combine_xor_u;
+    imp->combine_32[PIXMAN_OP_ADD] = avx2_combine_add_u;
+
+    imp->iter_info = avx2_iters;
+
+    return imp;
+}
@@ -208,18 +208,22 @@ static force_inline void reduce_32(unsigned int satot, unsigned int srtot,
                                    void *p)
 {
     uint32_t *ret = p;
+    int32_t a, r, g, b;
 
-    satot = (satot + 0x8000) >> 16;
-    srtot = (srtot + 0x8000) >> 16;
-    sgtot = (sgtot + 0x8000) >> 16;
-    sbtot = (sbtot + 0x8000) >> 16;
+    /* The totals are signed; negative filter lobes can make them
+     * go below zero, which must clamp to 0 and not wrap to 0xff.
+     */
+    a = ((int32_t)satot + 0x8000) >> 16;
+    r = ((int32_t)srtot + 0x8000) >> 16;
+    g = ((int32_t)sgtot + 0x8000) >> 16;
+    b = ((int32_t)sbtot + 0x8000) >> 16;
 
-    satot = CLIP (satot, 0, 0xff);
-    srtot = CLIP (srtot, 0, 0xff);
-    sgtot = CLIP (sgtot, 0, 0xff);
-    sbtot = CLIP (sbtot, 0, 0xff);
+    a = CLIP (a, 0, 0xff);
+    r = CLIP (r, 0, 0xff);
+    g = CLIP (g, 0, 0xff);
+    b = CLIP (b, 0, 0xff);
 
-    *ret = ((satot << 24) | (srtot << 16) | (sgtot <<  8) | (sbtot));
+    *ret = (((uint32_t)a << 24) | (r << 16) | (g <<  8) | (b));
 }
 
 static force_inline void accum_float(unsigned int *satot, unsigned int *srtot,
@@ -240,10 +244,10 @@ static force_inline void reduce_float(unsigned int satot, unsigned int srtot,
 {
     argb_t *ret = p;
 
-    ret->a = CLIP (satot / 65536.f, 0.f, 1.f);
-    ret->r = CLIP (srtot / 65536.f, 0.f, 1.f);
-    ret->g = CLIP (sgtot / 65536.f, 0.f, 1.f);
-    ret->b = CLIP (sbtot / 65536.f, 0.f, 1.f);
+    ret->a = CLIP ((int32_t)satot / 65536.f, 0.f, 1.f);
+    ret->r = CLIP ((int32_t)srtot / 65536.f, 0.f, 1.f);
+    ret->g = CLIP ((int32_t)sgtot / 65536.f, 0.f, 1.f);
+    ret->b = CLIP ((int32_t)sbtot / 65536.f, 0.f, 1.f);
 }
 
 typedef void (* accumulate_pixel_t) (unsigned int *satot, unsigned int *srtot,
@@ -471,6 +475,18 @@ bits_image_fetch_pixel_filtered (bits_image_t  *image,
     }
 }
 
+/* In wide mode the mask is a scanline of argb_t, so pixel i is the
+ * four words starting at 4 * i, not word i.
+ */
+static force_inline pixman_bool_t
+mask_is_set (const uint32_t *mask, pixman_bool_t wide, int i)
+{
+    if (wide)
+	return (mask[4 * i] | mask[4 * i + 1] | mask[4 * i + 2] | mask[4 * i + 3]) != 0;
+
+    return mask[i] != 0;
+}
+
 static uint32_t *
 __bits_image_fetch_affine_no_alpha (pixman_iter_t *  iter,
 				    pixman_bool_t    wide,
@@ -513,7 +529,7 @@ __bits_image_fetch_affine_no_alpha (pixman_iter_t *  iter,
 
     for (i = 0; i < width; ++i)
     {
-	if (!mask || mask[i])
+	if (!mask || mask_is_set (mask, wide, i))
 	{
 	    bits_image_fetch_pixel_filtered (
 		&image->bits, wide, x, y, get_pixel, buffer);
@@ -670,7 +686,7 @@ __bits_image_fetch_general (pixman_iter_t  *iter,
     {
 	pixman_fixed_t x0, y0;
 
-	if (!mask || mask[i])
+	if (!mask || mask_is_set (mask, wide, i))
 	{
 	    if (w != 0)
 	    {
@@ -1164,6 +1180,139 @@ dither_apply_ordered (pixman_iter_t *iter, dither_factor_t factor)
     return iter->buffer;
 }
 
+void
+_pixman_bits_image_get_dither_row (bits_image_t *image, int x, int y,
+				   uint16_t *row)
+{
+    const uint16_t *noise;
+    int i;
+
+    x += image->dither_offset_x;
+    y += image->dither_offset_y;
+
+    switch (image->dither)
+    {
+    case PIXMAN_DITHER_NONE:
+	memset (row, 0, DITHER_ROW_LENGTH * sizeof (uint16_t));
+	break;
+
+    case PIXMAN_DITHER_GOOD:
+    case PIXMAN_DITHER_BEST:
+    case PIXMAN_DITHER_ORDERED_BLUE_NOISE_64:
+	noise = dither_blue_noise_64x64 + ((y & 0x3f) << 6);
+
+	for (i = 0; i < DITHER_ROW_LENGTH; ++i)
+	    row[i] = 2 * noise[(x + i) & 0x3f] + 1;
+	break;
+
+    case PIXMAN_DITHER_FAST:
+    case PIXMAN_DITHER_ORDERED_BAYER_8:
+	/* The factors are multiples of 1/128, so this is exact */
+	for (i = 0; i < DITHER_ROW_LENGTH; ++i)
+	    row[i] = dither_factor_bayer_8 (x + i, y) * 8192.f;
+	break;
+    }
+}
+
+/* For a channel value c and an n bit destination channel, the wide
+ * pipeline stores
+ *
+ *     floor (c / 255 * (2^n - 1) + d)
+ *
+ * (see dither_apply_channel() and float_to_unorm()). Since c * (2^n - 1)
+ * is an integer, this is the same as
+ *
+ *     floor ((c * (2^n - 1) + floor (d * 255)) / 255)
+ *
+ * The result is then multiplied by 2^(8 - n), so that the store, which
+ * drops the low bits, gets it back. Channels that are not narrower than
+ * 8 bits can't be dithered in the narrow pipeline; they use a factor of
+ * 255 and come out unchanged.
+ */
+void
+_pixman_dither_get_narrow_factors (pixman_format_code_t format,
+				   uint16_t mul[4], uint16_t scale[4])
+{
+    int sizes[4];
+    int i;
+
+    sizes[0] = PIXMAN_FORMAT_B (format);
+    sizes[1] = PIXMAN_FORMAT_G (format);
+    sizes[2] = PIXMAN_FORMAT_R (format);
+    sizes[3] = PIXMAN_FORMAT_A (format);
+
+    for (i = 0; i < 4; ++i)
+    {
+	if (sizes[i] == 0 || sizes[i] >= 8)
+	{
+	    mul[i] = 255;
+	    scale[i] = 1;
+	}
+	else
+	{
+	    mul[i] = (1 << sizes[i]) - 1;
+	    scale[i] = 1 << (8 - sizes[i]);
+	}
+    }
+}
+
+/* Whether a composite that dithers into image can use the narrow
+ * pipeline. That is the case when every channel of the destination is
+ * narrower than 8 bits, so that the 8 bits of the narrow pipeline
+ * still have something to dither with. PIXMAN_DITHER_BEST always uses
+ * the wide pipeline.
+ */
+pixman_bool_t
+_pixman_dither_is_narrow (pixman_image_t *image)
+{
+    pixman_format_code_t format = image->bits.format;
+
+    if (image->bits.dither == PIXMAN_DITHER_NONE)
+	return TRUE;
+
+    if (image->bits.dither == PIXMAN_DITHER_BEST)
+	return FALSE;
+
+    return (PIXMAN_FORMAT_A (format) < 8 &&
+	    PIXMAN_FORMAT_R (format) < 8 &&
+	    PIXMAN_FORMAT_G (format) < 8 &&
+	    PIXMAN_FORMAT_B (format) < 8);
+}
+
+static void
+dest_write_back_narrow_dither (pixman_iter_t *iter)
+{
+    bits_image_t *  image  = &iter->image->bits;
+    uint32_t *      buffer = iter->buffer;
+    int             width  = iter->width;
+    uint16_t        row[DITHER_ROW_LENGTH];
+    uint16_t        mul[4], scale[4];
+    int             i, c;
+
+    _pixman_bits_image_get_dither_row (image, iter->x, iter->y, row);
+    _pixman_dither_get_narrow_factors (image->format, mul, scale);
+
+    for (i = 0; i < width; ++i)
+    {
+	uint32_t d = (row[i % DITHER_ROW_LENGTH] * 255) >> 13;
+	uint32_t s = buffer[i];
+	uint32_t result = 0;
+
+	for (c = 0; c < 4; ++c)
+	{
+	    uint32_t v = (s >> (8 * c)) & 0xff;
+
+	    v = (v * mul[c] + d) / 255 * scale[c];
+
+	    result |= v << (8 * c);
+	}
+
+	buffer[i] = result;
+    }
+
+    dest_write_back_narrow (iter);
+}
+
 static void
 dest_write_back_wide (pixman_iter_t *iter)
 {
@@ -1218,8 +1367,11 @@ _pixman_bits_image_dest_iter_init (pixman_image_t *image, pixman_iter_t *iter)
 	{
 	    iter->get_scanline = dest_get_scanline_narrow;
 	}
-	
-	iter->write_back = dest_write_back_narrow;
+
+	if (image->bits.dither != PIXMAN_DITHER_NONE)
+	    iter->write_back = dest_write_back_narrow_dither;
+	else
+	    iter->write_back = dest_write_back_narrow;
     }
     else
     {
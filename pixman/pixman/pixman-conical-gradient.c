@@ -50,10 +50,71 @@ coordinates_to_parameter (double x, double y, double angle)
 				      */
 }
 
+/* atan2 (y, x) to within about 1e-5, which is far below the angle
+ * covered by one entry of the color table.
+ */
+static force_inline double
+fast_atan2 (double y, double x)
+{
+    double ax = fabs (x), ay = fabs (y);
+    double mn = ax < ay ? ax : ay;
+    double mx = ax < ay ? ay : ax;
+    double q = mx > 0 ? mn / mx : 0;
+    double s = q * q;
+    double r;
+
+    r = ((-0.0464964749 * s + 0.15931422) * s - 0.327622764) * s * q + q;
+
+    if (ay > ax)
+	r = M_PI / 2 - r;
+    if (x < 0)
+	r = M_PI - r;
+    if (y < 0)
+	r = -r;
+
+    return r;
+}
+
+/* The affine case of conical_get_scanline() for a gradient with a
+ * color table.
+ */
+static void
+conical_write_row_lut (const conical_gradient_t *conical,
+		       const uint32_t           *lut,
+		       pixman_repeat_t           repeat,
+		       double                    rx,
+		       double                    ry,
+		       double                    cx,
+		       double                    cy,
+		       const uint32_t           *mask,
+		       uint32_t                 *buffer,
+		       int                       width)
+{
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	if (!mask || mask[i])
+	{
+	    double t = fast_atan2 (ry, rx) + conical->angle;
+
+	    t -= 2 * M_PI * floor (t * (1 / (2 * M_PI)));
+	    t = 1 - t * (1 / (2 * M_PI));
+
+	    buffer[i] = _pixman_gradient_lut_lookup (
+		lut, repeat, pixman_double_to_fixed (t));
+	}
+
+	rx += cx;
+	ry += cy;
+    }
+}
+
 static uint32_t *
 conical_get_scanline (pixman_iter_t                 *iter,
 		      const uint32_t                *mask,
 		      int                            Bpp,
+		      const uint32_t                *lut,
 		      pixman_gradient_walker_write_t write_pixel)
 {
     pixman_image_t *image = iter->image;
@@ -101,7 +162,15 @@ conical_get_scanline (pixman_iter_t                 *iter,
 	    v.vector[2] == pixman_fixed_1;
     }
 
-    if (affine)
+    if (affine && lut)
+    {
+	rx -= conical->center.x / 65536.;
+	ry -= conical->center.y / 65536.;
+
+	conical_write_row_lut (conical, lut, image->common.repeat,
+			       rx, ry, cx, cy, mask, buffer, width);
+    }
+    else if (affine)
     {
 	rx -= conical->center.x / 65536.;
 	ry -= conical->center.y / 65536.;
@@ -168,14 +237,17 @@ conical_get_scanline (pixman_iter_t                 *iter,
 static uint32_t *
 conical_get_scanline_narrow (pixman_iter_t *iter, const uint32_t *mask)
 {
+    gradient_t *gradient = (gradient_t *)iter->image;
+
     return conical_get_scanline (iter, mask, 4,
+				 gradient->lut ? gradient->lut->colors : NULL,
 				 _pixman_gradient_walker_write_narrow);
 }
 
 static uint32_t *
 conical_get_scanline_wide (pixman_iter_t *iter, const uint32_t *mask)
 {
-    return conical_get_scanline (iter, NULL, 16,
+    return conical_get_scanline (iter, NULL, 16, NULL,
 				 _pixman_gradient_walker_write_wide);
 }
 
@@ -3173,12 +3173,12 @@ static const pixman_iter_info_t fast_iters[] =
     { PIXMAN_r5g6b5, IMAGE_FLAGS, ITER_NARROW | ITER_SRC,
       _pixman_iter_init_bits_stride, fast_fetch_r5g6b5, NULL },
 
-    { PIXMAN_r5g6b5, FAST_PATH_STD_DEST_FLAGS,
+    { PIXMAN_r5g6b5, FAST_PATH_STD_DEST_FLAGS | FAST_PATH_NO_DITHER,
       ITER_NARROW | ITER_DEST,
       _pixman_iter_init_bits_stride,
       fast_fetch_r5g6b5, fast_write_back_r5g6b5 },
     
-    { PIXMAN_r5g6b5, FAST_PATH_STD_DEST_FLAGS,
+    { PIXMAN_r5g6b5, FAST_PATH_STD_DEST_FLAGS | FAST_PATH_NO_DITHER,
       ITER_NARROW | ITER_DEST | ITER_IGNORE_RGB | ITER_IGNORE_ALPHA,
       _pixman_iter_init_bits_stride,
       fast_dest_fetch_noop, fast_write_back_r5g6b5 },
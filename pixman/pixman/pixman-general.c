@@ -142,7 +142,7 @@ general_composite_rect  (pixman_implementation_t *imp,
 	(!mask_image || mask_image->common.flags & FAST_PATH_NARROW_FORMAT)  &&
 	(dest_image->common.flags & FAST_PATH_NARROW_FORMAT)		     &&
 	!(operator_needs_division (op))                                      &&
-	(dest_image->bits.dither == PIXMAN_DITHER_NONE))
+	_pixman_dither_is_narrow (dest_image))
     {
 	width_flag = ITER_NARROW;
 	Bpp = 4;
@@ -391,20 +391,22 @@ box32_intersect (pixman_box32_t *dest,
     return dest->x2 > dest->x1 && dest->y2 > dest->y1;
 }
 
-#if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
-__attribute__((__force_align_arg_pointer__))
-#endif
-PIXMAN_EXPORT void
-pixman_composite_glyphs_no_mask (pixman_op_t            op,
-				 pixman_image_t        *src,
-				 pixman_image_t        *dest,
-				 int32_t                src_x,
-				 int32_t                src_y,
-				 int32_t                dest_x,
-				 int32_t                dest_y,
-				 pixman_glyph_cache_t  *cache,
-				 int                    n_glyphs,
-				 const pixman_glyph_t  *glyphs)
+/* Composites each glyph directly onto the destination, using the glyph
+ * as the mask. If clip is not NULL, only the part of the destination
+ * inside that box is affected.
+ */
+static void
+composite_glyphs_direct (pixman_op_t            op,
+			 pixman_image_t        *src,
+			 pixman_image_t        *dest,
+			 int32_t                src_x,
+			 int32_t                src_y,
+			 int32_t                dest_x,
+			 int32_t                dest_y,
+			 const pixman_box32_t  *clip,
+			 pixman_glyph_cache_t  *cache,
+			 int                    n_glyphs,
+			 const pixman_glyph_t  *glyphs)
 {
     pixman_region32_t region;
     pixman_format_code_t glyph_format = PIXMAN_null;
@@ -432,6 +434,14 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
 	goto out;
     }
 
+    if (clip)
+    {
+	pixman_region32_intersect_rect (&region, &region,
+					clip->x1, clip->y1,
+					clip->x2 - clip->x1,
+					clip->y2 - clip->y1);
+    }
+
     info.op = op;
     info.src_image = src;
     info.dest_image = dest;
@@ -498,6 +508,25 @@ out:
     pixman_region32_fini (&region);
 }
 
+#if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+PIXMAN_EXPORT void
+pixman_composite_glyphs_no_mask (pixman_op_t            op,
+				 pixman_image_t        *src,
+				 pixman_image_t        *dest,
+				 int32_t                src_x,
+				 int32_t                src_y,
+				 int32_t                dest_x,
+				 int32_t                dest_y,
+				 pixman_glyph_cache_t  *cache,
+				 int                    n_glyphs,
+				 const pixman_glyph_t  *glyphs)
+{
+    composite_glyphs_direct (op, src, dest, src_x, src_y, dest_x, dest_y,
+			     NULL, cache, n_glyphs, glyphs);
+}
+
 static void
 add_glyphs (pixman_glyph_cache_t *cache,
 	    pixman_image_t *dest,
@@ -617,6 +646,79 @@ out:
 	pixman_image_unref (white_img);
 }
 
+/* Runs longer than this always go through a mask. Such runs are rarely
+ * free of overlaps, and the cost of the mask is spread over many glyphs.
+ */
+#define N_DIRECT_GLYPHS 128
+
+/* Returns TRUE if compositing the glyphs one by one onto the destination
+ * gives the same result as compositing them through a mask of the given
+ * format. This is the case when
+ *
+ *   - the operator leaves the destination alone where the mask is zero,
+ *   - the mask has an alpha channel, so it is zero outside the glyphs,
+ *   - every glyph has the format of the mask, so that adding it to the
+ *     (initially clear) mask doesn't change its pixels, and
+ *   - no two glyphs overlap.
+ */
+static pixman_bool_t
+can_composite_glyphs_direct (pixman_op_t           op,
+			     pixman_format_code_t  mask_format,
+			     int                   n_glyphs,
+			     const pixman_glyph_t *glyphs)
+{
+    pixman_box32_t boxes[N_DIRECT_GLYPHS];
+    int max_width = 0;
+    int i, j;
+
+    if (op != PIXMAN_OP_OVER && op != PIXMAN_OP_ADD)
+	return FALSE;
+
+    if (PIXMAN_FORMAT_A (mask_format) == 0 || n_glyphs > N_DIRECT_GLYPHS)
+	return FALSE;
+
+    /* Insertion sort on x1; glyph runs are usually already in order */
+    for (i = 0; i < n_glyphs; ++i)
+    {
+	const glyph_t *glyph = glyphs[i].glyph;
+	pixman_box32_t box;
+
+	if (glyph->image->bits.format != mask_format)
+	    return FALSE;
+
+	box.x1 = glyphs[i].x - glyph->origin_x;
+	box.y1 = glyphs[i].y - glyph->origin_y;
+	box.x2 = box.x1 + glyph->image->bits.width;
+	box.y2 = box.y1 + glyph->image->bits.height;
+
+	if (box.x2 - box.x1 > max_width)
+	    max_width = box.x2 - box.x1;
+
+	for (j = i; j > 0 && boxes[j - 1].x1 > box.x1; --j)
+	    boxes[j] = boxes[j - 1];
+
+	boxes[j] = box;
+    }
+
+    /* Only boxes that start less than max_width to the left of a box
+     * can reach into it.
+     */
+    for (i = 1; i < n_glyphs; ++i)
+    {
+	for (j = i - 1; j >= 0 && boxes[j].x1 > boxes[i].x1 - max_width; --j)
+	{
+	    if (boxes[j].x2 > boxes[i].x1	&&
+		boxes[j].y1 < boxes[i].y2	&&
+		boxes[i].y1 < boxes[j].y2)
+	    {
+		return FALSE;
+	    }
+	}
+    }
+
+    return TRUE;
+}
+
 /* Conceptually, for each glyph, (white IN glyph) is PIXMAN_OP_ADDed to an
  * infinitely big mask image at the position such that the glyph origin point
  * is positioned at the (glyphs[i].x, glyphs[i].y) point.
@@ -629,6 +731,9 @@ out:
  *
  * rectangle.
  *
+ * When that gives the same result, short runs of glyphs that don't
+ * overlap skip the mask and are composited straight onto the destination.
+ *
  * TODO:
  *   - Trim the mask to the destination clip/image?
  *   - Trim composite region based on sources, when the op ignores 0s.
@@ -655,6 +760,25 @@ pixman_composite_glyphs (pixman_op_t            op,
 {
     pixman_image_t *mask;
 
+    if (width <= 0 || height <= 0)
+	return;
+
+    if (can_composite_glyphs_direct (op, mask_format, n_glyphs, glyphs))
+    {
+	pixman_box32_t clip;
+
+	clip.x1 = dest_x;
+	clip.y1 = dest_y;
+	clip.x2 = dest_x + width;
+	clip.y2 = dest_y + height;
+
+	composite_glyphs_direct (op, src, dest,
+				 src_x - mask_x, src_y - mask_y,
+				 dest_x - mask_x, dest_y - mask_y,
+				 &clip, cache, n_glyphs, glyphs);
+	return;
+    }
+
     if (!(mask = pixman_image_create_bits (mask_format, width, height, NULL, -1)))
 	return;
 
@@ -26,6 +26,7 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
+#include <stdlib.h>
 #include "pixman-private.h"
 
 void
@@ -262,3 +263,56 @@ _pixman_gradient_walker_fill_wide (pixman_gradient_walker_t *walker,
     while (buffer_wide < end_wide)
 	*buffer_wide++ = color;
 }
+
+/* Compositing fewer pixels than this many times the size of the
+ * color table evaluates the gradient directly, since filling the
+ * table costs about as much as evaluating that many pixels.
+ */
+#define GRADIENT_LUT_MIN_RATIO	4
+
+/* Makes sure a gradient that is about to be composited n_pixels at a
+ * time has a color table for its current repeat mode if that is
+ * worthwhile. The table is built during composite setup rather than
+ * on first use, because the iterators of a threaded composite run
+ * concurrently and must only read the image.
+ */
+void
+_pixman_gradient_prepare_lut (pixman_image_t *image,
+			      int64_t         n_pixels)
+{
+    gradient_t *gradient = &image->gradient;
+    pixman_repeat_t repeat = image->common.repeat;
+    pixman_gradient_walker_t walker;
+    gradient_lut_t *lut;
+    int i;
+
+    if (image->type != LINEAR && image->type != RADIAL &&
+	image->type != CONICAL)
+    {
+	return;
+    }
+
+    if (gradient->lut || n_pixels < GRADIENT_LUT_MIN_RATIO * GRADIENT_LUT_SIZE)
+	return;
+
+    lut = malloc (sizeof (gradient_lut_t));
+    if (!lut)
+	return;
+
+    _pixman_gradient_walker_init (&walker, gradient, repeat);
+
+    lut->repeat = repeat;
+    lut->colors[0] = pixman_gradient_walker_pixel_32 (&walker, -1);
+
+    for (i = 0; i < GRADIENT_LUT_SIZE; ++i)
+    {
+	pixman_fixed_48_16_t pos = ((2 * i + 1) << 16) / (2 * GRADIENT_LUT_SIZE);
+
+	lut->colors[i + 1] = pixman_gradient_walker_pixel_32 (&walker, pos);
+    }
+
+    lut->colors[GRADIENT_LUT_SIZE + 1] =
+	pixman_gradient_walker_pixel_32 (&walker, pixman_fixed_1);
+
+    gradient->lut = lut;
+}
@@ -73,6 +73,15 @@ gradient_property_changed (pixman_image_t *image)
 	end->color = stops[n - 1].color;
 	break;
     }
+
+    /* The stops never change, so the color table only has to go when
+     * the repeat mode does.
+     */
+    if (gradient->lut && gradient->lut->repeat != gradient->common.repeat)
+    {
+	free (gradient->lut);
+	gradient->lut = NULL;
+    }
 }
 
 pixman_bool_t
@@ -100,6 +109,7 @@ _pixman_init_gradient (gradient_t *                  gradient,
     gradient->stops += 1;
     memcpy (gradient->stops, stops, n_stops * sizeof (pixman_gradient_stop_t));
     gradient->n_stops = n_stops;
+    gradient->lut = NULL;
 
     gradient->common.property_changed = gradient_property_changed;
 
@@ -161,6 +171,8 @@ _pixman_image_fini (pixman_image_t *image)
 		free (image->gradient.stops - 1);
 	    }
 
+	    free (image->gradient.lut);
+
 	    /* This will trigger if someone adds a property_changed
 	     * method to the linear/radial/conical gradient overwriting
 	     * the general one.
@@ -525,6 +537,11 @@ compute_image_info (pixman_image_t *image)
 	    flags &= ~FAST_PATH_NARROW_FORMAT;
     }
 
+    if (image->type == BITS && image->bits.dither != PIXMAN_DITHER_NONE)
+	flags |= FAST_PATH_DITHER;
+    else
+	flags |= FAST_PATH_NO_DITHER;
+
     /* Both alpha maps and convolution filters can introduce
      * non-opaqueness in otherwise opaque images. Also
      * an image with component alpha turned on is only opaque
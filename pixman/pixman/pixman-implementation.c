@@ -52,6 +52,273 @@ _pixman_implementation_create (pixman_implementation_t *fallback,
     return imp;
 }
 
+/* Index of the fast paths of a whole implementation chain
+ *
+ * Fast paths that name an operator and all three formats go into a
+ * hash table keyed on those; the few that use PIXMAN_OP_any or
+ * PIXMAN_any are kept in a separate list. A lookup walks its bucket
+ * and that list together, in the order in which a search of the fast
+ * path arrays would visit them, and stops at the first fast path whose
+ * flags match. So it picks the same fast path as such a search.
+ */
+typedef struct
+{
+    const pixman_fast_path_t *	fast_path;
+    pixman_implementation_t *	imp;
+    int				priority;
+} indexed_fast_path_t;
+
+typedef struct
+{
+    pixman_op_t			op;
+    pixman_format_code_t	src_format;
+    pixman_format_code_t	mask_format;
+    pixman_format_code_t	dest_format;
+    int				first;
+    int				n_paths;
+} fast_path_bucket_t;
+
+struct pixman_fast_path_index_t
+{
+    uint32_t			hash_mask;
+    fast_path_bucket_t *	buckets;
+    indexed_fast_path_t *	paths;
+    indexed_fast_path_t *	wildcards;
+    int				n_wildcards;
+};
+
+static force_inline pixman_bool_t
+fast_path_matches (const pixman_fast_path_t *info,
+		   pixman_op_t               op,
+		   pixman_format_code_t      src_format,
+		   uint32_t                  src_flags,
+		   pixman_format_code_t      mask_format,
+		   uint32_t                  mask_flags,
+		   pixman_format_code_t      dest_format,
+		   uint32_t                  dest_flags)
+{
+    return
+	(info->op == op || info->op == PIXMAN_OP_any)		&&
+	/* Formats */
+	((info->src_format == src_format) ||
+	 (info->src_format == PIXMAN_any))			&&
+	((info->mask_format == mask_format) ||
+	 (info->mask_format == PIXMAN_any))			&&
+	((info->dest_format == dest_format) ||
+	 (info->dest_format == PIXMAN_any))			&&
+	/* Flags */
+	(info->src_flags & src_flags) == info->src_flags	&&
+	(info->mask_flags & mask_flags) == info->mask_flags	&&
+	(info->dest_flags & dest_flags) == info->dest_flags;
+}
+
+static pixman_bool_t
+is_wildcard_fast_path (const pixman_fast_path_t *info)
+{
+    return info->op == PIXMAN_OP_any		||
+	   info->src_format == PIXMAN_any	||
+	   info->mask_format == PIXMAN_any	||
+	   info->dest_format == PIXMAN_any;
+}
+
+static force_inline uint32_t
+hash_fast_path_key (pixman_op_t          op,
+		    pixman_format_code_t src_format,
+		    pixman_format_code_t mask_format,
+		    pixman_format_code_t dest_format)
+{
+    uint32_t h = op;
+
+    h = (h ^ src_format) * 0x9e3779b1;
+    h = (h ^ mask_format) * 0x9e3779b1;
+    h = (h ^ dest_format) * 0x9e3779b1;
+
+    return h ^ (h >> 16);
+}
+
+static fast_path_bucket_t *
+find_bucket (const pixman_fast_path_index_t *index,
+	     pixman_op_t                     op,
+	     pixman_format_code_t            src_format,
+	     pixman_format_code_t            mask_format,
+	     pixman_format_code_t            dest_format)
+{
+    uint32_t i = hash_fast_path_key (
+	op, src_format, mask_format, dest_format) & index->hash_mask;
+
+    for (;;)
+    {
+	fast_path_bucket_t *bucket = &index->buckets[i];
+
+	/* Unused buckets have PIXMAN_OP_NONE and no paths */
+	if (bucket->op == PIXMAN_OP_NONE		||
+	    (bucket->op == op				&&
+	     bucket->src_format == src_format		&&
+	     bucket->mask_format == mask_format		&&
+	     bucket->dest_format == dest_format))
+	{
+	    return bucket;
+	}
+
+	i = (i + 1) & index->hash_mask;
+    }
+}
+
+void
+_pixman_implementation_build_fast_path_index (pixman_implementation_t *toplevel)
+{
+    pixman_fast_path_index_t *index;
+    pixman_implementation_t *imp;
+    const pixman_fast_path_t *info;
+    int n_paths = 0, n_wildcards = 0, n_buckets, priority, i;
+
+    for (imp = toplevel; imp != NULL; imp = imp->fallback)
+    {
+	for (info = imp->fast_paths; info->op != PIXMAN_OP_NONE; ++info)
+	{
+	    if (is_wildcard_fast_path (info))
+		n_wildcards++;
+	    else
+		n_paths++;
+	}
+    }
+
+    /* At most half full, so that probing always finds an unused
+     * bucket and stays short
+     */
+    n_buckets = 16;
+    while (n_buckets < 2 * n_paths)
+	n_buckets *= 2;
+
+    index = malloc (sizeof (pixman_fast_path_index_t));
+    if (!index)
+	return;
+
+    index->hash_mask = n_buckets - 1;
+    index->n_wildcards = n_wildcards;
+    index->buckets = calloc (n_buckets, sizeof (fast_path_bucket_t));
+    index->paths = pixman_malloc_ab (
+	n_paths + n_wildcards, sizeof (indexed_fast_path_t));
+
+    if (!index->buckets || !index->paths)
+    {
+	free (index->buckets);
+	free (index->paths);
+	free (index);
+	return;
+    }
+
+    index->wildcards = index->paths + n_paths;
+
+    for (i = 0; i < n_buckets; ++i)
+	index->buckets[i].op = PIXMAN_OP_NONE;
+
+    /* Count the fast paths in each bucket... */
+    for (imp = toplevel; imp != NULL; imp = imp->fallback)
+    {
+	for (info = imp->fast_paths; info->op != PIXMAN_OP_NONE; ++info)
+	{
+	    fast_path_bucket_t *bucket;
+
+	    if (is_wildcard_fast_path (info))
+		continue;
+
+	    bucket = find_bucket (index, info->op, info->src_format,
+				  info->mask_format, info->dest_format);
+
+	    bucket->op = info->op;
+	    bucket->src_format = info->src_format;
+	    bucket->mask_format = info->mask_format;
+	    bucket->dest_format = info->dest_format;
+	    bucket->n_paths++;
+	}
+    }
+
+    /* ...give each bucket its range of paths... */
+    n_paths = 0;
+    for (i = 0; i < n_buckets; ++i)
+    {
+	index->buckets[i].first = n_paths;
+	n_paths += index->buckets[i].n_paths;
+	index->buckets[i].n_paths = 0;
+    }
+
+    /* ...and fill them in, in the order of the search */
+    priority = 0;
+    n_wildcards = 0;
+    for (imp = toplevel; imp != NULL; imp = imp->fallback)
+    {
+	for (info = imp->fast_paths; info->op != PIXMAN_OP_NONE; ++info)
+	{
+	    indexed_fast_path_t *path;
+
+	    if (is_wildcard_fast_path (info))
+	    {
+		path = &index->wildcards[n_wildcards++];
+	    }
+	    else
+	    {
+		fast_path_bucket_t *bucket = find_bucket (
+		    index, info->op, info->src_format,
+		    info->mask_format, info->dest_format);
+
+		path = &index->paths[bucket->first + bucket->n_paths++];
+	    }
+
+	    path->fast_path = info;
+	    path->imp = imp;
+	    path->priority = priority++;
+	}
+    }
+
+    toplevel->fast_path_index = index;
+}
+
+static pixman_bool_t
+lookup_indexed (const pixman_fast_path_index_t *index,
+		pixman_op_t                     op,
+		pixman_format_code_t            src_format,
+		uint32_t                        src_flags,
+		pixman_format_code_t            mask_format,
+		uint32_t                        mask_flags,
+		pixman_format_code_t            dest_format,
+		uint32_t                        dest_flags,
+		pixman_implementation_t       **out_imp,
+		pixman_composite_func_t        *out_func)
+{
+    const fast_path_bucket_t *bucket;
+    const indexed_fast_path_t *p, *p_end, *w, *w_end;
+
+    bucket = find_bucket (index, op, src_format, mask_format, dest_format);
+
+    p = index->paths + bucket->first;
+    p_end = p + bucket->n_paths;
+    w = index->wildcards;
+    w_end = w + index->n_wildcards;
+
+    while (p < p_end || w < w_end)
+    {
+	const indexed_fast_path_t *path;
+
+	if (w == w_end || (p < p_end && p->priority < w->priority))
+	    path = p++;
+	else
+	    path = w++;
+
+	if (fast_path_matches (path->fast_path, op,
+			       src_format, src_flags,
+			       mask_format, mask_flags,
+			       dest_format, dest_flags))
+	{
+	    *out_imp = path->imp;
+	    *out_func = path->fast_path->func;
+	    return TRUE;
+	}
+    }
+
+    return FALSE;
+}
+
 #define N_CACHED_FAST_PATHS 8
 
 typedef struct
@@ -115,37 +382,43 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 	}
     }
 
-    for (imp = toplevel; imp != NULL; imp = imp->fallback)
-    {
-	const pixman_fast_path_t *info = imp->fast_paths;
+    /* Set i to the last spot in the cache so that the move-to-front
+     * code below will work
+     */
+    i = N_CACHED_FAST_PATHS - 1;
 
-	while (info->op != PIXMAN_OP_NONE)
+    if (toplevel->fast_path_index)
+    {
+	if (lookup_indexed (toplevel->fast_path_index, op,
+			    src_format, src_flags,
+			    mask_format, mask_flags,
+			    dest_format, dest_flags,
+			    out_imp, out_func))
 	{
-	    if ((info->op == op || info->op == PIXMAN_OP_any)		&&
-		/* Formats */
-		((info->src_format == src_format) ||
-		 (info->src_format == PIXMAN_any))			&&
-		((info->mask_format == mask_format) ||
-		 (info->mask_format == PIXMAN_any))			&&
-		((info->dest_format == dest_format) ||
-		 (info->dest_format == PIXMAN_any))			&&
-		/* Flags */
-		(info->src_flags & src_flags) == info->src_flags	&&
-		(info->mask_flags & mask_flags) == info->mask_flags	&&
-		(info->dest_flags & dest_flags) == info->dest_flags)
-	    {
-		*out_imp = imp;
-		*out_func = info->func;
-
-		/* Set i to the last spot in the cache so that the
-		 * move-to-front code below will work
-		 */
-		i = N_CACHED_FAST_PATHS - 1;
+	    goto update_cache;
+	}
+    }
+    else
+    {
+	for (imp = toplevel; imp != NULL; imp = imp->fallback)
+	{
+	    const pixman_fast_path_t *info = imp->fast_paths;
 
-		goto update_cache;
+	    while (info->op != PIXMAN_OP_NONE)
+	    {
+		if (fast_path_matches (info, op,
+				       src_format, src_flags,
+				       mask_format, mask_flags,
+				       dest_format, dest_flags))
+		{
+		    *out_imp = imp;
+		    *out_func = info->func;
+
+		    goto update_cache;
+		}
+
+		++info;
 	    }
-
-	    ++info;
 	}
     }
 
@@ -413,5 +686,7 @@ _pixman_choose_implementation (void)
             cur->fast_paths = empty_fast_path;
     }
 
+    _pixman_implementation_build_fast_path_index (imp);
+
     return imp;
 }
@@ -31,18 +31,19 @@
 #include <stdlib.h>
 #include "pixman-private.h"
 
+/* Computes how much the input of the gradient walker changes when
+ * moving down by 'height' rows. Returns FALSE if that is not a
+ * constant.
+ */
 static pixman_bool_t
-linear_gradient_is_horizontal (pixman_image_t *image,
-			       int             x,
-			       int             y,
-			       int             width,
-			       int             height)
+linear_gradient_increment (pixman_image_t *image,
+			   int             height,
+			   double         *inc)
 {
     linear_gradient_t *linear = (linear_gradient_t *)image;
     pixman_vector_t v;
     pixman_fixed_32_32_t l;
     pixman_fixed_48_16_t dx, dy;
-    double inc;
 
     if (image->common.transform)
     {
@@ -73,13 +74,28 @@ linear_gradient_is_horizontal (pixman_image_t *image,
     if (l == 0)
 	return FALSE;
 
+    *inc = height * (double) pixman_fixed_1 * pixman_fixed_1 *
+	(dx * v.vector[0] + dy * v.vector[1]) /
+	(v.vector[2] * (double) l);
+
+    return TRUE;
+}
+
+static pixman_bool_t
+linear_gradient_is_horizontal (pixman_image_t *image,
+			       int             x,
+			       int             y,
+			       int             width,
+			       int             height)
+{
+    double inc;
+
     /*
      * compute how much the input of the gradient walked changes
      * when moving vertically through the whole image
      */
-    inc = height * (double) pixman_fixed_1 * pixman_fixed_1 *
-	(dx * v.vector[0] + dy * v.vector[1]) /
-	(v.vector[2] * (double) l);
+    if (!linear_gradient_increment (image, height, &inc))
+	return FALSE;
 
     /* check that casting to integer would result in 0 */
     if (-1 < inc && inc < 1)
@@ -88,10 +104,28 @@ linear_gradient_is_horizontal (pixman_image_t *image,
     return FALSE;
 }
 
+/* Whether compositing the rows of a gradient in several pieces
+ * produces the same pixels as compositing them at once. It does
+ * unless the gradient changes so little from row to row that
+ * linear_gradient_is_horizontal() answers differently depending on
+ * the height.
+ */
+pixman_bool_t
+_pixman_linear_gradient_is_splittable (pixman_image_t *image)
+{
+    double inc;
+
+    if (!linear_gradient_increment (image, 1, &inc))
+	return TRUE;
+
+    return inc == 0 || inc <= -1 || inc >= 1;
+}
+
 static uint32_t *
 linear_get_scanline (pixman_iter_t                 *iter,
 		     const uint32_t                *mask,
 		     int                            Bpp,
+		     const uint32_t                *lut,
 		     pixman_gradient_walker_write_t write_pixel,
 		     pixman_gradient_walker_fill_t  fill_pixel)
 {
@@ -165,6 +199,20 @@ linear_get_scanline (pixman_iter_t                 *iter,
 	{
 	    fill_pixel (&walker, t, buffer, end);
 	}
+	else if (lut)
+	{
+	    pixman_repeat_t repeat = image->common.repeat;
+	    int i;
+
+	    for (i = 0; i < width; ++i)
+	    {
+		if (!mask || mask[i])
+		{
+		    buffer[i] = _pixman_gradient_lut_lookup (
+			lut, repeat, t + (pixman_fixed_32_32_t)(inc * i));
+		}
+	    }
+	}
 	else
 	{
 	    int i;
@@ -204,7 +252,15 @@ linear_get_scanline (pixman_iter_t                 *iter,
 			 (dx * linear->p1.x + dy * linear->p1.y) * v2) * invden;
 		}
 
-		write_pixel (&walker, t, buffer);
+		if (lut)
+		{
+		    *buffer = _pixman_gradient_lut_lookup (
+			lut, image->common.repeat, t);
+		}
+		else
+		{
+		    write_pixel (&walker, t, buffer);
+		}
 	    }
 
 	    buffer += (Bpp / 4);
@@ -224,7 +280,10 @@ static uint32_t *
 linear_get_scanline_narrow (pixman_iter_t  *iter,
 			    const uint32_t *mask)
 {
+    gradient_t *gradient = (gradient_t *)iter->image;
+
     return linear_get_scanline (iter, mask, 4,
+				gradient->lut ? gradient->lut->colors : NULL,
 				_pixman_gradient_walker_write_narrow,
 				_pixman_gradient_walker_fill_narrow);
 }
@@ -233,7 +292,7 @@ linear_get_scanline_narrow (pixman_iter_t  *iter,
 static uint32_t *
 linear_get_scanline_wide (pixman_iter_t *iter, const uint32_t *mask)
 {
-    return linear_get_scanline (iter, NULL, 16,
+    return linear_get_scanline (iter, NULL, 16, NULL,
 				_pixman_gradient_walker_write_wide,
 				_pixman_gradient_walker_fill_wide);
 }
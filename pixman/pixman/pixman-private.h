@@ -128,11 +128,26 @@ struct solid_fill
     argb_t	   color_float;
 };
 
+/* The colors of a gradient at GRADIENT_LUT_SIZE evenly spaced
+ * positions in [0, 1), preceded by the color before 0 and followed by
+ * the color from 1 on, which is what the NONE and PAD repeat modes
+ * use outside the stops.
+ */
+#define GRADIENT_LUT_BITS	12
+#define GRADIENT_LUT_SIZE	(1 << GRADIENT_LUT_BITS)
+
+typedef struct
+{
+    pixman_repeat_t	    repeat;
+    uint32_t		    colors[GRADIENT_LUT_SIZE + 2];
+} gradient_lut_t;
+
 struct gradient
 {
     image_common_t	    common;
     int                     n_stops;
     pixman_gradient_stop_t *stops;
+    gradient_lut_t *	    lut;
 };
 
 struct linear_gradient
@@ -289,9 +304,35 @@ _pixman_bits_image_src_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 void
 _pixman_bits_image_dest_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 
+/* Ordered dithering. The thresholds are in units of 1/8192, and pixel
+ * x + i of a scanline uses row[i % DITHER_ROW_LENGTH].
+ */
+#define DITHER_ROW_LENGTH	64
+
+void
+_pixman_bits_image_get_dither_row (bits_image_t *image, int x, int y,
+				   uint16_t *row);
+
+/* Per channel factors for dithering 8 bit channels, in the order b, g, r, a
+ * of an a8r8g8b8 pixel. A channel c becomes
+ *
+ *     (c * mul + threshold * 255 / 8192) / 255 * scale
+ *
+ * where the threshold comes from _pixman_bits_image_get_dither_row().
+ */
+void
+_pixman_dither_get_narrow_factors (pixman_format_code_t format,
+				   uint16_t mul[4], uint16_t scale[4]);
+
+pixman_bool_t
+_pixman_dither_is_narrow (pixman_image_t *image);
+
 void
 _pixman_linear_gradient_iter_init (pixman_image_t *image, pixman_iter_t  *iter);
 
+pixman_bool_t
+_pixman_linear_gradient_is_splittable (pixman_image_t *image);
+
 void
 _pixman_radial_gradient_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 
@@ -400,6 +441,43 @@ _pixman_gradient_walker_fill_wide(pixman_gradient_walker_t *walker,
 				  uint32_t                 *buffer,
 				  uint32_t                 *end);
 
+void
+_pixman_gradient_prepare_lut (pixman_image_t *image,
+			      int64_t         n_pixels);
+
+/* Looks up the 8888 color at pos in the color table of a gradient.
+ * This is what _pixman_gradient_walker_write_narrow() would produce,
+ * except that positions are rounded to the middle of one of the
+ * GRADIENT_LUT_SIZE steps.
+ */
+static force_inline uint32_t
+_pixman_gradient_lut_lookup (const uint32_t       *colors,
+			     pixman_repeat_t       repeat,
+			     pixman_fixed_48_16_t  pos)
+{
+    const int shift = 16 - GRADIENT_LUT_BITS;
+    int32_t x = (int32_t)pos;
+
+    switch (repeat)
+    {
+    case PIXMAN_REPEAT_NORMAL:
+	return colors[1 + ((x & 0xffff) >> shift)];
+
+    case PIXMAN_REPEAT_REFLECT:
+	/* Odd periods run backwards */
+	x ^= -((x >> 16) & 1);
+	return colors[1 + ((x & 0xffff) >> shift)];
+
+    default:
+	if (pos < 0)
+	    return colors[0];
+	else if (pos >= pixman_fixed_1)
+	    return colors[GRADIENT_LUT_SIZE + 1];
+	else
+	    return colors[1 + (x >> shift)];
+    }
+}
+
 /*
  * Edges
  */
@@ -524,6 +602,8 @@ typedef struct
     pixman_composite_func_t func;
 } pixman_fast_path_t;
 
+typedef struct pixman_fast_path_index_t pixman_fast_path_index_t;
+
 struct pixman_implementation_t
 {
     pixman_implementation_t *	toplevel;
@@ -531,6 +611,11 @@ struct pixman_implementation_t
     const pixman_fast_path_t *	fast_paths;
     const pixman_iter_info_t *  iter_info;
 
+    /* Fast paths of the whole chain, by operator and formats; only
+     * set on the toplevel implementation
+     */
+    pixman_fast_path_index_t *	fast_path_index;
+
     pixman_blt_func_t		blt;
     pixman_fill_func_t		fill;
 
@@ -549,6 +634,9 @@ pixman_implementation_t *
 _pixman_implementation_create (pixman_implementation_t *fallback,
 			       const pixman_fast_path_t *fast_paths);
 
+void
+_pixman_implementation_build_fast_path_index (pixman_implementation_t *toplevel);
+
 void
 _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 					 pixman_op_t               op,
@@ -630,6 +718,11 @@ pixman_implementation_t *
 _pixman_implementation_create_ssse3 (pixman_implementation_t *fallback);
 #endif
 
+#ifdef USE_AVX2
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback);
+#endif
+
 #ifdef USE_ARM_SIMD
 pixman_implementation_t *
 _pixman_implementation_create_arm_simd (pixman_implementation_t *fallback);
@@ -671,6 +764,20 @@ _pixman_choose_implementation (void);
 pixman_bool_t
 _pixman_disabled (const char *name);
 
+/*
+ * Worker pool
+ */
+typedef void (* pixman_task_func_t) (void *data, int task);
+
+int
+_pixman_threads_get_default (void);
+
+void
+_pixman_threads_run (int                n_threads,
+		     int                n_tasks,
+		     pixman_task_func_t func,
+		     void *             data);
+
 
 /*
  * Utilities
@@ -688,6 +795,22 @@ _pixman_compute_composite_region32 (pixman_region32_t * region,
 				    int32_t             dest_y,
 				    int32_t             width,
 				    int32_t             height);
+
+void
+_pixman_image_composite_region32 (pixman_op_t         op,
+				  pixman_image_t *    src,
+				  pixman_image_t *    mask,
+				  pixman_image_t *    dest,
+				  int32_t             src_x,
+				  int32_t             src_y,
+				  int32_t             mask_x,
+				  int32_t             mask_y,
+				  int32_t             dest_x,
+				  int32_t             dest_y,
+				  int32_t             width,
+				  int32_t             height,
+				  pixman_region32_t * limit);
+
 uint32_t *
 _pixman_iter_get_scanline_noop (pixman_iter_t *iter, const uint32_t *mask);
 
@@ -733,6 +856,8 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 #define FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR	(1 << 24)
 #define FAST_PATH_BITS_IMAGE			(1 << 25)
 #define FAST_PATH_SEPARABLE_CONVOLUTION_FILTER  (1 << 26)
+#define FAST_PATH_NO_DITHER			(1 << 27)
+#define FAST_PATH_DITHER			(1 << 28)
 
 #define FAST_PATH_PAD_REPEAT						\
     (FAST_PATH_NO_NONE_REPEAT		|				\
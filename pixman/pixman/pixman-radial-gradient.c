@@ -181,10 +181,72 @@ radial_write_color (double                         a,
     return;
 }
 
+/* Like calling radial_write_color() for each of width pixels along a
+ * row of an affine transformed gradient with a != 0, but choosing the
+ * root without branches and reading the colors from the color table.
+ */
+static void
+radial_write_row_lut (const radial_gradient_t *radial,
+		      const uint32_t          *lut,
+		      pixman_repeat_t          repeat,
+		      pixman_fixed_32_32_t     b,
+		      pixman_fixed_32_32_t     db,
+		      pixman_fixed_32_32_t     c,
+		      pixman_fixed_32_32_t     dc,
+		      pixman_fixed_32_32_t     ddc,
+		      const uint32_t          *mask,
+		      uint32_t                *buffer,
+		      int                      width)
+{
+    double a = radial->a;
+    double inva = radial->inva;
+    double dr = radial->delta.radius;
+    double mindr = radial->mindr;
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	if (!mask || mask[i])
+	{
+	    double discr = fdot (b, a, 0, b, -c, 0);
+	    double sqrtdiscr = sqrt (discr > 0 ? discr : 0);
+	    double t0 = (b + sqrtdiscr) * inva;
+	    double t1 = (b - sqrtdiscr) * inva;
+	    pixman_bool_t valid0, valid1;
+
+	    if (repeat == PIXMAN_REPEAT_NONE)
+	    {
+		valid0 = 0 <= t0 && t0 <= pixman_fixed_1;
+		valid1 = 0 <= t1 && t1 <= pixman_fixed_1;
+	    }
+	    else
+	    {
+		valid0 = t0 * dr >= mindr;
+		valid1 = t1 * dr >= mindr;
+	    }
+
+	    if (discr >= 0 && (valid0 | valid1))
+	    {
+		buffer[i] = _pixman_gradient_lut_lookup (
+		    lut, repeat, valid0 ? t0 : t1);
+	    }
+	    else
+	    {
+		buffer[i] = 0;
+	    }
+	}
+
+	b += db;
+	c += dc;
+	dc += ddc;
+    }
+}
+
 static uint32_t *
 radial_get_scanline (pixman_iter_t                 *iter,
 		     const uint32_t                *mask,
 		     int                            Bpp,
+		     const uint32_t                *lut,
 		     pixman_gradient_walker_write_t write_pixel)
 {
     /*
@@ -355,25 +417,33 @@ radial_get_scanline (pixman_iter_t                 *iter,
 	ddc = 2 * dot (unit.vector[0], unit.vector[1], 0,
 		       unit.vector[0], unit.vector[1], 0);
 
-	while (buffer < end)
+	if (lut && radial->a != 0)
 	{
-	    if (!mask || *mask++)
+	    radial_write_row_lut (radial, lut, image->common.repeat,
+				  b, db, c, dc, ddc, mask, buffer, width);
+	}
+	else
+	{
+	    while (buffer < end)
 	    {
-		radial_write_color (radial->a, b, c,
-				    radial->inva,
-				    radial->delta.radius,
-				    radial->mindr,
-				    &walker,
-				    image->common.repeat,
-				    Bpp,
-				    write_pixel,
-				    buffer);
-	    }
+		if (!mask || *mask++)
+		{
+		    radial_write_color (radial->a, b, c,
+					radial->inva,
+					radial->delta.radius,
+					radial->mindr,
+					&walker,
+					image->common.repeat,
+					Bpp,
+					write_pixel,
+					buffer);
+		}
 
-	    b += db;
-	    c += dc;
-	    dc += ddc;
-	    buffer += (Bpp / 4);
+		b += db;
+		c += dc;
+		dc += ddc;
+		buffer += (Bpp / 4);
+	    }
 	}
     }
     else
@@ -438,14 +508,17 @@ radial_get_scanline (pixman_iter_t                 *iter,
 static uint32_t *
 radial_get_scanline_narrow (pixman_iter_t *iter, const uint32_t *mask)
 {
+    gradient_t *gradient = (gradient_t *)iter->image;
+
     return radial_get_scanline (iter, mask, 4,
+				gradient->lut ? gradient->lut->colors : NULL,
 				_pixman_gradient_walker_write_narrow);
 }
 
 static uint32_t *
 radial_get_scanline_wide (pixman_iter_t *iter, const uint32_t *mask)
 {
-    return radial_get_scanline (iter, NULL, 16,
+    return radial_get_scanline (iter, NULL, 16, NULL,
 				_pixman_gradient_walker_write_wide);
 }
 
@@ -2369,6 +2369,892 @@ sse2_combine_add_ca (pixman_implementation_t *imp,
     }
 }
 
+/*
+ * Float combiners
+ *
+ * The Porter/Duff operators apply the same function to all four
+ * channels, so they work on one pixel per register. The PDF blend
+ * modes treat alpha differently from the colors and mix the color
+ * channels, so they combine four pixels at a time, transposed so that
+ * each register holds one channel of all four.
+ *
+ * Both follow the C combiners in pixman-combine-float.c operation by
+ * operation; branches become selects between both results, and
+ * divisors that the C code checks for zero are replaced by one before
+ * dividing so that no lane can raise a division by zero. The results
+ * are the same, bit for bit.
+ */
+typedef struct
+{
+    __m128 a, r, g, b;
+} argb_4x128_t;
+
+typedef struct
+{
+    __m128 r, g, b;
+} rgb_4x128_t;
+
+static force_inline void
+load_argb_4x128 (const float *p, argb_4x128_t *v)
+{
+    __m128 p0 = _mm_loadu_ps (p + 0);
+    __m128 p1 = _mm_loadu_ps (p + 4);
+    __m128 p2 = _mm_loadu_ps (p + 8);
+    __m128 p3 = _mm_loadu_ps (p + 12);
+
+    _MM_TRANSPOSE4_PS (p0, p1, p2, p3);
+
+    v->a = p0;
+    v->r = p1;
+    v->g = p2;
+    v->b = p3;
+}
+
+static force_inline void
+store_argb_4x128 (float *p, const argb_4x128_t *v)
+{
+    __m128 p0 = v->a;
+    __m128 p1 = v->r;
+    __m128 p2 = v->g;
+    __m128 p3 = v->b;
+
+    _MM_TRANSPOSE4_PS (p0, p1, p2, p3);
+
+    _mm_storeu_ps (p + 0, p0);
+    _mm_storeu_ps (p + 4, p1);
+    _mm_storeu_ps (p + 8, p2);
+    _mm_storeu_ps (p + 12, p3);
+}
+
+static force_inline __m128
+select_128f (__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b));
+}
+
+static force_inline __m128
+is_zero_128f (__m128 f)
+{
+    return _mm_and_ps (_mm_cmplt_ps (_mm_set1_ps (-FLT_MIN), f),
+		       _mm_cmplt_ps (f, _mm_set1_ps (FLT_MIN)));
+}
+
+/* Divides by den, except in the lanes where zero is set */
+static force_inline __m128
+safe_div_128f (__m128 num, __m128 den, __m128 zero)
+{
+    return _mm_div_ps (num, select_128f (zero, _mm_set1_ps (1.0f), den));
+}
+
+static force_inline __m128
+clamp_128f (__m128 f)
+{
+    __m128 one = _mm_set1_ps (1.0f);
+
+    f = select_128f (_mm_cmpgt_ps (f, one), one, f);
+
+    return _mm_andnot_ps (_mm_cmplt_ps (f, _mm_setzero_ps ()), f);
+}
+
+typedef __m128 (* combine_channel_128f_t) (__m128 sa, __m128 s,
+					   __m128 da, __m128 d);
+
+typedef void (* combine_4x128f_t) (argb_4x128_t       *d,
+				   const argb_4x128_t *s,
+				   const argb_4x128_t *m);
+
+static force_inline void
+combine_channels_4x128f (pixman_bool_t          component,
+			 argb_4x128_t          *d,
+			 const argb_4x128_t    *s,
+			 const argb_4x128_t    *m,
+			 combine_channel_128f_t combine_a,
+			 combine_channel_128f_t combine_c)
+{
+    __m128 sa = s->a, sr = s->r, sg = s->g, sb = s->b;
+    __m128 ma, mr, mg, mb;
+
+    if (!m)
+    {
+	ma = mr = mg = mb = sa;
+    }
+    else if (component)
+    {
+	sr = _mm_mul_ps (sr, m->r);
+	sg = _mm_mul_ps (sg, m->g);
+	sb = _mm_mul_ps (sb, m->b);
+
+	ma = _mm_mul_ps (m->a, sa);
+	mr = _mm_mul_ps (m->r, sa);
+	mg = _mm_mul_ps (m->g, sa);
+	mb = _mm_mul_ps (m->b, sa);
+
+	sa = ma;
+    }
+    else
+    {
+	sa = _mm_mul_ps (sa, m->a);
+	sr = _mm_mul_ps (sr, m->a);
+	sg = _mm_mul_ps (sg, m->a);
+	sb = _mm_mul_ps (sb, m->a);
+
+	ma = mr = mg = mb = sa;
+    }
+
+    d->r = combine_c (mr, sr, d->a, d->r);
+    d->g = combine_c (mg, sg, d->a, d->g);
+    d->b = combine_c (mb, sb, d->a, d->b);
+    d->a = combine_a (ma, sa, d->a, d->a);
+}
+
+static force_inline void
+combine_float_sse2 (float            *dest,
+		    const float      *src,
+		    const float      *mask,
+		    int               n_pixels,
+		    combine_4x128f_t  combine)
+{
+    argb_4x128_t s, m, d;
+
+    while (n_pixels >= 4)
+    {
+	load_argb_4x128 (src, &s);
+	load_argb_4x128 (dest, &d);
+
+	if (mask)
+	{
+	    load_argb_4x128 (mask, &m);
+	    mask += 16;
+	}
+
+	combine (&d, &s, mask ? &m : NULL);
+
+	store_argb_4x128 (dest, &d);
+
+	src += 16;
+	dest += 16;
+	n_pixels -= 4;
+    }
+
+    if (n_pixels > 0)
+    {
+	float s_tail[16] = { 0 }, m_tail[16] = { 0 }, d_tail[16] = { 0 };
+
+	memcpy (s_tail, src, n_pixels * 4 * sizeof (float));
+	memcpy (d_tail, dest, n_pixels * 4 * sizeof (float));
+
+	load_argb_4x128 (s_tail, &s);
+	load_argb_4x128 (d_tail, &d);
+
+	if (mask)
+	{
+	    memcpy (m_tail, mask, n_pixels * 4 * sizeof (float));
+	    load_argb_4x128 (m_tail, &m);
+	}
+
+	combine (&d, &s, mask ? &m : NULL);
+
+	store_argb_4x128 (d_tail, &d);
+	memcpy (dest, d_tail, n_pixels * 4 * sizeof (float));
+    }
+}
+
+#define MAKE_FLOAT_COMBINER_SSE2(name, component, combine_a, combine_c)	\
+    static force_inline void						\
+    combine_ ## name ## _4x128f (argb_4x128_t       *d,			\
+				 const argb_4x128_t *s,			\
+				 const argb_4x128_t *m)			\
+    {									\
+	combine_channels_4x128f (component, d, s, m,			\
+				 combine_a, combine_c);			\
+    }									\
+									\
+    static void								\
+    sse2_combine_ ## name ## _float (pixman_implementation_t *imp,	\
+				     pixman_op_t              op,	\
+				     float                   *dest,	\
+				     const float             *src,	\
+				     const float             *mask,	\
+				     int                      n_pixels)	\
+    {									\
+	combine_float_sse2 (dest, src, mask, n_pixels,			\
+			    combine_ ## name ## _4x128f);		\
+    }
+
+#define MAKE_FLOAT_COMBINERS_SSE2(name, combine_a, combine_c)		\
+    MAKE_FLOAT_COMBINER_SSE2 (name ## _ca, TRUE, combine_a, combine_c)	\
+    MAKE_FLOAT_COMBINER_SSE2 (name ## _u, FALSE, combine_a, combine_c)
+
+/* Porter/Duff operators */
+typedef enum
+{
+    ZERO,
+    ONE,
+    SRC_ALPHA,
+    DEST_ALPHA,
+    INV_SA,
+    INV_DA,
+    SA_OVER_DA,
+    DA_OVER_SA,
+    INV_SA_OVER_DA,
+    INV_DA_OVER_SA,
+    ONE_MINUS_SA_OVER_DA,
+    ONE_MINUS_DA_OVER_SA,
+    ONE_MINUS_INV_DA_OVER_SA,
+    ONE_MINUS_INV_SA_OVER_DA
+} combine_factor_t;
+
+static force_inline __m128
+get_factor_128f (combine_factor_t factor, __m128 sa, __m128 da)
+{
+    __m128 one = _mm_set1_ps (1.0f);
+    __m128 zero = _mm_setzero_ps ();
+
+    switch (factor)
+    {
+    case ZERO:
+	return zero;
+
+    case ONE:
+	return one;
+
+    case SRC_ALPHA:
+	return sa;
+
+    case DEST_ALPHA:
+	return da;
+
+    case INV_SA:
+	return _mm_sub_ps (one, sa);
+
+    case INV_DA:
+	return _mm_sub_ps (one, da);
+
+    case SA_OVER_DA:
+	zero = is_zero_128f (da);
+	return select_128f (
+	    zero, one, clamp_128f (safe_div_128f (sa, da, zero)));
+
+    case DA_OVER_SA:
+	zero = is_zero_128f (sa);
+	return select_128f (
+	    zero, one, clamp_128f (safe_div_128f (da, sa, zero)));
+
+    case INV_SA_OVER_DA:
+	zero = is_zero_128f (da);
+	return select_128f (
+	    zero, one,
+	    clamp_128f (safe_div_128f (_mm_sub_ps (one, sa), da, zero)));
+
+    case INV_DA_OVER_SA:
+	zero = is_zero_128f (sa);
+	return select_128f (
+	    zero, one,
+	    clamp_128f (safe_div_128f (_mm_sub_ps (one, da), sa, zero)));
+
+    case ONE_MINUS_SA_OVER_DA:
+	zero = is_zero_128f (da);
+	return _mm_andnot_ps (
+	    zero,
+	    clamp_128f (_mm_sub_ps (one, safe_div_128f (sa, da, zero))));
+
+    case ONE_MINUS_DA_OVER_SA:
+	zero = is_zero_128f (sa);
+	return _mm_andnot_ps (
+	    zero,
+	    clamp_128f (_mm_sub_ps (one, safe_div_128f (da, sa, zero))));
+
+    case ONE_MINUS_INV_DA_OVER_SA:
+	zero = is_zero_128f (sa);
+	return _mm_andnot_ps (
+	    zero,
+	    clamp_128f (_mm_sub_ps (
+			    one,
+			    safe_div_128f (_mm_sub_ps (one, da), sa, zero))));
+
+    case ONE_MINUS_INV_SA_OVER_DA:
+	zero = is_zero_128f (da);
+	return _mm_andnot_ps (
+	    zero,
+	    clamp_128f (_mm_sub_ps (
+			    one,
+			    safe_div_128f (_mm_sub_ps (one, sa), da, zero))));
+    }
+
+    return _mm_set1_ps (-1.0f);
+}
+
+/* One pixel per register; sa and da hold the alpha that applies to
+ * each channel, as in combine_inner().
+ */
+static force_inline void
+combine_pd_float_sse2 (pixman_bool_t          component,
+		       float                 *dest,
+		       const float           *src,
+		       const float           *mask,
+		       int                    n_pixels,
+		       combine_channel_128f_t combine)
+{
+    __m128 s, m, d, sa, da;
+
+    while (n_pixels--)
+    {
+	s = _mm_loadu_ps (src);
+	d = _mm_loadu_ps (dest);
+
+	if (!mask)
+	{
+	    sa = _mm_shuffle_ps (s, s, _MM_SHUFFLE (0, 0, 0, 0));
+	}
+	else if (component)
+	{
+	    m = _mm_loadu_ps (mask);
+	    sa = _mm_mul_ps (m, _mm_shuffle_ps (s, s, _MM_SHUFFLE (0, 0, 0, 0)));
+	    s = _mm_mul_ps (s, m);
+	    mask += 4;
+	}
+	else
+	{
+	    s = _mm_mul_ps (s, _mm_set1_ps (*mask));
+	    sa = _mm_shuffle_ps (s, s, _MM_SHUFFLE (0, 0, 0, 0));
+	    mask += 4;
+	}
+
+	da = _mm_shuffle_ps (d, d, _MM_SHUFFLE (0, 0, 0, 0));
+
+	_mm_storeu_ps (dest, combine (sa, s, da, d));
+
+	src += 4;
+	dest += 4;
+    }
+}
+
+/* Operators whose factors need a division are faster with the pixels
+ * transposed, since then there is one division per pixel rather than
+ * one per channel. With component alpha every channel has its own
+ * factors anyway. The factors up to INV_DA are cheap.
+ */
+#define PD_FACTORS_ARE_CHEAP(a, b) ((a) <= INV_DA && (b) <= INV_DA)
+
+#define MAKE_PD_FLOAT_COMBINER_SSE2(name, suffix, component, a, b)	\
+    static force_inline void						\
+    combine_ ## name ## suffix ## _4x128f (				\
+	argb_4x128_t *d, const argb_4x128_t *s, const argb_4x128_t *m)	\
+    {									\
+	combine_channels_4x128f (component, d, s, m,			\
+				 pd_combine_ ## name ## _128f,		\
+				 pd_combine_ ## name ## _128f);		\
+    }									\
+									\
+    static void								\
+    sse2_combine_ ## name ## suffix ## _float (				\
+	pixman_implementation_t *imp,					\
+	pixman_op_t              op,					\
+	float                   *dest,					\
+	const float             *src,					\
+	const float             *mask,					\
+	int                      n_pixels)				\
+    {									\
+	if (component || PD_FACTORS_ARE_CHEAP (a, b))			\
+	{								\
+	    combine_pd_float_sse2 (component, dest, src, mask, n_pixels, \
+				   pd_combine_ ## name ## _128f);	\
+	}								\
+	else								\
+	{								\
+	    combine_float_sse2 (dest, src, mask, n_pixels,		\
+				combine_ ## name ## suffix ## _4x128f);	\
+	}								\
+    }
+
+#define MAKE_PD_FLOAT_COMBINERS_SSE2(name, a, b)			\
+    static force_inline __m128						\
+    pd_combine_ ## name ## _128f (__m128 sa, __m128 s,			\
+				  __m128 da, __m128 d)			\
+    {									\
+	const __m128 fa = get_factor_128f (a, sa, da);			\
+	const __m128 fb = get_factor_128f (b, sa, da);			\
+									\
+	return _mm_min_ps (_mm_set1_ps (1.0f),				\
+			   _mm_add_ps (_mm_mul_ps (s, fa),		\
+				       _mm_mul_ps (d, fb)));		\
+    }									\
+									\
+    MAKE_PD_FLOAT_COMBINER_SSE2 (name, _ca, TRUE, a, b)		\
+    MAKE_PD_FLOAT_COMBINER_SSE2 (name, _u, FALSE, a, b)
+
+MAKE_PD_FLOAT_COMBINERS_SSE2 (clear,			ZERO,				ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (src,			ONE,				ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (dst,			ZERO,				ONE)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (over,			ONE,				INV_SA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (over_reverse,		INV_DA,				ONE)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (in,			DEST_ALPHA,			ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (in_reverse,		ZERO,				SRC_ALPHA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (out,			INV_DA,				ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (out_reverse,		ZERO,				INV_SA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (atop,			DEST_ALPHA,			INV_SA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (atop_reverse,		INV_DA,				SRC_ALPHA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (xor,			INV_DA,				INV_SA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (add,			ONE,				ONE)
+
+MAKE_PD_FLOAT_COMBINERS_SSE2 (saturate,			INV_DA_OVER_SA,			ONE)
+
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_clear,		ZERO,				ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_src,		ONE,				ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_dst,		ZERO,				ONE)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_over,		ONE,				INV_SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_over_reverse,	INV_DA_OVER_SA,			ONE)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_in,		ONE_MINUS_INV_DA_OVER_SA,	ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_in_reverse,	ZERO,				ONE_MINUS_INV_SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_out,		INV_DA_OVER_SA,			ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_out_reverse,	ZERO,				INV_SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_atop,		ONE_MINUS_INV_DA_OVER_SA,	INV_SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_atop_reverse,	INV_DA_OVER_SA,			ONE_MINUS_INV_SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (disjoint_xor,		INV_DA_OVER_SA,			INV_SA_OVER_DA)
+
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_clear,		ZERO,				ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_src,		ONE,				ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_dst,		ZERO,				ONE)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_over,		ONE,				ONE_MINUS_SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_over_reverse,	ONE_MINUS_DA_OVER_SA,		ONE)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_in,		DA_OVER_SA,			ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_in_reverse,	ZERO,				SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_out,		ONE_MINUS_DA_OVER_SA,		ZERO)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_out_reverse,	ZERO,				ONE_MINUS_SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_atop,		DA_OVER_SA,			ONE_MINUS_SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_atop_reverse,	ONE_MINUS_DA_OVER_SA,		SA_OVER_DA)
+MAKE_PD_FLOAT_COMBINERS_SSE2 (conjoint_xor,		ONE_MINUS_DA_OVER_SA,		ONE_MINUS_SA_OVER_DA)
+
+/* Separable PDF blend modes; see pixman-combine-float.c for how the
+ * blend functions are derived.
+ */
+#define MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2(name)			\
+    static force_inline __m128						\
+    combine_ ## name ## _a_128f (__m128 sa, __m128 s,			\
+				 __m128 da, __m128 d)			\
+    {									\
+	return _mm_sub_ps (_mm_add_ps (da, sa), _mm_mul_ps (da, sa));	\
+    }									\
+									\
+    static force_inline __m128						\
+    combine_ ## name ## _c_128f (__m128 sa, __m128 s,			\
+				 __m128 da, __m128 d)			\
+    {									\
+	__m128 one = _mm_set1_ps (1.0f);				\
+	__m128 f = _mm_add_ps (_mm_mul_ps (_mm_sub_ps (one, sa), d),	\
+			       _mm_mul_ps (_mm_sub_ps (one, da), s));	\
+									\
+	return _mm_add_ps (f, blend_ ## name ## _128f (sa, s, da, d));	\
+    }									\
+									\
+    MAKE_FLOAT_COMBINERS_SSE2 (name,					\
+			       combine_ ## name ## _a_128f,		\
+			       combine_ ## name ## _c_128f)
+
+static force_inline __m128
+blend_multiply_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    return _mm_mul_ps (d, s);
+}
+
+static force_inline __m128
+blend_screen_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    return _mm_sub_ps (_mm_add_ps (_mm_mul_ps (d, sa), _mm_mul_ps (s, da)),
+		       _mm_mul_ps (s, d));
+}
+
+/* if (2 * s < sa) 2 * s * d else sa * da - 2 * (da - d) * (sa - s),
+ * which is both hard light and, with the roles swapped, overlay.
+ */
+static force_inline __m128
+blend_hard_light_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    __m128 two = _mm_set1_ps (2.0f);
+    __m128 two_s = _mm_mul_ps (two, s);
+
+    return select_128f (
+	_mm_cmplt_ps (two_s, sa),
+	_mm_mul_ps (two_s, d),
+	_mm_sub_ps (_mm_mul_ps (sa, da),
+		    _mm_mul_ps (_mm_mul_ps (two, _mm_sub_ps (da, d)),
+				_mm_sub_ps (sa, s))));
+}
+
+static force_inline __m128
+blend_overlay_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    __m128 two = _mm_set1_ps (2.0f);
+
+    return select_128f (
+	_mm_cmplt_ps (_mm_mul_ps (two, d), da),
+	_mm_mul_ps (_mm_mul_ps (two, s), d),
+	_mm_sub_ps (_mm_mul_ps (sa, da),
+		    _mm_mul_ps (_mm_mul_ps (two, _mm_sub_ps (da, d)),
+				_mm_sub_ps (sa, s))));
+}
+
+static force_inline __m128
+blend_darken_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    s = _mm_mul_ps (s, da);
+    d = _mm_mul_ps (d, sa);
+
+    return select_128f (_mm_cmpgt_ps (s, d), d, s);
+}
+
+static force_inline __m128
+blend_lighten_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    s = _mm_mul_ps (s, da);
+    d = _mm_mul_ps (d, sa);
+
+    return select_128f (_mm_cmpgt_ps (s, d), s, d);
+}
+
+static force_inline __m128
+blend_color_dodge_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    __m128 sada = _mm_mul_ps (sa, da);
+    __m128 sa_s = _mm_sub_ps (sa, s);
+    __m128 zero = is_zero_128f (sa_s);
+    __m128 r;
+
+    r = safe_div_128f (_mm_mul_ps (_mm_mul_ps (sa, sa), d), sa_s, zero);
+    r = select_128f (zero, sada, r);
+    r = select_128f (
+	_mm_cmpge_ps (_mm_mul_ps (d, sa), _mm_sub_ps (sada, _mm_mul_ps (s, da))),
+	sada, r);
+
+    return _mm_andnot_ps (is_zero_128f (d), r);
+}
+
+static force_inline __m128
+blend_color_burn_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    __m128 da_d = _mm_sub_ps (da, d);
+    __m128 zero = is_zero_128f (s);
+    __m128 r;
+
+    r = _mm_mul_ps (
+	sa, _mm_sub_ps (da, safe_div_128f (_mm_mul_ps (sa, da_d), s, zero)));
+    r = _mm_andnot_ps (zero, r);
+    r = _mm_andnot_ps (
+	_mm_cmpge_ps (_mm_mul_ps (sa, da_d), _mm_mul_ps (s, da)), r);
+
+    return select_128f (_mm_cmpge_ps (d, da), _mm_mul_ps (sa, da), r);
+}
+
+static force_inline __m128
+blend_soft_light_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    __m128 two = _mm_set1_ps (2.0f);
+    __m128 dsa = _mm_mul_ps (d, sa);
+    __m128 two_s_sa = _mm_sub_ps (_mm_mul_ps (two, s), sa);
+    __m128 zero = is_zero_128f (da);
+    __m128 r1, r2, r3, t;
+
+    /* 2 * s <= sa */
+    r1 = _mm_sub_ps (
+	dsa,
+	safe_div_128f (
+	    _mm_mul_ps (_mm_mul_ps (d, _mm_sub_ps (da, d)),
+			_mm_sub_ps (sa, _mm_mul_ps (two, s))),
+	    da, zero));
+
+    /* 4 * d <= da */
+    t = safe_div_128f (_mm_mul_ps (_mm_set1_ps (16.0f), d), da, zero);
+    t = _mm_sub_ps (t, _mm_set1_ps (12.0f));
+    t = safe_div_128f (_mm_mul_ps (t, d), da, zero);
+    t = _mm_add_ps (t, _mm_set1_ps (3.0f));
+    r2 = _mm_add_ps (dsa, _mm_mul_ps (_mm_mul_ps (two_s_sa, d), t));
+
+    /* otherwise */
+    r3 = _mm_add_ps (
+	dsa,
+	_mm_mul_ps (_mm_sub_ps (_mm_sqrt_ps (_mm_mul_ps (d, da)), d),
+		    two_s_sa));
+
+    r2 = select_128f (
+	_mm_cmple_ps (_mm_mul_ps (_mm_set1_ps (4.0f), d), da), r2, r3);
+    r1 = select_128f (_mm_cmple_ps (_mm_mul_ps (two, s), sa), r1, r2);
+
+    return select_128f (zero, dsa, r1);
+}
+
+static force_inline __m128
+blend_difference_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    __m128 dsa = _mm_mul_ps (d, sa);
+    __m128 sda = _mm_mul_ps (s, da);
+
+    return select_128f (_mm_cmplt_ps (sda, dsa),
+			_mm_sub_ps (dsa, sda), _mm_sub_ps (sda, dsa));
+}
+
+static force_inline __m128
+blend_exclusion_128f (__m128 sa, __m128 s, __m128 da, __m128 d)
+{
+    return _mm_sub_ps (_mm_add_ps (_mm_mul_ps (s, da), _mm_mul_ps (d, sa)),
+		       _mm_mul_ps (_mm_mul_ps (_mm_set1_ps (2.0f), d), s));
+}
+
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (multiply)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (screen)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (overlay)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (darken)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (lighten)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (color_dodge)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (color_burn)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (hard_light)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (soft_light)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (difference)
+MAKE_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (exclusion)
+
+/* Non-separable PDF blend modes */
+static force_inline __m128
+get_lum_128f (const rgb_4x128_t *c)
+{
+    return _mm_add_ps (_mm_add_ps (_mm_mul_ps (c->r, _mm_set1_ps (0.3f)),
+				   _mm_mul_ps (c->g, _mm_set1_ps (0.59f))),
+		       _mm_mul_ps (c->b, _mm_set1_ps (0.11f)));
+}
+
+static force_inline __m128
+channel_min_128f (const rgb_4x128_t *c)
+{
+    return _mm_min_ps (_mm_min_ps (c->r, c->g), c->b);
+}
+
+static force_inline __m128
+channel_max_128f (const rgb_4x128_t *c)
+{
+    return _mm_max_ps (_mm_max_ps (c->r, c->g), c->b);
+}
+
+static force_inline __m128
+get_sat_128f (const rgb_4x128_t *c)
+{
+    return _mm_sub_ps (channel_max_128f (c), channel_min_128f (c));
+}
+
+static force_inline __m128
+clip_channel_128f (__m128 c, __m128 l, __m128 f, __m128 t, __m128 zero)
+{
+    return _mm_add_ps (
+	l, safe_div_128f (_mm_mul_ps (_mm_sub_ps (c, l), f), t, zero));
+}
+
+static force_inline void
+clip_color_128f (rgb_4x128_t *color, __m128 a)
+{
+    __m128 l = get_lum_128f (color);
+    __m128 n = channel_min_128f (color);
+    __m128 x = channel_max_128f (color);
+    __m128 t, zero, below, above;
+
+    below = _mm_cmplt_ps (n, _mm_setzero_ps ());
+    t = _mm_sub_ps (l, n);
+    zero = is_zero_128f (t);
+
+    color->r = select_128f (
+	below, _mm_andnot_ps (zero, clip_channel_128f (color->r, l, l, t, zero)),
+	color->r);
+    color->g = select_128f (
+	below, _mm_andnot_ps (zero, clip_channel_128f (color->g, l, l, t, zero)),
+	color->g);
+    color->b = select_128f (
+	below, _mm_andnot_ps (zero, clip_channel_128f (color->b, l, l, t, zero)),
+	color->b);
+
+    above = _mm_cmpgt_ps (x, a);
+    t = _mm_sub_ps (x, l);
+    zero = is_zero_128f (t);
+
+    color->r = select_128f (
+	above, select_128f (zero, a, clip_channel_128f (
+				color->r, l, _mm_sub_ps (a, l), t, zero)),
+	color->r);
+    color->g = select_128f (
+	above, select_128f (zero, a, clip_channel_128f (
+				color->g, l, _mm_sub_ps (a, l), t, zero)),
+	color->g);
+    color->b = select_128f (
+	above, select_128f (zero, a, clip_channel_128f (
+				color->b, l, _mm_sub_ps (a, l), t, zero)),
+	color->b);
+}
+
+static force_inline void
+set_lum_128f (rgb_4x128_t *color, __m128 sa, __m128 l)
+{
+    __m128 d = _mm_sub_ps (l, get_lum_128f (color));
+
+    color->r = _mm_add_ps (color->r, d);
+    color->g = _mm_add_ps (color->g, d);
+    color->b = _mm_add_ps (color->b, d);
+
+    clip_color_128f (color, sa);
+}
+
+/* Picks the maximum, middle and minimum channel with the same
+ * comparisons as set_sat() in the C code, so that ties resolve the
+ * same way.
+ */
+static force_inline void
+set_sat_128f (rgb_4x128_t *src, __m128 sat)
+{
+    __m128 r_gt_g = _mm_cmpgt_ps (src->r, src->g);
+    __m128 r_gt_b = _mm_cmpgt_ps (src->r, src->b);
+    __m128 g_gt_b = _mm_cmpgt_ps (src->g, src->b);
+    __m128 r_max = _mm_and_ps (r_gt_g, r_gt_b);
+    __m128 b_max_r_mid = _mm_andnot_ps (r_gt_b, r_gt_g);
+    __m128 g_max_r_mid = _mm_andnot_ps (r_gt_g, r_gt_b);
+    __m128 r_min = _mm_andnot_ps (_mm_or_ps (r_gt_g, r_gt_b),
+				  _mm_castsi128_ps (mask_ffff));
+    __m128 r_mid = _mm_or_ps (b_max_r_mid, g_max_r_mid);
+    __m128 g_max, g_mid, b_max, b_mid;
+    __m128 max, mid, min, t, zero, new_max, new_mid;
+
+    g_max = _mm_or_ps (g_max_r_mid, _mm_and_ps (r_min, g_gt_b));
+    b_max = _mm_or_ps (b_max_r_mid, _mm_andnot_ps (g_gt_b, r_min));
+    g_mid = _mm_or_ps (_mm_and_ps (r_max, g_gt_b),
+		       _mm_andnot_ps (g_gt_b, r_min));
+    b_mid = _mm_or_ps (_mm_andnot_ps (g_gt_b, r_max),
+		       _mm_and_ps (r_min, g_gt_b));
+
+    max = select_128f (r_max, src->r,
+		       select_128f (g_max, src->g, src->b));
+    mid = select_128f (r_mid, src->r,
+		       select_128f (g_mid, src->g, src->b));
+    min = select_128f (_mm_or_ps (r_max, r_mid),
+		       select_128f (_mm_or_ps (g_max, g_mid), src->b, src->g),
+		       src->r);
+
+    t = _mm_sub_ps (max, min);
+    zero = is_zero_128f (t);
+
+    new_max = _mm_andnot_ps (zero, sat);
+    new_mid = _mm_andnot_ps (
+	zero, safe_div_128f (_mm_mul_ps (_mm_sub_ps (mid, min), sat), t, zero));
+
+    src->r = _mm_or_ps (_mm_and_ps (r_max, new_max),
+			_mm_and_ps (r_mid, new_mid));
+    src->g = _mm_or_ps (_mm_and_ps (g_max, new_max),
+			_mm_and_ps (g_mid, new_mid));
+    src->b = _mm_or_ps (_mm_and_ps (b_max, new_max),
+			_mm_and_ps (b_mid, new_mid));
+}
+
+static force_inline void
+scale_rgb_128f (rgb_4x128_t *res, const rgb_4x128_t *c, __m128 f)
+{
+    res->r = _mm_mul_ps (c->r, f);
+    res->g = _mm_mul_ps (c->g, f);
+    res->b = _mm_mul_ps (c->b, f);
+}
+
+static force_inline void
+blend_hsl_hue_128f (rgb_4x128_t *res,
+		    const rgb_4x128_t *dest, __m128 da,
+		    const rgb_4x128_t *src, __m128 sa)
+{
+    scale_rgb_128f (res, src, da);
+    set_sat_128f (res, _mm_mul_ps (get_sat_128f (dest), sa));
+    set_lum_128f (res, _mm_mul_ps (sa, da),
+		  _mm_mul_ps (get_lum_128f (dest), sa));
+}
+
+static force_inline void
+blend_hsl_saturation_128f (rgb_4x128_t *res,
+			   const rgb_4x128_t *dest, __m128 da,
+			   const rgb_4x128_t *src, __m128 sa)
+{
+    scale_rgb_128f (res, dest, sa);
+    set_sat_128f (res, _mm_mul_ps (get_sat_128f (src), da));
+    set_lum_128f (res, _mm_mul_ps (sa, da),
+		  _mm_mul_ps (get_lum_128f (dest), sa));
+}
+
+static force_inline void
+blend_hsl_color_128f (rgb_4x128_t *res,
+		      const rgb_4x128_t *dest, __m128 da,
+		      const rgb_4x128_t *src, __m128 sa)
+{
+    scale_rgb_128f (res, src, da);
+    set_lum_128f (res, _mm_mul_ps (sa, da),
+		  _mm_mul_ps (get_lum_128f (dest), sa));
+}
+
+static force_inline void
+blend_hsl_luminosity_128f (rgb_4x128_t *res,
+			   const rgb_4x128_t *dest, __m128 da,
+			   const rgb_4x128_t *src, __m128 sa)
+{
+    scale_rgb_128f (res, dest, sa);
+    set_lum_128f (res, _mm_mul_ps (sa, da),
+		  _mm_mul_ps (get_lum_128f (src), da));
+}
+
+/* The C combiners scale green by the mask twice and leave blue alone;
+ * this does the same so that both give the same results.
+ */
+#define MAKE_NON_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2(name)		\
+    static force_inline void						\
+    combine_ ## name ## _u_4x128f (argb_4x128_t       *d,		\
+				   const argb_4x128_t *s,		\
+				   const argb_4x128_t *m)		\
+    {									\
+	__m128 one = _mm_set1_ps (1.0f);				\
+	__m128 sa = s->a, da = d->a;					\
+	rgb_4x128_t sc, dc, rc;						\
+									\
+	sc.r = s->r;							\
+	sc.g = s->g;							\
+	sc.b = s->b;							\
+	dc.r = d->r;							\
+	dc.g = d->g;							\
+	dc.b = d->b;							\
+									\
+	if (m)								\
+	{								\
+	    sa = _mm_mul_ps (sa, m->a);					\
+	    sc.r = _mm_mul_ps (sc.r, m->a);				\
+	    sc.g = _mm_mul_ps (sc.g, m->a);				\
+	    sc.g = _mm_mul_ps (sc.g, m->a);				\
+	}								\
+									\
+	blend_ ## name ## _128f (&rc, &dc, da, &sc, sa);		\
+									\
+	d->a = _mm_sub_ps (_mm_add_ps (sa, da), _mm_mul_ps (sa, da));	\
+	d->r = _mm_add_ps (						\
+	    _mm_add_ps (_mm_mul_ps (_mm_sub_ps (one, sa), dc.r),	\
+			_mm_mul_ps (_mm_sub_ps (one, da), sc.r)), rc.r);\
+	d->g = _mm_add_ps (						\
+	    _mm_add_ps (_mm_mul_ps (_mm_sub_ps (one, sa), dc.g),	\
+			_mm_mul_ps (_mm_sub_ps (one, da), sc.g)), rc.g);\
+	d->b = _mm_add_ps (						\
+	    _mm_add_ps (_mm_mul_ps (_mm_sub_ps (one, sa), dc.b),	\
+			_mm_mul_ps (_mm_sub_ps (one, da), sc.b)), rc.b);\
+    }									\
+									\
+    static void								\
+    sse2_combine_ ## name ## _u_float (pixman_implementation_t *imp,	\
+				       pixman_op_t              op,	\
+				       float                   *dest,	\
+				       const float             *src,	\
+				       const float             *mask,	\
+				       int                      n_pixels) \
+    {									\
+	combine_float_sse2 (dest, src, mask, n_pixels,			\
+			    combine_ ## name ## _u_4x128f);		\
+    }
+
+MAKE_NON_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (hsl_hue)
+MAKE_NON_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (hsl_saturation)
+MAKE_NON_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (hsl_color)
+MAKE_NON_SEPARABLE_PDF_FLOAT_COMBINERS_SSE2 (hsl_luminosity)
+
 static force_inline __m128i
 create_mask_16_128 (uint16_t mask)
 {
@@ -6238,6 +7124,9 @@ static const pixman_fast_path_t sse2_fast_paths[] =
 
     /* PIXMAN_OP_ADD */
     PIXMAN_STD_FAST_PATH_CA (ADD, solid, a8r8g8b8, a8r8g8b8, sse2_composite_add_n_8888_8888_ca),
+    PIXMAN_STD_FAST_PATH_CA (ADD, solid, a8r8g8b8, x8r8g8b8, sse2_composite_add_n_8888_8888_ca),
+    PIXMAN_STD_FAST_PATH_CA (ADD, solid, a8b8g8r8, a8b8g8r8, sse2_composite_add_n_8888_8888_ca),
+    PIXMAN_STD_FAST_PATH_CA (ADD, solid, a8b8g8r8, x8b8g8r8, sse2_composite_add_n_8888_8888_ca),
     PIXMAN_STD_FAST_PATH (ADD, a8, null, a8, sse2_composite_add_8_8),
     PIXMAN_STD_FAST_PATH (ADD, a8r8g8b8, null, a8r8g8b8, sse2_composite_add_8888_8888),
     PIXMAN_STD_FAST_PATH (ADD, a8b8g8r8, null, a8b8g8r8, sse2_composite_add_8888_8888),
@@ -6447,10 +7336,497 @@ sse2_fetch_a8 (pixman_iter_t *iter, const uint32_t *mask)
     return iter->buffer;
 }
 
+/*
+ * Separable convolution for scaled 32 bpp sources, done in two passes.
+ * Every source line a destination row needs is filtered horizontally
+ * once and kept in a small line cache; each destination row is then
+ * a vertical combination of cheight cached lines. This does
+ * cwidth + cheight multiplications per pixel instead of the
+ * cwidth * cheight of bits_image_fetch_pixel_separable_convolution().
+ *
+ * Filter weights are rounded to 14 bits and the horizontally filtered
+ * lines are kept as 16 bit values with 6 fractional bits, so results
+ * can differ from the per-pixel path by one unit.
+ */
+#define SEPARABLE_MAX_TAPS	64
+
+typedef struct
+{
+    int		x_phase_bits;
+    int		y_phase_bits;
+    int		cwidth;
+    int		cheight;
+    int		x_pairs;	/* taps rounded up to pairs */
+    int		y_pairs;
+    int		min_x;		/* first source column read */
+    int		span;		/* number of source columns read */
+    int		x8;		/* format has no alpha channel */
+    int		abgr;		/* red and blue need swapping */
+    int32_t *	x_start;	/* first tap of each pixel, from min_x */
+    int16_t **	x_weights;	/* weights of each pixel, in pairs */
+    int16_t *	y_weights;	/* per phase, cheight rounded up to even */
+    uint32_t *	src_line;
+    int16_t *	zero_line;
+    int16_t **	lines;
+    int *	line_y;
+} separable_info_t;
+
+static force_inline int16_t
+separable_weight (pixman_fixed_t f)
+{
+    int32_t w = (f + 2) >> 2;
+
+    return CLIP (w, -32768, 32767);
+}
+
+static void
+separable_fetch_source_line (pixman_iter_t *iter, separable_info_t *info,
+			     int y)
+{
+    bits_image_t *image = &iter->image->bits;
+    pixman_repeat_t repeat_mode = image->common.repeat;
+    uint32_t *dst = info->src_line;
+    uint32_t alpha = info->x8 ? 0xff000000 : 0;
+    const uint32_t *row;
+    int i;
+
+    memset (dst, 0, (info->span + 1) * sizeof (uint32_t));
+
+    if (!repeat (repeat_mode, &y, image->height))
+	return;
+
+    row = image->bits + y * image->rowstride;
+
+    for (i = 0; i < info->span; ++i)
+    {
+	int x = info->min_x + i;
+
+	if (repeat (repeat_mode, &x, image->width))
+	    dst[i] = row[x] | alpha;
+    }
+
+    if (info->abgr)
+    {
+	for (i = 0; i < info->span; ++i)
+	{
+	    uint32_t p = dst[i];
+
+	    dst[i] = (p & 0xff00ff00) | ((p >> 16) & 0xff) | ((p & 0xff) << 16);
+	}
+    }
+}
+
+static void
+separable_filter_line (pixman_iter_t *iter, separable_info_t *info,
+		       int16_t *out)
+{
+    const uint32_t *src = info->src_line;
+    int width = iter->width;
+    int i, k;
+
+    for (i = 0; i < width; ++i)
+    {
+	const uint32_t *p = src + info->x_start[i];
+	const __m128i *w = (const __m128i *)info->x_weights[i];
+	__m128i acc = _mm_setzero_si128 ();
+
+	for (k = 0; k < info->x_pairs; ++k)
+	{
+	    /* b0 g0 r0 a0 b1 g1 r1 a1 -> b0 b1 g0 g1 r0 r1 a0 a1 */
+	    __m128i s = _mm_unpacklo_epi8 (
+		_mm_loadl_epi64 ((const __m128i *)(p + 2 * k)),
+		_mm_setzero_si128 ());
+
+	    s = _mm_unpacklo_epi16 (s, _mm_srli_si128 (s, 8));
+	    acc = _mm_add_epi32 (acc, _mm_madd_epi16 (s, _mm_load_si128 (w + k)));
+	}
+
+	acc = _mm_srai_epi32 (_mm_add_epi32 (acc, _mm_set1_epi32 (1 << 7)), 8);
+	_mm_storel_epi64 ((__m128i *)(out + 4 * i), _mm_packs_epi32 (acc, acc));
+    }
+}
+
+static uint32_t *
+sse2_fetch_separable_convolution (pixman_iter_t *iter, const uint32_t *mask)
+{
+    separable_info_t *info = iter->data;
+    int y_phase_shift = 16 - info->y_phase_bits;
+    int y_off = ((info->cheight << 16) - pixman_fixed_1) >> 1;
+    const int16_t *rows[SEPARABLE_MAX_TAPS + 1];
+    const int16_t *y_weights;
+    uint32_t *dst = iter->buffer;
+    pixman_fixed_t y;
+    pixman_vector_t v;
+    int width = iter->width;
+    int i, k, y1;
+
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y++) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (iter->image->common.transform, &v))
+	return iter->buffer;
+
+    /* Same phase rounding as the per-pixel path */
+    y = v.vector[1];
+    y = ((y >> y_phase_shift) << y_phase_shift) + ((1 << y_phase_shift) >> 1);
+    y_weights = info->y_weights +
+	((y & 0xffff) >> y_phase_shift) * info->y_pairs * 2;
+    y1 = pixman_fixed_to_int (y - pixman_fixed_e - y_off);
+
+    for (k = 0; k < info->cheight; ++k)
+    {
+	int line = y1 + k;
+	int slot = MOD (line, info->cheight);
+
+	if (info->line_y[slot] != line)
+	{
+	    separable_fetch_source_line (iter, info, line);
+	    separable_filter_line (iter, info, info->lines[slot]);
+	    info->line_y[slot] = line;
+	}
+
+	rows[k] = info->lines[slot];
+    }
+    rows[info->cheight] = info->zero_line;
+
+    for (i = 0; i < width; i += 2)
+    {
+	__m128i acc0 = _mm_setzero_si128 ();
+	__m128i acc1 = _mm_setzero_si128 ();
+	__m128i d;
+
+	for (k = 0; k < info->y_pairs; ++k)
+	{
+	    __m128i a = _mm_loadu_si128 ((const __m128i *)(rows[2 * k] + 4 * i));
+	    __m128i b = _mm_loadu_si128 ((const __m128i *)(rows[2 * k + 1] + 4 * i));
+	    __m128i w = _mm_set1_epi32 (
+		(y_weights[2 * k] & 0xffff) | ((uint32_t)y_weights[2 * k + 1] << 16));
+
+	    acc0 = _mm_add_epi32 (acc0, _mm_madd_epi16 (_mm_unpacklo_epi16 (a, b), w));
+	    acc1 = _mm_add_epi32 (acc1, _mm_madd_epi16 (_mm_unpackhi_epi16 (a, b), w));
+	}
+
+	acc0 = _mm_srai_epi32 (_mm_add_epi32 (acc0, _mm_set1_epi32 (1 << 19)), 20);
+	acc1 = _mm_srai_epi32 (_mm_add_epi32 (acc1, _mm_set1_epi32 (1 << 19)), 20);
+	d = _mm_packs_epi32 (acc0, acc1);
+	d = _mm_packus_epi16 (d, d);
+
+	if (i + 1 < width)
+	    _mm_storel_epi64 ((__m128i *)(dst + i), d);
+	else
+	    dst[i] = _mm_cvtsi128_si32 (d);
+    }
+
+    return iter->buffer;
+}
+
+static void
+sse2_separable_convolution_iter_fini (pixman_iter_t *iter)
+{
+    separable_info_t *info = iter->data;
+
+    free (info->src_line);
+    free (info);
+}
+
+static void
+sse2_separable_convolution_iter_init (pixman_iter_t *iter,
+				      const pixman_iter_info_t *iter_info)
+{
+    pixman_image_t *image = iter->image;
+    pixman_fixed_t *params = image->common.filter_params;
+    int cwidth = pixman_fixed_to_int (params[0]);
+    int cheight = pixman_fixed_to_int (params[1]);
+    int x_phase_bits = pixman_fixed_to_int (params[2]);
+    int y_phase_bits = pixman_fixed_to_int (params[3]);
+    int x_phase_shift = 16 - x_phase_bits;
+    int x_off = ((cwidth << 16) - pixman_fixed_1) >> 1;
+    pixman_fixed_t *x_params = params + 4;
+    pixman_fixed_t *y_params = x_params + (1 << x_phase_bits) * cwidth;
+    int width = iter->width;
+    int x_pairs, y_pairs, line_len, max_x, i, j, k;
+    separable_info_t *info;
+    int16_t *x_weights;
+    pixman_fixed_t x, ux;
+    pixman_vector_t v;
+    size_t size;
+    uint8_t *p;
+
+    /* Larger kernels, or weights beyond +-1 that could overflow
+     * the 16 bit intermediates, use the per-pixel path.
+     */
+    if (cwidth < 1 || cheight < 1 ||
+	cwidth > SEPARABLE_MAX_TAPS || cheight > SEPARABLE_MAX_TAPS ||
+	x_phase_bits > 8 || y_phase_bits > 8)
+    {
+	goto fallback;
+    }
+
+    for (i = 0; i < (1 << x_phase_bits) * cwidth + (1 << y_phase_bits) * cheight; ++i)
+    {
+	if (x_params[i] > pixman_fixed_1 || x_params[i] < -pixman_fixed_1)
+	    goto fallback;
+    }
+
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	goto fallback;
+
+    x_pairs = (cwidth + 1) / 2;
+    y_pairs = (cheight + 1) / 2;
+    line_len = 4 * (width + 1);
+
+    /* Each of the cheight + 7 pieces below may need 15 bytes of padding */
+    size = sizeof (separable_info_t) + (cheight + 7) * 16 +
+	width * (sizeof (int32_t) + sizeof (int16_t *)) +
+	(1 << x_phase_bits) * x_pairs * 8 * sizeof (int16_t) +
+	(1 << y_phase_bits) * y_pairs * 2 * sizeof (int16_t) +
+	(cheight + 1) * line_len * sizeof (int16_t) +
+	cheight * (sizeof (int16_t *) + sizeof (int));
+
+    if (!(info = calloc (1, size)))
+	goto fallback;
+
+    p = (uint8_t *)(info + 1);
+
+#define TAKE(ptr, n)							\
+    do {								\
+	p = (uint8_t *)((((uintptr_t)p) + 15) & ~15);			\
+	(ptr) = (void *)p;						\
+	p += (n);							\
+    } while (0)
+
+    TAKE (x_weights, (1 << x_phase_bits) * x_pairs * 8 * sizeof (int16_t));
+    TAKE (info->y_weights, (1 << y_phase_bits) * y_pairs * 2 * sizeof (int16_t));
+    TAKE (info->zero_line, line_len * sizeof (int16_t));
+    TAKE (info->lines, cheight * sizeof (int16_t *));
+    for (k = 0; k < cheight; ++k)
+	TAKE (info->lines[k], line_len * sizeof (int16_t));
+    TAKE (info->line_y, cheight * sizeof (int));
+    TAKE (info->x_start, width * sizeof (int32_t));
+    TAKE (info->x_weights, width * sizeof (int16_t *));
+
+#undef TAKE
+
+    info->x_phase_bits = x_phase_bits;
+    info->y_phase_bits = y_phase_bits;
+    info->cwidth = cwidth;
+    info->cheight = cheight;
+    info->x_pairs = x_pairs;
+    info->y_pairs = y_pairs;
+    info->x8 = !PIXMAN_FORMAT_A (image->bits.format);
+    info->abgr = PIXMAN_FORMAT_TYPE (image->bits.format) == PIXMAN_TYPE_ABGR;
+
+    for (i = 0; i < (1 << x_phase_bits); ++i)
+    {
+	for (j = 0; j < 2 * x_pairs; ++j)
+	{
+	    int16_t w = j < cwidth ? separable_weight (x_params[i * cwidth + j]) : 0;
+
+	    for (k = 0; k < 4; ++k)
+		x_weights[(i * x_pairs + j / 2) * 8 + 2 * k + (j & 1)] = w;
+	}
+    }
+
+    for (i = 0; i < (1 << y_phase_bits); ++i)
+    {
+	for (j = 0; j < cheight; ++j)
+	{
+	    info->y_weights[i * y_pairs * 2 + j] =
+		separable_weight (y_params[i * cheight + j]);
+	}
+    }
+
+    for (k = 0; k < cheight; ++k)
+	info->line_y[k] = INT32_MIN;
+
+    /* With a scale transform the source columns do not depend on
+     * the row, so the taps of each pixel are computed once.
+     */
+    x = v.vector[0];
+    ux = image->common.transform->matrix[0][0];
+    info->min_x = INT32_MAX;
+    max_x = INT32_MIN;
+
+    for (i = 0; i < width; ++i)
+    {
+	pixman_fixed_t rx;
+	int x1;
+
+	rx = ((x >> x_phase_shift) << x_phase_shift) + ((1 << x_phase_shift) >> 1);
+	x1 = pixman_fixed_to_int (rx - pixman_fixed_e - x_off);
+
+	info->x_start[i] = x1;
+	info->x_weights[i] =
+	    x_weights + ((rx & 0xffff) >> x_phase_shift) * x_pairs * 8;
+
+	info->min_x = MIN (info->min_x, x1);
+	max_x = MAX (max_x, x1);
+
+	x += ux;
+    }
+
+    for (i = 0; i < width; ++i)
+	info->x_start[i] -= info->min_x;
+
+    /* The last pair of an odd kernel reads one pixel past the taps */
+    info->span = max_x - info->min_x + 2 * x_pairs;
+    info->src_line = malloc ((info->span + 1) * sizeof (uint32_t));
+    if (!info->src_line)
+    {
+	free (info);
+	goto fallback;
+    }
+
+    iter->data = info;
+    iter->get_scanline = sse2_fetch_separable_convolution;
+    iter->fini = sse2_separable_convolution_iter_fini;
+    return;
+
+fallback:
+    _pixman_bits_image_src_iter_init (image, iter);
+}
+
+/* Dithers four pixels of the narrow pipeline in place, see
+ * _pixman_dither_get_narrow_factors().
+ */
+static force_inline void
+sse2_dither_4_pixels (uint32_t *pixels, const uint16_t *thresholds,
+		      __m128i xmm_mul, __m128i xmm_scale)
+{
+    __m128i xmm_src, xmm_lo, xmm_hi, xmm_d, xmm_d_lo, xmm_d_hi;
+
+    /* floor (threshold * 255 / 8192), for each pixel in every channel */
+    xmm_d = _mm_loadl_epi64 ((__m128i *)thresholds);
+    xmm_d = _mm_mulhi_epu16 (xmm_d, _mm_set1_epi16 (255 * 8));
+    xmm_d = _mm_unpacklo_epi16 (xmm_d, xmm_d);
+    xmm_d_lo = _mm_unpacklo_epi32 (xmm_d, xmm_d);
+    xmm_d_hi = _mm_unpackhi_epi32 (xmm_d, xmm_d);
+
+    xmm_src = load_128_unaligned ((__m128i *)pixels);
+    xmm_lo = _mm_unpacklo_epi8 (xmm_src, _mm_setzero_si128 ());
+    xmm_hi = _mm_unpackhi_epi8 (xmm_src, _mm_setzero_si128 ());
+
+    xmm_lo = _mm_add_epi16 (_mm_mullo_epi16 (xmm_lo, xmm_mul), xmm_d_lo);
+    xmm_hi = _mm_add_epi16 (_mm_mullo_epi16 (xmm_hi, xmm_mul), xmm_d_hi);
+
+    /* x / 255 == (x * 0x8081) >> 23 for all 16 bit x */
+    xmm_lo = _mm_srli_epi16 (_mm_mulhi_epu16 (xmm_lo, _mm_set1_epi16 (0x8081)), 7);
+    xmm_hi = _mm_srli_epi16 (_mm_mulhi_epu16 (xmm_hi, _mm_set1_epi16 (0x8081)), 7);
+
+    xmm_lo = _mm_mullo_epi16 (xmm_lo, xmm_scale);
+    xmm_hi = _mm_mullo_epi16 (xmm_hi, xmm_scale);
+
+    save_128_unaligned ((__m128i *)pixels, _mm_packus_epi16 (xmm_lo, xmm_hi));
+}
+
+static void
+sse2_dither_write_back_narrow (pixman_iter_t *iter)
+{
+    bits_image_t *image = &iter->image->bits;
+    uint32_t *buffer = iter->buffer;
+    int width = iter->width;
+    uint16_t row[DITHER_ROW_LENGTH];
+    uint16_t mul[4], scale[4];
+    __m128i xmm_mul, xmm_scale;
+    int i;
+
+    _pixman_bits_image_get_dither_row (image, iter->x, iter->y, row);
+    _pixman_dither_get_narrow_factors (image->format, mul, scale);
+
+    xmm_mul = _mm_set_epi16 (mul[3], mul[2], mul[1], mul[0],
+			     mul[3], mul[2], mul[1], mul[0]);
+    xmm_scale = _mm_set_epi16 (scale[3], scale[2], scale[1], scale[0],
+			       scale[3], scale[2], scale[1], scale[0]);
+
+    for (i = 0; i + 4 <= width; i += 4)
+	sse2_dither_4_pixels (buffer + i, row + i % DITHER_ROW_LENGTH, xmm_mul, xmm_scale);
+
+    if (i < width)
+    {
+	uint32_t tail[4];
+
+	memcpy (tail, buffer + i, (width - i) * sizeof (uint32_t));
+	sse2_dither_4_pixels (tail, row + i % DITHER_ROW_LENGTH, xmm_mul, xmm_scale);
+	memcpy (buffer + i, tail, (width - i) * sizeof (uint32_t));
+    }
+
+    image->store_scanline_32 (image, iter->x, iter->y, width, buffer);
+
+    iter->y++;
+}
+
+static force_inline float
+sse2_dither_scale (int n_bits)
+{
+    if (n_bits == 0 || n_bits >= 32)
+	return 0.f;
+
+    return 1.f / (float)(1 << n_bits);
+}
+
+/* Same computation as dither_apply_ordered() in pixman-bits-image.c, one
+ * argb_t per register.
+ */
+static void
+sse2_dither_write_back_wide (pixman_iter_t *iter)
+{
+    bits_image_t *image = &iter->image->bits;
+    pixman_format_code_t format = image->format;
+    float *buffer = (float *)iter->buffer;
+    int width = iter->width;
+    uint16_t row[DITHER_ROW_LENGTH];
+    __m128 xmm_scale, xmm_d, xmm_f;
+    int i;
+
+    _pixman_bits_image_get_dither_row (image, iter->x, iter->y, row);
+
+    xmm_scale = _mm_set_ps (sse2_dither_scale (PIXMAN_FORMAT_B (format)),
+			    sse2_dither_scale (PIXMAN_FORMAT_G (format)),
+			    sse2_dither_scale (PIXMAN_FORMAT_R (format)),
+			    sse2_dither_scale (PIXMAN_FORMAT_A (format)));
+
+    for (i = 0; i < width; ++i)
+    {
+	xmm_d = _mm_set1_ps (row[i % DITHER_ROW_LENGTH] * (1.f / 8192.f));
+	xmm_f = _mm_loadu_ps (buffer + 4 * i);
+	xmm_f = _mm_add_ps (xmm_f, _mm_mul_ps (_mm_sub_ps (xmm_d, xmm_f), xmm_scale));
+	_mm_storeu_ps (buffer + 4 * i, xmm_f);
+    }
+
+    image->store_scanline_float (image, iter->x, iter->y, width, iter->buffer);
+
+    iter->y++;
+}
+
+static void
+sse2_dither_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *iter_info)
+{
+    _pixman_bits_image_dest_iter_init (iter->image, iter);
+
+    if (iter->iter_flags & ITER_NARROW)
+	iter->write_back = sse2_dither_write_back_narrow;
+    else
+	iter->write_back = sse2_dither_write_back_wide;
+}
+
 #define IMAGE_FLAGS							\
     (FAST_PATH_STANDARD_FLAGS | FAST_PATH_ID_TRANSFORM |		\
      FAST_PATH_BITS_IMAGE | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)
 
+#define SEPARABLE_ITER(format)						\
+    { PIXMAN_ ## format,						\
+      (FAST_PATH_NO_ALPHA_MAP | FAST_PATH_NO_ACCESSORS |		\
+       FAST_PATH_BITS_IMAGE | FAST_PATH_SCALE_TRANSFORM |		\
+       FAST_PATH_SEPARABLE_CONVOLUTION_FILTER),				\
+      ITER_NARROW | ITER_SRC,						\
+      sse2_separable_convolution_iter_init, NULL, NULL			\
+    }
+
 static const pixman_iter_info_t sse2_iters[] = 
 {
     { PIXMAN_x8r8g8b8, IMAGE_FLAGS, ITER_NARROW,
@@ -6462,6 +7838,16 @@ static const pixman_iter_info_t sse2_iters[] =
     { PIXMAN_a8, IMAGE_FLAGS, ITER_NARROW,
       _pixman_iter_init_bits_stride, sse2_fetch_a8, NULL
     },
+    SEPARABLE_ITER (a8r8g8b8),
+    SEPARABLE_ITER (x8r8g8b8),
+    SEPARABLE_ITER (a8b8g8r8),
+    SEPARABLE_ITER (x8b8g8r8),
+    { PIXMAN_any, FAST_PATH_NO_ALPHA_MAP | FAST_PATH_DITHER, ITER_NARROW | ITER_DEST,
+      sse2_dither_iter_init, NULL, NULL
+    },
+    { PIXMAN_any, FAST_PATH_NO_ALPHA_MAP | FAST_PATH_DITHER, ITER_WIDE | ITER_DEST,
+      sse2_dither_iter_init, NULL, NULL
+    },
     { PIXMAN_null },
 };
 
@@ -6518,6 +7904,110 @@ _pixman_implementation_create_sse2 (pixman_implementation_t *fallback)
     imp->combine_32_ca[PIXMAN_OP_XOR] = sse2_combine_xor_ca;
     imp->combine_32_ca[PIXMAN_OP_ADD] = sse2_combine_add_ca;
 
+    imp->combine_float[PIXMAN_OP_CLEAR] = sse2_combine_clear_u_float;
+    imp->combine_float[PIXMAN_OP_SRC] = sse2_combine_src_u_float;
+    imp->combine_float[PIXMAN_OP_DST] = sse2_combine_dst_u_float;
+    imp->combine_float[PIXMAN_OP_OVER] = sse2_combine_over_u_float;
+    imp->combine_float[PIXMAN_OP_OVER_REVERSE] = sse2_combine_over_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_IN] = sse2_combine_in_u_float;
+    imp->combine_float[PIXMAN_OP_IN_REVERSE] = sse2_combine_in_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_OUT] = sse2_combine_out_u_float;
+    imp->combine_float[PIXMAN_OP_OUT_REVERSE] = sse2_combine_out_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_ATOP] = sse2_combine_atop_u_float;
+    imp->combine_float[PIXMAN_OP_ATOP_REVERSE] = sse2_combine_atop_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_XOR] = sse2_combine_xor_u_float;
+    imp->combine_float[PIXMAN_OP_ADD] = sse2_combine_add_u_float;
+    imp->combine_float[PIXMAN_OP_SATURATE] = sse2_combine_saturate_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_CLEAR] = sse2_combine_disjoint_clear_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_SRC] = sse2_combine_disjoint_src_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_DST] = sse2_combine_disjoint_dst_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_OVER] = sse2_combine_disjoint_over_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_OVER_REVERSE] = sse2_combine_disjoint_over_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_IN] = sse2_combine_disjoint_in_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_IN_REVERSE] = sse2_combine_disjoint_in_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_OUT] = sse2_combine_disjoint_out_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_OUT_REVERSE] = sse2_combine_disjoint_out_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_ATOP] = sse2_combine_disjoint_atop_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_ATOP_REVERSE] = sse2_combine_disjoint_atop_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_DISJOINT_XOR] = sse2_combine_disjoint_xor_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_CLEAR] = sse2_combine_conjoint_clear_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_SRC] = sse2_combine_conjoint_src_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_DST] = sse2_combine_conjoint_dst_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_OVER] = sse2_combine_conjoint_over_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_OVER_REVERSE] = sse2_combine_conjoint_over_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_IN] = sse2_combine_conjoint_in_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_IN_REVERSE] = sse2_combine_conjoint_in_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_OUT] = sse2_combine_conjoint_out_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_OUT_REVERSE] = sse2_combine_conjoint_out_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_ATOP] = sse2_combine_conjoint_atop_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_ATOP_REVERSE] = sse2_combine_conjoint_atop_reverse_u_float;
+    imp->combine_float[PIXMAN_OP_CONJOINT_XOR] = sse2_combine_conjoint_xor_u_float;
+    imp->combine_float[PIXMAN_OP_MULTIPLY] = sse2_combine_multiply_u_float;
+    imp->combine_float[PIXMAN_OP_SCREEN] = sse2_combine_screen_u_float;
+    imp->combine_float[PIXMAN_OP_OVERLAY] = sse2_combine_overlay_u_float;
+    imp->combine_float[PIXMAN_OP_DARKEN] = sse2_combine_darken_u_float;
+    imp->combine_float[PIXMAN_OP_LIGHTEN] = sse2_combine_lighten_u_float;
+    imp->combine_float[PIXMAN_OP_COLOR_DODGE] = sse2_combine_color_dodge_u_float;
+    imp->combine_float[PIXMAN_OP_COLOR_BURN] = sse2_combine_color_burn_u_float;
+    imp->combine_float[PIXMAN_OP_HARD_LIGHT] = sse2_combine_hard_light_u_float;
+    imp->combine_float[PIXMAN_OP_SOFT_LIGHT] = sse2_combine_soft_light_u_float;
+    imp->combine_float[PIXMAN_OP_DIFFERENCE] = sse2_combine_difference_u_float;
+    imp->combine_float[PIXMAN_OP_EXCLUSION] = sse2_combine_exclusion_u_float;
+    imp->combine_float[PIXMAN_OP_HSL_HUE] = sse2_combine_hsl_hue_u_float;
+    imp->combine_float[PIXMAN_OP_HSL_SATURATION] = sse2_combine_hsl_saturation_u_float;
+    imp->combine_float[PIXMAN_OP_HSL_COLOR] = sse2_combine_hsl_color_u_float;
+    imp->combine_float[PIXMAN_OP_HSL_LUMINOSITY] = sse2_combine_hsl_luminosity_u_float;
+
+    imp->combine_float_ca[PIXMAN_OP_CLEAR] = sse2_combine_clear_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_SRC] = sse2_combine_src_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DST] = sse2_combine_dst_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_OVER] = sse2_combine_over_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_OVER_REVERSE] = sse2_combine_over_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_IN] = sse2_combine_in_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_IN_REVERSE] = sse2_combine_in_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_OUT] = sse2_combine_out_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_OUT_REVERSE] = sse2_combine_out_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_ATOP] = sse2_combine_atop_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_ATOP_REVERSE] = sse2_combine_atop_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_XOR] = sse2_combine_xor_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_ADD] = sse2_combine_add_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_SATURATE] = sse2_combine_saturate_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_CLEAR] = sse2_combine_disjoint_clear_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_SRC] = sse2_combine_disjoint_src_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_DST] = sse2_combine_disjoint_dst_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_OVER] = sse2_combine_disjoint_over_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_OVER_REVERSE] = sse2_combine_disjoint_over_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_IN] = sse2_combine_disjoint_in_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_IN_REVERSE] = sse2_combine_disjoint_in_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_OUT] = sse2_combine_disjoint_out_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_OUT_REVERSE] = sse2_combine_disjoint_out_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_ATOP] = sse2_combine_disjoint_atop_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_ATOP_REVERSE] = sse2_combine_disjoint_atop_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DISJOINT_XOR] = sse2_combine_disjoint_xor_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_CLEAR] = sse2_combine_conjoint_clear_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_SRC] = sse2_combine_conjoint_src_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_DST] = sse2_combine_conjoint_dst_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_OVER] = sse2_combine_conjoint_over_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_OVER_REVERSE] = sse2_combine_conjoint_over_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_IN] = sse2_combine_conjoint_in_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_IN_REVERSE] = sse2_combine_conjoint_in_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_OUT] = sse2_combine_conjoint_out_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_OUT_REVERSE] = sse2_combine_conjoint_out_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_ATOP] = sse2_combine_conjoint_atop_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_ATOP_REVERSE] = sse2_combine_conjoint_atop_reverse_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_CONJOINT_XOR] = sse2_combine_conjoint_xor_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_MULTIPLY] = sse2_combine_multiply_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_SCREEN] = sse2_combine_screen_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_OVERLAY] = sse2_combine_overlay_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DARKEN] = sse2_combine_darken_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_LIGHTEN] = sse2_combine_lighten_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_COLOR_DODGE] = sse2_combine_color_dodge_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_COLOR_BURN] = sse2_combine_color_burn_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_HARD_LIGHT] = sse2_combine_hard_light_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_SOFT_LIGHT] = sse2_combine_soft_light_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_DIFFERENCE] = sse2_combine_difference_ca_float;
+    imp->combine_float_ca[PIXMAN_OP_EXCLUSION] = sse2_combine_exclusion_ca_float;
+
     imp->blt = sse2_blt;
     imp->fill = sse2_fill;
 
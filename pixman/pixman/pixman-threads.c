@@ -0,0 +1,323 @@
+/*
+ * Copyright © 2024 The pixman authors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * A small worker pool used by pixman_image_composite32_threaded().
+ *
+ * The pool is created lazily and grows to the largest number of
+ * threads that has been asked for. Only one job runs at a time; a
+ * caller that finds the pool busy simply runs its tasks itself, so
+ * nested or concurrent use never blocks. The calling thread always
+ * takes part in its own job, which means a job asking for N threads
+ * uses at most N - 1 workers.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include "pixman-private.h"
+
+#if defined (HAVE_PTHREADS)
+# include <pthread.h>
+# ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+# endif
+#elif defined (_WIN32)
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+#endif
+
+#define MAX_THREADS 64
+
+#if defined (HAVE_PTHREADS) || defined (_WIN32)
+
+typedef struct
+{
+    pixman_task_func_t	func;
+    void *		data;
+    int			n_tasks;
+    int			next_task;
+    int			max_helpers;
+    int			n_helpers;
+    int			n_active;
+} job_t;
+
+static job_t *current_job;
+static int n_workers;
+
+#if defined (HAVE_PTHREADS)
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+
+#define POOL_LOCK()		pthread_mutex_lock (&pool_mutex)
+#define POOL_UNLOCK()		pthread_mutex_unlock (&pool_mutex)
+#define WAIT_WORK()		pthread_cond_wait (&work_cond, &pool_mutex)
+#define WAIT_DONE()		pthread_cond_wait (&done_cond, &pool_mutex)
+#define WAKE_WORKERS()		pthread_cond_broadcast (&work_cond)
+#define WAKE_CALLER()		pthread_cond_signal (&done_cond)
+
+#else
+
+static SRWLOCK pool_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE work_cond = CONDITION_VARIABLE_INIT;
+static CONDITION_VARIABLE done_cond = CONDITION_VARIABLE_INIT;
+
+#define POOL_LOCK()		AcquireSRWLockExclusive (&pool_lock)
+#define POOL_UNLOCK()		ReleaseSRWLockExclusive (&pool_lock)
+#define WAIT_WORK()							\
+    SleepConditionVariableSRW (&work_cond, &pool_lock, INFINITE, 0)
+#define WAIT_DONE()							\
+    SleepConditionVariableSRW (&done_cond, &pool_lock, INFINITE, 0)
+#define WAKE_WORKERS()		WakeAllConditionVariable (&work_cond)
+#define WAKE_CALLER()		WakeConditionVariable (&done_cond)
+
+#endif
+
+/* Called with the pool lock held; drops it around each task. */
+static void
+run_tasks_locked (job_t *job)
+{
+    while (job->next_task < job->n_tasks)
+    {
+	int task = job->next_task++;
+
+	POOL_UNLOCK ();
+	job->func (job->data, task);
+	POOL_LOCK ();
+    }
+}
+
+static void
+worker_loop (void)
+{
+    POOL_LOCK ();
+
+    for (;;)
+    {
+	job_t *job = current_job;
+
+	if (!job				||
+	    job->n_helpers >= job->max_helpers	||
+	    job->next_task >= job->n_tasks)
+	{
+	    WAIT_WORK ();
+	    continue;
+	}
+
+	job->n_helpers++;
+	job->n_active++;
+
+	run_tasks_locked (job);
+
+	if (--job->n_active == 0)
+	    WAKE_CALLER ();
+    }
+}
+
+#if defined (HAVE_PTHREADS)
+
+static void *
+worker (void *data)
+{
+    worker_loop ();
+
+    return NULL;
+}
+
+/* A forked child has none of the parent's workers, and the pool
+ * lock may have been held by one of them at the time of the fork.
+ */
+static void
+pool_reset_after_fork (void)
+{
+    pthread_mutex_init (&pool_mutex, NULL);
+    pthread_cond_init (&work_cond, NULL);
+    pthread_cond_init (&done_cond, NULL);
+
+    current_job = NULL;
+    n_workers = 0;
+}
+
+static pixman_bool_t
+spawn_worker (void)
+{
+    static pixman_bool_t registered_atfork;
+    pthread_attr_t attr;
+    pthread_t thread;
+    int err;
+
+    if (!registered_atfork)
+    {
+	if (pthread_atfork (NULL, NULL, pool_reset_after_fork) != 0)
+	    return FALSE;
+
+	registered_atfork = TRUE;
+    }
+
+    if (pthread_attr_init (&attr) != 0)
+	return FALSE;
+
+    pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+    err = pthread_create (&thread, &attr, worker, NULL);
+    pthread_attr_destroy (&attr);
+
+    return err == 0;
+}
+
+int
+_pixman_threads_get_default (void)
+{
+    long n = 1;
+
+#ifdef _SC_NPROCESSORS_ONLN
+    n = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+    if (n < 1)
+	n = 1;
+    if (n > MAX_THREADS)
+	n = MAX_THREADS;
+
+    return n;
+}
+
+#else /* _WIN32 */
+
+static DWORD WINAPI
+worker (LPVOID data)
+{
+    worker_loop ();
+
+    return 0;
+}
+
+static pixman_bool_t
+spawn_worker (void)
+{
+    HANDLE thread = CreateThread (NULL, 0, worker, NULL, 0, NULL);
+
+    if (!thread)
+	return FALSE;
+
+    CloseHandle (thread);
+    return TRUE;
+}
+
+int
+_pixman_threads_get_default (void)
+{
+    SYSTEM_INFO info;
+    int n;
+
+    GetSystemInfo (&info);
+    n = info.dwNumberOfProcessors;
+
+    if (n < 1)
+	n = 1;
+    if (n > MAX_THREADS)
+	n = MAX_THREADS;
+
+    return n;
+}
+
+#endif
+
+void
+_pixman_threads_run (int		n_threads,
+		     int		n_tasks,
+		     pixman_task_func_t	func,
+		     void *		data)
+{
+    job_t job;
+    int i;
+
+    if (n_threads > MAX_THREADS)
+	n_threads = MAX_THREADS;
+    if (n_threads > n_tasks)
+	n_threads = n_tasks;
+
+    if (n_threads <= 1)
+	goto serial;
+
+    POOL_LOCK ();
+
+    if (current_job)
+    {
+	POOL_UNLOCK ();
+	goto serial;
+    }
+
+    while (n_workers < n_threads - 1 && spawn_worker ())
+	n_workers++;
+
+    job.func = func;
+    job.data = data;
+    job.n_tasks = n_tasks;
+    job.next_task = 0;
+    job.max_helpers = MIN (n_workers, n_threads - 1);
+    job.n_helpers = 0;
+    job.n_active = 0;
+
+    current_job = &job;
+    WAKE_WORKERS ();
+
+    run_tasks_locked (&job);
+
+    while (job.n_active)
+	WAIT_DONE ();
+
+    current_job = NULL;
+
+    POOL_UNLOCK ();
+    return;
+
+serial:
+    for (i = 0; i < n_tasks; ++i)
+	func (data, i);
+}
+
+#else /* no thread support */
+
+int
+_pixman_threads_get_default (void)
+{
+    return 1;
+}
+
+void
+_pixman_threads_run (int		n_threads,
+		     int		n_tasks,
+		     pixman_task_func_t	func,
+		     void *		data)
+{
+    int i;
+
+    for (i = 0; i < n_tasks; ++i)
+	func (data, i);
+}
+
+#endif
@@ -468,6 +468,467 @@ get_trap_extents (pixman_op_t op, pixman_image_t *dest,
     return TRUE;
 }
 
+/*
+ * Anti-aliased rasterization of a whole set of trapezoids into an a8
+ * image with exact area coverage.
+ *
+ * Instead of point sampling every trapezoid on its own, the edges of
+ * all of them are swept down the image together. On each scanline an
+ * edge adds the area it covers to an accumulation buffer, in which a
+ * left edge adds coverage to everything on its right and a right edge
+ * takes it away again; a prefix sum over the touched part of the
+ * scanline then gives the coverage of each pixel. Overlapping
+ * trapezoids add up and saturate, as they do with PIXMAN_OP_ADD.
+ */
+typedef struct
+{
+    double	y_top;
+    double	y_bottom;
+    double	x_top;		/* x at y_top */
+    double	dxdy;
+    float	dir;		/* 1 for left edges, -1 for right edges */
+} sweep_edge_t;
+
+static double
+line_x_at (const pixman_line_fixed_t *line, double y)
+{
+    double x1 = pixman_fixed_to_double (line->p1.x);
+    double y1 = pixman_fixed_to_double (line->p1.y);
+    double x2 = pixman_fixed_to_double (line->p2.x);
+    double y2 = pixman_fixed_to_double (line->p2.y);
+
+    return x1 + (y - y1) * (x2 - x1) / (y2 - y1);
+}
+
+static int
+compare_edges (const void *a, const void *b)
+{
+    const sweep_edge_t *ea = a;
+    const sweep_edge_t *eb = b;
+
+    if (ea->y_top < eb->y_top)
+	return -1;
+
+    return ea->y_top > eb->y_top;
+}
+
+/* Generate the edges of the part of trap that lies within the rows
+ * 0 to height and where the left edge is actually left of the right
+ * one; the rest is empty, just like in pixman_rasterize_trapezoid().
+ */
+static int
+trap_to_edges (const pixman_trapezoid_t *trap,
+	       int x_off, int y_off, int height,
+	       sweep_edge_t *edges)
+{
+    double top = pixman_fixed_to_double (trap->top);
+    double bottom = pixman_fixed_to_double (trap->bottom);
+    double lt, lb, rt, rb;
+
+    if (top < -y_off)
+	top = -y_off;
+    if (bottom > height - y_off)
+	bottom = height - y_off;
+    if (bottom <= top)
+	return 0;
+
+    lt = line_x_at (&trap->left, top);
+    lb = line_x_at (&trap->left, bottom);
+    rt = line_x_at (&trap->right, top);
+    rb = line_x_at (&trap->right, bottom);
+
+    if (rt - lt <= 0 && rb - lb <= 0)
+	return 0;
+
+    if (rt - lt < 0)
+    {
+	top += (bottom - top) * (lt - rt) / ((rb - lb) - (rt - lt));
+	lt = rt = line_x_at (&trap->left, top);
+    }
+    else if (rb - lb < 0)
+    {
+	bottom -= (bottom - top) * (lb - rb) / ((rt - lt) - (rb - lb));
+	lb = rb = line_x_at (&trap->left, bottom);
+    }
+
+    if (bottom <= top)
+	return 0;
+
+    edges[0].y_top = edges[1].y_top = top + y_off;
+    edges[0].y_bottom = edges[1].y_bottom = bottom + y_off;
+
+    edges[0].x_top = lt + x_off;
+    edges[0].dxdy = (lb - lt) / (bottom - top);
+    edges[0].dir = 1;
+
+    edges[1].x_top = rt + x_off;
+    edges[1].dxdy = (rb - rt) / (bottom - top);
+    edges[1].dir = -1;
+
+    return 2;
+}
+
+/* The accumulation buffer of a scanline. It is cleared again as it is
+ * rendered; touched records which blocks of it may be non-zero, so
+ * that rendering can skip over the stretches between edges.
+ */
+#define SWEEP_BLOCK_BITS	5
+#define SWEEP_BLOCK		(1 << SWEEP_BLOCK_BITS)
+
+typedef struct
+{
+    float *		acc;
+    uint8_t *		touched;
+    int			width;
+    int			first_block;
+    int			last_block;
+} sweep_line_t;
+
+/* Rectangles of the mask that were written to, if they are wanted.
+ * n_boxes is negative if they could not all be recorded.
+ */
+typedef struct
+{
+    pixman_box32_t *	boxes;
+    int			n_boxes;
+    int			size;
+} sweep_spans_t;
+
+static void
+sweep_touch (sweep_line_t *line, int x1, int x2)
+{
+    int b;
+
+    x1 >>= SWEEP_BLOCK_BITS;
+    x2 >>= SWEEP_BLOCK_BITS;
+
+    for (b = x1; b <= x2; ++b)
+	line->touched[b] = 1;
+
+    line->first_block = MIN (line->first_block, x1);
+    line->last_block = MAX (line->last_block, x2);
+}
+
+/* Add the coverage of an edge segment that spans d of the height of
+ * the scanline and goes from x0 to x1 within it. Whatever lies left of
+ * the image is added to its first pixel; what lies right of it has no
+ * effect on the image.
+ */
+static void
+sweep_add_segment (sweep_line_t *line, double x0, double x1, double d)
+{
+    float *acc = line->acc;
+    int width = line->width;
+    int x0i, x1i, i;
+
+    if (x0 > x1)
+    {
+	double t = x0;
+	x0 = x1;
+	x1 = t;
+    }
+
+    if (x0 >= width)
+	return;
+
+    if (x1 <= 0)
+    {
+	acc[0] += d;
+	sweep_touch (line, 0, 0);
+	return;
+    }
+
+    if (x0 < 0)
+    {
+	double f = -x0 / (x1 - x0);
+
+	acc[0] += d * f;
+	d -= d * f;
+	x0 = 0;
+    }
+
+    if (x1 > width)
+    {
+	d = d * (width - x0) / (x1 - x0);
+	x1 = width;
+    }
+
+    x0i = (int)x0;
+    x1i = (int)x1;
+    if (x1i < x1)
+	x1i++;
+
+    if (x1i <= x0i + 1)
+    {
+	double xm = 0.5 * (x0 + x1) - x0i;
+
+	acc[x0i] += d - d * xm;
+	acc[x0i + 1] += d * xm;
+
+	x1i = x0i + 1;
+    }
+    else
+    {
+	double s = 1 / (x1 - x0);
+	double x0f = x0 - x0i;
+	double x1f = x1 - x1i + 1;
+	double a0 = 0.5 * s * (1 - x0f) * (1 - x0f);
+	double am = 0.5 * s * x1f * x1f;
+
+	acc[x0i] += d * a0;
+
+	if (x1i == x0i + 2)
+	{
+	    acc[x0i + 1] += d * (1 - a0 - am);
+	}
+	else
+	{
+	    double a1 = s * (1.5 - x0f);
+	    double a2 = a1 + (x1i - x0i - 3) * s;
+
+	    acc[x0i + 1] += d * (a1 - a0);
+	    for (i = x0i + 2; i < x1i - 1; ++i)
+		acc[i] += d * s;
+	    acc[x1i - 1] += d * (1 - a2 - am);
+	}
+
+	acc[x1i] += d * am;
+    }
+
+    sweep_touch (line, x0i, x1i);
+}
+
+static void
+sweep_add_span (sweep_spans_t *spans, int y, int x1, int x2)
+{
+    pixman_box32_t *box;
+
+    if (!spans || spans->n_boxes < 0)
+	return;
+
+    if (spans->n_boxes == spans->size)
+    {
+	int size = spans->size ? 2 * spans->size : 256;
+	pixman_box32_t *boxes = NULL;
+
+	if (!_pixman_multiply_overflows_int (size, sizeof (pixman_box32_t)))
+	    boxes = realloc (spans->boxes, size * sizeof (pixman_box32_t));
+
+	if (!boxes)
+	{
+	    free (spans->boxes);
+	    spans->boxes = NULL;
+	    spans->n_boxes = -1;
+	    return;
+	}
+
+	spans->boxes = boxes;
+	spans->size = size;
+    }
+
+    box = &spans->boxes[spans->n_boxes++];
+    box->x1 = x1;
+    box->y1 = y;
+    box->x2 = x2;
+    box->y2 = y + 1;
+}
+
+static force_inline int
+sweep_coverage (float cover)
+{
+    float a = cover * 0xff + 0.5f;
+
+    a = a > 0 ? a : 0;
+    a = a < 0xff ? a : 0xff;
+
+    return (int)a;
+}
+
+/* Add the coverage of the scanline to the pixels of row y in dst */
+static void
+sweep_render_line (sweep_line_t *line, uint8_t *dst, int y,
+		   sweep_spans_t *spans)
+{
+    int width = line->width;
+    int n_blocks = (width + SWEEP_BLOCK - 1) >> SWEEP_BLOCK_BITS;
+    int span_start = -1;
+    float cover = 0;
+    int b, x, x1, x2;
+
+    for (b = line->first_block; b < n_blocks; ++b)
+    {
+	int painted = 0;
+
+	x1 = b << SWEEP_BLOCK_BITS;
+	x2 = MIN (x1 + SWEEP_BLOCK, width);
+
+	if (line->touched[b])
+	{
+	    line->touched[b] = 0;
+
+	    for (x = x1; x < x2; ++x)
+	    {
+		int a;
+
+		cover += line->acc[x];
+		line->acc[x] = 0;
+
+		a = sweep_coverage (cover);
+		painted |= a;
+
+		a += dst[x];
+		dst[x] = a > 0xff ? 0xff : a;
+	    }
+	}
+	else
+	{
+	    /* Between edges the coverage stays the same */
+	    int a = sweep_coverage (cover);
+
+	    if (a == 0 && b > line->last_block)
+		break;
+
+	    if (a == 0xff)
+	    {
+		memset (dst + x1, 0xff, x2 - x1);
+		painted = TRUE;
+	    }
+	    else if (a)
+	    {
+		for (x = x1; x < x2; ++x)
+		{
+		    int t = dst[x] + a;
+		    dst[x] = t > 0xff ? 0xff : t;
+		}
+		painted = TRUE;
+	    }
+	}
+
+	if (painted && span_start < 0)
+	{
+	    span_start = x1;
+	}
+	else if (!painted && span_start >= 0)
+	{
+	    sweep_add_span (spans, y, span_start, x1);
+	    span_start = -1;
+	}
+    }
+
+    if (span_start >= 0)
+	sweep_add_span (spans, y, span_start, MIN (b << SWEEP_BLOCK_BITS, width));
+
+    /* The last pixel of an edge may be just past the image */
+    line->acc[width] = 0;
+    line->touched[n_blocks] = 0;
+
+    line->first_block = INT32_MAX;
+    line->last_block = -1;
+}
+
+/* Rasterize traps into the a8 image, adding to what is there. If
+ * spans is not NULL, the rectangles that were written to are added
+ * to it. Returns FALSE if memory could not be allocated.
+ */
+static pixman_bool_t
+sweep_rasterize_trapezoids (pixman_image_t *image,
+			    int x_off, int y_off,
+			    int n_traps, const pixman_trapezoid_t *traps,
+			    sweep_spans_t *spans)
+{
+    int width = image->bits.width;
+    int height = image->bits.height;
+    sweep_edge_t *edges, **active;
+    int n_edges, n_active, next;
+    sweep_line_t line;
+    int i, y;
+
+    edges = pixman_malloc_ab (n_traps, 2 * sizeof (sweep_edge_t));
+    active = pixman_malloc_ab (n_traps, 2 * sizeof (sweep_edge_t *));
+    line.acc = calloc (width + 2, sizeof (float));
+    line.touched = calloc ((width >> SWEEP_BLOCK_BITS) + 2, 1);
+
+    if (!edges || !active || !line.acc || !line.touched)
+    {
+	free (edges);
+	free (active);
+	free (line.acc);
+	free (line.touched);
+	return FALSE;
+    }
+
+    line.width = width;
+    line.first_block = INT32_MAX;
+    line.last_block = -1;
+
+    n_edges = 0;
+    for (i = 0; i < n_traps; ++i)
+    {
+	if (pixman_trapezoid_valid (&traps[i]))
+	{
+	    n_edges += trap_to_edges (
+		&traps[i], x_off, y_off, height, edges + n_edges);
+	}
+    }
+
+    qsort (edges, n_edges, sizeof (sweep_edge_t), compare_edges);
+
+    n_active = 0;
+    next = 0;
+
+    for (y = 0; y < height; ++y)
+    {
+	int j;
+
+	if (n_active == 0)
+	{
+	    if (next == n_edges)
+		break;
+
+	    /* Skip ahead to the next edge */
+	    if (edges[next].y_top >= y + 1)
+		y = (int)edges[next].y_top;
+	}
+
+	while (next < n_edges && edges[next].y_top < y + 1)
+	    active[n_active++] = &edges[next++];
+
+	for (i = 0, j = 0; i < n_active; ++i)
+	{
+	    sweep_edge_t *e = active[i];
+	    double y0 = MAX (e->y_top, y);
+	    double y1 = MIN (e->y_bottom, y + 1);
+
+	    if (y1 > y0)
+	    {
+		sweep_add_segment (&line,
+				   e->x_top + (y0 - e->y_top) * e->dxdy,
+				   e->x_top + (y1 - e->y_top) * e->dxdy,
+				   (y1 - y0) * e->dir);
+	    }
+
+	    if (e->y_bottom > y + 1)
+		active[j++] = e;
+	}
+	n_active = j;
+
+	if (line.first_block <= line.last_block)
+	{
+	    sweep_render_line (
+		&line,
+		(uint8_t *)(image->bits.bits + y * image->bits.rowstride),
+		y, spans);
+	}
+    }
+
+    free (edges);
+    free (active);
+    free (line.acc);
+    free (line.touched);
+
+    return TRUE;
+}
+
 /*
  * pixman_composite_trapezoids()
  *
@@ -504,6 +965,16 @@ pixman_composite_trapezoids (pixman_op_t		op,
 	(mask_format == dst->common.extended_format_code)	&&
 	!(dst->common.have_clip_region))
     {
+	/* The sweep writes dst->bits directly, so it can't be used when
+	 * dst has accessors.
+	 */
+	if (mask_format == PIXMAN_a8					&&
+	    (dst->common.flags & FAST_PATH_NO_ACCESSORS)		&&
+	    sweep_rasterize_trapezoids (dst, x_dst, y_dst, n_traps, traps, NULL))
+	{
+	    return;
+	}
+
 	for (i = 0; i < n_traps; ++i)
 	{
 	    const pixman_trapezoid_t *trap = &(traps[i]);
@@ -518,6 +989,7 @@ pixman_composite_trapezoids (pixman_op_t		op,
     {
 	pixman_image_t *tmp;
 	pixman_box32_t box;
+	sweep_spans_t spans = { NULL, 0, 0 };
 	int i;
 
 	if (!get_trap_extents (op, dst, traps, n_traps, &box))
@@ -526,22 +998,65 @@ pixman_composite_trapezoids (pixman_op_t		op,
 	if (!(tmp = pixman_image_create_bits (
 		  mask_format, box.x2 - box.x1, box.y2 - box.y1, NULL, -1)))
 	    return;
-	
-	for (i = 0; i < n_traps; ++i)
+
+	/* When a zero mask leaves the destination alone, only the
+	 * spans that the rasterizer wrote to need compositing.
+	 */
+	if (!zero_src_has_no_effect[op])
+	    spans.n_boxes = -1;
+
+	if (mask_format != PIXMAN_a8 ||
+	    !sweep_rasterize_trapezoids (
+		tmp, - box.x1, - box.y1, n_traps, traps, &spans))
 	{
-	    const pixman_trapezoid_t *trap = &(traps[i]);
-	    
-	    if (!pixman_trapezoid_valid (trap))
-		continue;
-	    
-	    pixman_rasterize_trapezoid (tmp, trap, - box.x1, - box.y1);
+	    spans.n_boxes = -1;
+
+	    for (i = 0; i < n_traps; ++i)
+	    {
+		const pixman_trapezoid_t *trap = &(traps[i]);
+
+		if (!pixman_trapezoid_valid (trap))
+		    continue;
+
+		pixman_rasterize_trapezoid (tmp, trap, - box.x1, - box.y1);
+	    }
+	}
+
+	if (spans.n_boxes >= 0)
+	{
+	    pixman_region32_t region;
+
+	    if (pixman_region32_init_rects (&region, spans.boxes, spans.n_boxes))
+	    {
+		pixman_region32_translate (&region,
+					   x_dst + box.x1, y_dst + box.y1);
+
+		_pixman_image_composite_region32 (
+		    op, src, tmp, dst,
+		    x_src + box.x1, y_src + box.y1,
+		    0, 0,
+		    x_dst + box.x1, y_dst + box.y1,
+		    box.x2 - box.x1, box.y2 - box.y1,
+		    &region);
+
+		pixman_region32_fini (&region);
+	    }
+	    else
+	    {
+		spans.n_boxes = -1;
+	    }
+
+	    free (spans.boxes);
+	}
+
+	if (spans.n_boxes < 0)
+	{
+	    pixman_image_composite (op, src, tmp, dst,
+				    x_src + box.x1, y_src + box.y1,
+				    0, 0,
+				    x_dst + box.x1, y_dst + box.y1,
+				    box.x2 - box.x1, box.y2 - box.y1);
 	}
-	
-	pixman_image_composite (op, src, tmp, dst,
-				x_src + box.x1, y_src + box.y1,
-				0, 0,
-				x_dst + box.x1, y_dst + box.y1,
-				box.x2 - box.x1, box.y2 - box.y1);
 	
 	pixman_image_unref (tmp);
     }
@@ -25,7 +25,8 @@
 
 #include "pixman-private.h"
 
-#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3)
+#if defined(USE_X86_MMX) || defined (USE_SSE2) || defined (USE_SSSE3) || \
+    defined (USE_AVX2)
 
 /* The CPU detection code needs to be in a file not compiled with
  * "-mmmx -msse", as gcc would generate CMOV instructions otherwise
@@ -40,7 +41,8 @@ typedef enum
     X86_SSE			= (1 << 2) | X86_MMX_EXTENSIONS,
     X86_SSE2			= (1 << 3),
     X86_CMOV			= (1 << 4),
-    X86_SSSE3			= (1 << 5)
+    X86_SSSE3			= (1 << 5),
+    X86_AVX2			= (1 << 6)
 } cpu_features_t;
 
 #ifdef HAVE_GETISAX
@@ -74,6 +76,11 @@ detect_cpu_features (void)
 
 #else
 
+#if defined (_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
 #define _PIXMAN_X86_64							\
     (defined(__amd64__) || defined(__x86_64__) || defined(_M_AMD64))
 
@@ -109,6 +116,9 @@ have_cpuid (void)
 #endif
 }
 
+/* Sub-leaf 0 is always requested; leaf 7 needs it in %ecx and the
+ * other leaves ignore it.
+ */
 static void
 pixman_cpuid (uint32_t feature,
 	      uint32_t *a, uint32_t *b, uint32_t *c, uint32_t *d)
@@ -119,7 +129,7 @@ pixman_cpuid (uint32_t feature,
     __asm__ volatile (
         "cpuid"				"\n\t"
 	: "=a" (*a), "=b" (*b), "=c" (*c), "=d" (*d)
-	: "a" (feature));
+	: "a" (feature), "c" (0));
 #else
     /* On x86-32 we need to be careful about the handling of %ebx
      * and %esp. We can't declare either one as clobbered
@@ -134,13 +144,13 @@ pixman_cpuid (uint32_t feature,
 	"cpuid"				"\n\t"
 	"xchg %%ebx, %1"		"\n\t"
 	: "=a" (*a), "=r" (*b), "=c" (*c), "=d" (*d)
-	: "a" (feature));
+	: "a" (feature), "c" (0));
 #endif
 
 #elif defined (_MSC_VER)
     int info[4];
 
-    __cpuid (info, feature);
+    __cpuidex (info, feature, 0);
 
     *a = info[0];
     *b = info[1];
@@ -151,6 +161,26 @@ pixman_cpuid (uint32_t feature,
 #endif
 }
 
+static uint32_t
+pixman_xgetbv (void)
+{
+#if defined (__GNUC__)
+    uint32_t lo, hi;
+
+    /* xgetbv with %ecx = 0, spelled out for older assemblers */
+    __asm__ volatile (
+	".byte 0x0f, 0x01, 0xd0"	"\n\t"
+	: "=a" (lo), "=d" (hi)
+	: "c" (0));
+
+    return lo;
+#elif defined (_MSC_VER)
+    return (uint32_t) _xgetbv (0);
+#else
+#error Unknown compiler
+#endif
+}
+
 static cpu_features_t
 detect_cpu_features (void)
 {
@@ -173,6 +203,23 @@ detect_cpu_features (void)
     if (c & (1 << 9))
 	features |= X86_SSSE3;
 
+    /* AVX2 also needs the OS to save the YMM state (OSXSAVE + AVX, then
+     * XCR0 bits 1 and 2)
+     */
+    if ((c & (1 << 27)) && (c & (1 << 28)) &&
+	(pixman_xgetbv () & 0x6) == 0x6)
+    {
+	uint32_t max_leaf;
+
+	pixman_cpuid (0x00, &max_leaf, &b, &c, &d);
+	if (max_leaf >= 7)
+	{
+	    pixman_cpuid (0x07, &a, &b, &c, &d);
+	    if (b & (1 << 5))
+		features |= X86_AVX2;
+	}
+    }
+
     /* Check for AMD specific features */
     if ((features & X86_MMX) && !(features & X86_SSE))
     {
@@ -229,6 +276,7 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 #define MMX_BITS  (X86_MMX | X86_MMX_EXTENSIONS)
 #define SSE2_BITS (X86_MMX | X86_MMX_EXTENSIONS | X86_SSE | X86_SSE2)
 #define SSSE3_BITS (X86_SSE | X86_SSE2 | X86_SSSE3)
+#define AVX2_BITS (X86_SSE | X86_SSE2 | X86_SSSE3 | X86_AVX2)
 
 #ifdef USE_X86_MMX
     if (!_pixman_disabled ("mmx") && have_feature (MMX_BITS))
@@ -245,5 +293,10 @@ _pixman_x86_get_implementations (pixman_implementation_t *imp)
 	imp = _pixman_implementation_create_ssse3 (imp);
 #endif
 
+#ifdef USE_AVX2
+    if (!_pixman_disabled ("avx2") && have_feature (AVX2_BITS))
+	imp = _pixman_implementation_create_avx2 (imp);
+#endif
+
     return imp;
 }
@@ -540,47 +540,29 @@ analyze_extent (pixman_image_t       *image,
     return TRUE;
 }
 
-/*
- * Work around GCC bug causing crashes in Mozilla with SSE2
- *
- * When using -msse, gcc generates movdqa instructions assuming that
- * the stack is 16 byte aligned. Unfortunately some applications, such
- * as Mozilla and Mono, end up aligning the stack to 4 bytes, which
- * causes the movdqa instructions to fail.
- *
- * The __force_align_arg_pointer__ makes gcc generate a prologue that
- * realigns the stack pointer to 16 bytes.
- *
- * On x86-64 this is not necessary because the standard ABI already
- * calls for a 16 byte aligned stack.
- *
- * See https://bugs.freedesktop.org/show_bug.cgi?id=15693
+/* Computes the composite region, the flags and the composite
+ * function for a composite. Returns FALSE if there is nothing to do.
  */
-#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
-__attribute__((__force_align_arg_pointer__))
-#endif
-PIXMAN_EXPORT void
-pixman_image_composite32 (pixman_op_t      op,
-                          pixman_image_t * src,
-                          pixman_image_t * mask,
-                          pixman_image_t * dest,
-                          int32_t          src_x,
-                          int32_t          src_y,
-                          int32_t          mask_x,
-                          int32_t          mask_y,
-                          int32_t          dest_x,
-                          int32_t          dest_y,
-                          int32_t          width,
-                          int32_t          height)
+static pixman_bool_t
+setup_composite (pixman_op_t		   op,
+		 pixman_image_t *	   src,
+		 pixman_image_t *	   mask,
+		 pixman_image_t *	   dest,
+		 int32_t		   src_x,
+		 int32_t		   src_y,
+		 int32_t		   mask_x,
+		 int32_t		   mask_y,
+		 int32_t		   dest_x,
+		 int32_t		   dest_y,
+		 int32_t		   width,
+		 int32_t		   height,
+		 pixman_region32_t *	   region,
+		 pixman_composite_info_t * info,
+		 pixman_implementation_t **imp,
+		 pixman_composite_func_t * func)
 {
     pixman_format_code_t src_format, mask_format, dest_format;
-    pixman_region32_t region;
     pixman_box32_t extents;
-    pixman_implementation_t *imp;
-    pixman_composite_func_t func;
-    pixman_composite_info_t info;
-    const pixman_box32_t *pbox;
-    int n;
 
     _pixman_image_validate (src);
     if (mask)
@@ -588,27 +570,27 @@ pixman_image_composite32 (pixman_op_t      op,
     _pixman_image_validate (dest);
 
     src_format = src->common.extended_format_code;
-    info.src_flags = src->common.flags;
+    info->src_flags = src->common.flags;
 
     if (mask && !(mask->common.flags & FAST_PATH_IS_OPAQUE))
     {
 	mask_format = mask->common.extended_format_code;
-	info.mask_flags = mask->common.flags;
+	info->mask_flags = mask->common.flags;
     }
     else
     {
 	mask_format = PIXMAN_null;
-	info.mask_flags = FAST_PATH_IS_OPAQUE | FAST_PATH_NO_ALPHA_MAP;
+	info->mask_flags = FAST_PATH_IS_OPAQUE | FAST_PATH_NO_ALPHA_MAP;
     }
 
     dest_format = dest->common.extended_format_code;
-    info.dest_flags = dest->common.flags;
+    info->dest_flags = dest->common.flags;
 
     /* Check for pixbufs */
     if ((mask_format == PIXMAN_a8r8g8b8 || mask_format == PIXMAN_a8b8g8r8) &&
 	(src->type == BITS && src->bits.bits == mask->bits.bits)	   &&
 	(src->common.repeat == mask->common.repeat)			   &&
-	(info.src_flags & info.mask_flags & FAST_PATH_ID_TRANSFORM)	   &&
+	(info->src_flags & info->mask_flags & FAST_PATH_ID_TRANSFORM)	   &&
 	(src_x == mask_x && src_y == mask_y))
     {
 	if (src_format == PIXMAN_x8b8g8r8)
@@ -617,32 +599,40 @@ pixman_image_composite32 (pixman_op_t      op,
 	    src_format = mask_format = PIXMAN_rpixbuf;
     }
 
-    pixman_region32_init (&region);
-
     if (!_pixman_compute_composite_region32 (
-	    &region, src, mask, dest,
+	    region, src, mask, dest,
 	    src_x, src_y, mask_x, mask_y, dest_x, dest_y, width, height))
     {
-	goto out;
+	return FALSE;
     }
 
-    extents = *pixman_region32_extents (&region);
+    extents = *pixman_region32_extents (region);
+
+    if (src->common.flags & dest->common.flags & FAST_PATH_NARROW_FORMAT)
+    {
+	int64_t n_pixels = (int64_t)(extents.x2 - extents.x1) *
+	    (extents.y2 - extents.y1);
+
+	_pixman_gradient_prepare_lut (src, n_pixels);
+	if (mask)
+	    _pixman_gradient_prepare_lut (mask, n_pixels);
+    }
 
     extents.x1 -= dest_x - src_x;
     extents.y1 -= dest_y - src_y;
     extents.x2 -= dest_x - src_x;
     extents.y2 -= dest_y - src_y;
 
-    if (!analyze_extent (src, &extents, &info.src_flags))
-	goto out;
+    if (!analyze_extent (src, &extents, &info->src_flags))
+	return FALSE;
 
     extents.x1 -= src_x - mask_x;
     extents.y1 -= src_y - mask_y;
     extents.x2 -= src_x - mask_x;
     extents.y2 -= src_y - mask_y;
 
-    if (!analyze_extent (mask, &extents, &info.mask_flags))
-	goto out;
+    if (!analyze_extent (mask, &extents, &info->mask_flags))
+	return FALSE;
 
     /* If the clip is within the source samples, and the samples are
      * opaque, then the source is effectively opaque.
@@ -654,16 +644,16 @@ pixman_image_composite32 (pixman_op_t      op,
 			 FAST_PATH_BILINEAR_FILTER |			\
 			 FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR)
 
-    if ((info.src_flags & NEAREST_OPAQUE) == NEAREST_OPAQUE ||
-	(info.src_flags & BILINEAR_OPAQUE) == BILINEAR_OPAQUE)
+    if ((info->src_flags & NEAREST_OPAQUE) == NEAREST_OPAQUE ||
+	(info->src_flags & BILINEAR_OPAQUE) == BILINEAR_OPAQUE)
     {
-	info.src_flags |= FAST_PATH_IS_OPAQUE;
+	info->src_flags |= FAST_PATH_IS_OPAQUE;
     }
 
-    if ((info.mask_flags & NEAREST_OPAQUE) == NEAREST_OPAQUE ||
-	(info.mask_flags & BILINEAR_OPAQUE) == BILINEAR_OPAQUE)
+    if ((info->mask_flags & NEAREST_OPAQUE) == NEAREST_OPAQUE ||
+	(info->mask_flags & BILINEAR_OPAQUE) == BILINEAR_OPAQUE)
     {
-	info.mask_flags |= FAST_PATH_IS_OPAQUE;
+	info->mask_flags |= FAST_PATH_IS_OPAQUE;
     }
 
     /*
@@ -671,36 +661,349 @@ pixman_image_composite32 (pixman_op_t      op,
      * if the src or dest are opaque. The output operator should be
      * mathematically equivalent to the source.
      */
-    info.op = optimize_operator (op, info.src_flags, info.mask_flags, info.dest_flags);
+    info->op = optimize_operator (op, info->src_flags, info->mask_flags, info->dest_flags);
 
     _pixman_implementation_lookup_composite (
-	get_implementation (), info.op,
-	src_format, info.src_flags,
-	mask_format, info.mask_flags,
-	dest_format, info.dest_flags,
-	&imp, &func);
+	get_implementation (), info->op,
+	src_format, info->src_flags,
+	mask_format, info->mask_flags,
+	dest_format, info->dest_flags,
+	imp, func);
+
+    info->src_image = src;
+    info->mask_image = mask;
+    info->dest_image = dest;
+
+    return TRUE;
+}
+
+static void
+composite_region (pixman_implementation_t * imp,
+		  pixman_composite_func_t   func,
+		  pixman_composite_info_t * info,
+		  pixman_region32_t *	    region,
+		  int32_t		    src_dx,
+		  int32_t		    src_dy,
+		  int32_t		    mask_dx,
+		  int32_t		    mask_dy)
+{
+    const pixman_box32_t *pbox;
+    int n;
+
+    pbox = pixman_region32_rectangles (region, &n);
+
+    while (n--)
+    {
+	info->src_x = pbox->x1 + src_dx;
+	info->src_y = pbox->y1 + src_dy;
+	info->mask_x = pbox->x1 + mask_dx;
+	info->mask_y = pbox->y1 + mask_dy;
+	info->dest_x = pbox->x1;
+	info->dest_y = pbox->y1;
+	info->width = pbox->x2 - pbox->x1;
+	info->height = pbox->y2 - pbox->y1;
+
+	func (imp, info);
+
+	pbox++;
+    }
+}
+
+/*
+ * Work around GCC bug causing crashes in Mozilla with SSE2
+ *
+ * When using -msse, gcc generates movdqa instructions assuming that
+ * the stack is 16 byte aligned. Unfortunately some applications, such
+ * as Mozilla and Mono, end up aligning the stack to 4 bytes, which
+ * causes the movdqa instructions to fail.
+ *
+ * The __force_align_arg_pointer__ makes gcc generate a prologue that
+ * realigns the stack pointer to 16 bytes.
+ *
+ * On x86-64 this is not necessary because the standard ABI already
+ * calls for a 16 byte aligned stack.
+ *
+ * See https://bugs.freedesktop.org/show_bug.cgi?id=15693
+ */
+#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+PIXMAN_EXPORT void
+pixman_image_composite32 (pixman_op_t      op,
+                          pixman_image_t * src,
+                          pixman_image_t * mask,
+                          pixman_image_t * dest,
+                          int32_t          src_x,
+                          int32_t          src_y,
+                          int32_t          mask_x,
+                          int32_t          mask_y,
+                          int32_t          dest_x,
+                          int32_t          dest_y,
+                          int32_t          width,
+                          int32_t          height)
+{
+    pixman_region32_t region;
+    pixman_implementation_t *imp;
+    pixman_composite_func_t func;
+    pixman_composite_info_t info;
+
+    pixman_region32_init (&region);
+
+    if (setup_composite (op, src, mask, dest,
+			 src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+			 width, height, &region, &info, &imp, &func))
+    {
+	composite_region (imp, func, &info, &region,
+			  src_x - dest_x, src_y - dest_y,
+			  mask_x - dest_x, mask_y - dest_y);
+    }
+
+    pixman_region32_fini (&region);
+}
+
+/* Like pixman_image_composite32(), but only for the part of the
+ * destination that is also in limit. The composite function is chosen
+ * once for the whole rectangle, which is what makes this cheaper than
+ * compositing each rectangle of limit separately.
+ */
+void
+_pixman_image_composite_region32 (pixman_op_t		    op,
+				  pixman_image_t *	    src,
+				  pixman_image_t *	    mask,
+				  pixman_image_t *	    dest,
+				  int32_t		    src_x,
+				  int32_t		    src_y,
+				  int32_t		    mask_x,
+				  int32_t		    mask_y,
+				  int32_t		    dest_x,
+				  int32_t		    dest_y,
+				  int32_t		    width,
+				  int32_t		    height,
+				  pixman_region32_t *	    limit)
+{
+    pixman_region32_t region;
+    pixman_implementation_t *imp;
+    pixman_composite_func_t func;
+    pixman_composite_info_t info;
+
+    pixman_region32_init (&region);
+
+    if (setup_composite (op, src, mask, dest,
+			 src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+			 width, height, &region, &info, &imp, &func) &&
+	pixman_region32_intersect (&region, &region, limit))
+    {
+	composite_region (imp, func, &info, &region,
+			  src_x - dest_x, src_y - dest_y,
+			  mask_x - dest_x, mask_y - dest_y);
+    }
 
-    info.src_image = src;
-    info.mask_image = mask;
-    info.dest_image = dest;
+    pixman_region32_fini (&region);
+}
+
+/* Number of destination pixels per band handed to a worker: small
+ * enough that a band's source, mask and destination lines stay in
+ * the L2 cache, large enough that the per-band setup is amortized.
+ */
+#define BAND_PIXELS		16384
 
-    pbox = pixman_region32_rectangles (&region, &n);
+/* Composites smaller than this are not worth waking up the pool for */
+#define MIN_THREADED_PIXELS	(4 * BAND_PIXELS)
+
+typedef struct
+{
+    pixman_implementation_t *	imp;
+    pixman_composite_func_t	func;
+    pixman_composite_info_t	info;
+    const pixman_box32_t *	boxes;
+    int				n_boxes;
+    int32_t			src_dx;
+    int32_t			src_dy;
+    int32_t			mask_dx;
+    int32_t			mask_dy;
+    int32_t			y1;
+    int32_t			y2;
+    int32_t			band_height;
+} composite_bands_t;
+
+/* All bands share the flags and the composite function chosen for
+ * the whole region, so the result does not depend on how the region
+ * is split.
+ */
+static void
+composite_band (void *data, int band)
+{
+    composite_bands_t *c = data;
+    pixman_composite_info_t info = c->info;
+    const pixman_box32_t *pbox = c->boxes;
+    int32_t y1 = c->y1 + band * c->band_height;
+    int32_t y2 = MIN (y1 + c->band_height, c->y2);
+    int n = c->n_boxes;
 
     while (n--)
     {
-	info.src_x = pbox->x1 + src_x - dest_x;
-	info.src_y = pbox->y1 + src_y - dest_y;
-	info.mask_x = pbox->x1 + mask_x - dest_x;
-	info.mask_y = pbox->y1 + mask_y - dest_y;
-	info.dest_x = pbox->x1;
-	info.dest_y = pbox->y1;
-	info.width = pbox->x2 - pbox->x1;
-	info.height = pbox->y2 - pbox->y1;
+	int32_t by1 = MAX (pbox->y1, y1);
+	int32_t by2 = MIN (pbox->y2, y2);
 
-	func (imp, &info);
+	if (by1 < by2)
+	{
+	    info.src_x = pbox->x1 + c->src_dx;
+	    info.src_y = by1 + c->src_dy;
+	    info.mask_x = pbox->x1 + c->mask_dx;
+	    info.mask_y = by1 + c->mask_dy;
+	    info.dest_x = pbox->x1;
+	    info.dest_y = by1;
+	    info.width = pbox->x2 - pbox->x1;
+	    info.height = by2 - by1;
+
+	    c->func (c->imp, &info);
+	}
+	else if (pbox->y1 >= y2)
+	{
+	    break;
+	}
 
 	pbox++;
     }
+}
+
+static void
+get_bits_range (pixman_image_t *image, uint8_t **start, uint8_t **end)
+{
+    uint32_t *first = image->bits.bits;
+    uint32_t *last = first + (image->bits.height - 1) * image->bits.rowstride;
+    int stride = abs (image->bits.rowstride);
+
+    *start = (uint8_t *)MIN (first, last);
+    *end = (uint8_t *)(MAX (first, last) + stride);
+}
+
+static pixman_bool_t
+bits_overlap (pixman_image_t *a, pixman_image_t *b)
+{
+    uint8_t *a_start, *a_end, *b_start, *b_end;
+
+    if (!a || !b || a->type != BITS || b->type != BITS)
+	return FALSE;
+
+    get_bits_range (a, &a_start, &a_end);
+    get_bits_range (b, &b_start, &b_end);
+
+    return a_start < b_end && b_start < a_end;
+}
+
+/* Bands only ever write disjoint destination rows, so splitting is
+ * safe unless a band could read pixels another band writes, the
+ * images go through user supplied accessors that may not be
+ * reentrant, or a linear gradient would take its single row
+ * shortcut for some bands but not for others.
+ */
+static pixman_bool_t
+can_split_composite (pixman_image_t *src,
+		     pixman_image_t *mask,
+		     pixman_image_t *dest)
+{
+    pixman_image_t *images[6];
+    int i, j;
+
+    images[0] = src;
+    images[1] = (pixman_image_t *)src->common.alpha_map;
+    images[2] = mask;
+    images[3] = mask ? (pixman_image_t *)mask->common.alpha_map : NULL;
+    images[4] = dest;
+    images[5] = (pixman_image_t *)dest->common.alpha_map;
+
+    for (i = 0; i < 6; ++i)
+    {
+	if (images[i] && !(images[i]->common.flags & FAST_PATH_NO_ACCESSORS))
+	    return FALSE;
+    }
+
+    for (i = 0; i < 4; i += 2)
+    {
+	if (images[i] && images[i]->type == LINEAR &&
+	    !_pixman_linear_gradient_is_splittable (images[i]))
+	{
+	    return FALSE;
+	}
+    }
+
+    for (i = 0; i < 4; ++i)
+    {
+	for (j = 4; j < 6; ++j)
+	{
+	    if (bits_overlap (images[i], images[j]))
+		return FALSE;
+	}
+    }
+
+    return TRUE;
+}
+
+#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+PIXMAN_EXPORT void
+pixman_image_composite32_threaded (pixman_op_t      op,
+				   pixman_image_t * src,
+				   pixman_image_t * mask,
+				   pixman_image_t * dest,
+				   int32_t          src_x,
+				   int32_t          src_y,
+				   int32_t          mask_x,
+				   int32_t          mask_y,
+				   int32_t          dest_x,
+				   int32_t          dest_y,
+				   int32_t          width,
+				   int32_t          height,
+				   int              n_threads)
+{
+    composite_bands_t c;
+    pixman_region32_t region;
+    const pixman_box32_t *extents;
+    int32_t w;
+    int n_bands;
+
+    pixman_region32_init (&region);
+
+    /* Validation and setup write to the images, so they happen once
+     * here; the bands only read them.
+     */
+    if (!setup_composite (op, src, mask, dest,
+			  src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+			  width, height, &region, &c.info, &c.imp, &c.func))
+    {
+	goto out;
+    }
+
+    if (n_threads <= 0)
+	n_threads = _pixman_threads_get_default ();
+
+    extents = pixman_region32_extents (&region);
+    w = extents->x2 - extents->x1;
+
+    c.boxes = pixman_region32_rectangles (&region, &c.n_boxes);
+    c.src_dx = src_x - dest_x;
+    c.src_dy = src_y - dest_y;
+    c.mask_dx = mask_x - dest_x;
+    c.mask_dy = mask_y - dest_y;
+    c.y1 = extents->y1;
+    c.y2 = extents->y2;
+
+    if (n_threads == 1						||
+	(int64_t)w * (c.y2 - c.y1) < MIN_THREADED_PIXELS	||
+	!can_split_composite (src, mask, dest))
+    {
+	c.band_height = c.y2 - c.y1;
+	n_bands = 1;
+    }
+    else
+    {
+	c.band_height = MAX (1, BAND_PIXELS / w);
+	n_bands = (c.y2 - c.y1 + c.band_height - 1) / c.band_height;
+    }
+
+    _pixman_threads_run (n_threads, n_bands, composite_band, &c);
 
 out:
     pixman_region32_fini (&region);
@@ -1170,6 +1170,32 @@ void          pixman_image_composite32        (pixman_op_t        op,
 					       int32_t            width,
 					       int32_t            height);
 
+/* Like pixman_image_composite32(), but the destination rectangle is
+ * split into bands of rows that are composited by up to n_threads
+ * threads, the calling thread included. n_threads <= 0 means one
+ * thread per online CPU.
+ *
+ * The result is identical to pixman_image_composite32(). Small
+ * composites, images with accessors, sources or masks whose pixels
+ * overlap the destination, and nearly horizontal linear gradients
+ * are composited on the calling thread alone. The images must not be
+ * modified by other threads while the call is in progress.
+ */
+PIXMAN_API
+void          pixman_image_composite32_threaded (pixman_op_t        op,
+						 pixman_image_t    *src,
+						 pixman_image_t    *mask,
+						 pixman_image_t    *dest,
+						 int32_t            src_x,
+						 int32_t            src_y,
+						 int32_t            mask_x,
+						 int32_t            mask_y,
+						 int32_t            dest_x,
+						 int32_t            dest_y,
+						 int32_t            width,
+						 int32_t            height,
+						 int                n_threads);
+
 /* Executive Summary: This function is a no-op that only exists
  * for historical reasons.
  *
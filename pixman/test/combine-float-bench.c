@@ -0,0 +1,145 @@
+/*
+ * Compares the float combiners of the selected implementation with the
+ * C ones, for each operator, without a mask, with a unified mask and
+ * with a component alpha mask.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+#include "pixman-private.h"
+
+#define WIDTH		1024
+#define MIN_SECONDS	0.05
+
+static const struct
+{
+    pixman_op_t	op;
+    const char *name;
+} op_list[] =
+{
+#define OP(op) { PIXMAN_OP_ ## op, #op }
+    OP (SRC), OP (OVER), OP (OVER_REVERSE), OP (IN), OP (IN_REVERSE),
+    OP (OUT), OP (OUT_REVERSE), OP (ATOP), OP (ATOP_REVERSE), OP (XOR),
+    OP (ADD), OP (SATURATE),
+    OP (DISJOINT_OVER), OP (DISJOINT_IN), OP (DISJOINT_ATOP),
+    OP (CONJOINT_OVER), OP (CONJOINT_IN), OP (CONJOINT_ATOP),
+    OP (MULTIPLY), OP (SCREEN), OP (OVERLAY), OP (DARKEN), OP (LIGHTEN),
+    OP (COLOR_DODGE), OP (COLOR_BURN), OP (HARD_LIGHT), OP (SOFT_LIGHT),
+    OP (DIFFERENCE), OP (EXCLUSION),
+    OP (HSL_HUE), OP (HSL_SATURATION), OP (HSL_COLOR), OP (HSL_LUMINOSITY),
+#undef OP
+};
+
+static pixman_combine_float_func_t
+lookup_combiner (pixman_implementation_t *imp, pixman_op_t op,
+		 pixman_bool_t component_alpha, pixman_bool_t last)
+{
+    pixman_combine_float_func_t f, found = NULL;
+
+    for (; imp; imp = imp->fallback)
+    {
+	f = component_alpha? imp->combine_float_ca[op] : imp->combine_float[op];
+
+	if (f)
+	{
+	    found = f;
+	    if (!last)
+		break;
+	}
+    }
+
+    return found;
+}
+
+static void
+random_pixels (argb_t *argb, int width)
+{
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	argb[i].a = prng_rand_n (0x10000) / 65535.0f;
+	argb[i].r = prng_rand_n (0x10000) / 65535.0f * argb[i].a;
+	argb[i].g = prng_rand_n (0x10000) / 65535.0f * argb[i].a;
+	argb[i].b = prng_rand_n (0x10000) / 65535.0f * argb[i].a;
+    }
+}
+
+/* Nanoseconds per pixel */
+static double
+bench (pixman_implementation_t *imp, pixman_op_t op,
+       pixman_combine_float_func_t combiner,
+       argb_t *dest, const argb_t *src, const argb_t *mask)
+{
+    double start, elapsed;
+    int n = 0;
+
+    start = gettime ();
+
+    do
+    {
+	/* Keep the destination from drifting towards values where the
+	 * combiners take different paths than with real images.
+	 */
+	if ((n & 63) == 0)
+	    random_pixels (dest, WIDTH);
+
+	combiner (imp, op, (float *)dest, (const float *)src,
+		  (const float *)mask, WIDTH);
+	n++;
+
+	elapsed = gettime () - start;
+    }
+    while (elapsed < MIN_SECONDS);
+
+    return elapsed / n / WIDTH * 1e9;
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const char *mask_names[] = { "none", "unified", "component" };
+    pixman_implementation_t *imp;
+    argb_t *src, *mask, *dest;
+    int i, m;
+
+    imp = _pixman_internal_only_get_implementation ();
+
+    src = malloc (WIDTH * sizeof (argb_t));
+    mask = malloc (WIDTH * sizeof (argb_t));
+    dest = malloc (WIDTH * sizeof (argb_t));
+
+    prng_srand (0);
+    random_pixels (src, WIDTH);
+    random_pixels (mask, WIDTH);
+
+    printf ("# %d pixel float combines, ns per pixel\n", WIDTH);
+    printf ("# %-16s %-10s %8s %8s %8s\n",
+	    "operator", "mask", "C", "selected", "speedup");
+
+    for (i = 0; i < ARRAY_LENGTH (op_list); ++i)
+    {
+	for (m = 0; m < 3; ++m)
+	{
+	    pixman_combine_float_func_t c, selected;
+	    double t_c, t_selected;
+
+	    c = lookup_combiner (imp, op_list[i].op, m == 2, TRUE);
+	    selected = lookup_combiner (imp, op_list[i].op, m == 2, FALSE);
+
+	    t_c = bench (imp, op_list[i].op, c, dest, src, m? mask : NULL);
+	    t_selected = bench (imp, op_list[i].op, selected,
+				dest, src, m? mask : NULL);
+
+	    printf ("  %-16s %-10s %8.2f %8.2f %7.2fx\n",
+		    op_list[i].name, mask_names[m], t_c, t_selected,
+		    t_c / t_selected);
+	}
+    }
+
+    free (src);
+    free (mask);
+    free (dest);
+
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <float.h>
 #include "utils.h"
 #include <sys/types.h>
 #include "pixman-private.h"
@@ -110,6 +112,139 @@ lookup_combiner (pixman_implementation_t *imp, pixman_op_t op,
     return f;
 }
 
+/* The combiner of the last implementation in the chain that has one,
+ * which is the plain C version.
+ */
+static pixman_combine_float_func_t
+lookup_c_combiner (pixman_implementation_t *imp, pixman_op_t op,
+		   pixman_bool_t component_alpha)
+{
+    pixman_combine_float_func_t f, c = NULL;
+
+    for (; imp; imp = imp->fallback)
+    {
+	if (component_alpha)
+	    f = imp->combine_float_ca[op];
+	else
+	    f = imp->combine_float[op];
+
+	if (f)
+	    c = f;
+    }
+
+    return c;
+}
+
+static pixman_bool_t
+same_float (float a, float b)
+{
+    if (a != a && b != b)
+	return TRUE;
+
+    return memcmp (&a, &b, sizeof (float)) == 0;
+}
+
+/* Optimized combiners must give exactly the same results as the C
+ * ones, other than in the payloads of NaNs. That can only be expected
+ * when the C code doesn't keep intermediate results at a higher
+ * precision.
+ */
+static int
+check_combiner (pixman_implementation_t *impl, pixman_op_t op, int ca,
+		pixman_combine_float_func_t combiner,
+		const argb_t *src, const argb_t *mask, const argb_t *dest)
+{
+    pixman_combine_float_func_t c_combiner;
+    argb_t *expected, *result;
+    int n_failures = 0;
+    int n, i;
+
+    c_combiner = lookup_c_combiner (impl, op, ca);
+
+    if (combiner == c_combiner || FLT_EVAL_METHOD != 0)
+	return 0;
+
+    expected = malloc (WIDTH * sizeof (argb_t));
+    result = malloc (WIDTH * sizeof (argb_t));
+
+    /* All widths up to a few pixels, to cover the loop tails */
+    for (n = 1; n <= WIDTH; n = (n < 8)? n + 1 : n * 4)
+    {
+	const float *m;
+
+	for (m = NULL; ; m = (const float *)mask)
+	{
+	    memcpy (expected, dest, n * sizeof (argb_t));
+	    memcpy (result, dest, n * sizeof (argb_t));
+
+	    c_combiner (impl, op, (float *)expected, (const float *)src, m, n);
+	    combiner (impl, op, (float *)result, (const float *)src, m, n);
+
+	    for (i = 0; i < n; ++i)
+	    {
+		if (!same_float (expected[i].a, result[i].a)	||
+		    !same_float (expected[i].r, result[i].r)	||
+		    !same_float (expected[i].g, result[i].g)	||
+		    !same_float (expected[i].b, result[i].b))
+		{
+		    printf ("op %d%s%s, pixel %d of %d: "
+			    "%.9g %.9g %.9g %.9g, expected %.9g %.9g %.9g %.9g\n",
+			    op, ca? " ca" : "", m? " with mask" : "", i, n,
+			    result[i].a, result[i].r, result[i].g, result[i].b,
+			    expected[i].a, expected[i].r,
+			    expected[i].g, expected[i].b);
+		    n_failures++;
+		    break;
+		}
+	    }
+
+	    if (m)
+		break;
+	}
+    }
+
+    free (expected);
+    free (result);
+
+    return n_failures;
+}
+
+/* Random pixels that are mostly within the range that real images use,
+ * with some values outside of it and some exact zeros and ones, which
+ * is where the combiners branch.
+ */
+static float
+rand_channel (void)
+{
+    switch (prng_rand_n (8))
+    {
+    case 0:
+	return 0.0f;
+    case 1:
+	return 1.0f;
+    case 2:
+	return (int)prng_rand_n (1024) / 256.0f - 2.0f;
+    default:
+	return prng_rand_n (0x10000) / 65535.0f;
+    }
+}
+
+static void
+random_pixels (argb_t *argb, int width)
+{
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	argb_t *p = argb + i;
+
+	p->a = rand_channel ();
+	p->r = rand_channel () * p->a;
+	p->g = rand_channel () * p->a;
+	p->b = rand_channel () * p->a;
+    }
+}
+
 int
 main ()
 {
@@ -117,6 +252,7 @@ main ()
     argb_t *src_bytes = malloc (WIDTH * sizeof (argb_t));
     argb_t *mask_bytes = malloc (WIDTH * sizeof (argb_t));
     argb_t *dest_bytes = malloc (WIDTH * sizeof (argb_t));
+    int n_failures = 0;
     int i;
 
     enable_divbyzero_exceptions();
@@ -144,8 +280,26 @@ main ()
 		      (float *)mask_bytes,
 		      (float *)src_bytes,
 		      WIDTH);
+
+	    random_floats (src_bytes, WIDTH);
+	    random_floats (mask_bytes, WIDTH);
+	    random_floats (dest_bytes, WIDTH);
+
+	    n_failures += check_combiner (impl, op, ca, combiner,
+					  src_bytes, mask_bytes, dest_bytes);
+
+	    random_pixels (src_bytes, WIDTH);
+	    random_pixels (mask_bytes, WIDTH);
+	    random_pixels (dest_bytes, WIDTH);
+
+	    n_failures += check_combiner (impl, op, ca, combiner,
+					  src_bytes, mask_bytes, dest_bytes);
 	}
-    }	
+    }
+
+    free (src_bytes);
+    free (mask_bytes);
+    free (dest_bytes);
 
-    return 0;
+    return n_failures? 1 : 0;
 }
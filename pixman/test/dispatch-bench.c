@@ -0,0 +1,150 @@
+/*
+ * Measures the cost of small composites, where finding the composite
+ * function is a large part of the work. Each run cycles through a
+ * number of different operator and format combinations; with more of
+ * them than the per-thread cache of recently used fast paths holds,
+ * every composite has to look its fast path up again.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+#define MIN_SECONDS	0.2
+#define N_IMAGES	8
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_SRC, PIXMAN_OP_OVER, PIXMAN_OP_ADD, PIXMAN_OP_IN
+};
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8, PIXMAN_x8r8g8b8, PIXMAN_r5g6b5, PIXMAN_a8,
+    PIXMAN_a8b8g8r8, PIXMAN_b8g8r8a8, PIXMAN_a1r5g5b5, PIXMAN_r8g8b8
+};
+
+typedef struct
+{
+    pixman_op_t		op;
+    pixman_image_t *	src;
+    pixman_image_t *	mask;
+    pixman_image_t *	dest;
+} combination_t;
+
+static pixman_image_t *
+create_image (pixman_format_code_t format)
+{
+    pixman_image_t *image;
+    uint32_t *bits;
+    int i;
+
+    image = pixman_image_create_bits (format, 16, 16, NULL, -1);
+    bits = pixman_image_get_data (image);
+
+    for (i = 0; i < 16 * pixman_image_get_stride (image) / 4; ++i)
+	bits[i] = prng_rand ();
+
+    return image;
+}
+
+static void
+make_combination (combination_t *c, pixman_image_t **images, int i)
+{
+    static const pixman_color_t color = { 0x8000, 0x4000, 0x2000, 0xc000 };
+
+    c->op = ops[i % ARRAY_LENGTH (ops)];
+    c->dest = pixman_image_ref (images[(i / 4) % N_IMAGES]);
+
+    switch ((i / 32) % 3)
+    {
+    case 0:
+	c->src = pixman_image_ref (images[(i * 3 + 1) % N_IMAGES]);
+	c->mask = NULL;
+	break;
+
+    case 1:
+	c->src = pixman_image_create_solid_fill (&color);
+	c->mask = pixman_image_ref (images[3]);
+	break;
+
+    default:
+	c->src = pixman_image_ref (images[(i * 5 + 2) % N_IMAGES]);
+	c->mask = pixman_image_ref (images[3]);
+	break;
+    }
+}
+
+/* Nanoseconds per composite */
+static double
+bench (const combination_t *combinations, int n_combinations, int size)
+{
+    double start, elapsed;
+    int n = 0, i;
+
+    start = gettime ();
+
+    do
+    {
+	for (i = 0; i < n_combinations; ++i)
+	{
+	    const combination_t *c = &combinations[i];
+
+	    pixman_image_composite32 (c->op, c->src, c->mask, c->dest,
+				      0, 0, 0, 0, 0, 0, size, size);
+	}
+
+	n += n_combinations;
+	elapsed = gettime () - start;
+    }
+    while (elapsed < MIN_SECONDS);
+
+    return elapsed / n * 1e9;
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const int sizes[] = { 1, 2, 4, 8, 16 };
+    static const int counts[] = { 1, 4, 16, 64, 96 };
+    pixman_image_t *images[N_IMAGES];
+    combination_t combinations[96];
+    int i, j;
+
+    prng_srand (0);
+
+    for (i = 0; i < N_IMAGES; ++i)
+	images[i] = create_image (formats[i]);
+
+    for (i = 0; i < ARRAY_LENGTH (combinations); ++i)
+	make_combination (&combinations[i], images, i);
+
+    printf ("# ns per composite, cycling through N combinations of "
+	    "operator and formats\n");
+    printf ("# %-6s", "size");
+    for (j = 0; j < ARRAY_LENGTH (counts); ++j)
+	printf (" %8s%-3d", "N = ", counts[j]);
+    printf ("\n");
+
+    for (i = 0; i < ARRAY_LENGTH (sizes); ++i)
+    {
+	printf ("  %2dx%-3d", sizes[i], sizes[i]);
+
+	for (j = 0; j < ARRAY_LENGTH (counts); ++j)
+	    printf (" %11.1f", bench (combinations, counts[j], sizes[i]));
+
+	printf ("\n");
+    }
+
+    for (i = 0; i < ARRAY_LENGTH (combinations); ++i)
+    {
+	pixman_image_unref (combinations[i].src);
+	if (combinations[i].mask)
+	    pixman_image_unref (combinations[i].mask);
+	pixman_image_unref (combinations[i].dest);
+    }
+
+    for (i = 0; i < N_IMAGES; ++i)
+	pixman_image_unref (images[i]);
+
+    return 0;
+}
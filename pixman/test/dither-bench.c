@@ -0,0 +1,113 @@
+/*
+ * Measures compositing a linear gradient into dithered destinations.
+ * PIXMAN_DITHER_BEST always goes through the wide pipeline, and uses
+ * the same blue noise thresholds as PIXMAN_DITHER_ORDERED_BLUE_NOISE_64,
+ * so comparing the two shows what the narrow dithering path gains for
+ * destinations with less than 8 bits per channel. Run with
+ * PIXMAN_DISABLE="sse2 avx2" to compare with the C write-back.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "utils.h"
+
+#define WIDTH		1024
+#define HEIGHT		64
+#define MIN_SECONDS	0.2
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_r5g6b5, PIXMAN_x1r5g5b5, PIXMAN_a2r10g10b10, PIXMAN_x2r10g10b10
+};
+
+static const pixman_dither_t dithers[] =
+{
+    PIXMAN_DITHER_NONE,
+    PIXMAN_DITHER_BEST,
+    PIXMAN_DITHER_ORDERED_BAYER_8,
+    PIXMAN_DITHER_ORDERED_BLUE_NOISE_64
+};
+
+static const char *dither_names[] =
+{
+    "none", "best", "bayer", "blue-noise"
+};
+
+static pixman_image_t *
+create_gradient (void)
+{
+    static const pixman_gradient_stop_t stops[] =
+    {
+	{ pixman_int_to_fixed (0), { 0x0000, 0x2000, 0x4000, 0xffff } },
+	{ pixman_int_to_fixed (1), { 0xffff, 0xc000, 0x8000, 0xffff } },
+    };
+    pixman_point_fixed_t p1 = { 0, 0 };
+    pixman_point_fixed_t p2 = { pixman_int_to_fixed (WIDTH), 0 };
+
+    return pixman_image_create_linear_gradient (&p1, &p2, stops,
+						ARRAY_LENGTH (stops));
+}
+
+/* Nanoseconds per pixel */
+static double
+bench (pixman_op_t op, pixman_image_t *src, pixman_image_t *dest)
+{
+    double start, elapsed;
+    int n = 0;
+
+    start = gettime ();
+
+    do
+    {
+	pixman_image_composite32 (op, src, NULL, dest,
+				  0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+	n++;
+	elapsed = gettime () - start;
+    }
+    while (elapsed < MIN_SECONDS);
+
+    return elapsed / n / (WIDTH * HEIGHT) * 1e9;
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const pixman_op_t ops[] = { PIXMAN_OP_SRC, PIXMAN_OP_OVER };
+    pixman_image_t *src;
+    int f, o, d;
+
+    src = create_gradient ();
+
+    printf ("# %dx%d linear gradient composites, ns per pixel\n", WIDTH, HEIGHT);
+    printf ("# %-4s %-12s", "op", "dest");
+    for (d = 0; d < ARRAY_LENGTH (dithers); ++d)
+	printf (" %10s", dither_names[d]);
+    printf ("\n");
+
+    for (o = 0; o < ARRAY_LENGTH (ops); ++o)
+    {
+	for (f = 0; f < ARRAY_LENGTH (formats); ++f)
+	{
+	    pixman_image_t *dest = pixman_image_create_bits (
+		formats[f], WIDTH, HEIGHT, NULL, -1);
+
+	    printf ("  %-4s %-12s",
+		    operator_name (ops[o]) + strlen ("PIXMAN_OP_"),
+		    format_name (formats[f]));
+
+	    for (d = 0; d < ARRAY_LENGTH (dithers); ++d)
+	    {
+		pixman_image_set_dither (dest, dithers[d]);
+		printf (" %10.2f", bench (ops[o], src, dest));
+	    }
+
+	    printf ("\n");
+
+	    pixman_image_unref (dest);
+	}
+    }
+
+    pixman_image_unref (src);
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * Measures pixman_composite_glyphs() on terminal-style runs: a line of
+ * non-overlapping glyphs drawn with a solid source. Each run is also
+ * drawn the way it would be without the direct path, through a glyph
+ * mask the size of the run, and the two results are compared.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "utils.h"
+
+#define MIN_SECONDS	0.2
+#define GLYPH_WIDTH	8
+#define GLYPH_HEIGHT	16
+#define N_GLYPH_IMAGES	64
+#define DEST_WIDTH	1024
+#define DEST_HEIGHT	64
+
+static pixman_image_t *
+create_glyph (pixman_format_code_t format)
+{
+    pixman_image_t *image;
+    uint32_t *bits;
+    int i;
+
+    image = pixman_image_create_bits (format, GLYPH_WIDTH, GLYPH_HEIGHT, NULL, -1);
+    bits = pixman_image_get_data (image);
+
+    for (i = 0; i < GLYPH_HEIGHT * pixman_image_get_stride (image) / 4; ++i)
+	bits[i] = prng_rand () & prng_rand ();
+
+    return image;
+}
+
+static void
+composite_masked (pixman_op_t op, pixman_image_t *src, pixman_image_t *dest,
+		  pixman_format_code_t mask_format, pixman_glyph_cache_t *cache,
+		  int n_glyphs, const pixman_glyph_t *glyphs, int width)
+{
+    static const pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_image_t *white_img, *mask;
+
+    white_img = pixman_image_create_solid_fill (&white);
+    mask = pixman_image_create_bits (mask_format, width, GLYPH_HEIGHT, NULL, -1);
+
+    if (PIXMAN_FORMAT_RGB (mask_format))
+	pixman_image_set_component_alpha (mask, TRUE);
+
+    pixman_composite_glyphs_no_mask (PIXMAN_OP_ADD, white_img, mask,
+				     0, 0, 0, 0, cache, n_glyphs, glyphs);
+    pixman_image_composite32 (op, src, mask, dest,
+			      0, 0, 0, 0, 0, 0, width, GLYPH_HEIGHT);
+
+    pixman_image_unref (mask);
+    pixman_image_unref (white_img);
+}
+
+/* Nanoseconds per glyph */
+static double
+bench (pixman_bool_t direct, pixman_op_t op,
+       pixman_image_t *src, pixman_image_t *dest,
+       pixman_format_code_t mask_format, pixman_glyph_cache_t *cache,
+       int n_glyphs, const pixman_glyph_t *glyphs)
+{
+    int width = n_glyphs * GLYPH_WIDTH;
+    double start, elapsed;
+    int n = 0;
+
+    start = gettime ();
+
+    do
+    {
+	if (direct)
+	{
+	    pixman_composite_glyphs (op, src, dest, mask_format,
+				     0, 0, 0, 0, 0, 0, width, GLYPH_HEIGHT,
+				     cache, n_glyphs, glyphs);
+	}
+	else
+	{
+	    composite_masked (op, src, dest, mask_format,
+			      cache, n_glyphs, glyphs, width);
+	}
+
+	n++;
+	elapsed = gettime () - start;
+    }
+    while (elapsed < MIN_SECONDS);
+
+    return elapsed / n / n_glyphs * 1e9;
+}
+
+static pixman_bool_t
+results_match (pixman_op_t op, pixman_image_t *src,
+	       pixman_format_code_t dest_format, pixman_format_code_t mask_format,
+	       pixman_glyph_cache_t *cache, int n_glyphs,
+	       const pixman_glyph_t *glyphs)
+{
+    int width = n_glyphs * GLYPH_WIDTH;
+    pixman_image_t *a, *b;
+    pixman_bool_t match;
+    uint32_t *bits;
+    int i;
+
+    a = pixman_image_create_bits (dest_format, DEST_WIDTH, DEST_HEIGHT, NULL, -1);
+    b = pixman_image_create_bits (dest_format, DEST_WIDTH, DEST_HEIGHT, NULL, -1);
+
+    bits = pixman_image_get_data (a);
+    for (i = 0; i < DEST_HEIGHT * pixman_image_get_stride (a) / 4; ++i)
+	bits[i] = prng_rand ();
+    memcpy (pixman_image_get_data (b), bits,
+	    DEST_HEIGHT * pixman_image_get_stride (a));
+
+    pixman_composite_glyphs (op, src, a, mask_format,
+			     0, 0, 0, 0, 0, 0, width, GLYPH_HEIGHT,
+			     cache, n_glyphs, glyphs);
+    composite_masked (op, src, b, mask_format, cache, n_glyphs, glyphs, width);
+
+    match = compute_crc32_for_image (0, a) == compute_crc32_for_image (0, b);
+
+    pixman_image_unref (a);
+    pixman_image_unref (b);
+
+    return match;
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const pixman_format_code_t glyph_formats[] =
+    {
+	PIXMAN_a8, PIXMAN_a8r8g8b8
+    };
+    static const pixman_format_code_t dest_formats[] =
+    {
+	PIXMAN_x8r8g8b8, PIXMAN_a8r8g8b8
+    };
+    static const pixman_op_t ops[] = { PIXMAN_OP_OVER, PIXMAN_OP_ADD };
+    static const int run_lengths[] = { 1, 4, 16, 80 };
+    static const pixman_color_t color = { 0xc000, 0x8000, 0x4000, 0xffff };
+    pixman_glyph_t glyphs[80];
+    pixman_image_t *src;
+    int failures = 0;
+    int g, d, o, r, i;
+
+    prng_srand (0);
+
+    src = pixman_image_create_solid_fill (&color);
+
+    printf ("# ns per glyph, %dx%d glyphs in a single line\n",
+	    GLYPH_WIDTH, GLYPH_HEIGHT);
+    printf ("# %-4s %-9s %-9s %4s %9s %9s %8s\n",
+	    "op", "glyph", "dest", "run", "masked", "direct", "speedup");
+
+    for (g = 0; g < ARRAY_LENGTH (glyph_formats); ++g)
+    {
+	pixman_glyph_cache_t *cache = pixman_glyph_cache_create ();
+	pixman_image_t *images[N_GLYPH_IMAGES];
+
+	pixman_glyph_cache_freeze (cache);
+
+	for (i = 0; i < N_GLYPH_IMAGES; ++i)
+	{
+	    images[i] = create_glyph (glyph_formats[g]);
+	    pixman_glyph_cache_insert (cache, cache, images[i], 0, 12, images[i]);
+	}
+
+	for (i = 0; i < ARRAY_LENGTH (glyphs); ++i)
+	{
+	    glyphs[i].glyph = pixman_glyph_cache_lookup (
+		cache, cache, images[prng_rand_n (N_GLYPH_IMAGES)]);
+	    glyphs[i].x = i * GLYPH_WIDTH;
+	    glyphs[i].y = 12;
+	}
+
+	for (d = 0; d < ARRAY_LENGTH (dest_formats); ++d)
+	{
+	    pixman_image_t *dest = pixman_image_create_bits (
+		dest_formats[d], DEST_WIDTH, DEST_HEIGHT, NULL, -1);
+
+	    for (o = 0; o < ARRAY_LENGTH (ops); ++o)
+	    {
+		for (r = 0; r < ARRAY_LENGTH (run_lengths); ++r)
+		{
+		    int n = run_lengths[r];
+		    double t_masked, t_direct;
+
+		    if (!results_match (ops[o], src, dest_formats[d],
+					glyph_formats[g], cache, n, glyphs))
+		    {
+			failures++;
+		    }
+
+		    t_masked = bench (FALSE, ops[o], src, dest,
+				      glyph_formats[g], cache, n, glyphs);
+		    t_direct = bench (TRUE, ops[o], src, dest,
+				      glyph_formats[g], cache, n, glyphs);
+
+		    printf ("  %-4s %-9s %-9s %4d %9.1f %9.1f %7.2fx\n",
+			    operator_name (ops[o]) + strlen ("PIXMAN_OP_"),
+			    format_name (glyph_formats[g]),
+			    format_name (dest_formats[d]),
+			    n, t_masked, t_direct, t_masked / t_direct);
+		}
+	    }
+
+	    pixman_image_unref (dest);
+	}
+
+	pixman_glyph_cache_thaw (cache);
+
+	for (i = 0; i < N_GLYPH_IMAGES; ++i)
+	{
+	    pixman_glyph_cache_remove (cache, cache, images[i]);
+	    pixman_image_unref (images[i]);
+	}
+
+	pixman_glyph_cache_destroy (cache);
+    }
+
+    pixman_image_unref (src);
+
+    if (failures)
+	printf ("%d runs differ from the masked result\n", failures);
+
+    return failures != 0;
+}
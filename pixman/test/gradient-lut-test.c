@@ -0,0 +1,190 @@
+/*
+ * Checks that compositing a large area of a gradient, which reads the
+ * colors from a table, gives the same pixels as compositing it one row
+ * at a time, which evaluates the gradient directly, to within one unit.
+ *
+ * The angle of conical gradients is approximated when reading from the
+ * table, so pixels on the line where the gradient wraps around from 1
+ * to 0 may come out on either side of it; one such pixel is allowed
+ * per row.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+#define N_TESTS		300
+#define SIZE		128
+#define TOLERANCE	1
+
+static pixman_image_t *
+create_gradient (int type, pixman_repeat_t repeat, uint32_t seed)
+{
+    pixman_gradient_stop_t stops[6];
+    pixman_image_t *image;
+    int n_stops, i;
+
+    prng_srand (seed);
+
+    n_stops = 2 + prng_rand_n (ARRAY_LENGTH (stops) - 1);
+    for (i = 0; i < n_stops; ++i)
+    {
+	stops[i].x = i * pixman_fixed_1 / (n_stops - 1);
+	if (i > 0 && i < n_stops - 1)
+	    stops[i].x += prng_rand_n (0x1000) - 0x800;
+
+	stops[i].color.red = prng_rand_n (0x10000);
+	stops[i].color.green = prng_rand_n (0x10000);
+	stops[i].color.blue = prng_rand_n (0x10000);
+	stops[i].color.alpha = prng_rand_n (0x10000);
+    }
+
+    if (type == 0)
+    {
+	pixman_point_fixed_t p1, p2;
+
+	p1.x = prng_rand_n (SIZE << 16);
+	p1.y = prng_rand_n (SIZE << 16);
+	p2.x = prng_rand_n (3 * SIZE << 16) - (SIZE << 16);
+	p2.y = prng_rand_n (3 * SIZE << 16) - (SIZE << 16);
+
+	image = pixman_image_create_linear_gradient (&p1, &p2, stops, n_stops);
+    }
+    else if (type == 1)
+    {
+	pixman_point_fixed_t c1, c2;
+
+	c1.x = prng_rand_n (SIZE << 16);
+	c1.y = prng_rand_n (SIZE << 16);
+	c2.x = prng_rand_n (SIZE << 16);
+	c2.y = prng_rand_n (SIZE << 16);
+
+	image = pixman_image_create_radial_gradient (
+	    &c1, &c2, prng_rand_n (SIZE / 4 << 16), prng_rand_n (SIZE << 16),
+	    stops, n_stops);
+    }
+    else
+    {
+	pixman_point_fixed_t center;
+
+	center.x = prng_rand_n (SIZE << 16);
+	center.y = prng_rand_n (SIZE << 16);
+
+	image = pixman_image_create_conical_gradient (
+	    &center, prng_rand_n (360 << 16), stops, n_stops);
+    }
+
+    pixman_image_set_repeat (image, repeat);
+
+    if (prng_rand_n (2))
+    {
+	pixman_transform_t transform;
+
+	pixman_transform_init_rotate (&transform,
+				      pixman_double_to_fixed (0.6),
+				      pixman_double_to_fixed (0.8));
+	pixman_transform_scale (&transform, NULL,
+				pixman_double_to_fixed (0.75),
+				pixman_double_to_fixed (1.5));
+	pixman_image_set_transform (image, &transform);
+    }
+
+    return image;
+}
+
+static int
+channel_diff (uint32_t a, uint32_t b)
+{
+    int c, max = 0;
+
+    for (c = 0; c < 32; c += 8)
+    {
+	int d = abs ((int)((a >> c) & 0xff) - (int)((b >> c) & 0xff));
+
+	if (d > max)
+	    max = d;
+    }
+
+    return max;
+}
+
+static int
+test_one (int testno)
+{
+    static const char *names[] = { "linear", "radial", "conical" };
+    int type = testno % 3;
+    pixman_repeat_t repeat = (testno / 3) % 4;
+    pixman_image_t *table, *direct, *whole, *rows;
+    uint32_t *whole_bits, *rows_bits;
+    int x, y, n_off, failed = 0;
+
+    table = create_gradient (type, repeat, testno);
+    direct = create_gradient (type, repeat, testno);
+
+    whole = pixman_image_create_bits (PIXMAN_a8r8g8b8, SIZE, SIZE, NULL, -1);
+    rows = pixman_image_create_bits (PIXMAN_a8r8g8b8, SIZE, SIZE, NULL, -1);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, table, NULL, whole,
+			      0, 0, 0, 0, 0, 0, SIZE, SIZE);
+
+    for (y = 0; y < SIZE; ++y)
+    {
+	pixman_image_composite32 (PIXMAN_OP_SRC, direct, NULL, rows,
+				  0, y, 0, 0, 0, y, SIZE, 1);
+    }
+
+    whole_bits = pixman_image_get_data (whole);
+    rows_bits = pixman_image_get_data (rows);
+
+    for (y = 0; y < SIZE; ++y)
+    {
+	n_off = 0;
+
+	for (x = 0; x < SIZE; ++x)
+	{
+	    uint32_t a = whole_bits[y * SIZE + x];
+	    uint32_t b = rows_bits[y * SIZE + x];
+
+	    if (channel_diff (a, b) <= TOLERANCE)
+		continue;
+
+	    if (type == 2 && n_off++ == 0)
+		continue;
+
+	    printf ("test %d: %s repeat %d: (%d, %d) is %08x from the table, "
+		    "%08x evaluated directly\n",
+		    testno, names[type], repeat, x, y, a, b);
+	    failed = 1;
+	    break;
+	}
+
+	if (failed)
+	    break;
+    }
+
+    pixman_image_unref (table);
+    pixman_image_unref (direct);
+    pixman_image_unref (whole);
+    pixman_image_unref (rows);
+
+    return failed;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    int i, n_failures = 0;
+
+    for (i = 0; i < N_TESTS; ++i)
+    {
+	if (test_one (i))
+	    n_failures++;
+    }
+
+    if (n_failures)
+    {
+	printf ("%d of %d tests failed\n", n_failures, N_TESTS);
+	return 1;
+    }
+
+    return 0;
+}
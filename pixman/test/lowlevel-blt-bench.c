@@ -1037,6 +1037,8 @@ print_explanation (void)
     printf ("Benchmark for a set of most commonly used functions\n");
     printf ("---\n");
     printf ("All results are presented in millions of pixels per second\n");
+    if (getenv ("PIXMAN_DISABLE"))
+	printf ("Disabled implementations: %s\n", getenv ("PIXMAN_DISABLE"));
     printf ("L1  - small Xx1 rectangle (fitting L1 cache), always blitted at the same\n");
     printf ("      memory location with small drift in horizontal direction\n");
     printf ("L2  - small XxY rectangle (fitting L2 cache), always blitted at the same\n");
@@ -1086,11 +1088,13 @@ print_speed_scaling (double bw)
 static void
 usage (const char *progname)
 {
-    printf ("Usage: %s [-b] [-n] [-c] [-m M] pattern\n", progname);
+    printf ("Usage: %s [-b] [-n] [-c] [-m M] [-d impl] pattern\n", progname);
     printf ("  -n : benchmark nearest scaling\n");
     printf ("  -b : benchmark bilinear scaling\n");
     printf ("  -c : print output as CSV data\n");
     printf ("  -m M : set reference memcpy speed to M MB/s instead of measuring it\n");
+    printf ("  -d impl : disable the comma separated implementations (e.g. avx2),\n");
+    printf ("            to compare against the default run\n");
 }
 
 int
@@ -1119,6 +1123,8 @@ main (int argc, char *argv[])
 
 	    if (strcmp (argv[i], "-m") == 0 && i + 1 < argc)
 		bandwidth = atof (argv[++i]) * 1e6;
+	    else if (strcmp (argv[i], "-d") == 0 && i + 1 < argc)
+		restart_with_disabled_implementations (argv, argv[++i]);
 	}
 	else
 	{
@@ -1,37 +1,34 @@
 #include "utils.h"
 #include <stdio.h>
 
-int
-main ()
+#define N_COMPOSITE	500
+
+static const pixman_gradient_stop_t stops[] = {
+    { 0x00000, { 0x6666, 0x6666, 0x6666, 0xffff } },
+    { 0x10000, { 0x0000, 0x0000, 0x0000, 0xffff } }
+};
+
+static const pixman_gradient_stop_t rainbow[] = {
+    { 0x00000, { 0xffff, 0x0000, 0x0000, 0xffff } },
+    { 0x04000, { 0xffff, 0xffff, 0x0000, 0xc000 } },
+    { 0x08000, { 0x0000, 0xffff, 0x0000, 0xffff } },
+    { 0x0c000, { 0x0000, 0x0000, 0xffff, 0x8000 } },
+    { 0x10000, { 0xffff, 0x0000, 0x0000, 0xffff } }
+};
+
+static void
+run (const char *name, pixman_image_t *gradient,
+     int src_x, int src_y, int width, int height)
 {
-    static const pixman_point_fixed_t inner = { 0x0000, 0x0000 };
-    static const pixman_point_fixed_t outer = { 0x0000, 0x0000 };
-    static const pixman_fixed_t r_inner = 0;
-    static const pixman_fixed_t r_outer = 64 << 16;
-    static const pixman_gradient_stop_t stops[] = {
-	{ 0x00000, { 0x6666, 0x6666, 0x6666, 0xffff } },
-	{ 0x10000, { 0x0000, 0x0000, 0x0000, 0xffff } }
-    };
-    static const pixman_transform_t transform = {
-	{ { 0x0,        0x26ee, 0x0}, 
-	  { 0xffffeeef, 0x0,    0x0}, 
-	  { 0x0,        0x0,    0x10000}
-	}
-    };
     static const pixman_color_t z = { 0x0000, 0x0000, 0x0000, 0x0000 };
-    pixman_image_t *dest, *radial, *zero;
+    pixman_image_t *dest, *zero;
+    char filename[64];
     int i;
     double before, after;
 
     dest = pixman_image_create_bits (
 	PIXMAN_x8r8g8b8, 640, 429, NULL, -1);
     zero = pixman_image_create_solid_fill (&z);
-    radial = pixman_image_create_radial_gradient (
-	&inner, &outer, r_inner, r_outer, stops, ARRAY_LENGTH (stops));
-    pixman_image_set_transform (radial, &transform);
-    pixman_image_set_repeat (radial, PIXMAN_REPEAT_PAD);
-
-#define N_COMPOSITE	500
 
     before = gettime();
     for (i = 0; i < N_COMPOSITE; ++i)
@@ -45,14 +42,61 @@ main ()
 	before += gettime();
 
 	pixman_image_composite32 (
-	    PIXMAN_OP_OVER, radial, NULL, dest,
-	    - 150, -158, 0, 0, 0, 0, 640, 361);
+	    PIXMAN_OP_OVER, gradient, NULL, dest,
+	    src_x, src_y, 0, 0, 0, 0, width, height);
     }
 
     after = gettime();
 
-    write_png (dest, "radial.png");
+    snprintf (filename, sizeof (filename), "%s.png", name);
+    write_png (dest, filename);
+
+    printf ("Average time to composite %s: %f\n",
+	    name, (after - before) / N_COMPOSITE);
+
+    pixman_image_unref (gradient);
+    pixman_image_unref (zero);
+    pixman_image_unref (dest);
+}
+
+int
+main ()
+{
+    static const pixman_point_fixed_t inner = { 0x0000, 0x0000 };
+    static const pixman_point_fixed_t outer = { 0x0000, 0x0000 };
+    static const pixman_fixed_t r_inner = 0;
+    static const pixman_fixed_t r_outer = 64 << 16;
+    static const pixman_transform_t transform = {
+	{ { 0x0,        0x26ee, 0x0},
+	  { 0xffffeeef, 0x0,    0x0},
+	  { 0x0,        0x0,    0x10000}
+	}
+    };
+    static const pixman_point_fixed_t p1 = { 0x0000, 0x0000 };
+    static const pixman_point_fixed_t p2 = { 90 << 16, 30 << 16 };
+    static const pixman_point_fixed_t center = { 320 << 16, 214 << 16 };
+    pixman_image_t *radial, *linear, *conical;
+
+    radial = pixman_image_create_radial_gradient (
+	&inner, &outer, r_inner, r_outer, stops, ARRAY_LENGTH (stops));
+    pixman_image_set_transform (radial, &transform);
+    pixman_image_set_repeat (radial, PIXMAN_REPEAT_PAD);
+
+    run ("radial", radial, -150, -158, 640, 361);
+
+    /* A slanted multi-stop gradient repeated a few times across the
+     * destination
+     */
+    linear = pixman_image_create_linear_gradient (
+	&p1, &p2, rainbow, ARRAY_LENGTH (rainbow));
+    pixman_image_set_repeat (linear, PIXMAN_REPEAT_REFLECT);
+
+    run ("linear", linear, 0, 0, 640, 429);
+
+    conical = pixman_image_create_conical_gradient (
+	&center, 30 << 16, rainbow, ARRAY_LENGTH (rainbow));
+
+    run ("conical", conical, 0, 0, 640, 429);
 
-    printf ("Average time to composite: %f\n", (after - before) / N_COMPOSITE);
     return 0;
 }
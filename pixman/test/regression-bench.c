@@ -0,0 +1,662 @@
+/*
+ * Runs a fixed matrix of composites (operator, formats, size, source
+ * transform and filter) on each implementation level and reports the
+ * throughput of each one as CSV or JSON. Given the CSV output of an
+ * earlier run as a baseline, it also reports which cases got
+ * significantly faster or slower, and exits with status 1 if any got
+ * slower.
+ *
+ * Each level runs in a child process started with PIXMAN_DISABLE set
+ * to turn off all implementations above it. Levels that the CPU
+ * doesn't support are skipped.
+ *
+ *     regression-bench -f csv > baseline.csv
+ *     ... upgrade pixman ...
+ *     regression-bench -b baseline.csv
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "utils.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+#define MAX_RESULTS	4096
+#define MAX_SAMPLES	15
+
+typedef struct
+{
+    const char *	name;
+    const char *	disable;
+} level_t;
+
+#define ALL_X86		"mmx sse2 ssse3 avx2"
+#define ALL_ARM		"arm-simd arm-iwmmxt arm-neon"
+#define ALL_OTHER	"vmx loongson-mmi mips-dspr2"
+
+static const level_t levels[] =
+{
+    { "general",	"fast " ALL_X86 " " ALL_ARM " " ALL_OTHER },
+    { "fast",		ALL_X86 " " ALL_ARM " " ALL_OTHER },
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+    { "mmx",		"sse2 ssse3 avx2" },
+    { "sse2",		"ssse3 avx2" },
+    { "ssse3",		"avx2" },
+    { "avx2",		"" },
+#elif defined(__arm__) || defined(__aarch64__)
+    { "arm-simd",	"arm-iwmmxt arm-neon" },
+    { "arm-iwmmxt",	"arm-neon" },
+    { "arm-neon",	"" },
+#else
+    { "native",		"" },
+#endif
+};
+
+/* The matrix */
+static const struct
+{
+    pixman_op_t		op;
+    const char *	name;
+} ops[] =
+{
+    { PIXMAN_OP_SRC,	"src" },
+    { PIXMAN_OP_OVER,	"over" },
+    { PIXMAN_OP_ADD,	"add" },
+};
+
+static const struct
+{
+    pixman_format_code_t	src;
+    pixman_format_code_t	mask;
+    pixman_bool_t		component_alpha;
+    pixman_format_code_t	dest;
+} untransformed[] =
+{
+    { PIXMAN_a8r8g8b8,	PIXMAN_null,	  FALSE, PIXMAN_a8r8g8b8 },
+    { PIXMAN_a8r8g8b8,	PIXMAN_null,	  FALSE, PIXMAN_r5g6b5 },
+    { PIXMAN_x8r8g8b8,	PIXMAN_null,	  FALSE, PIXMAN_x8r8g8b8 },
+    { PIXMAN_r5g6b5,	PIXMAN_null,	  FALSE, PIXMAN_r5g6b5 },
+    { PIXMAN_a8,	PIXMAN_null,	  FALSE, PIXMAN_a8 },
+    { PIXMAN_a8r8g8b8,	PIXMAN_a8,	  FALSE, PIXMAN_a8r8g8b8 },
+    { PIXMAN_solid,	PIXMAN_a8,	  FALSE, PIXMAN_a8r8g8b8 },
+    { PIXMAN_solid,	PIXMAN_a8,	  FALSE, PIXMAN_r5g6b5 },
+    { PIXMAN_solid,	PIXMAN_a8r8g8b8, TRUE,	 PIXMAN_a8r8g8b8 },
+};
+
+static const struct
+{
+    pixman_format_code_t	src;
+    pixman_format_code_t	dest;
+} transformed[] =
+{
+    { PIXMAN_a8r8g8b8,	PIXMAN_a8r8g8b8 },
+    { PIXMAN_x8r8g8b8,	PIXMAN_r5g6b5 },
+};
+
+typedef enum { IDENTITY, SCALE, ROTATE } transform_type_t;
+
+static const char *transform_names[] = { "identity", "scale", "rotate" };
+
+static const struct
+{
+    pixman_filter_t	filter;
+    const char *	name;
+} filters[] =
+{
+    { PIXMAN_FILTER_NEAREST,	"nearest" },
+    { PIXMAN_FILTER_BILINEAR,	"bilinear" },
+};
+
+static const int sizes[] = { 8, 64, 512 };
+
+typedef struct
+{
+    char	level[32];
+    char	name[128];
+    double	mpix;		/* Megapixels per second, median */
+    double	stddev;		/* Percent of the mean */
+    int		n_samples;
+
+    double	base_mpix;	/* < 0 if not in the baseline */
+    double	base_stddev;
+    double	change;		/* Percent */
+    const char *status;
+} result_t;
+
+typedef struct
+{
+    double		sample_seconds;
+    int			n_samples;
+    const char *	filter;		/* Only cases containing this */
+} options_t;
+
+static void
+destroy_bits (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+make_image (pixman_format_code_t format, int size)
+{
+    static const pixman_color_t color = { 0x8000, 0x4000, 0x2000, 0xc000 };
+    pixman_image_t *image;
+    uint32_t *bits;
+    int stride, i;
+
+    if (format == PIXMAN_solid)
+	return pixman_image_create_solid_fill (&color);
+
+    stride = (size * PIXMAN_FORMAT_BPP (format) / 8 + 3) & ~3;
+    bits = malloc (stride * size);
+
+    for (i = 0; i < stride * size / 4; ++i)
+	bits[i] = prng_rand ();
+
+    image = pixman_image_create_bits (format, size, size, bits, stride);
+    pixman_image_set_destroy_function (image, destroy_bits, bits);
+
+    return image;
+}
+
+static int
+compare_doubles (const void *a, const void *b)
+{
+    double d = *(const double *)a - *(const double *)b;
+
+    return d < 0? -1 : d > 0? 1 : 0;
+}
+
+static void
+run_case (const options_t *options, const char *name,
+	  pixman_op_t op, pixman_format_code_t src_format,
+	  pixman_format_code_t mask_format, pixman_bool_t component_alpha,
+	  pixman_format_code_t dest_format,
+	  int size, transform_type_t transform_type, pixman_filter_t filter)
+{
+    pixman_image_t *src, *mask = NULL, *dest;
+    double samples[MAX_SAMPLES], sum = 0, sum2 = 0, mean;
+    int i;
+
+    if (options->filter && !strstr (name, options->filter))
+	return;
+
+    if (transform_type == IDENTITY)
+    {
+	src = make_image (src_format, size);
+    }
+    else
+    {
+	pixman_transform_t transform;
+
+	/* Large enough for both transforms to stay within it */
+	src = make_image (src_format, 2 * size);
+
+	if (transform_type == SCALE)
+	{
+	    pixman_transform_init_scale (&transform,
+					 pixman_double_to_fixed (1.5),
+					 pixman_double_to_fixed (1.5));
+	}
+	else
+	{
+	    pixman_transform_init_translate (&transform,
+					     pixman_int_to_fixed (size),
+					     pixman_int_to_fixed (size / 4));
+	    pixman_transform_rotate (&transform, NULL,
+				     pixman_double_to_fixed (0.866025),
+				     pixman_double_to_fixed (0.5));
+	}
+
+	pixman_image_set_transform (src, &transform);
+	pixman_image_set_filter (src, filter, NULL, 0);
+	pixman_image_set_repeat (src, PIXMAN_REPEAT_PAD);
+    }
+
+    if (mask_format != PIXMAN_null)
+    {
+	mask = make_image (mask_format, size);
+	pixman_image_set_component_alpha (mask, component_alpha);
+    }
+
+    dest = make_image (dest_format, size);
+
+    for (i = 0; i < options->n_samples; ++i)
+    {
+	double start, elapsed;
+	int n = 0;
+
+	start = gettime ();
+
+	do
+	{
+	    pixman_image_composite32 (op, src, mask, dest,
+				      0, 0, 0, 0, 0, 0, size, size);
+	    n++;
+
+	    elapsed = gettime () - start;
+	}
+	while (elapsed < options->sample_seconds);
+
+	samples[i] = (double)n * size * size / elapsed / 1e6;
+	sum += samples[i];
+	sum2 += samples[i] * samples[i];
+    }
+
+    mean = sum / options->n_samples;
+    qsort (samples, options->n_samples, sizeof (double), compare_doubles);
+
+    printf ("@%s,%.3f,%.2f,%d\n", name,
+	    samples[options->n_samples / 2],
+	    100 * sqrt (MAX (sum2 / options->n_samples - mean * mean, 0)) / mean,
+	    options->n_samples);
+    fflush (stdout);
+
+    pixman_image_unref (src);
+    if (mask)
+	pixman_image_unref (mask);
+    pixman_image_unref (dest);
+}
+
+static const char *
+short_format_name (pixman_format_code_t format)
+{
+    if (format == PIXMAN_solid)
+	return "solid";
+
+    return format_name (format);
+}
+
+/* Runs the whole matrix in this process and prints one line per case */
+static void
+run_matrix (const options_t *options)
+{
+    pixman_implementation_t *imp;
+    char name[128];
+    int depth = 0;
+    int o, f, s, t, i;
+
+    /* Tells the parent whether this level differs from the one below */
+    for (imp = _pixman_internal_only_get_implementation (); imp;
+	 imp = imp->fallback)
+    {
+	depth++;
+    }
+    printf ("@depth %d\n", depth);
+
+    prng_srand (0);
+
+    for (o = 0; o < ARRAY_LENGTH (ops); ++o)
+    {
+	for (f = 0; f < ARRAY_LENGTH (untransformed); ++f)
+	{
+	    for (s = 0; s < ARRAY_LENGTH (sizes); ++s)
+	    {
+		snprintf (name, sizeof (name), "%s/%s/%s%s/%s/%dx%d/identity",
+			  ops[o].name,
+			  short_format_name (untransformed[f].src),
+			  short_format_name (untransformed[f].mask),
+			  untransformed[f].component_alpha? "-ca" : "",
+			  short_format_name (untransformed[f].dest),
+			  sizes[s], sizes[s]);
+
+		run_case (options, name, ops[o].op,
+			  untransformed[f].src, untransformed[f].mask,
+			  untransformed[f].component_alpha,
+			  untransformed[f].dest, sizes[s],
+			  IDENTITY, PIXMAN_FILTER_NEAREST);
+	    }
+	}
+    }
+
+    /* ADD is rare with transformed sources */
+    for (o = 0; o < 2; ++o)
+    {
+	for (f = 0; f < ARRAY_LENGTH (transformed); ++f)
+	{
+	    for (s = 0; s < ARRAY_LENGTH (sizes); ++s)
+	    {
+		for (t = SCALE; t <= ROTATE; ++t)
+		{
+		    for (i = 0; i < ARRAY_LENGTH (filters); ++i)
+		    {
+			snprintf (name, sizeof (name),
+				  "%s/%s/null/%s/%dx%d/%s/%s",
+				  ops[o].name,
+				  short_format_name (transformed[f].src),
+				  short_format_name (transformed[f].dest),
+				  sizes[s], sizes[s],
+				  transform_names[t], filters[i].name);
+
+			run_case (options, name, ops[o].op,
+				  transformed[f].src, PIXMAN_null, FALSE,
+				  transformed[f].dest, sizes[s],
+				  t, filters[i].filter);
+		    }
+		}
+	    }
+	}
+    }
+}
+
+/* Runs the matrix for one level in a child process and appends its
+ * results. Returns the depth of the implementation chain of the level,
+ * or -1 if the child couldn't be run.
+ */
+static int
+run_level (const char *argv0, const options_t *options, const level_t *level,
+	   result_t *results, int *n_results)
+{
+    char command[1024], line[512];
+    FILE *child;
+    int depth = -1;
+
+    snprintf (command, sizeof (command),
+	      "\"%s\" --child -t %g -n %d%s%s",
+	      argv0, options->sample_seconds, options->n_samples,
+	      options->filter? " -m " : "",
+	      options->filter? options->filter : "");
+
+#ifdef _WIN32
+    _putenv_s ("PIXMAN_DISABLE", level->disable);
+#else
+    setenv ("PIXMAN_DISABLE", level->disable, 1);
+#endif
+
+    if (!(child = popen (command, "r")))
+	return -1;
+
+    while (fgets (line, sizeof (line), child))
+    {
+	result_t *r = &results[*n_results];
+
+	/* pixman prints which implementations are disabled */
+	if (line[0] != '@')
+	    continue;
+
+	if (sscanf (line, "@depth %d", &depth) == 1)
+	    continue;
+
+	if (*n_results < MAX_RESULTS &&
+	    sscanf (line, "@%127[^,],%lf,%lf,%d",
+		    r->name, &r->mpix, &r->stddev, &r->n_samples) == 4)
+	{
+	    snprintf (r->level, sizeof (r->level), "%.31s", level->name);
+	    r->base_mpix = -1;
+	    r->status = "";
+	    (*n_results)++;
+	}
+    }
+
+    pclose (child);
+
+    return depth;
+}
+
+static pixman_bool_t
+parse_csv_line (char *line, result_t *r)
+{
+    char *fields[6];
+    int n = 0;
+
+    fields[n++] = line;
+    while (n < ARRAY_LENGTH (fields) && (line = strchr (line, ',')))
+    {
+	*line++ = '\0';
+	fields[n++] = line;
+    }
+
+    if (n < 5 || strcmp (fields[0], "level") == 0)
+	return FALSE;
+
+    snprintf (r->level, sizeof (r->level), "%.31s", fields[0]);
+    snprintf (r->name, sizeof (r->name), "%.127s", fields[1]);
+    r->mpix = strtod (fields[2], NULL);
+    r->stddev = strtod (fields[3], NULL);
+
+    return r->mpix > 0;
+}
+
+/* Marks each result as faster or slower than the baseline when the
+ * difference exceeds both the threshold and twice the combined noise
+ * of the two measurements. Returns the number of slower cases.
+ */
+static int
+compare_baseline (const char *filename, double threshold,
+		  result_t *results, int n_results)
+{
+    char line[512];
+    result_t base;
+    FILE *f;
+    int n_slower = 0, n_faster = 0, n_compared = 0, i;
+
+    if (!(f = fopen (filename, "r")))
+    {
+	fprintf (stderr, "Can't open baseline %s\n", filename);
+	exit (2);
+    }
+
+    while (fgets (line, sizeof (line), f))
+    {
+	line[strcspn (line, "\r\n")] = '\0';
+
+	if (!parse_csv_line (line, &base))
+	    continue;
+
+	for (i = 0; i < n_results; ++i)
+	{
+	    result_t *r = &results[i];
+
+	    if (strcmp (r->level, base.level) == 0 &&
+		strcmp (r->name, base.name) == 0)
+	    {
+		double noise = 2 * sqrt (r->stddev * r->stddev +
+					 base.stddev * base.stddev);
+
+		r->base_mpix = base.mpix;
+		r->base_stddev = base.stddev;
+		r->change = 100 * (r->mpix - base.mpix) / base.mpix;
+
+		if (fabs (r->change) <= MAX (threshold, noise))
+		    r->status = "same";
+		else if (r->change < 0)
+		    r->status = "slower", n_slower++;
+		else
+		    r->status = "faster", n_faster++;
+
+		n_compared++;
+		break;
+	    }
+	}
+    }
+
+    fclose (f);
+
+    fprintf (stderr, "%d of %d cases compared with the baseline: "
+	     "%d slower, %d faster\n",
+	     n_compared, n_results, n_slower, n_faster);
+
+    for (i = 0; i < n_results; ++i)
+    {
+	if (strcmp (results[i].status, "slower") == 0)
+	{
+	    fprintf (stderr, "  slower: %s %s %.1f%%\n",
+		     results[i].level, results[i].name, results[i].change);
+	}
+    }
+
+    return n_slower;
+}
+
+static void
+print_csv (const result_t *results, int n_results, pixman_bool_t baseline)
+{
+    int i;
+
+    printf ("level,case,mpix_per_s,stddev_pct,samples%s\n",
+	    baseline? ",baseline_mpix_per_s,change_pct,status" : "");
+
+    for (i = 0; i < n_results; ++i)
+    {
+	const result_t *r = &results[i];
+
+	printf ("%s,%s,%.3f,%.2f,%d", r->level, r->name,
+		r->mpix, r->stddev, r->n_samples);
+
+	if (baseline && r->base_mpix >= 0)
+	    printf (",%.3f,%.2f,%s", r->base_mpix, r->change, r->status);
+	else if (baseline)
+	    printf (",,,");
+
+	printf ("\n");
+    }
+}
+
+static void
+print_json (const result_t *results, int n_results)
+{
+    int i;
+
+    printf ("[\n");
+
+    for (i = 0; i < n_results; ++i)
+    {
+	const result_t *r = &results[i];
+
+	printf ("  { \"level\": \"%s\", \"case\": \"%s\", "
+		"\"mpix_per_s\": %.3f, \"stddev_pct\": %.2f, \"samples\": %d",
+		r->level, r->name, r->mpix, r->stddev, r->n_samples);
+
+	if (r->base_mpix >= 0)
+	{
+	    printf (", \"baseline_mpix_per_s\": %.3f, \"change_pct\": %.2f, "
+		    "\"status\": \"%s\"", r->base_mpix, r->change, r->status);
+	}
+
+	printf (" }%s\n", i < n_results - 1? "," : "");
+    }
+
+    printf ("]\n");
+}
+
+static void
+usage (void)
+{
+    printf ("Usage: regression-bench [-f csv|json] [-l level[,level...]]\n"
+	    "                        [-m substring] [-t seconds] [-n samples]\n"
+	    "                        [-b baseline.csv] [-r percent]\n"
+	    "  -f : output format, csv by default\n"
+	    "  -l : only run these levels\n"
+	    "  -m : only run cases whose name contains the substring\n"
+	    "  -t : length of each sample, 0.02 seconds by default\n"
+	    "  -n : samples per case, 5 by default\n"
+	    "  -b : compare with the csv output of an earlier run\n"
+	    "  -r : smallest change to report, 5 percent by default\n"
+	    "Levels:");
+
+    {
+	int i;
+
+	for (i = 0; i < ARRAY_LENGTH (levels); ++i)
+	    printf (" %s", levels[i].name);
+    }
+
+    printf ("\n");
+}
+
+int
+main (int argc, char *argv[])
+{
+    options_t options = { 0.02, 5, NULL };
+    const char *format = "csv", *only = NULL, *baseline = NULL;
+    pixman_bool_t child = FALSE;
+    double threshold = 5;
+    result_t *results;
+    int n_results = 0, last_depth = 0, n_slower = 0, i;
+
+    for (i = 1; i < argc; ++i)
+    {
+	const char *arg = argv[i];
+	const char *value = i + 1 < argc? argv[i + 1] : NULL;
+
+	if (strcmp (arg, "--child") == 0)
+	{
+	    child = TRUE;
+	    continue;
+	}
+
+	if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '\0' || !value)
+	{
+	    usage ();
+	    return 2;
+	}
+
+	switch (arg[1])
+	{
+	case 'f': format = value; break;
+	case 'l': only = value; break;
+	case 'm': options.filter = value; break;
+	case 't': options.sample_seconds = atof (value); break;
+	case 'n': options.n_samples = atoi (value); break;
+	case 'b': baseline = value; break;
+	case 'r': threshold = atof (value); break;
+	default: usage (); return 2;
+	}
+
+	i++;
+    }
+
+    options.n_samples = MAX (1, MIN (options.n_samples, MAX_SAMPLES));
+
+    if (child)
+    {
+	run_matrix (&options);
+	return 0;
+    }
+
+    results = malloc (MAX_RESULTS * sizeof (result_t));
+
+    for (i = 0; i < ARRAY_LENGTH (levels); ++i)
+    {
+	int n_before = n_results;
+	int depth;
+
+	if (only && !strstr (only, levels[i].name))
+	    continue;
+
+	fprintf (stderr, "Running %s\n", levels[i].name);
+
+	depth = run_level (argv[0], &options, &levels[i], results, &n_results);
+
+	if (depth < 0)
+	{
+	    fprintf (stderr, "Couldn't run %s\n", argv[0]);
+	    return 2;
+	}
+
+	/* The CPU doesn't support this level, so it ran the one below */
+	if (depth == last_depth)
+	{
+	    fprintf (stderr, "  not supported, skipped\n");
+	    n_results = n_before;
+	}
+
+	last_depth = depth;
+    }
+
+    if (baseline)
+	n_slower = compare_baseline (baseline, threshold, results, n_results);
+
+    if (strcmp (format, "json") == 0)
+	print_json (results, n_results);
+    else
+	print_csv (results, n_results, baseline != NULL);
+
+    free (results);
+
+    return n_slower? 1 : 0;
+}
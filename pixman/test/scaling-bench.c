@@ -6,7 +6,7 @@
 #define TEST_REPEATS 3
 
 static pixman_image_t *
-make_source (void)
+make_source (pixman_filter_t filter)
 {
     size_t n_bytes = (SOURCE_WIDTH + 2) * (SOURCE_HEIGHT + 2) * 4;
     uint32_t *data = malloc (n_bytes);
@@ -19,20 +19,62 @@ make_source (void)
 	data,
 	(SOURCE_WIDTH + 2) * 4);
 
-    pixman_image_set_filter (source, PIXMAN_FILTER_BILINEAR, NULL, 0);
+    /* Separable convolution parameters depend on the scale */
+    if (filter != PIXMAN_FILTER_SEPARABLE_CONVOLUTION)
+	pixman_image_set_filter (source, filter, NULL, 0);
 
     return source;
 }
 
+static void
+usage (const char *progname)
+{
+    printf ("Usage: %s [-n | -s] [-d impl]\n", progname);
+    printf ("  -n : benchmark nearest instead of bilinear scaling\n");
+    printf ("  -s : benchmark a separable convolution filter (box sampled\n");
+    printf ("       lanczos3) instead of bilinear scaling\n");
+    printf ("  -d impl : disable the comma separated implementations (e.g. avx2),\n");
+    printf ("            to compare against the default run\n");
+}
+
 int
-main ()
+main (int argc, char *argv[])
 {
+    pixman_filter_t filter = PIXMAN_FILTER_BILINEAR;
     double scale;
     pixman_image_t *src;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+	if (strcmp (argv[i], "-n") == 0)
+	{
+	    filter = PIXMAN_FILTER_NEAREST;
+	}
+	else if (strcmp (argv[i], "-s") == 0)
+	{
+	    filter = PIXMAN_FILTER_SEPARABLE_CONVOLUTION;
+	}
+	else if (strcmp (argv[i], "-d") == 0 && i + 1 < argc)
+	{
+	    restart_with_disabled_implementations (argv, argv[++i]);
+	}
+	else
+	{
+	    usage (argv[0]);
+	    return 1;
+	}
+    }
 
     prng_srand (23874);
     
-    src = make_source ();
+    src = make_source (filter);
+    printf ("# %s scaling",
+	    filter == PIXMAN_FILTER_NEAREST ? "NEAREST" :
+	    filter == PIXMAN_FILTER_BILINEAR ? "BILINEAR" : "SEPARABLE_CONVOLUTION");
+    if (getenv ("PIXMAN_DISABLE"))
+	printf (", disabled implementations: %s", getenv ("PIXMAN_DISABLE"));
+    printf ("\n");
     printf ("# %-6s %-22s   %-14s %-12s\n",
 	    "ratio",
 	    "resolutions",
@@ -53,6 +95,19 @@ main ()
 
 	pixman_transform_init_scale (&transform, s, s);
 	pixman_image_set_transform (src, &transform);
+
+	if (filter == PIXMAN_FILTER_SEPARABLE_CONVOLUTION)
+	{
+	    pixman_fixed_t *params;
+	    int n_params;
+
+	    params = pixman_filter_create_separable_convolution (
+		&n_params, s, s,
+		PIXMAN_KERNEL_LANCZOS3, PIXMAN_KERNEL_LANCZOS3,
+		PIXMAN_KERNEL_BOX, PIXMAN_KERNEL_BOX, 4, 4);
+	    pixman_image_set_filter (src, filter, params, n_params);
+	    free (params);
+	}
 	
 	dest = pixman_image_create_bits (
 	    PIXMAN_a8r8g8b8, dest_width, dest_height, dest_buf, dest_byte_stride);
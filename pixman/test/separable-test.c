@@ -0,0 +1,251 @@
+/*
+ * Checks scaled compositing with separable convolution filters against
+ * a direct evaluation of the filter, so that SIMD implementations which
+ * filter in two passes stay within one unit of the per-pixel result.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include "utils.h"
+
+#define N_TESTS		3000
+#define TOLERANCE	1
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+    PIXMAN_a8b8g8r8,
+    PIXMAN_x8b8g8r8,
+};
+
+/* IMPULSE is only used for reconstruction; as a sampling kernel
+ * together with IMPULSE reconstruction it makes an empty filter.
+ */
+static const pixman_kernel_t kernels[] =
+{
+    PIXMAN_KERNEL_IMPULSE,
+    PIXMAN_KERNEL_BOX,
+    PIXMAN_KERNEL_LINEAR,
+    PIXMAN_KERNEL_CUBIC,
+    PIXMAN_KERNEL_GAUSSIAN,
+    PIXMAN_KERNEL_LANCZOS2,
+    PIXMAN_KERNEL_LANCZOS3,
+    PIXMAN_KERNEL_LANCZOS3_STRETCHED,
+};
+
+static int
+repeat_coord (pixman_repeat_t repeat, int c, int size)
+{
+    switch (repeat)
+    {
+    case PIXMAN_REPEAT_NORMAL:
+	c %= size;
+	return c < 0 ? c + size : c;
+
+    case PIXMAN_REPEAT_PAD:
+	return c < 0 ? 0 : (c >= size ? size - 1 : c);
+
+    case PIXMAN_REPEAT_REFLECT:
+	c %= 2 * size;
+	if (c < 0)
+	    c += 2 * size;
+	return c >= size ? 2 * size - c - 1 : c;
+
+    default:
+	return (c < 0 || c >= size) ? -1 : c;
+    }
+}
+
+static int
+clamp_channel (int t)
+{
+    t = (t + 0x8000) >> 16;
+
+    return t < 0 ? 0 : (t > 0xff ? 0xff : t);
+}
+
+/* The per-pixel evaluation used by the C implementation */
+static uint32_t
+reference_pixel (const uint32_t *bits, int width, int height,
+		 pixman_format_code_t format, pixman_repeat_t repeat,
+		 const pixman_fixed_t *params,
+		 pixman_fixed_t x, pixman_fixed_t y)
+{
+    int cwidth = pixman_fixed_to_int (params[0]);
+    int cheight = pixman_fixed_to_int (params[1]);
+    int x_phase_bits = pixman_fixed_to_int (params[2]);
+    int y_phase_bits = pixman_fixed_to_int (params[3]);
+    int x_phase_shift = 16 - x_phase_bits;
+    int y_phase_shift = 16 - y_phase_bits;
+    int x_off = ((cwidth << 16) - pixman_fixed_1) >> 1;
+    int y_off = ((cheight << 16) - pixman_fixed_1) >> 1;
+    const pixman_fixed_t *x_params, *y_params;
+    int32_t tot[4] = { 0, 0, 0, 0 };
+    int x1, y1, i, j, c;
+
+    x = ((x >> x_phase_shift) << x_phase_shift) + ((1 << x_phase_shift) >> 1);
+    y = ((y >> y_phase_shift) << y_phase_shift) + ((1 << y_phase_shift) >> 1);
+
+    x_params = params + 4 + ((x & 0xffff) >> x_phase_shift) * cwidth;
+    y_params = params + 4 + (1 << x_phase_bits) * cwidth +
+	((y & 0xffff) >> y_phase_shift) * cheight;
+
+    x1 = pixman_fixed_to_int (x - pixman_fixed_e - x_off);
+    y1 = pixman_fixed_to_int (y - pixman_fixed_e - y_off);
+
+    for (i = 0; i < cheight; ++i)
+    {
+	int ry = repeat_coord (repeat, y1 + i, height);
+
+	for (j = 0; j < cwidth; ++j)
+	{
+	    int rx = repeat_coord (repeat, x1 + j, width);
+	    int32_t f = ((int64_t)x_params[j] * y_params[i] + 0x8000) >> 16;
+	    uint32_t pixel = 0;
+
+	    if (rx >= 0 && ry >= 0)
+	    {
+		pixel = bits[ry * width + rx];
+		if (!PIXMAN_FORMAT_A (format))
+		    pixel |= 0xff000000;
+	    }
+
+	    for (c = 0; c < 4; ++c)
+		tot[c] += (int)((pixel >> (8 * c)) & 0xff) * f;
+	}
+    }
+
+    return (clamp_channel (tot[3]) << 24) | (clamp_channel (tot[2]) << 16) |
+	   (clamp_channel (tot[1]) << 8) | clamp_channel (tot[0]);
+}
+
+static int
+channel_diff (uint32_t a, uint32_t b)
+{
+    int c, max = 0;
+
+    for (c = 0; c < 32; c += 8)
+    {
+	int d = abs ((int)((a >> c) & 0xff) - (int)((b >> c) & 0xff));
+
+	if (d > max)
+	    max = d;
+    }
+
+    return max;
+}
+
+static int
+test_one (int testno)
+{
+    pixman_format_code_t format = formats[prng_rand_n (ARRAY_LENGTH (formats))];
+    pixman_repeat_t repeat = prng_rand_n (4);
+    int src_width = 1 + prng_rand_n (64);
+    int src_height = 1 + prng_rand_n (64);
+    int dst_width = 1 + prng_rand_n (96);
+    int dst_height = 1 + prng_rand_n (96);
+    double scale_x = 0.25 + prng_rand_n (1000) / 250.0;
+    double scale_y = 0.25 + prng_rand_n (1000) / 250.0;
+    pixman_image_t *src, *dst;
+    pixman_fixed_t *params;
+    pixman_transform_t transform;
+    uint32_t *src_bits, *dst_bits;
+    int n_params, x, y, n_failures = 0;
+
+    src_bits = malloc (src_width * src_height * 4);
+    dst_bits = malloc (dst_width * dst_height * 4);
+    prng_randmemset (src_bits, src_width * src_height * 4, 0);
+
+    src = pixman_image_create_bits (
+	format, src_width, src_height, src_bits, src_width * 4);
+    dst = pixman_image_create_bits (
+	PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_ARGB ?
+	PIXMAN_a8r8g8b8 : PIXMAN_a8b8g8r8,
+	dst_width, dst_height, dst_bits, dst_width * 4);
+
+    pixman_transform_init_scale (&transform,
+				 pixman_double_to_fixed (1 / scale_x),
+				 pixman_double_to_fixed (1 / scale_y));
+    pixman_transform_translate (&transform, NULL,
+				pixman_int_to_fixed (prng_rand_n (17) - 8),
+				pixman_int_to_fixed (prng_rand_n (17) - 8));
+
+    params = pixman_filter_create_separable_convolution (
+	&n_params,
+	pixman_double_to_fixed (1 / scale_x),
+	pixman_double_to_fixed (1 / scale_y),
+	kernels[prng_rand_n (ARRAY_LENGTH (kernels))],
+	kernels[prng_rand_n (ARRAY_LENGTH (kernels))],
+	kernels[1 + prng_rand_n (ARRAY_LENGTH (kernels) - 1)],
+	kernels[1 + prng_rand_n (ARRAY_LENGTH (kernels) - 1)],
+	prng_rand_n (5), prng_rand_n (5));
+
+    pixman_image_set_transform (src, &transform);
+    pixman_image_set_repeat (src, repeat);
+    pixman_image_set_filter (
+	src, PIXMAN_FILTER_SEPARABLE_CONVOLUTION, params, n_params);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dst,
+			      0, 0, 0, 0, 0, 0, dst_width, dst_height);
+
+    for (y = 0; y < dst_height; ++y)
+    {
+	for (x = 0; x < dst_width; ++x)
+	{
+	    pixman_vector_t v;
+	    uint32_t expected, result;
+
+	    v.vector[0] = pixman_int_to_fixed (x) + pixman_fixed_1 / 2;
+	    v.vector[1] = pixman_int_to_fixed (y) + pixman_fixed_1 / 2;
+	    v.vector[2] = pixman_fixed_1;
+	    pixman_transform_point_3d (&transform, &v);
+
+	    expected = reference_pixel (src_bits, src_width, src_height,
+					format, repeat, params,
+					v.vector[0], v.vector[1]);
+	    result = dst_bits[y * dst_width + x];
+
+	    if (channel_diff (expected, result) > TOLERANCE)
+	    {
+		if (n_failures++ == 0)
+		{
+		    printf ("test %d: %s repeat %d, %dx%d -> %dx%d: "
+			    "(%d, %d) is %08x, expected %08x\n",
+			    testno, format_name (format), repeat,
+			    src_width, src_height, dst_width, dst_height,
+			    x, y, result, expected);
+		}
+	    }
+	}
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dst);
+    free (params);
+    free (src_bits);
+    free (dst_bits);
+
+    return n_failures;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    int i, n_failures = 0;
+
+    prng_srand (0);
+
+    for (i = 0; i < N_TESTS; ++i)
+    {
+	if (test_one (i))
+	    n_failures++;
+    }
+
+    if (n_failures)
+    {
+	printf ("%d of %d tests failed\n", n_failures, N_TESTS);
+	return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+/*
+ * Measures the throughput of pixman_image_composite32_threaded() for
+ * a few typical full screen operations as the number of threads goes
+ * from 1 to N.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "utils.h"
+
+#define DEST_WIDTH	1920
+#define DEST_HEIGHT	1080
+#define MIN_SECONDS	0.5
+
+typedef struct
+{
+    const char *	name;
+    pixman_op_t		op;
+    pixman_image_t *	src;
+    pixman_image_t *	mask;
+} bench_t;
+
+static void
+destroy_bits (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+make_bits (pixman_format_code_t format, int width, int height)
+{
+    int stride = ((PIXMAN_FORMAT_BPP (format) * width + 127) / 128) * 16;
+    uint32_t *bits = aligned_malloc (64, stride * height);
+    pixman_image_t *image;
+
+    prng_randmemset (bits, stride * height, 0);
+
+    image = pixman_image_create_bits (format, width, height, bits, stride);
+    pixman_image_set_destroy_function (image, destroy_bits, bits);
+
+    return image;
+}
+
+static pixman_image_t *
+make_scaled (pixman_filter_t filter)
+{
+    pixman_image_t *image = make_bits (PIXMAN_a8r8g8b8, 640, 360);
+    pixman_transform_t transform;
+
+    pixman_transform_init_scale (&transform,
+				 pixman_double_to_fixed (640.0 / DEST_WIDTH),
+				 pixman_double_to_fixed (360.0 / DEST_HEIGHT));
+    pixman_image_set_transform (image, &transform);
+    pixman_image_set_filter (image, filter, NULL, 0);
+    pixman_image_set_repeat (image, PIXMAN_REPEAT_PAD);
+
+    return image;
+}
+
+static pixman_image_t *
+make_radial (void)
+{
+    pixman_point_fixed_t c1 = { pixman_int_to_fixed (400),
+				pixman_int_to_fixed (300) };
+    pixman_point_fixed_t c2 = { pixman_int_to_fixed (960),
+				pixman_int_to_fixed (540) };
+    pixman_gradient_stop_t stops[3] = {
+	{ 0, { 0xffff, 0x0000, 0x0000, 0xffff } },
+	{ pixman_fixed_1 / 2, { 0x0000, 0xffff, 0x0000, 0x8000 } },
+	{ pixman_fixed_1, { 0x0000, 0x0000, 0xffff, 0xffff } }
+    };
+
+    return pixman_image_create_radial_gradient (
+	&c1, &c2, pixman_int_to_fixed (10), pixman_int_to_fixed (900),
+	stops, 3);
+}
+
+static double
+bench (const bench_t *b, pixman_image_t *dest, int n_threads)
+{
+    double start, elapsed;
+    int n = 0;
+
+    start = gettime ();
+
+    do
+    {
+	pixman_image_composite32_threaded (
+	    b->op, b->src, b->mask, dest,
+	    0, 0, 0, 0, 0, 0, DEST_WIDTH, DEST_HEIGHT, n_threads);
+	n++;
+
+	elapsed = gettime () - start;
+    }
+    while (elapsed < MIN_SECONDS);
+
+    return (double)n * DEST_WIDTH * DEST_HEIGHT / elapsed / 1000000.0;
+}
+
+static void
+usage (const char *progname)
+{
+    printf ("Usage: %s [-t max_threads] [-d impl]\n", progname);
+    printf ("  -t max_threads : highest thread count to measure (default 8)\n");
+    printf ("  -d impl : disable the comma separated implementations (e.g. avx2)\n");
+}
+
+int
+main (int argc, char *argv[])
+{
+    pixman_image_t *dest;
+    bench_t benches[5];
+    int max_threads = 8;
+    int i, j, t;
+
+    for (i = 1; i < argc; i++)
+    {
+	if (strcmp (argv[i], "-t") == 0 && i + 1 < argc)
+	{
+	    max_threads = atoi (argv[++i]);
+	    if (max_threads < 1)
+		max_threads = 1;
+	}
+	else if (strcmp (argv[i], "-d") == 0 && i + 1 < argc)
+	{
+	    restart_with_disabled_implementations (argv, argv[++i]);
+	}
+	else
+	{
+	    usage (argv[0]);
+	    return 1;
+	}
+    }
+
+    prng_srand (0);
+
+    dest = make_bits (PIXMAN_a8r8g8b8, DEST_WIDTH, DEST_HEIGHT);
+
+    benches[0].name = "over_8888_8888";
+    benches[0].op = PIXMAN_OP_OVER;
+    benches[0].src = make_bits (PIXMAN_a8r8g8b8, DEST_WIDTH, DEST_HEIGHT);
+    benches[0].mask = NULL;
+
+    benches[1].name = "over_8888_8_8888";
+    benches[1].op = PIXMAN_OP_OVER;
+    benches[1].src = make_bits (PIXMAN_a8r8g8b8, DEST_WIDTH, DEST_HEIGHT);
+    benches[1].mask = make_bits (PIXMAN_a8, DEST_WIDTH, DEST_HEIGHT);
+
+    benches[2].name = "src_bilinear_scale";
+    benches[2].op = PIXMAN_OP_SRC;
+    benches[2].src = make_scaled (PIXMAN_FILTER_BILINEAR);
+    benches[2].mask = NULL;
+
+    benches[3].name = "over_radial";
+    benches[3].op = PIXMAN_OP_OVER;
+    benches[3].src = make_radial ();
+    benches[3].mask = NULL;
+
+    benches[4].name = "multiply_8888_8888";
+    benches[4].op = PIXMAN_OP_MULTIPLY;
+    benches[4].src = make_bits (PIXMAN_a8r8g8b8, DEST_WIDTH, DEST_HEIGHT);
+    benches[4].mask = NULL;
+
+    printf ("# %dx%d destination, Mpixels/s", DEST_WIDTH, DEST_HEIGHT);
+    if (getenv ("PIXMAN_DISABLE"))
+	printf (", disabled implementations: %s", getenv ("PIXMAN_DISABLE"));
+    printf ("\n");
+
+    printf ("# %-20s", "operation");
+    for (t = 1; t <= max_threads; t++)
+	printf (" %6d", t);
+    printf ("\n");
+
+    for (j = 0; j < ARRAY_LENGTH (benches); j++)
+    {
+	double base = 0, mpix = 0;
+
+	printf ("  %-20s", benches[j].name);
+	fflush (stdout);
+
+	for (t = 1; t <= max_threads; t++)
+	{
+	    mpix = bench (&benches[j], dest, t);
+
+	    if (t == 1)
+		base = mpix;
+
+	    printf (" %6.0f", mpix);
+	    fflush (stdout);
+	}
+
+	printf ("   (x%.2f)\n", mpix / base);
+
+	pixman_image_unref (benches[j].src);
+	if (benches[j].mask)
+	    pixman_image_unref (benches[j].mask);
+    }
+
+    pixman_image_unref (dest);
+
+    return 0;
+}
@@ -11,6 +11,7 @@ int main ()
 #else
 
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef HAVE_PTHREADS
 # include <pthread.h>
@@ -145,6 +146,191 @@ byteswap32 (uint32_t x)
            ((x & ((uint32_t)0xFF <<  0)) << 24);
 }
 
+/* pixman_image_composite32_threaded() must produce exactly what
+ * pixman_image_composite32() does, whatever the images look like.
+ */
+#define N_THREADED_ROUNDS 400
+
+static void
+destroy_bits (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static uint32_t *
+make_random_bits (int n_bytes)
+{
+    uint32_t *bits = malloc (n_bytes);
+
+    prng_randmemset (bits, n_bytes, 0);
+
+    return bits;
+}
+
+/* Returns NULL when the destination should be its own source */
+static pixman_image_t *
+create_threaded_source (void)
+{
+    pixman_image_t *image;
+    int w, h, stride;
+    uint32_t *bits;
+
+    switch (prng_rand_n (8))
+    {
+    case 0:
+	return pixman_image_create_solid_fill (&(pixman_color_t) {
+		prng_rand_n (0x10000), prng_rand_n (0x10000),
+		prng_rand_n (0x10000), prng_rand_n (0x10000) });
+
+    case 1:
+    {
+	pixman_point_fixed_t p1 = { 0, 0 };
+	pixman_point_fixed_t p2 = { pixman_int_to_fixed (prng_rand_n (300)),
+				    pixman_int_to_fixed (prng_rand_n (300)) };
+	pixman_gradient_stop_t stops[2] = {
+	    { 0, { 0xffff, 0x0000, 0x8000, 0xc000 } },
+	    { pixman_fixed_1, { 0x0000, 0xffff, 0x4000, 0xffff } }
+	};
+
+	return pixman_image_create_linear_gradient (&p1, &p2, stops, 2);
+    }
+
+    case 2:
+	return NULL;
+
+    default:
+	break;
+    }
+
+    w = 1 + prng_rand_n (400);
+    h = 1 + prng_rand_n (400);
+    stride = w * 4;
+    bits = make_random_bits (stride * h);
+
+    image = pixman_image_create_bits (
+	formats[prng_rand_n (ARRAY_LENGTH (formats))], w, h, bits, stride);
+    pixman_image_set_destroy_function (image, destroy_bits, bits);
+
+    pixman_image_set_repeat (image, prng_rand_n (4));
+
+    if (prng_rand_n (3) == 0)
+    {
+	pixman_transform_t transform;
+	double scale = 0.3 + prng_rand_n (300) / 100.0;
+
+	pixman_transform_init_scale (&transform,
+				     pixman_double_to_fixed (scale),
+				     pixman_double_to_fixed (scale));
+	pixman_image_set_transform (image, &transform);
+	pixman_image_set_filter (
+	    image, prng_rand_n (2) ? PIXMAN_FILTER_BILINEAR
+				   : PIXMAN_FILTER_NEAREST, NULL, 0);
+    }
+
+    return image;
+}
+
+static int
+test_threaded_composite (void)
+{
+    int i, n_failures = 0;
+
+    prng_srand (0);
+
+    for (i = 0; i < N_THREADED_ROUNDS; ++i)
+    {
+	pixman_format_code_t format;
+	pixman_image_t *dests[2], *srcs[2], *src, *mask, *alpha_map;
+	uint32_t *bits[2], *alpha_bits[2] = { NULL, NULL };
+	pixman_dither_t dither;
+	pixman_op_t op;
+	int w, h, stride, n_threads, j;
+	int sx, sy, mx, my, dx, dy, cw, ch;
+
+	format = formats[prng_rand_n (ARRAY_LENGTH (formats))];
+	w = 1 + prng_rand_n (800);
+	h = 200 + prng_rand_n (600);
+	stride = ((PIXMAN_FORMAT_BPP (format) * w + 31) / 32) * 4;
+
+	bits[0] = make_random_bits (stride * h);
+	bits[1] = malloc (stride * h);
+	memcpy (bits[1], bits[0], stride * h);
+
+	if (prng_rand_n (4) == 0)
+	{
+	    alpha_bits[0] = make_random_bits (w * 4 * h);
+	    alpha_bits[1] = malloc (w * 4 * h);
+	    memcpy (alpha_bits[1], alpha_bits[0], w * 4 * h);
+	}
+
+	dither = prng_rand_n (2) ? PIXMAN_DITHER_ORDERED_BAYER_8
+				 : PIXMAN_DITHER_NONE;
+	src = create_threaded_source ();
+
+	for (j = 0; j < 2; ++j)
+	{
+	    dests[j] = pixman_image_create_bits (format, w, h, bits[j], stride);
+	    pixman_image_set_dither (dests[j], dither);
+	    srcs[j] = src ? src : dests[j];
+
+	    if (alpha_bits[j])
+	    {
+		alpha_map = pixman_image_create_bits (
+		    PIXMAN_a8r8g8b8, w, h, alpha_bits[j], w * 4);
+		pixman_image_set_alpha_map (dests[j], alpha_map, 0, 0);
+		pixman_image_unref (alpha_map);
+	    }
+	}
+
+	mask = prng_rand_n (2) ? create_threaded_source () : NULL;
+	if (mask && prng_rand_n (2))
+	    pixman_image_set_component_alpha (mask, TRUE);
+
+	op = operators[prng_rand_n (ARRAY_LENGTH (operators))];
+	n_threads = prng_rand_n (9);
+
+	sx = prng_rand_n (100) - 50;
+	sy = prng_rand_n (100) - 50;
+	mx = prng_rand_n (100) - 50;
+	my = prng_rand_n (100) - 50;
+	dx = prng_rand_n (w / 4 + 1);
+	dy = prng_rand_n (h / 4 + 1);
+	cw = w / 2 + prng_rand_n (w);
+	ch = h / 2 + prng_rand_n (h);
+
+	pixman_image_composite32 (op, srcs[1], mask, dests[1],
+				  sx, sy, mx, my, dx, dy, cw, ch);
+	pixman_image_composite32_threaded (op, srcs[0], mask, dests[0],
+					   sx, sy, mx, my, dx, dy, cw, ch,
+					   n_threads);
+
+	if (memcmp (bits[0], bits[1], stride * h) != 0 ||
+	    (alpha_bits[0] &&
+	     memcmp (alpha_bits[0], alpha_bits[1], w * 4 * h) != 0))
+	{
+	    printf ("threaded composite %d differs: %s %s %dx%d, %d threads\n",
+		    i, operator_name (op), format_name (format), cw, ch,
+		    n_threads);
+	    n_failures++;
+	}
+
+	if (src)
+	    pixman_image_unref (src);
+	if (mask)
+	    pixman_image_unref (mask);
+	pixman_image_unref (dests[0]);
+	pixman_image_unref (dests[1]);
+
+	for (j = 0; j < 2; ++j)
+	{
+	    free (bits[j]);
+	    free (alpha_bits[j]);
+	}
+    }
+
+    return n_failures;
+}
+
 int
 main (void)
 {
@@ -224,6 +410,12 @@ main (void)
 	return 1;
     }
 
+    if (test_threaded_composite () != 0)
+    {
+	printf ("thread-test failed: threaded compositing is not exact\n");
+	return 1;
+    }
+
     return 0;
 }
 
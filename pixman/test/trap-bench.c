@@ -0,0 +1,227 @@
+/*
+ * Compares pixman_composite_trapezoids() with rasterizing each
+ * trapezoid on its own into an a8 mask and compositing the whole mask,
+ * which is what it used to do, for some large tessellated paths.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "utils.h"
+
+#define DEST_WIDTH	1920
+#define DEST_HEIGHT	1080
+#define MIN_SECONDS	0.5
+
+typedef struct
+{
+    const char *	name;
+    int			n_traps;
+    pixman_trapezoid_t *traps;
+} shape_t;
+
+static void
+set_trap (pixman_trapezoid_t *t,
+	  double top, double bottom,
+	  double xl_top, double xl_bottom,
+	  double xr_top, double xr_bottom)
+{
+    t->top = t->left.p1.y = t->right.p1.y = pixman_double_to_fixed (top);
+    t->bottom = t->left.p2.y = t->right.p2.y = pixman_double_to_fixed (bottom);
+    t->left.p1.x = pixman_double_to_fixed (xl_top);
+    t->left.p2.x = pixman_double_to_fixed (xl_bottom);
+    t->right.p1.x = pixman_double_to_fixed (xr_top);
+    t->right.p2.x = pixman_double_to_fixed (xr_bottom);
+}
+
+/* A filled ellipse cut into n horizontal bands */
+static void
+make_disc (shape_t *shape, int n)
+{
+    double cx = DEST_WIDTH / 2, cy = DEST_HEIGHT / 2;
+    double rx = DEST_WIDTH * 0.45, ry = DEST_HEIGHT * 0.45;
+    int i;
+
+    shape->name = "disc";
+    shape->n_traps = n;
+    shape->traps = malloc (n * sizeof (pixman_trapezoid_t));
+
+    for (i = 0; i < n; ++i)
+    {
+	double a0 = M_PI * i / n, a1 = M_PI * (i + 1) / n;
+
+	set_trap (&shape->traps[i],
+		  cy - ry * cos (a0), cy - ry * cos (a1),
+		  cx - rx * sin (a0), cx - rx * sin (a1),
+		  cx + rx * sin (a0), cx + rx * sin (a1));
+    }
+}
+
+/* A thin ring, two trapezoids per band */
+static void
+make_ring (shape_t *shape, int n)
+{
+    double cx = DEST_WIDTH / 2, cy = DEST_HEIGHT / 2;
+    double r = DEST_HEIGHT * 0.45, w = 3;
+    int i;
+
+    shape->name = "ring";
+    shape->n_traps = 2 * n;
+    shape->traps = malloc (2 * n * sizeof (pixman_trapezoid_t));
+
+    for (i = 0; i < n; ++i)
+    {
+	double a0 = M_PI * i / n, a1 = M_PI * (i + 1) / n;
+	double y0 = cy - r * cos (a0), y1 = cy - r * cos (a1);
+	double o0 = r * sin (a0), o1 = r * sin (a1);
+	double i0 = MAX (o0 - w, 0), i1 = MAX (o1 - w, 0);
+
+	set_trap (&shape->traps[2 * i], y0, y1,
+		  cx - o0, cx - o1, cx - i0, cx - i1);
+	set_trap (&shape->traps[2 * i + 1], y0, y1,
+		  cx + i0, cx + i1, cx + o0, cx + o1);
+    }
+}
+
+/* Many thin slanted strokes scattered over the destination */
+static void
+make_strokes (shape_t *shape, int n)
+{
+    int i;
+
+    shape->name = "strokes";
+    shape->n_traps = n;
+    shape->traps = malloc (n * sizeof (pixman_trapezoid_t));
+
+    for (i = 0; i < n; ++i)
+    {
+	double x = prng_rand_n (DEST_WIDTH);
+	double y = prng_rand_n (DEST_HEIGHT - 200);
+	double h = 20 + prng_rand_n (180);
+	double dx = (int)prng_rand_n (401) - 200;
+
+	set_trap (&shape->traps[i], y, y + h, x, x + dx, x + 1.5, x + dx + 1.5);
+    }
+}
+
+/* Many small overlapping trapezoids, as in glyph outlines */
+static void
+make_glyphs (shape_t *shape, int n)
+{
+    int i;
+
+    shape->name = "glyphs";
+    shape->n_traps = n;
+    shape->traps = malloc (n * sizeof (pixman_trapezoid_t));
+
+    for (i = 0; i < n; ++i)
+    {
+	double x = prng_rand_n (DEST_WIDTH - 16) + prng_rand_n (256) / 256.0;
+	double y = prng_rand_n (DEST_HEIGHT - 16) + prng_rand_n (256) / 256.0;
+	double h = 2 + prng_rand_n (10);
+	double w = 1 + prng_rand_n (6);
+
+	set_trap (&shape->traps[i], y, y + h,
+		  x + prng_rand_n (3), x, x + w, x + w + prng_rand_n (3));
+    }
+}
+
+/* The way pixman_composite_trapezoids() used to work */
+static void
+composite_each (pixman_op_t op, pixman_image_t *src, pixman_image_t *dest,
+		const shape_t *shape)
+{
+    int x1 = INT32_MAX, y1 = INT32_MAX, x2 = INT32_MIN, y2 = INT32_MIN;
+    pixman_image_t *mask;
+    int i;
+
+    for (i = 0; i < shape->n_traps; ++i)
+    {
+	const pixman_trapezoid_t *t = &shape->traps[i];
+
+	y1 = MIN (y1, pixman_fixed_to_int (t->top));
+	y2 = MAX (y2, pixman_fixed_to_int (pixman_fixed_ceil (t->bottom)));
+	x1 = MIN (x1, pixman_fixed_to_int (MIN (t->left.p1.x, t->left.p2.x)));
+	x2 = MAX (x2, pixman_fixed_to_int (
+		      pixman_fixed_ceil (MAX (t->right.p1.x, t->right.p2.x))));
+    }
+
+    mask = pixman_image_create_bits (PIXMAN_a8, x2 - x1, y2 - y1, NULL, -1);
+    pixman_add_trapezoids (mask, -x1, -y1, shape->n_traps, shape->traps);
+    pixman_image_composite32 (op, src, mask, dest, 0, 0, 0, 0,
+			      x1, y1, x2 - x1, y2 - y1);
+    pixman_image_unref (mask);
+}
+
+static double
+bench (pixman_op_t op, pixman_image_t *src, pixman_image_t *dest,
+       const shape_t *shape, pixman_bool_t each)
+{
+    double start, elapsed;
+    int n = 0;
+
+    start = gettime ();
+
+    do
+    {
+	if (each)
+	{
+	    composite_each (op, src, dest, shape);
+	}
+	else
+	{
+	    pixman_composite_trapezoids (op, src, dest, PIXMAN_a8, 0, 0, 0, 0,
+					 shape->n_traps, shape->traps);
+	}
+	n++;
+
+	elapsed = gettime () - start;
+    }
+    while (elapsed < MIN_SECONDS);
+
+    return elapsed / n * 1000.0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const pixman_color_t color = { 0x8000, 0x4000, 0x2000, 0xc000 };
+    pixman_image_t *src, *dest;
+    shape_t shapes[4];
+    int i;
+
+    prng_srand (0);
+
+    src = pixman_image_create_solid_fill (&color);
+    dest = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, DEST_WIDTH, DEST_HEIGHT, NULL, -1);
+
+    make_disc (&shapes[0], 2000);
+    make_ring (&shapes[1], 2000);
+    make_strokes (&shapes[2], 5000);
+    make_glyphs (&shapes[3], 20000);
+
+    printf ("# OVER with an a8 mask onto a %dx%d a8r8g8b8 destination, "
+	    "ms per call\n", DEST_WIDTH, DEST_HEIGHT);
+    printf ("# %-10s %8s %12s %12s %8s\n",
+	    "shape", "traps", "per trap", "sweep", "speedup");
+
+    for (i = 0; i < ARRAY_LENGTH (shapes); ++i)
+    {
+	double t_each, t_sweep;
+
+	t_each = bench (PIXMAN_OP_OVER, src, dest, &shapes[i], TRUE);
+	t_sweep = bench (PIXMAN_OP_OVER, src, dest, &shapes[i], FALSE);
+
+	printf ("  %-10s %8d %12.3f %12.3f %7.2fx\n",
+		shapes[i].name, shapes[i].n_traps, t_each, t_sweep,
+		t_each / t_sweep);
+
+	free (shapes[i].traps);
+    }
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return 0;
+}
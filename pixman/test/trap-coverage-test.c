@@ -0,0 +1,220 @@
+/*
+ * Checks the exact area coverage that pixman_composite_trapezoids()
+ * produces for a8 masks:
+ *
+ * - It must agree, within the error of point sampling, with the
+ *   coverage that pixman_add_trapezoids() samples trapezoid by
+ *   trapezoid.
+ *
+ * - Rasterizing directly into the destination (the ADD path) and
+ *   compositing through a temporary mask must give identical results.
+ *
+ * - For trapezoids that do not overlap, the sum of the coverage must
+ *   be their total area.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "utils.h"
+
+#define N_TESTS		2000
+#define MAX_SIZE	64
+
+/* pixman_add_trapezoids() takes 15 x 17 samples per pixel for a8;
+ * allow a pixel to be off by two rows of samples.
+ */
+#define MAX_DIFF	(2 * 255 / 15)
+
+static pixman_fixed_t
+random_fixed (int n)
+{
+    return prng_rand_n (n << 16);
+}
+
+static pixman_image_t *
+create_zeroed (pixman_format_code_t format, int width, int height)
+{
+    return pixman_image_create_bits (format, width, height, NULL, -1);
+}
+
+static int
+test_random (int testno)
+{
+    static const pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    int width = prng_rand_n (MAX_SIZE) + 1;
+    int height = prng_rand_n (MAX_SIZE) + 1;
+    int n_traps = prng_rand_n (20) + 1;
+    pixman_image_t *solid, *direct, *masked, *sampled;
+    pixman_trapezoid_t *traps;
+    int x, y, i, max_diff = 0;
+    int failed = 0;
+
+    traps = malloc (n_traps * sizeof (pixman_trapezoid_t));
+
+    for (i = 0; i < n_traps; ++i)
+    {
+	pixman_trapezoid_t *t = &traps[i];
+
+	t->top = random_fixed (height + 8) - pixman_int_to_fixed (4);
+	t->bottom = t->top + random_fixed (height);
+	t->left.p1.x = random_fixed (width + 8) - pixman_int_to_fixed (8);
+	t->left.p1.y = t->top - random_fixed (20);
+	t->left.p2.x = random_fixed (width + 8) - pixman_int_to_fixed (8);
+	t->left.p2.y = t->bottom + random_fixed (20);
+	t->right.p1.x = t->left.p1.x + random_fixed (width);
+	t->right.p1.y = t->top - random_fixed (20);
+	t->right.p2.x = t->left.p2.x + random_fixed (width);
+	t->right.p2.y = t->bottom + random_fixed (20);
+    }
+
+    solid = pixman_image_create_solid_fill (&white);
+    direct = create_zeroed (PIXMAN_a8, width, height);
+    masked = create_zeroed (PIXMAN_a8r8g8b8, width, height);
+    sampled = create_zeroed (PIXMAN_a8, width, height);
+
+    pixman_composite_trapezoids (PIXMAN_OP_ADD, solid, direct, PIXMAN_a8,
+				 0, 0, 0, 0, n_traps, traps);
+    pixman_composite_trapezoids (PIXMAN_OP_OVER, solid, masked, PIXMAN_a8,
+				 0, 0, 0, 0, n_traps, traps);
+    pixman_add_trapezoids (sampled, 0, 0, n_traps, traps);
+
+    for (y = 0; y < height; ++y)
+    {
+	uint8_t *d = (uint8_t *)pixman_image_get_data (direct) +
+	    y * pixman_image_get_stride (direct);
+	uint32_t *m = pixman_image_get_data (masked) +
+	    y * pixman_image_get_stride (masked) / 4;
+	uint8_t *s = (uint8_t *)pixman_image_get_data (sampled) +
+	    y * pixman_image_get_stride (sampled);
+
+	for (x = 0; x < width; ++x)
+	{
+	    if (d[x] != m[x] >> 24)
+	    {
+		printf ("test %d: (%d, %d) is %02x when rasterized directly, "
+			"%02x through a mask\n", testno, x, y, d[x], m[x] >> 24);
+		failed = 1;
+	    }
+
+	    max_diff = MAX (max_diff, abs (d[x] - s[x]));
+	}
+    }
+
+    if (max_diff > MAX_DIFF)
+    {
+	printf ("test %d: coverage differs from sampling by %d\n",
+		testno, max_diff);
+	failed = 1;
+    }
+
+    pixman_image_unref (solid);
+    pixman_image_unref (direct);
+    pixman_image_unref (masked);
+    pixman_image_unref (sampled);
+    free (traps);
+
+    return failed;
+}
+
+/* A polygon with a random number of vertices on an ellipse, cut into
+ * one trapezoid per pair of vertices on each side.
+ */
+static int
+test_area (int testno)
+{
+    static const pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    int width = prng_rand_n (MAX_SIZE) + 8;
+    int height = prng_rand_n (MAX_SIZE) + 8;
+    int n = prng_rand_n (60) + 2;
+    double cx = width / 2.0, cy = height / 2.0;
+    double rx = (width - 2) / 2.0 * (0.5 + prng_rand_n (1000) / 1000.0 / 2);
+    double ry = (height - 2) / 2.0 * (0.5 + prng_rand_n (1000) / 1000.0 / 2);
+    pixman_trapezoid_t *traps;
+    pixman_image_t *solid, *image;
+    double area = 0, sum = 0;
+    int i, x, y, failed = 0;
+
+    traps = malloc (n * sizeof (pixman_trapezoid_t));
+
+    for (i = 0; i < n; ++i)
+    {
+	double a0 = M_PI * i / n, a1 = M_PI * (i + 1) / n;
+	pixman_trapezoid_t *t = &traps[i];
+	pixman_fixed_t y0 = pixman_double_to_fixed (cy - ry * cos (a0));
+	pixman_fixed_t y1 = pixman_double_to_fixed (cy - ry * cos (a1));
+	pixman_fixed_t xl0 = pixman_double_to_fixed (cx - rx * sin (a0));
+	pixman_fixed_t xl1 = pixman_double_to_fixed (cx - rx * sin (a1));
+	pixman_fixed_t xr0 = pixman_double_to_fixed (cx + rx * sin (a0));
+	pixman_fixed_t xr1 = pixman_double_to_fixed (cx + rx * sin (a1));
+
+	t->top = y0;
+	t->bottom = y1;
+	t->left.p1.x = xl0;
+	t->left.p1.y = y0;
+	t->left.p2.x = xl1;
+	t->left.p2.y = y1;
+	t->right.p1.x = xr0;
+	t->right.p1.y = y0;
+	t->right.p2.x = xr1;
+	t->right.p2.y = y1;
+
+	if (y1 > y0)
+	{
+	    area += pixman_fixed_to_double (y1 - y0) *
+		pixman_fixed_to_double ((xr0 - xl0) + (xr1 - xl1)) / 2;
+	}
+    }
+
+    solid = pixman_image_create_solid_fill (&white);
+    image = create_zeroed (PIXMAN_a8, width, height);
+
+    pixman_composite_trapezoids (PIXMAN_OP_ADD, solid, image, PIXMAN_a8,
+				 0, 0, 0, 0, n, traps);
+
+    for (y = 0; y < height; ++y)
+    {
+	uint8_t *p = (uint8_t *)pixman_image_get_data (image) +
+	    y * pixman_image_get_stride (image);
+
+	for (x = 0; x < width; ++x)
+	    sum += p[x] / 255.0;
+    }
+
+    /* Each pixel is rounded to the nearest 1/255 */
+    if (fabs (sum - area) > width * height * 0.5 / 255)
+    {
+	printf ("test %d: covered area is %f, expected %f\n",
+		testno, sum, area);
+	failed = 1;
+    }
+
+    pixman_image_unref (solid);
+    pixman_image_unref (image);
+    free (traps);
+
+    return failed;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    int i, n_failures = 0;
+
+    prng_srand (0);
+
+    for (i = 0; i < N_TESTS; ++i)
+    {
+	if (test_random (i))
+	    n_failures++;
+	if (test_area (i))
+	    n_failures++;
+    }
+
+    if (n_failures)
+    {
+	printf ("%d failures\n", n_failures);
+	return 1;
+    }
+
+    return 0;
+}
@@ -934,6 +934,33 @@ gettime (void)
 #endif
 }
 
+void
+restart_with_disabled_implementations (char **argv, const char *names)
+{
+    const char *env = getenv ("PIXMAN_DISABLE");
+
+    if (env && strcmp (env, names) == 0)
+	return;
+
+#ifdef HAVE_UNISTD_H
+    {
+	char *var = malloc (strlen ("PIXMAN_DISABLE=") + strlen (names) + 1);
+
+	if (var)
+	{
+	    sprintf (var, "PIXMAN_DISABLE=%s", names);
+	    putenv (var);
+	    execvp (argv[0], argv);
+	}
+	perror (argv[0]);
+    }
+#else
+    printf ("Run with PIXMAN_DISABLE=%s set instead.\n", names);
+#endif
+
+    exit (1);
+}
+
 uint32_t
 get_random_seed (void)
 {
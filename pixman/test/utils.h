@@ -129,6 +129,13 @@ gettime (void);
 uint32_t
 get_random_seed (void);
 
+/* Implementations are selected when the library is loaded, so this
+ * re-executes the program with PIXMAN_DISABLE set to @names unless it
+ * already is. Used by the benchmarks to compare implementations.
+ */
+void
+restart_with_disabled_implementations (char **argv, const char *names);
+
 /* main body of the fuzzer test */
 int
 fuzzer_test_main (const char *test_name,
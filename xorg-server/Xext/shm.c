@@ -104,7 +104,6 @@ typedef struct _ShmScrPrivateRec {
 } ShmScrPrivateRec;
 
 static PixmapPtr fbShmCreatePixmap(XSHM_CREATE_PIXMAP_ARGS);
-static int ShmDetachSegment(void *value, XID shmseg);
 static void ShmResetProc(ExtensionEntry *extEntry);
 static void SShmCompletionEvent(xShmCompletionEvent *from,
                                 xShmCompletionEvent *to);
@@ -442,7 +441,7 @@ ProcShmAttach(ClientPtr client)
     return Success;
 }
 
- /*ARGSUSED*/ static int
+ /*ARGSUSED*/ int
 ShmDetachSegment(void *value, /* must conform to DeleteType */
                  XID unused)
 {
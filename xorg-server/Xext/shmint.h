@@ -86,6 +86,12 @@ extern _X_EXPORT void
 extern _X_EXPORT void
  ShmRegisterFbFuncs(ScreenPtr pScreen);
 
+/* Drops a reference taken by incrementing refcnt, detaching the segment
+ * when the last one goes away.
+ */
+extern _X_EXPORT int
+ ShmDetachSegment(void *value, XID unused);
+
 extern _X_EXPORT RESTYPE ShmSegType;
 extern _X_EXPORT int ShmCompletionCode;
 extern _X_EXPORT int BadShmSegCode;
@@ -2534,6 +2534,8 @@ RecalculateDeviceDeliverableEvents(WindowPtr pWin)
     WindowPtr pChild, tmp;
     int i;
 
+    InvalidateDeliveryCache();
+
     pChild = pWin;
     while (1) {
         if ((inputMasks = wOtherInputMasks(pChild)) != 0) {
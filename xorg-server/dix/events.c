@@ -2644,6 +2644,87 @@ EventIsDeliverable(DeviceIntPtr dev, int evtype, WindowPtr win)
     return rc;
 }
 
+/**
+ * Server-wide generation of the per-window delivery caches. Any change to
+ * event selections or to the window hierarchy goes through
+ * RecalculateDeliverableEvents() or RecalculateDeviceDeliverableEvents(),
+ * which bump it and thus invalidate every cache at once.
+ */
+static unsigned long deliveryGeneration = 1;
+
+void
+InvalidateDeliveryCache(void)
+{
+    deliveryGeneration++;
+}
+
+/**
+ * @return TRUE if any client selected for any core, XI or XI2 event, or set
+ * a do-not-propagate mask, on the given window. If this returns FALSE,
+ * EventIsDeliverable() is 0 for every device and event type.
+ */
+static Bool
+WindowHasSelections(WindowPtr win)
+{
+    return win->eventMask || wOtherEventMasks(win) ||
+        wDontPropagateMask(win) || wOtherInputMasks(win);
+}
+
+/**
+ * Bring the delivery cache of the given window up to date.
+ *
+ * Walks up to the nearest ancestor with a valid cache and fills in all
+ * windows on the way, so each window is visited once per generation.
+ */
+static void
+UpdateDeliveryCache(WindowPtr pWin)
+{
+    WindowPtr win, child, run, target;
+    Window targetChild;
+    int depth, n = 0;
+
+    if (pWin->deliveryCache.generation == deliveryGeneration)
+        return;
+
+    for (win = pWin; win && win->deliveryCache.generation != deliveryGeneration;
+         win = win->parent)
+        n++;
+    depth = win ? win->deliveryCache.depth + n : n - 1;
+
+    /* Windows between two ancestors with selections share their target */
+    run = pWin;
+    for (child = pWin, win = pWin->parent;; child = win, win = win->parent) {
+        if (!win) {
+            target = NullWindow;
+            targetChild = None;
+        }
+        else if (WindowHasSelections(win)) {
+            target = win;
+            targetChild = child->drawable.id;
+        }
+        else if (win->deliveryCache.generation == deliveryGeneration) {
+            target = win->deliveryCache.target;
+            targetChild = win->deliveryCache.child;
+        }
+        else
+            continue;
+
+        while (1) {
+            run->deliveryCache.generation = deliveryGeneration;
+            run->deliveryCache.target = target;
+            run->deliveryCache.child = targetChild;
+            run->deliveryCache.depth = depth--;
+            if (run == child)
+                break;
+            run = run->parent;
+        }
+        run = win;
+
+        if (!win || win->deliveryCache.generation == deliveryGeneration)
+            break;
+    }
+}
+
 static int
 DeliverEvent(DeviceIntPtr dev, xEvent *xE, int count,
              WindowPtr win, Window child, GrabPtr grab)
@@ -2721,6 +2802,7 @@ DeliverDeviceEvents(WindowPtr pWin, InternalEvent *event, GrabPtr grab,
                     WindowPtr stopAt, DeviceIntPtr dev)
 {
     Window child = None;
+    WindowPtr next;
     int deliveries = 0;
     int mask;
 
@@ -2759,8 +2841,27 @@ DeliverDeviceEvents(WindowPtr pWin, InternalEvent *event, GrabPtr grab,
             break;
         }
 
-        child = pWin->drawable.id;
-        pWin = pWin->parent;
+        /* Jump straight to the next ancestor anyone selected events on,
+         * unless stopAt may be one of the windows skipped. */
+        UpdateDeliveryCache(pWin);
+        next = pWin->deliveryCache.target;
+        if (!next)
+            break;              /* nobody above us is interested */
+        if (stopAt) {
+            UpdateDeliveryCache(stopAt);
+            if (stopAt->deliveryCache.depth > next->deliveryCache.depth &&
+                stopAt->deliveryCache.depth < pWin->deliveryCache.depth)
+                next = NullWindow;
+        }
+
+        if (next) {
+            child = pWin->deliveryCache.child;
+            pWin = next;
+        }
+        else {
+            child = pWin->drawable.id;
+            pWin = pWin->parent;
+        }
     }
 
     return deliveries;
@@ -4356,6 +4457,8 @@ RecalculateDeliverableEvents(WindowPtr pWin)
     OtherClients *others;
     WindowPtr pChild;
 
+    InvalidateDeliveryCache();
+
     pChild = pWin;
     while (1) {
         if (pChild->optional) {
@@ -158,6 +158,10 @@ static void RebuildTable(int    /*client */
 #define INITHASHSIZE 6
 #define MAXHASHSIZE 16
 
+/* IDs per chunk of the per-client ID usage index */
+#define ID_CHUNK_SHIFT 12
+#define ID_CHUNK_SIZE (1 << ID_CHUNK_SHIFT)
+
 typedef struct _Resource {
     struct _Resource *next;
     XID id;
@@ -172,6 +176,9 @@ typedef struct _ClientResource {
     int hashsize;               /* log(2)(buckets) */
     XID fakeID;
     XID endFakeID;
+    unsigned int *idCounts;     /* resources per ID chunk, client IDs
+                                   first and then SERVER_BIT ones */
+    int idChunks;               /* chunks in each half of idCounts */
 } ClientResourceRec;
 
 RESTYPE lastResourceType;
@@ -653,6 +660,14 @@ InitClientResources(ClientPtr client)
         malloc(INITBUCKETS * sizeof(ResourcePtr));
     if (!clientTable[i].resources)
         return FALSE;
+    clientTable[i].idChunks = (RESOURCE_ID_MASK >> ID_CHUNK_SHIFT) + 1;
+    clientTable[i].idCounts = calloc(2 * clientTable[i].idChunks,
+                                     sizeof(unsigned int));
+    if (!clientTable[i].idCounts) {
+        free(clientTable[i].resources);
+        clientTable[i].resources = NULL;
+        return FALSE;
+    }
     clientTable[i].buckets = INITBUCKETS;
     clientTable[i].elements = 0;
     clientTable[i].hashsize = INITHASHSIZE;
@@ -683,52 +698,90 @@ HashResourceID(XID id, unsigned int numBits)
     return (id ^ (id >> numBits)) & ~((~0) << numBits);
 }
 
-static XID
-AvailableID(int client, XID id, XID maxid, XID goodid)
+/*
+ * The usage count of the ID chunk holding id, or NULL for IDs outside
+ * the indexed client and SERVER_BIT ranges.
+ */
+static unsigned int *
+IDChunkCount(ClientResourceRec *rrec, XID id)
+{
+    if (!rrec->idCounts ||
+        (id & ~(SERVER_BIT | RESOURCE_CLIENT_MASK | RESOURCE_ID_MASK)))
+        return NULL;
+    return &rrec->idCounts[((id & SERVER_BIT) ? rrec->idChunks : 0) +
+                           ((id & RESOURCE_ID_MASK) >> ID_CHUNK_SHIFT)];
+}
+
+static Bool
+IDInUse(int client, XID id)
 {
     ResourcePtr res;
 
-    if ((goodid >= id) && (goodid <= maxid))
-        return goodid;
-    for (; id <= maxid; id++) {
-        res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
-        while (res && (res->id != id))
-            res = res->next;
-        if (!res)
-            return id;
-    }
-    return 0;
+    res = clientTable[client].resources[HashResourceID(id, clientTable[client].hashsize)];
+    while (res && (res->id != id))
+        res = res->next;
+    return res != NULL;
 }
 
+/*
+ * Find a range of unused IDs for the client: the longest run of chunks
+ * that hold no resources, or failing that the longest run of free IDs
+ * in the least used chunk.  Returns 0 for both ends if there are none.
+ */
 void
 GetXIDRange(int client, Bool server, XID *minp, XID *maxp)
 {
-    XID id, maxid;
-    ResourcePtr *resp;
-    ResourcePtr res;
-    int i;
-    XID goodid;
+    ClientResourceRec *rrec = &clientTable[client];
+    unsigned int *counts;
+    XID base, minid, id, maxid, first, last, x;
+    int i, run, best, start;
+
+    base = (Mask) client << CLIENTOFFSET;
+    if (server && client)
+        base |= SERVER_BIT;
+    minid = base | (server && !client ? SERVER_MINID : 0);
+    counts = rrec->idCounts + ((base & SERVER_BIT) ? rrec->idChunks : 0);
+
+    best = start = run = 0;
+    for (i = 0; i < rrec->idChunks; i++) {
+        if (counts[i]) {
+            run = 0;
+        } else if (++run > best) {
+            best = run;
+            start = i - run + 1;
+        }
+    }
+    if (best) {
+        id = base | ((XID) start << ID_CHUNK_SHIFT);
+        maxid = id + ((XID) best << ID_CHUNK_SHIFT) - 1;
+        if (id < minid)
+            id = minid;
+        *minp = id;
+        *maxp = maxid;
+        return;
+    }
 
-    id = (Mask) client << CLIENTOFFSET;
-    if (server)
-        id |= client ? SERVER_BIT : SERVER_MINID;
-    maxid = id | RESOURCE_ID_MASK;
-    goodid = 0;
-    for (resp = clientTable[client].resources, i = clientTable[client].buckets;
-         --i >= 0;) {
-        for (res = *resp++; res; res = res->next) {
-            if ((res->id < id) || (res->id > maxid))
-                continue;
-            if (((res->id - id) >= (maxid - res->id)) ?
-                (goodid = AvailableID(client, id, res->id - 1, goodid)) :
-                !(goodid = AvailableID(client, res->id + 1, maxid, goodid)))
-                maxid = res->id - 1;
-            else
-                id = res->id + 1;
+    for (start = 0, i = 1; i < rrec->idChunks; i++)
+        if (counts[i] < counts[start])
+            start = i;
+    first = base | ((XID) start << ID_CHUNK_SHIFT);
+    last = first + ID_CHUNK_SIZE - 1;
+    if (first < minid)
+        first = minid;
+    id = maxid = 0;
+    for (x = first; x <= last; x++) {
+        XID end;
+
+        if (IDInUse(client, x))
+            continue;
+        for (end = x; end < last && !IDInUse(client, end + 1); end++)
+            ;
+        if (!id || end - x > maxid - id) {
+            id = x;
+            maxid = end;
         }
+        x = end;
     }
-    if (id > maxid)
-        id = maxid = 0;
     *minp = id;
     *maxp = maxid;
 }
@@ -804,6 +857,7 @@ AddResource(XID id, RESTYPE type, void *value)
     int client;
     ClientResourceRec *rrec;
     ResourcePtr res, *head;
+    unsigned int *count;
 
 #ifdef XSERVER_DTRACE
     XSERVER_RESOURCE_ALLOC(id, type, value, TypeNameString(type));
@@ -829,6 +883,8 @@ AddResource(XID id, RESTYPE type, void *value)
     res->value = value;
     *head = res;
     rrec->elements++;
+    if ((count = IDChunkCount(rrec, id)))
+        (*count)++;
     CallResourceStateCallback(ResourceStateAdding, res);
     return TRUE;
 }
@@ -879,6 +935,11 @@ RebuildTable(int client)
 static void
 doFreeResource(ResourcePtr res, Bool skip)
 {
+    unsigned int *count = IDChunkCount(&clientTable[CLIENT_ID(res->id)],
+                                       res->id);
+
+    if (count)
+        (*count)--;
     CallResourceStateCallback(ResourceStateFreeing, res);
 
     if (!skip)
@@ -1154,6 +1215,8 @@ FreeClientResources(ClientPtr client)
     free(clientTable[client->index].resources);
     clientTable[client->index].resources = NULL;
     clientTable[client->index].buckets = 0;
+    free(clientTable[client->index].idCounts);
+    clientTable[client->index].idCounts = NULL;
 }
 
 void
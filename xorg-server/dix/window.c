@@ -498,6 +498,7 @@ SetWindowToDefaults(WindowPtr pWin)
     pWin->eventMask = 0;
     pWin->deliverableEvents = 0;
     pWin->dontPropagate = 0;
+    pWin->deliveryCache.generation = 0;
     pWin->redirectDraw = RedirectDrawNone;
     pWin->forcedBG = FALSE;
     pWin->unhittable = FALSE;
@@ -456,6 +456,9 @@ FixKeyState(DeviceEvent * /* event */ ,
 extern void
 RecalculateDeliverableEvents(WindowPtr /* pWin */ );
 
+extern void
+InvalidateDeliveryCache(void);
+
 extern _X_EXPORT int
 OtherClientGone(void *value,
                 XID id);
@@ -125,6 +125,19 @@ typedef struct _WindowOpt {
 #define RedirectDrawAutomatic	1
 #define RedirectDrawManual	2
 
+/*
+ * Per-window summary used to propagate device events up the tree: the
+ * nearest ancestor on which any client selected any event. The entry is
+ * only valid while generation matches the server-wide delivery generation,
+ * see InvalidateDeliveryCache().
+ */
+typedef struct _WindowDeliveryCache {
+    unsigned long generation;
+    WindowPtr target;           /* NullWindow if no ancestor qualifies */
+    Window child;               /* child of target on the path to us */
+    int depth;                  /* distance from the root window */
+} WindowDeliveryCacheRec;
+
 typedef struct _Window {
     DrawableRec drawable;
     PrivateRec *devPrivates;
@@ -145,6 +158,7 @@ typedef struct _Window {
     PixUnion background;
     PixUnion border;
     WindowOptPtr optional;
+    WindowDeliveryCacheRec deliveryCache;
     unsigned backgroundState:2; /* None, Relative, Pixel, Pixmap */
     unsigned borderIsPixel:1;
     unsigned cursorIsNone:1;    /* else real cursor (might inherit) */
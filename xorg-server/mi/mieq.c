@@ -59,20 +59,39 @@ in this Software without prior written authorization from The Open Group.
 #include <X11/extensions/dpmsconst.h>
 #endif
 
-/* Maximum size should be initial size multiplied by a power of 2 */
-#define QUEUE_INITIAL_SIZE                 1024
-#define QUEUE_RESERVED_SIZE                 64
-#define QUEUE_MAXIMUM_SIZE                4096
+/* Queue size must be a power of 2 */
+#define QUEUE_SIZE                        4096
 #define QUEUE_DROP_BACKTRACE_FREQUENCY     100
 #define QUEUE_DROP_BACKTRACE_MAX            10
 
+/* Number of power-of-two microsecond buckets in the latency histogram */
+#define LATENCY_BUCKETS                     24
+/* Milliseconds between latency reports in the log */
+#define LATENCY_LOG_INTERVAL            (5 * 60 * 1000)
+
 #define EnqueueScreen(dev) dev->spriteInfo->sprite->pEnqueueScreen
 #define DequeueScreen(dev) dev->spriteInfo->sprite->pDequeueScreen
 
+/*
+ * The queue is a fixed-size ring with a single producer and a single
+ * consumer. Producers are serialized by input_lock(), the consumer is
+ * mieqProcessInputEvents() on the main thread, which does not take the
+ * lock. The slot state lets the producer merge a motion event into the
+ * last queued slot only while the consumer has not started reading it.
+ */
+enum SlotState {
+    SLOT_FREE = 0,
+    SLOT_READY,                 /* filled, owned by the consumer */
+    SLOT_WRITING,               /* being merged into by the producer */
+    SLOT_TAKEN,                 /* being read by the consumer */
+};
+
 typedef struct _Event {
     InternalEvent *events;
     ScreenPtr pScreen;
     DeviceIntPtr pDev;          /* device this event _originated_ from */
+    CARD64 enqueued;            /* GetTimeInMicros() when first queued */
+    int state;                  /* enum SlotState */
 } EventRec, *EventPtr;
 
 typedef struct _EventQueue {
@@ -87,88 +106,110 @@ typedef struct _EventQueue {
 
 static EventQueueRec miEventQueue;
 
+/* Time from enqueueing an event until it has been processed and written
+ * to the clients. Bucket i counts latencies below 2^i microseconds. The
+ * histogram is logged and cleared every LATENCY_LOG_INTERVAL. */
+static struct {
+    CARD64 count[LATENCY_BUCKETS];
+    CARD64 events;
+    CARD64 total;
+    CARD64 max;
+    CARD32 since;               /* GetTimeInMillis() when last cleared */
+} miEventLatency;
+
+#if INPUTTHREAD
+#define mieqLoad(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define mieqStore(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define mieqLoad(p)         (*(p))
+#define mieqStore(p, v)     (*(p) = (v))
+#endif
+
+static inline Bool
+mieqSlotTransition(EventPtr e, int from, int to)
+{
+#if INPUTTHREAD
+    return __atomic_compare_exchange_n(&e->state, &from, to, FALSE,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+    if (e->state != from)
+        return FALSE;
+    e->state = to;
+    return TRUE;
+#endif
+}
+
 static size_t
 mieqNumEnqueued(EventQueuePtr eventQueue)
 {
-    size_t n_enqueued = 0;
-
-    if (eventQueue->nevents) {
-        /* % is not well-defined with negative numbers... sigh */
-        n_enqueued = eventQueue->tail - eventQueue->head + eventQueue->nevents;
-        if (n_enqueued >= eventQueue->nevents)
-            n_enqueued -= eventQueue->nevents;
-    }
-    return n_enqueued;
+    return (mieqLoad(&eventQueue->tail) - mieqLoad(&eventQueue->head)) &
+        (eventQueue->nevents - 1);
 }
 
-/* Pre-condition: Called with input_lock held */
-static Bool
-mieqGrowQueue(EventQueuePtr eventQueue, size_t new_nevents)
+static void
+mieqRecordLatency(CARD64 enqueued)
 {
-    size_t i, n_enqueued, first_hunk;
-    EventRec *new_events;
+    CARD64 latency = GetTimeInMicros() - enqueued;
+    int bucket = 0;
 
-    if (!eventQueue) {
-        ErrorF("[mi] mieqGrowQueue called with a NULL eventQueue\n");
-        return FALSE;
-    }
+    while (bucket < LATENCY_BUCKETS - 1 && (latency >> bucket))
+        bucket++;
 
-    if (new_nevents <= eventQueue->nevents)
-        return FALSE;
-
-    new_events = calloc(new_nevents, sizeof(EventRec));
-    if (new_events == NULL) {
-        ErrorF("[mi] mieqGrowQueue memory allocation error.\n");
-        return FALSE;
-    }
+    miEventLatency.count[bucket]++;
+    miEventLatency.events++;
+    miEventLatency.total += latency;
+    if (latency > miEventLatency.max)
+        miEventLatency.max = latency;
+}
 
-    n_enqueued = mieqNumEnqueued(eventQueue);
+static void
+mieqLogLatency(void)
+{
+    CARD32 now = GetTimeInMillis();
+    int i;
 
-    /* First copy the existing events */
-    first_hunk = eventQueue->nevents - eventQueue->head;
-    if (eventQueue->events) {
-        memcpy(new_events,
-               &eventQueue->events[eventQueue->head],
-               first_hunk * sizeof(EventRec));
-        memcpy(&new_events[first_hunk],
-               eventQueue->events, eventQueue->head * sizeof(EventRec));
+    if (!miEventLatency.events) {
+        miEventLatency.since = now;
+        return;
     }
 
-    /* Initialize the new portion */
-    for (i = eventQueue->nevents; i < new_nevents; i++) {
-        InternalEvent *evlist = InitEventList(1);
-
-        if (!evlist) {
-            size_t j;
-
-            for (j = 0; j < i; j++)
-                FreeEventList(new_events[j].events, 1);
-            free(new_events);
-            return FALSE;
-        }
-        new_events[i].events = evlist;
+    LogMessageVerb(X_INFO, 7, "[mi] EQ latency over %u s: %llu events, "
+                   "mean %llu us, max %llu us\n",
+                   (unsigned int) ((now - miEventLatency.since) / 1000),
+                   (unsigned long long) miEventLatency.events,
+                   (unsigned long long) (miEventLatency.total /
+                                         miEventLatency.events),
+                   (unsigned long long) miEventLatency.max);
+    for (i = 0; i < LATENCY_BUCKETS; i++) {
+        if (miEventLatency.count[i])
+            LogMessageVerb(X_INFO, 7, "[mi] EQ latency < %llu us: %llu\n",
+                           1ULL << i,
+                           (unsigned long long) miEventLatency.count[i]);
     }
 
-    /* And update our record */
-    eventQueue->tail = n_enqueued;
-    eventQueue->head = 0;
-    eventQueue->nevents = new_nevents;
-    free(eventQueue->events);
-    eventQueue->events = new_events;
-
-    return TRUE;
+    memset(&miEventLatency, 0, sizeof(miEventLatency));
+    miEventLatency.since = now;
 }
 
 Bool
 mieqInit(void)
 {
+    InternalEvent *evlist;
+    size_t i;
+
     memset(&miEventQueue, 0, sizeof(miEventQueue));
+    memset(&miEventLatency, 0, sizeof(miEventLatency));
     miEventQueue.lastEventTime = GetTimeInMillis();
+    miEventLatency.since = miEventQueue.lastEventTime;
 
-    input_lock();
-    if (!mieqGrowQueue(&miEventQueue, QUEUE_INITIAL_SIZE))
+    miEventQueue.events = calloc(QUEUE_SIZE, sizeof(EventRec));
+    evlist = InitEventList(QUEUE_SIZE);
+    if (!miEventQueue.events || !evlist)
         FatalError("Could not allocate event queue.\n");
-    input_unlock();
+
+    for (i = 0; i < QUEUE_SIZE; i++)
+        miEventQueue.events[i].events = &evlist[i];
+    miEventQueue.nevents = QUEUE_SIZE;
 
     SetInputCheck(&miEventQueue.head, &miEventQueue.tail);
     return TRUE;
@@ -177,15 +218,33 @@ mieqInit(void)
 void
 mieqFini(void)
 {
-    int i;
+    mieqLogLatency();
 
-    for (i = 0; i < miEventQueue.nevents; i++) {
-        if (miEventQueue.events[i].events != NULL) {
-            FreeEventList(miEventQueue.events[i].events, 1);
-            miEventQueue.events[i].events = NULL;
-        }
+    if (miEventQueue.events) {
+        FreeEventList(miEventQueue.events[0].events, miEventQueue.nevents);
+        free(miEventQueue.events);
+        miEventQueue.events = NULL;
     }
-    free(miEventQueue.events);
+}
+
+static void
+mieqFillSlot(EventPtr slot, DeviceIntPtr pDev, InternalEvent *e)
+{
+    InternalEvent *evt = slot->events;
+    Time time;
+
+    memcpy(evt, e, e->any.length);
+
+    time = e->any.time;
+    /* Make sure that event times don't go backwards - this
+     * is "unnecessary", but very useful. */
+    if (time < miEventQueue.lastEventTime &&
+        miEventQueue.lastEventTime - time < 10000)
+        e->any.time = miEventQueue.lastEventTime;
+
+    miEventQueue.lastEventTime = evt->any.time;
+    slot->pScreen = pDev ? EnqueueScreen(pDev) : NULL;
+    slot->pDev = pDev;
 }
 
 /*
@@ -197,72 +256,62 @@ void
 mieqEnqueue(DeviceIntPtr pDev, InternalEvent *e)
 {
     unsigned int oldtail = miEventQueue.tail;
-    InternalEvent *evt;
+    EventPtr slot;
     int isMotion = 0;
-    int evlen;
-    Time time;
-    size_t n_enqueued;
 
     verify_internal_event(e);
 
-    n_enqueued = mieqNumEnqueued(&miEventQueue);
-
     /* avoid merging events from different devices */
     if (e->any.type == ET_Motion)
         isMotion = pDev->id;
 
+    /* Merge into the previous motion event unless the consumer has
+     * already started on it */
     if (isMotion && isMotion == miEventQueue.lastMotion &&
-        oldtail != miEventQueue.head) {
-        oldtail = (oldtail - 1) % miEventQueue.nevents;
-    }
-    else if (n_enqueued + 1 == miEventQueue.nevents) {
-        if (!mieqGrowQueue(&miEventQueue, miEventQueue.nevents << 1)) {
-            /* Toss events which come in late.  Usually this means your server's
-             * stuck in an infinite loop in the main thread.
-             */
-            miEventQueue.dropped++;
-            if (miEventQueue.dropped == 1) {
-                ErrorFSigSafe("[mi] EQ overflowing.  Additional events will be "
-                              "discarded until existing events are processed.\n");
-                xorg_backtrace();
-                ErrorFSigSafe("[mi] These backtraces from mieqEnqueue may point to "
-                              "a culprit higher up the stack.\n");
-                ErrorFSigSafe("[mi] mieq is *NOT* the cause.  It is a victim.\n");
-            }
-            else if (miEventQueue.dropped % QUEUE_DROP_BACKTRACE_FREQUENCY == 0 &&
-                     miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY <=
-                     QUEUE_DROP_BACKTRACE_MAX) {
-                ErrorFSigSafe("[mi] EQ overflow continuing.  %zu events have been "
-                              "dropped.\n", miEventQueue.dropped);
-                if (miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY ==
-                    QUEUE_DROP_BACKTRACE_MAX) {
-                    ErrorFSigSafe("[mi] No further overflow reports will be "
-                                  "reported until the clog is cleared.\n");
-                }
-                xorg_backtrace();
-            }
+        oldtail != mieqLoad(&miEventQueue.head)) {
+        slot = &miEventQueue.events[(oldtail - 1) & (miEventQueue.nevents - 1)];
+        if (mieqSlotTransition(slot, SLOT_READY, SLOT_WRITING)) {
+            mieqFillSlot(slot, pDev, e);
+            mieqStore(&slot->state, SLOT_READY);
             return;
         }
-        oldtail = miEventQueue.tail;
     }
 
-    evlen = e->any.length;
-    evt = miEventQueue.events[oldtail].events;
-    memcpy(evt, e, evlen);
-
-    time = e->any.time;
-    /* Make sure that event times don't go backwards - this
-     * is "unnecessary", but very useful. */
-    if (time < miEventQueue.lastEventTime &&
-        miEventQueue.lastEventTime - time < 10000)
-        e->any.time = miEventQueue.lastEventTime;
+    if (mieqNumEnqueued(&miEventQueue) + 1 == miEventQueue.nevents) {
+        /* Toss events which come in late.  Usually this means your server's
+         * stuck in an infinite loop in the main thread.
+         */
+        miEventQueue.dropped++;
+        if (miEventQueue.dropped == 1) {
+            ErrorFSigSafe("[mi] EQ overflowing.  Additional events will be "
+                          "discarded until existing events are processed.\n");
+            xorg_backtrace();
+            ErrorFSigSafe("[mi] These backtraces from mieqEnqueue may point to "
+                          "a culprit higher up the stack.\n");
+            ErrorFSigSafe("[mi] mieq is *NOT* the cause.  It is a victim.\n");
+        }
+        else if (miEventQueue.dropped % QUEUE_DROP_BACKTRACE_FREQUENCY == 0 &&
+                 miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY <=
+                 QUEUE_DROP_BACKTRACE_MAX) {
+            ErrorFSigSafe("[mi] EQ overflow continuing.  %zu events have been "
+                          "dropped.\n", miEventQueue.dropped);
+            if (miEventQueue.dropped / QUEUE_DROP_BACKTRACE_FREQUENCY ==
+                QUEUE_DROP_BACKTRACE_MAX) {
+                ErrorFSigSafe("[mi] No further overflow reports will be "
+                              "reported until the clog is cleared.\n");
+            }
+            xorg_backtrace();
+        }
+        return;
+    }
 
-    miEventQueue.lastEventTime = evt->any.time;
-    miEventQueue.events[oldtail].pScreen = pDev ? EnqueueScreen(pDev) : NULL;
-    miEventQueue.events[oldtail].pDev = pDev;
+    slot = &miEventQueue.events[oldtail];
+    mieqFillSlot(slot, pDev, e);
+    slot->enqueued = GetTimeInMicros();
+    slot->state = SLOT_READY;
 
     miEventQueue.lastMotion = isMotion;
-    miEventQueue.tail = (oldtail + 1) % miEventQueue.nevents;
+    mieqStore(&miEventQueue.tail, (oldtail + 1) & (miEventQueue.nevents - 1));
 }
 
 /**
@@ -507,10 +556,10 @@ mieqProcessInputEvents(void)
     ScreenPtr screen;
     InternalEvent event;
     DeviceIntPtr dev = NULL, master = NULL;
+    CARD64 enqueued;
+    unsigned int head;
     static Bool inProcessInputEvents = FALSE;
 
-    input_lock();
-
     /*
      * report an error if mieqProcessInputEvents() is called recursively;
      * this can happen, e.g., if something in the mieqProcessDeviceEvent()
@@ -519,6 +568,7 @@ mieqProcessInputEvents(void)
     BUG_WARN_MSG(inProcessInputEvents, "[mi] mieqProcessInputEvents() called recursively.\n");
     inProcessInputEvents = TRUE;
 
+    input_lock();
     if (miEventQueue.dropped) {
         ErrorF("[mi] EQ processing has resumed after %lu dropped events.\n",
                (unsigned long) miEventQueue.dropped);
@@ -526,17 +576,25 @@ mieqProcessInputEvents(void)
             ("[mi] This may be caused by a misbehaving driver monopolizing the server's resources.\n");
         miEventQueue.dropped = 0;
     }
+    input_unlock();
+
+    while ((head = miEventQueue.head) != mieqLoad(&miEventQueue.tail)) {
+        e = &miEventQueue.events[head];
 
-    while (miEventQueue.head != miEventQueue.tail) {
-        e = &miEventQueue.events[miEventQueue.head];
+        /* The producer is merging a motion event into this slot. Leave it
+         * for the next pass instead of waiting: head != tail keeps
+         * InputCheckPending() true, and the input thread wakes the main
+         * thread once it is done. */
+        if (!mieqSlotTransition(e, SLOT_READY, SLOT_TAKEN))
+            break;
 
         event = *e->events;
         dev = e->pDev;
         screen = e->pScreen;
+        enqueued = e->enqueued;
 
-        miEventQueue.head = (miEventQueue.head + 1) % miEventQueue.nevents;
-
-        input_unlock();
+        mieqStore(&e->state, SLOT_FREE);
+        mieqStore(&miEventQueue.head, (head + 1) & (miEventQueue.nevents - 1));
 
         master = (dev) ? GetMaster(dev, MASTER_ATTACHED) : NULL;
 
@@ -560,10 +618,11 @@ mieqProcessInputEvents(void)
               event.device_event.flags & TOUCH_POINTER_EMULATED)))
             miPointerUpdateSprite(dev);
 
-        input_lock();
+        mieqRecordLatency(enqueued);
     }
 
-    inProcessInputEvents = FALSE;
+    if (GetTimeInMillis() - miEventLatency.since >= LATENCY_LOG_INTERVAL)
+        mieqLogLatency();
 
-    input_unlock();
+    inProcessInputEvents = FALSE;
 }
@@ -27,13 +27,21 @@
 #include "present_priv.h"
 #include "list.h"
 
-static struct xorg_list fake_vblank_queue;
+/*
+ * Software vblank clock for screens and windows without a CRTC.
+ *
+ * Each screen ticks every fake_interval microseconds, with MSC n falling
+ * exactly at n * fake_interval on the GetTimeInMicros clock.  All pending
+ * vblanks of a screen sit on one list sorted by MSC, and a single timer
+ * is armed for the earliest of them; when it fires, every vblank that is
+ * due is executed in the same pass and reported with the tick's nominal
+ * UST, so timestamps don't pick up timer latency.
+ */
 
 typedef struct present_fake_vblank {
     struct xorg_list            list;
     uint64_t                    event_id;
-    OsTimerPtr                  timer;
-    ScreenPtr                   screen;
+    uint64_t                    msc;
 } present_fake_vblank_rec, *present_fake_vblank_ptr;
 
 int
@@ -41,18 +49,52 @@ present_fake_get_ust_msc(ScreenPtr screen, uint64_t *ust, uint64_t *msc)
 {
     present_screen_priv_ptr screen_priv = present_screen_priv(screen);
 
-    *ust = GetTimeInMicros();
-    *msc = (*ust + screen_priv->fake_interval / 2) / screen_priv->fake_interval;
+    /* Like a real CRTC, report the most recent vblank */
+    *msc = GetTimeInMicros() / screen_priv->fake_interval;
+    *ust = *msc * screen_priv->fake_interval;
     return Success;
 }
 
-static void
-present_fake_notify(ScreenPtr screen, uint64_t event_id)
+static CARD32
+present_fake_do_timer(OsTimerPtr timer, CARD32 time, void *arg);
+
+/*
+ * Make sure the screen timer fires in time for the first queued vblank.
+ * The delay is rounded up so the timer never fires before the tick.
+ */
+static Bool
+present_fake_arm_timer(ScreenPtr screen)
 {
-    uint64_t                    ust, msc;
+    present_screen_priv_ptr     screen_priv = present_screen_priv(screen);
+    present_fake_vblank_ptr     first;
+    uint64_t                    ust, now;
+    CARD32                      delay;
+    OsTimerPtr                  timer;
 
-    present_fake_get_ust_msc(screen, &ust, &msc);
-    present_event_notify(event_id, ust, msc);
+    if (xorg_list_is_empty(&screen_priv->fake_vblank_queue)) {
+        if (screen_priv->fake_timer)
+            TimerCancel(screen_priv->fake_timer);
+        screen_priv->fake_timer_msc = 0;
+        return TRUE;
+    }
+
+    first = xorg_list_first_entry(&screen_priv->fake_vblank_queue,
+                                  present_fake_vblank_rec, list);
+    if (screen_priv->fake_timer_msc &&
+        screen_priv->fake_timer_msc <= first->msc)
+        return TRUE;
+
+    ust = first->msc * screen_priv->fake_interval;
+    now = GetTimeInMicros();
+    delay = ust > now ? (ust - now + 999) / 1000 : 1;
+
+    timer = TimerSet(screen_priv->fake_timer, 0, delay,
+                     present_fake_do_timer, screen);
+    if (!timer)
+        return FALSE;
+    screen_priv->fake_timer = timer;
+    screen_priv->fake_timer_msc = first->msc;
+    return TRUE;
 }
 
 static CARD32
@@ -60,23 +102,45 @@ present_fake_do_timer(OsTimerPtr timer,
                       CARD32 time,
                       void *arg)
 {
-    present_fake_vblank_ptr     fake_vblank = arg;
+    ScreenPtr                   screen = arg;
+    present_screen_priv_ptr     screen_priv = present_screen_priv(screen);
+    present_fake_vblank_ptr     fake_vblank, tmp;
+    struct xorg_list            due;
+    uint64_t                    ust, msc;
+
+    screen_priv->fake_timer_msc = 0;
+    present_fake_get_ust_msc(screen, &ust, &msc);
+
+    /* Take everything that is due off the queue before executing any of
+     * it, as executing a vblank may queue or abort others.
+     */
+    xorg_list_init(&due);
+    xorg_list_for_each_entry_safe(fake_vblank, tmp, &screen_priv->fake_vblank_queue, list) {
+        if (fake_vblank->msc > msc)
+            break;
+        xorg_list_del(&fake_vblank->list);
+        xorg_list_append(&fake_vblank->list, &due);
+    }
+
+    while (!xorg_list_is_empty(&due)) {
+        fake_vblank = xorg_list_first_entry(&due, present_fake_vblank_rec, list);
+        xorg_list_del(&fake_vblank->list);
+        present_event_notify(fake_vblank->event_id, ust, msc);
+        free(fake_vblank);
+    }
 
-    present_fake_notify(fake_vblank->screen, fake_vblank->event_id);
-    xorg_list_del(&fake_vblank->list);
-    TimerFree(fake_vblank->timer);
-    free(fake_vblank);
+    present_fake_arm_timer(screen);
     return 0;
 }
 
 void
 present_fake_abort_vblank(ScreenPtr screen, uint64_t event_id, uint64_t msc)
 {
+    present_screen_priv_ptr     screen_priv = present_screen_priv(screen);
     present_fake_vblank_ptr     fake_vblank, tmp;
 
-    xorg_list_for_each_entry_safe(fake_vblank, tmp, &fake_vblank_queue, list) {
+    xorg_list_for_each_entry_safe(fake_vblank, tmp, &screen_priv->fake_vblank_queue, list) {
         if (fake_vblank->event_id == event_id) {
-            TimerFree(fake_vblank->timer); /* TimerFree will call TimerCancel() */
             xorg_list_del(&fake_vblank->list);
             free (fake_vblank);
             break;
@@ -90,13 +154,13 @@ present_fake_queue_vblank(ScreenPtr     screen,
                           uint64_t      msc)
 {
     present_screen_priv_ptr     screen_priv = present_screen_priv(screen);
-    uint64_t                    ust = msc * screen_priv->fake_interval;
-    uint64_t                    now = GetTimeInMicros();
-    INT32                       delay = ((int64_t) (ust - now)) / 1000;
     present_fake_vblank_ptr     fake_vblank;
+    struct xorg_list            *pos;
+    uint64_t                    ust, now;
 
-    if (delay <= 0) {
-        present_fake_notify(screen, event_id);
+    present_fake_get_ust_msc(screen, &ust, &now);
+    if (msc <= now) {
+        present_event_notify(event_id, ust, now);
         return Success;
     }
 
@@ -104,16 +168,28 @@ present_fake_queue_vblank(ScreenPtr     screen,
     if (!fake_vblank)
         return BadAlloc;
 
-    fake_vblank->screen = screen;
     fake_vblank->event_id = event_id;
-    fake_vblank->timer = TimerSet(NULL, 0, delay, present_fake_do_timer, fake_vblank);
-    if (!fake_vblank->timer) {
+    fake_vblank->msc = msc;
+
+    /* Most vblanks are for the next tick or later than everything else
+     * queued, so look for the insertion point from the end.
+     */
+    for (pos = screen_priv->fake_vblank_queue.prev;
+         pos != &screen_priv->fake_vblank_queue;
+         pos = pos->prev) {
+        present_fake_vblank_ptr prev = xorg_list_entry(pos, present_fake_vblank_rec, list);
+
+        if (prev->msc <= msc)
+            break;
+    }
+    xorg_list_add(&fake_vblank->list, pos);
+
+    if (!present_fake_arm_timer(screen)) {
+        xorg_list_del(&fake_vblank->list);
         free(fake_vblank);
         return BadAlloc;
     }
 
-    xorg_list_add(&fake_vblank->list, &fake_vblank_queue);
-
     return Success;
 }
 
@@ -135,7 +211,16 @@ present_fake_screen_init(ScreenPtr screen)
 }
 
 void
-present_fake_queue_init(void)
+present_fake_screen_fini(ScreenPtr screen)
 {
-    xorg_list_init(&fake_vblank_queue);
+    present_screen_priv_ptr     screen_priv = present_screen_priv(screen);
+    present_fake_vblank_ptr     fake_vblank, tmp;
+
+    TimerFree(screen_priv->fake_timer); /* TimerFree will call TimerCancel() */
+    screen_priv->fake_timer = NULL;
+
+    xorg_list_for_each_entry_safe(fake_vblank, tmp, &screen_priv->fake_vblank_queue, list) {
+        xorg_list_del(&fake_vblank->list);
+        free(fake_vblank);
+    }
 }
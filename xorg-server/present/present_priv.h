@@ -152,7 +152,11 @@ struct present_screen_priv {
     present_vblank_ptr          flip_pending;
     uint64_t                    unflip_event_id;
 
+    /* Software vblank clock, see present_fake.c */
     uint32_t                    fake_interval;
+    OsTimerPtr                  fake_timer;
+    uint64_t                    fake_timer_msc; /* 0 if not armed */
+    struct xorg_list            fake_vblank_queue;
 
     /* Currently active flipped pixmap and fence */
     RRCrtcPtr                   flip_crtc;
@@ -229,6 +233,13 @@ struct present_window_priv {
 
     present_vblank_ptr     flip_pending;
     present_vblank_ptr     flip_active;
+
+    /* Frame timing of completed PresentPixmap requests */
+    uint64_t               frames;
+    uint64_t               frames_missed;   /* completed after target MSC */
+    uint64_t               frame_ust;       /* UST of the last completion */
+    uint64_t               frame_interval_sum;
+    uint64_t               frame_interval_max;
 };
 
 #define PresentCrtcNeverSet     ((RRCrtcPtr) 1)
@@ -364,7 +375,7 @@ void
 present_fake_screen_init(ScreenPtr screen);
 
 void
-present_fake_queue_init(void);
+present_fake_screen_fini(ScreenPtr screen);
 
 /*
  * present_fence.c
@@ -478,6 +489,9 @@ present_vblank_scrap(present_vblank_ptr vblank);
 void
 present_vblank_destroy(present_vblank_ptr vblank);
 
+void
+present_vblank_log_stats(WindowPtr window);
+
 /*
  * present_wnmd.c
  */
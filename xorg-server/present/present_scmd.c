@@ -825,6 +825,5 @@ present_init(void)
 {
     xorg_list_init(&present_exec_queue);
     xorg_list_init(&present_flip_queue);
-    present_fake_queue_init();
     return TRUE;
 }
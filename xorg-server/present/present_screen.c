@@ -65,6 +65,7 @@ present_close_screen(ScreenPtr screen)
     present_screen_priv_ptr screen_priv = present_screen_priv(screen);
 
     screen_priv->flip_destroy(screen);
+    present_fake_screen_fini(screen);
 
     unwrap(screen_priv, screen, CloseScreen);
     (*screen->CloseScreen) (screen);
@@ -147,6 +148,7 @@ present_destroy_window(WindowPtr window)
     present_window_priv_ptr window_priv = present_window_priv(window);
 
     if (window_priv) {
+        present_vblank_log_stats(window);
         present_clear_window_notifies(window);
         present_free_events(window);
         present_free_window_vblank(window);
@@ -228,6 +230,8 @@ present_screen_priv_init(ScreenPtr screen)
     if (!screen_priv)
         return NULL;
 
+    xorg_list_init(&screen_priv->fake_vblank_queue);
+
     wrap(screen_priv, screen, CloseScreen, present_close_screen);
     wrap(screen_priv, screen, DestroyWindow, present_destroy_window);
     wrap(screen_priv, screen, ConfigNotify, present_config_notify);
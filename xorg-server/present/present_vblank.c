@@ -26,11 +26,61 @@
 
 #include "present_priv.h"
 
+/*
+ * Account a completed presentation in the window's frame timing
+ */
+static void
+present_vblank_account(present_vblank_ptr vblank, uint64_t ust, uint64_t crtc_msc)
+{
+    present_window_priv_ptr     window_priv = present_window_priv(vblank->window);
+
+    if (!window_priv)
+        return;
+
+    if (msc_is_after(crtc_msc, vblank->target_msc))
+        window_priv->frames_missed++;
+
+    if (window_priv->frames && ust > window_priv->frame_ust) {
+        uint64_t interval = ust - window_priv->frame_ust;
+
+        window_priv->frame_interval_sum += interval;
+        if (interval > window_priv->frame_interval_max)
+            window_priv->frame_interval_max = interval;
+    }
+    window_priv->frame_ust = ust;
+    window_priv->frames++;
+}
+
+/*
+ * Log the frame timing of a window that presented pixmaps
+ */
+void
+present_vblank_log_stats(WindowPtr window)
+{
+    present_window_priv_ptr     window_priv = present_window_priv(window);
+
+    if (!window_priv || window_priv->frames < 2)
+        return;
+
+    LogMessageVerb(X_INFO, 3,
+                   "present: window 0x%08lx: %" PRIu64 " frames, %"
+                   PRIu64 " missed, interval mean %" PRIu64 " us, max %"
+                   PRIu64 " us\n",
+                   (unsigned long) window->drawable.id, window_priv->frames,
+                   window_priv->frames_missed,
+                   window_priv->frame_interval_sum / (window_priv->frames - 1),
+                   window_priv->frame_interval_max);
+}
+
 void
 present_vblank_notify(present_vblank_ptr vblank, CARD8 kind, CARD8 mode, uint64_t ust, uint64_t crtc_msc)
 {
     int n;
 
+    if (vblank->window && kind == PresentCompleteKindPixmap &&
+        mode != PresentCompleteModeSkip)
+        present_vblank_account(vblank, ust, crtc_msc);
+
     if (vblank->window)
         present_send_complete_notify(vblank->window, kind, mode, vblank->serial, ust, crtc_msc - vblank->msc_offset);
     for (n = 0; n < vblank->num_notifies; n++) {
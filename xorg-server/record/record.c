@@ -56,6 +56,11 @@ and Jim Haggerty of Metheus.
 #include "cursor.h"
 #endif
 
+#ifdef MITSHM
+#include "shmint.h"
+#include "recordshm.h"
+#endif
+
 #include "protocol-versions.h"
 
 static RESTYPE RTContext;       /* internal resource type for Record contexts */
@@ -65,6 +70,45 @@ static RESTYPE RTContext;       /* internal resource type for Record contexts */
  */
 #define REPLY_BUF_SIZE 1024
 
+#ifdef MITSHM
+
+/* Smallest data area accepted for a shared memory ring. */
+#define RECORD_SHM_RING_MIN 4096
+
+/* The ring header is also written by the recording client, so accesses to
+ * head and tail must be ordered against the data they guard.
+ */
+#if defined(__GNUC__)
+#define RecordShmLoad(_p)	__atomic_load_n((_p), __ATOMIC_ACQUIRE)
+#define RecordShmStore(_p, _v)	__atomic_store_n((_p), (_v), __ATOMIC_RELEASE)
+#else
+#define RecordShmLoad(_p)	(*(volatile CARD32 *) (_p))
+#define RecordShmStore(_p, _v)	(*(volatile CARD32 *) (_p) = (_v))
+#endif
+
+/* what to do with the rest of the record currently being written */
+#define RING_COPY	0       /* copy it into the ring */
+#define RING_REPLY	1       /* send it as an ordinary reply */
+#define RING_DROP	2       /* discard it */
+
+/* Shared memory ring of a RecordShmEnableContext context */
+typedef struct {
+    ShmDescPtr shmdesc;         /* segment holding the ring, referenced */
+    xRecordShmRing *pHeader;    /* shared header */
+    char *pData;                /* shared data area, follows the header */
+    CARD32 size;                /* size of pData, a power of two */
+    CARD32 head;                /* bytes written, including unpublished */
+    CARD32 published;           /* head as last published */
+    CARD32 wakeHead;            /* head published at the last wakeup */
+    CARD32 sequence;            /* sequence number of the next record */
+    CARD32 dropped;             /* records dropped for lack of space */
+    CARD32 remaining;           /* bytes left of the current record */
+    int state;                  /* RING_* for the current record */
+    int dropPolicy;             /* XRecordShmDropNewest or Fallback */
+} RecordShmRingRec, *RecordShmRingPtr;
+
+#endif                          /* MITSHM */
+
 /* Record Context structure */
 
 typedef struct {
@@ -78,6 +122,9 @@ typedef struct {
     int numBufBytes;            /* number of bytes in replyBuffer */
     char replyBuffer[REPLY_BUF_SIZE];   /* buffered recorded protocol */
     int inFlush;                /*  are we inside RecordFlushReplyBuffer */
+#ifdef MITSHM
+    RecordShmRingPtr pRing;     /* non-NULL if enabled with RecordShmEnableContext */
+#endif
 } RecordContextRec, *RecordContextPtr;
 
 /*  RecordMinorOpRec - to hold minor opcode selections for extension requests
@@ -213,6 +260,227 @@ RecordFindContextOnAllContexts(RecordContextPtr pContext)
 
 /***************************************************************************/
 
+#ifdef MITSHM
+
+/* RecordShmRingCopy
+ *
+ * Arguments:
+ *	pRing is the ring to write to.
+ *	data is a pointer to the data, and len is its length in bytes.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	The data is copied into the ring at the current head, wrapping
+ *	around the end of the data area if needed, and head is advanced.
+ *	The caller has checked that there is room.
+ */
+static void
+RecordShmRingCopy(RecordShmRingPtr pRing, const char *data, CARD32 len)
+{
+    CARD32 offset = pRing->head & (pRing->size - 1);
+    CARD32 n = min(len, pRing->size - offset);
+
+    memcpy(pRing->pData + offset, data, n);
+    if (len > n)
+        memcpy(pRing->pData, data + n, len - n);
+    pRing->head += len;
+}                               /* RecordShmRingCopy */
+
+/* RecordShmRingEndRecord
+ *
+ * Arguments:
+ *	pRing is the ring whose current record is complete.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	If the record was copied into the ring, it is published to the
+ *	recording client by storing the new head.
+ */
+static void
+RecordShmRingEndRecord(RecordShmRingPtr pRing)
+{
+    xRecordShmRing *pHeader = pRing->pHeader;
+
+    pHeader->sequence = pRing->sequence;
+    pHeader->dropped = pRing->dropped;
+    if (pRing->state == RING_COPY) {
+        pRing->published = pRing->head;
+        RecordShmStore(&pHeader->head, pRing->published);
+    }
+}                               /* RecordShmRingEndRecord */
+
+/* RecordShmRingWrite
+ *
+ * Arguments:
+ *	pContext is a context enabled with RecordShmEnableContext.
+ *	data is a pointer to reply data, and len is its length in bytes.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	The data continues the stream of replies that RecordFlushReplyBuffer
+ *	would otherwise write to the recording client.  At the start of each
+ *	reply, which always arrives in one piece from the context's
+ *	replyBuffer, the whole record is either reserved in the ring, sent
+ *	as a reply, or dropped according to the context's drop policy, and
+ *	it is stamped with the next ring sequence number.
+ */
+static void
+RecordShmRingWrite(RecordContextPtr pContext, int len, char *data)
+{
+    RecordShmRingPtr pRing = pContext->pRing;
+    ClientPtr pRecordingClient = pContext->pRecordingClient;
+
+    while (len > 0) {
+        CARD32 n;
+
+        if (!pRing->remaining) {
+            xRecordEnableContextReply rep;
+            CARD32 replylen, tail, used;
+
+            if (len < sizeof(rep)) {    /* shouldn't happen */
+                WriteToClient(pRecordingClient, len, data);
+                return;
+            }
+            memcpy(&rep, data, sizeof(rep));
+            replylen = rep.length;
+            rep.pad3 = pRing->sequence++;
+            if (pRecordingClient->swapped) {
+                swapl(&replylen);
+                swapl(&rep.pad3);
+            }
+            pRing->remaining = sizeof(rep) + (replylen << 2);
+
+            tail = RecordShmLoad(&pRing->pHeader->tail);
+            used = pRing->head - tail;
+
+            if (rep.category == XRecordStartOfData ||
+                rep.category == XRecordEndOfData)
+                pRing->state = RING_REPLY;
+            else if (used <= pRing->size &&
+                     pRing->remaining <= pRing->size - used)
+                pRing->state = RING_COPY;
+            else if (pRing->dropPolicy == XRecordShmFallback)
+                pRing->state = RING_REPLY;
+            else {
+                pRing->state = RING_DROP;
+                pRing->dropped++;
+            }
+
+            if (pRing->state == RING_COPY)
+                RecordShmRingCopy(pRing, (char *) &rep, sizeof(rep));
+            else if (pRing->state == RING_REPLY)
+                WriteToClient(pRecordingClient, sizeof(rep), &rep);
+            n = sizeof(rep);
+        }
+        else {
+            n = min((CARD32) len, pRing->remaining);
+            if (pRing->state == RING_COPY)
+                RecordShmRingCopy(pRing, data, n);
+            else if (pRing->state == RING_REPLY)
+                WriteToClient(pRecordingClient, n, data);
+        }
+        data += n;
+        len -= n;
+        pRing->remaining -= n;
+        if (!pRing->remaining)
+            RecordShmRingEndRecord(pRing);
+    }
+}                               /* RecordShmRingWrite */
+
+/* RecordShmRingWakeup
+ *
+ * Arguments:
+ *	pContext is a context enabled with RecordShmEnableContext.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	If records were published since the last wakeup and the recording
+ *	client has consumed everything published up to that wakeup, a
+ *	ShmWakeup reply is sent.  A client still draining the ring gets no
+ *	wakeup; it will find the new records before it waits again.
+ */
+static void
+RecordShmRingWakeup(RecordContextPtr pContext)
+{
+    RecordShmRingPtr pRing = pContext->pRing;
+    ClientPtr pRecordingClient = pContext->pRecordingClient;
+    xRecordEnableContextReply rep;
+    CARD32 tail;
+
+    if (pRing->published == pRing->wakeHead || pRecordingClient->clientGone)
+        return;
+    tail = RecordShmLoad(&pRing->pHeader->tail);
+    if ((INT32) (tail - pRing->wakeHead) < 0)
+        return;
+    pRing->wakeHead = pRing->published;
+
+    memset(&rep, 0, sizeof(rep));
+    rep.type = X_Reply;
+    rep.category = XRecordShmWakeup;
+    rep.sequenceNumber = pRecordingClient->sequence;
+    rep.elementHeader = pContext->elemHeaders;
+    rep.serverTime = GetTimeInMillis();
+    rep.recordedSequenceNumber = pRing->sequence;
+    if (pRecordingClient->swapped) {
+        swaps(&rep.sequenceNumber);
+        swapl(&rep.serverTime);
+        swapl(&rep.recordedSequenceNumber);
+    }
+    WriteToClient(pRecordingClient, sizeof(rep), &rep);
+}                               /* RecordShmRingWakeup */
+
+/* RecordShmRingFree
+ *
+ * Arguments:
+ *	pContext is a context that may have a shared memory ring.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	The ring is freed and its reference on the segment dropped.
+ */
+static void
+RecordShmRingFree(RecordContextPtr pContext)
+{
+    RecordShmRingPtr pRing = pContext->pRing;
+
+    if (!pRing)
+        return;
+    ShmDetachSegment(pRing->shmdesc, 0);
+    free(pRing);
+    pContext->pRing = NULL;
+}                               /* RecordShmRingFree */
+
+#endif                          /* MITSHM */
+
+/* RecordWriteToRecorder
+ *
+ * Arguments:
+ *	pContext is an enabled context.
+ *	data is a pointer to reply data, and len is its length in bytes.
+ *
+ * Returns: nothing.
+ *
+ * Side Effects:
+ *	The data is written to the context's shared memory ring if it has
+ *	one, otherwise to the recording client.
+ */
+static void
+RecordWriteToRecorder(RecordContextPtr pContext, int len, void *data)
+{
+#ifdef MITSHM
+    if (pContext->pRing) {
+        RecordShmRingWrite(pContext, len, data);
+        return;
+    }
+#endif
+    WriteToClient(pContext->pRecordingClient, len, data);
+}                               /* RecordWriteToRecorder */
+
 /* RecordFlushReplyBuffer
  *
  * Arguments:
@@ -224,10 +492,10 @@ RecordFindContextOnAllContexts(RecordContextPtr pContext)
  *
  * Side Effects:
  *	If the context is enabled, any buffered (recorded) protocol is written
- *	to the recording client, and the number of buffered bytes is set to
- *	zero.  If len1 is not zero, data1/len1 are then written to the
- *	recording client, and similarly for data2/len2 (written after
- *	data1/len1).
+ *	to the recording client or its shared memory ring, and the number of
+ *	buffered bytes is set to zero.  If len1 is not zero, data1/len1 are
+ *	then written the same way, and similarly for data2/len2 (written
+ *	after data1/len1).
  */
 static void
 RecordFlushReplyBuffer(RecordContextPtr pContext,
@@ -238,13 +506,13 @@ RecordFlushReplyBuffer(RecordContextPtr pContext,
         return;
     ++pContext->inFlush;
     if (pContext->numBufBytes)
-        WriteToClient(pContext->pRecordingClient, pContext->numBufBytes,
-                      pContext->replyBuffer);
+        RecordWriteToRecorder(pContext, pContext->numBufBytes,
+                              pContext->replyBuffer);
     pContext->numBufBytes = 0;
     if (len1)
-        WriteToClient(pContext->pRecordingClient, len1, data1);
+        RecordWriteToRecorder(pContext, len1, data1);
     if (len2)
-        WriteToClient(pContext->pRecordingClient, len2, data2);
+        RecordWriteToRecorder(pContext, len2, data2);
     --pContext->inFlush;
 }                               /* RecordFlushReplyBuffer */
 
@@ -807,7 +1075,8 @@ RecordADeviceEvent(CallbackListPtr *pcbl, void *nulldata, void *calldata)
  *
  * Side Effects:
  *	All buffered reply data of all enabled contexts is written to
- *	the recording clients.
+ *	the recording clients.  Clients recording through a shared memory
+ *	ring are woken up if there is something new for them.
  */
 static void
 RecordFlushAllContexts(CallbackListPtr *pcbl,
@@ -826,6 +1095,10 @@ RecordFlushAllContexts(CallbackListPtr *pcbl,
          */
         if (pContext->numBufBytes)
             RecordFlushReplyBuffer(ppAllContexts[eci], NULL, 0, NULL, 0);
+#ifdef MITSHM
+        if (pContext->pRing)
+            RecordShmRingWakeup(pContext);
+#endif
     }
 }                               /* RecordFlushAllContexts */
 
@@ -1866,6 +2139,9 @@ ProcRecordCreateContext(ClientPtr client)
     pContext->pBufClient = NULL;
     pContext->continuedReply = 0;
     pContext->inFlush = 0;
+#ifdef MITSHM
+    pContext->pRing = NULL;
+#endif
 
     err = RecordRegisterClients(pContext, client,
                                 (xRecordRegisterClientsReq *) stuff);
@@ -2274,20 +2550,26 @@ ProcRecordGetContext(ClientPtr client)
     return err;
 }                               /* ProcRecordGetContext */
 
+/* RecordEnableContext
+ *
+ * Arguments:
+ *	pContext is the disabled context to enable.
+ *	client is the client enabling it, which will receive the data.
+ *
+ * Returns: Success, or an error if the recording hooks could not be
+ *	installed.
+ *
+ * Side Effects:
+ *	Request processing for client is suspended until the context is
+ *	disabled.  The context is moved to the front part of ppAllContexts
+ *	and StartOfData is sent.
+ */
 static int
-ProcRecordEnableContext(ClientPtr client)
+RecordEnableContext(RecordContextPtr pContext, ClientPtr client)
 {
-    RecordContextPtr pContext;
-
-    REQUEST(xRecordEnableContextReq);
     int i;
     RecordClientsAndProtocolPtr pRCAP;
 
-    REQUEST_SIZE_MATCH(xRecordGetContextReq);
-    VERIFY_CONTEXT(pContext, stuff->context, client);
-    if (pContext->pRecordingClient)
-        return BadMatch;        /* already enabled */
-
     /* install record hooks for each RCAP */
 
     for (pRCAP = pContext->pListOfRCAP; pRCAP; pRCAP = pRCAP->pNextRCAP) {
@@ -2332,8 +2614,107 @@ ProcRecordEnableContext(ClientPtr client)
     RecordAProtocolElement(pContext, NULL, XRecordStartOfData, NULL, 0, 0, 0);
     RecordFlushReplyBuffer(pContext, NULL, 0, NULL, 0);
     return Success;
+}                               /* RecordEnableContext */
+
+static int
+ProcRecordEnableContext(ClientPtr client)
+{
+    RecordContextPtr pContext;
+
+    REQUEST(xRecordEnableContextReq);
+
+    REQUEST_SIZE_MATCH(xRecordGetContextReq);
+    VERIFY_CONTEXT(pContext, stuff->context, client);
+    if (pContext->pRecordingClient)
+        return BadMatch;        /* already enabled */
+    return RecordEnableContext(pContext, client);
 }                               /* ProcRecordEnableContext */
 
+#ifdef MITSHM
+static int
+ProcRecordShmQueryVersion(ClientPtr client)
+{
+    xRecordShmQueryVersionReply rep = {
+        .type = X_Reply,
+        .sequenceNumber = client->sequence,
+        .length = 0,
+        .majorVersion = RECORDSHM_MAJOR_VERSION,
+        .minorVersion = RECORDSHM_MINOR_VERSION
+    };
+
+    REQUEST_SIZE_MATCH(xRecordShmQueryVersionReq);
+    if (client->swapped) {
+        swaps(&rep.sequenceNumber);
+        swaps(&rep.majorVersion);
+        swaps(&rep.minorVersion);
+    }
+    WriteToClient(client, sizeof(xRecordShmQueryVersionReply), &rep);
+    return Success;
+}                               /* ProcRecordShmQueryVersion */
+
+static int
+ProcRecordShmEnableContext(ClientPtr client)
+{
+    RecordContextPtr pContext;
+    RecordShmRingPtr pRing;
+    ShmDescPtr shmdesc;
+    int rc;
+
+    REQUEST(xRecordShmEnableContextReq);
+
+    REQUEST_SIZE_MATCH(xRecordShmEnableContextReq);
+    VERIFY_CONTEXT(pContext, stuff->context, client);
+    if (pContext->pRecordingClient)
+        return BadMatch;        /* already enabled */
+
+    rc = dixLookupResourceByType((void **) &shmdesc, stuff->shmseg,
+                                 ShmSegType, client, DixWriteAccess);
+    if (rc != Success)
+        return rc;
+    if (!shmdesc->writable)
+        return BadAccess;
+    if (stuff->dropPolicy != XRecordShmDropNewest &&
+        stuff->dropPolicy != XRecordShmFallback) {
+        client->errorValue = stuff->dropPolicy;
+        return BadValue;
+    }
+    if (stuff->size < RECORD_SHM_RING_MIN ||
+        (stuff->size & (stuff->size - 1))) {
+        client->errorValue = stuff->size;
+        return BadValue;
+    }
+    if ((stuff->offset & 3) || stuff->offset > shmdesc->size ||
+        shmdesc->size - stuff->offset <
+        (unsigned long) sizeof(xRecordShmRing) + stuff->size) {
+        client->errorValue = stuff->offset;
+        return BadValue;
+    }
+
+    pRing = calloc(1, sizeof(RecordShmRingRec));
+    if (!pRing)
+        return BadAlloc;
+    pRing->shmdesc = shmdesc;
+    pRing->pHeader = (xRecordShmRing *) (shmdesc->addr + stuff->offset);
+    pRing->pData = (char *) &pRing->pHeader[1];
+    pRing->size = stuff->size;
+    pRing->dropPolicy = stuff->dropPolicy;
+
+    pRing->pHeader->magic = XRecordShmRingMagic;
+    pRing->pHeader->size = pRing->size;
+    pRing->pHeader->tail = 0;
+    pRing->pHeader->sequence = 0;
+    pRing->pHeader->dropped = 0;
+    RecordShmStore(&pRing->pHeader->head, 0);
+
+    shmdesc->refcnt++;
+    pContext->pRing = pRing;
+    rc = RecordEnableContext(pContext, client);
+    if (rc != Success)
+        RecordShmRingFree(pContext);
+    return rc;
+}                               /* ProcRecordShmEnableContext */
+#endif                          /* MITSHM */
+
 /* RecordDisableContext
  *
  * Arguments:
@@ -2344,7 +2725,8 @@ ProcRecordEnableContext(ClientPtr client)
  *
  * Side Effects:
  *	If the context was enabled, it is disabled.  An EndOfData
- *	message is sent to the recording client.  Recording hooks for
+ *	message is sent to the recording client, and its shared memory
+ *	ring, if any, is released.  Recording hooks for
  *	this context are uninstalled.  The context is moved to the
  *	rear part of the ppAllContexts array.  numEnabledContexts is
  *	decremented.  Request processing for the formerly recording client
@@ -2362,6 +2744,9 @@ RecordDisableContext(RecordContextPtr pContext)
         RecordAProtocolElement(pContext, NULL, XRecordEndOfData, NULL, 0, 0, 0);
         RecordFlushReplyBuffer(pContext, NULL, 0, NULL, 0);
     }
+#ifdef MITSHM
+    RecordShmRingFree(pContext);
+#endif
     /* Re-enable request processing on this connection. */
     AttendClient(pContext->pRecordingClient);
 
@@ -2632,6 +3017,64 @@ SProcRecordDispatch(ClientPtr client)
     }
 }                               /* SProcRecordDispatch */
 
+#ifdef MITSHM
+static int
+ProcRecordShmDispatch(ClientPtr client)
+{
+    REQUEST(xReq);
+
+    switch (stuff->data) {
+    case X_RecordShmQueryVersion:
+        return ProcRecordShmQueryVersion(client);
+    case X_RecordShmEnableContext:
+        return ProcRecordShmEnableContext(client);
+    default:
+        return BadRequest;
+    }
+}                               /* ProcRecordShmDispatch */
+
+static int _X_COLD
+SProcRecordShmQueryVersion(ClientPtr client)
+{
+    REQUEST(xRecordShmQueryVersionReq);
+
+    swaps(&stuff->length);
+    REQUEST_SIZE_MATCH(xRecordShmQueryVersionReq);
+    swaps(&stuff->majorVersion);
+    swaps(&stuff->minorVersion);
+    return ProcRecordShmQueryVersion(client);
+}                               /* SProcRecordShmQueryVersion */
+
+static int _X_COLD
+SProcRecordShmEnableContext(ClientPtr client)
+{
+    REQUEST(xRecordShmEnableContextReq);
+
+    swaps(&stuff->length);
+    REQUEST_SIZE_MATCH(xRecordShmEnableContextReq);
+    swapl(&stuff->context);
+    swapl(&stuff->shmseg);
+    swapl(&stuff->offset);
+    swapl(&stuff->size);
+    return ProcRecordShmEnableContext(client);
+}                               /* SProcRecordShmEnableContext */
+
+static int _X_COLD
+SProcRecordShmDispatch(ClientPtr client)
+{
+    REQUEST(xReq);
+
+    switch (stuff->data) {
+    case X_RecordShmQueryVersion:
+        return SProcRecordShmQueryVersion(client);
+    case X_RecordShmEnableContext:
+        return SProcRecordShmEnableContext(client);
+    default:
+        return BadRequest;
+    }
+}                               /* SProcRecordShmDispatch */
+#endif                          /* MITSHM */
+
 /* RecordConnectionSetupInfo
  *
  * Arguments:
@@ -2785,7 +3228,8 @@ RecordCloseDown(ExtensionEntry * extEntry)
  * Returns: nothing.
  *
  * Side Effects:
- *	Enables the RECORD extension if possible.
+ *	Enables the RECORD extension if possible, and with MIT-SHM its
+ *	private VcXsrv-RecordShm companion.
  */
 void
 RecordExtensionInit(void)
@@ -2815,4 +3259,10 @@ RecordExtensionInit(void)
     SetResourceTypeErrorValue(RTContext,
                               extentry->errorBase + XRecordBadContext);
 
+#ifdef MITSHM
+    if (!noMITShmExtension)
+        AddExtension(RECORDSHM_NAME, 0, 0,
+                     ProcRecordShmDispatch, SProcRecordShmDispatch,
+                     NULL, StandardMinorOpcode);
+#endif
 }                               /* RecordExtensionInit */
@@ -0,0 +1,128 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * VcXsrv-RecordShm: a private companion to RECORD that delivers the
+ * protocol recorded by a RECORD context through a ring in a MIT-SHM
+ * segment instead of as EnableContext replies.  It is not part of the
+ * RECORD protocol, which stays at the version it advertises; clients find
+ * it with QueryExtension like any other extension.
+ */
+
+#ifndef _RECORDSHM_H_
+#define _RECORDSHM_H_
+
+#include <X11/Xmd.h>
+
+#define RECORDSHM_NAME			"VcXsrv-RecordShm"
+#define RECORDSHM_MAJOR_VERSION		1
+#define RECORDSHM_MINOR_VERSION		0
+
+#define X_RecordShmQueryVersion		0
+#define X_RecordShmEnableContext	1
+
+/*
+ * Category of the wakeup replies, which only contexts enabled with
+ * RecordShmEnableContext receive.  It is kept clear of the categories
+ * RECORD itself defines.
+ */
+#define XRecordShmWakeup		0x80
+
+/*
+ * Drop policies for RecordShmEnableContext
+ */
+#define XRecordShmDropNewest		0
+#define XRecordShmFallback		1
+
+#define XRecordShmRingMagic		0x52454352	/* "RECR" */
+
+typedef struct {
+    CARD8	reqType;
+    CARD8	recordShmReqType;
+    CARD16	length;
+    CARD16	majorVersion;
+    CARD16	minorVersion;
+} xRecordShmQueryVersionReq;
+#define sz_xRecordShmQueryVersionReq	8
+
+typedef struct {
+    CARD8	type;
+    CARD8	pad0;
+    CARD16	sequenceNumber;
+    CARD32	length;
+    CARD16	majorVersion;
+    CARD16	minorVersion;
+    CARD32	pad1;
+    CARD32	pad2;
+    CARD32	pad3;
+    CARD32	pad4;
+    CARD32	pad5;
+} xRecordShmQueryVersionReply;
+#define sz_xRecordShmQueryVersionReply	32
+
+/*
+ * Enable a RECORD context, reporting through a shared memory ring.
+ *
+ * The ring is a xRecordShmRing header at offset bytes into shmseg,
+ * followed by size bytes of data; size must be a power of two.  Each
+ * record in the ring is exactly what EnableContext would have sent as a
+ * reply, with pad3 holding a sequence number that is incremented for every
+ * record whether it went into the ring, was sent as a reply or was dropped.
+ * Records may wrap around the end of the data area.  head, sequence and
+ * dropped are written by the server, tail by the client, all in the
+ * server's byte order; head and tail are free-running byte counts.
+ *
+ * The request otherwise behaves like RECORD's EnableContext: StartOfData
+ * and EndOfData are always sent as replies, and DisableContext ends it.
+ * ShmWakeup replies are sent, at most once per server flush, when new
+ * records have been published and the client has consumed everything
+ * published at the previous wakeup; a client must check head again after
+ * draining the ring and before waiting for the next reply.
+ */
+typedef struct {
+    CARD8	reqType;
+    CARD8	recordShmReqType;
+    CARD16	length;
+    CARD32	context;	/* RECORD context */
+    CARD32	shmseg;
+    CARD32	offset;
+    CARD32	size;
+    CARD8	dropPolicy;
+    CARD8	pad0;
+    CARD16	pad1;
+} xRecordShmEnableContextReq;
+#define sz_xRecordShmEnableContextReq	24
+
+typedef struct {
+    CARD32	magic;
+    CARD32	size;
+    CARD32	head;
+    CARD32	tail;
+    CARD32	sequence;
+    CARD32	dropped;
+    CARD32	pad0;
+    CARD32	pad1;
+} xRecordShmRing;
+#define sz_xRecordShmRing	32
+
+#endif                          /* _RECORDSHM_H_ */
@@ -43,6 +43,14 @@ from The Open Group.
     implemented, and RecordCreateSet will decide heuristically which one
     to use based on the set members.
 
+    Membership is tested for every request, reply and event of every
+    recorded client, while sets are only built when a context is created
+    or clients are registered.  A bit vector answers in constant time, the
+    interval list needs a binary search, so the bit vector is used whenever
+    the set's members fit in 16 bits, which covers every set RECORD
+    builds; that costs at most 8K per set.  The interval list remains for
+    sets with larger members.
+
 */
 
 #ifdef HAVE_DIX_CONFIG_H
@@ -54,6 +62,9 @@ from The Open Group.
 #include "misc.h"
 #include "set.h"
 
+/* largest maximum member for which a bit vector is always used */
+#define MAX_BIT_VECTOR_MEMBER 65535
+
 static int
 maxMemberInInterval(RecordSetInterval * pIntervals, int nIntervals)
 {
@@ -378,8 +389,7 @@ _RecordSetMemoryRequirements(RecordSetInterval * pIntervals, int nIntervals,
                                             &bma);
     rlsize = IntervalListMemoryRequirements(pIntervals, nIntervals, maxMember,
                                             &rla);
-    if (((nIntervals > 1) && (maxMember <= 255))
-        || (bmsize < rlsize)) {
+    if ((maxMember <= MAX_BIT_VECTOR_MEMBER) || (bmsize < rlsize)) {
         *alignment = bma;
         *ppCreateSet = BitVectorCreateSet;
         return bmsize;
@@ -1815,33 +1815,76 @@ mieq_test(void)
     mieqInit();
     mieqSetHandler(ET_RawMotion, mieq_test_event_handler);
 
-    /* Enough to fit the buffer but trigger a grow */
+    /* Well within the queue size */
     mieq_test_generate_events(180);
-
-    /* We should resize to 512 now */
     mieqProcessInputEvents();
 
-    /* Some should now get dropped */
     mieq_test_generate_events(500);
-
-    /* Tell us how many got dropped, 1024 now */
     mieqProcessInputEvents();
 
-    /* Now make it 2048 */
     mieq_test_generate_events(900);
     mieqProcessInputEvents();
 
-    /* Now make it 4096 (max) */
-    mieq_test_generate_events(1950);
+    /* Just fits the queue */
+    mieq_test_generate_events(4095);
     mieqProcessInputEvents();
 
-    /* Now overflow one last time with the maximal queue and reach the verbosity limit */
+    /* Overflow the queue and reach the verbosity limit */
     mieq_test_generate_events(10000);
     mieqProcessInputEvents();
 
     mieqFini();
 }
 
+/* Consecutive motion events from the same device are merged into the last
+ * queued one, as long as nothing else was queued in between. */
+static int mieq_motion_test_processed;
+
+static void
+mieq_motion_test_handler(int screenNum, InternalEvent *ie, DeviceIntPtr dev)
+{
+    assert(ie->any.type == ET_Motion);
+    /* the merged event carries the last position */
+    assert(ie->device_event.root_x == 9);
+    mieq_motion_test_processed++;
+}
+
+static void
+mieq_motion_test(void)
+{
+    static DeviceIntRec dev;
+    static SpriteInfoRec spriteInfo;
+    static SpriteRec sprite;
+    int i;
+
+    memset(&dev, 0, sizeof(dev));
+    memset(&spriteInfo, 0, sizeof(spriteInfo));
+    memset(&sprite, 0, sizeof(sprite));
+    dev.spriteInfo = &spriteInfo;
+    spriteInfo.sprite = &sprite;
+    dev.enabled = 1;
+    dev.id = 2;
+
+    mieqInit();
+    mieqSetHandler(ET_Motion, mieq_motion_test_handler);
+
+    for (i = 0; i < 10; i++) {
+        DeviceEvent e = { 0 };
+
+        e.header = ET_Internal;
+        e.type = ET_Motion;
+        e.length = sizeof(e);
+        e.time = GetTimeInMillis();
+        e.root_x = i;
+        mieqEnqueue(&dev, (InternalEvent *) &e);
+    }
+    mieqProcessInputEvents();
+    assert(mieq_motion_test_processed == 1);
+
+    mieqSetHandler(ET_Motion, NULL);
+    mieqFini();
+}
+
 /* Simple check that we're replaying events in-order */
 static void
 process_input_proc(InternalEvent *ev, DeviceIntPtr device)
@@ -1928,6 +1971,7 @@ input_test(void)
     dix_get_master();
     input_option_test();
     mieq_test();
+    mieq_motion_test();
 
     return 0;
 }
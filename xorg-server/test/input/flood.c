@@ -0,0 +1,178 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Input delivery benchmark: a chain of nested windows with nobody selecting
+ * on the inner ones, a number of XI2 clients listening for motion on the
+ * root window, and XTest motion injected over the innermost window.
+ *
+ * Usage: input-flood [events] [listeners] [depth]
+ */
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/xinput.h>
+#include <xcb/xtest.h>
+
+#define BATCH 64
+
+static xcb_connection_t *
+connect_listener(void)
+{
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_screen_t *screen;
+    struct {
+        xcb_input_event_mask_t head;
+        uint32_t mask;
+    } mask;
+
+    if (xcb_connection_has_error(c))
+        return NULL;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    free(xcb_input_xi_query_version_reply(c,
+             xcb_input_xi_query_version(c, 2, 2), NULL));
+
+    mask.head.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
+    mask.head.mask_len = 1;
+    mask.mask = XCB_INPUT_XI_EVENT_MASK_MOTION;
+    xcb_input_xi_select_events(c, screen->root, 1, &mask.head);
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+    return c;
+}
+
+/* Read all pending motion events, return how many there were */
+static int
+drain(xcb_connection_t *c)
+{
+    xcb_generic_event_t *ev;
+    int n = 0;
+
+    while ((ev = xcb_poll_for_event(c))) {
+        if ((ev->response_type & ~0x80) == XCB_GE_GENERIC &&
+            ((xcb_ge_generic_event_t *) ev)->event_type == XCB_INPUT_MOTION)
+            n++;
+        free(ev);
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    int nevents = argc > 1 ? atoi(argv[1]) : 100000;
+    int nlisteners = argc > 2 ? atoi(argv[2]) : 16;
+    int depth = argc > 3 ? atoi(argv[3]) : 32;
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_connection_t **listeners;
+    struct pollfd *pfd;
+    xcb_screen_t *screen;
+    xcb_window_t parent;
+    struct timespec start, end;
+    int *received;
+    int sent, done, ready, i;
+    double secs;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "Failed to connect to the server\n");
+        return 1;
+    }
+    screen = xcb_setup_roots_iterator(xcb_get_setup(c)).data;
+
+    if (!xcb_get_extension_data(c, &xcb_test_id)->present) {
+        fprintf(stderr, "XTEST not available\n");
+        return 77;
+    }
+
+    /* Nested windows covering the screen, nobody selects on them */
+    parent = screen->root;
+    for (i = 0; i < depth; i++) {
+        xcb_window_t w = xcb_generate_id(c);
+
+        xcb_create_window(c, XCB_COPY_FROM_PARENT, w, parent, 0, 0,
+                          screen->width_in_pixels, screen->height_in_pixels,
+                          0, XCB_WINDOW_CLASS_INPUT_ONLY,
+                          XCB_COPY_FROM_PARENT, 0, NULL);
+        xcb_map_window(c, w);
+        parent = w;
+    }
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+    listeners = calloc(nlisteners, sizeof(*listeners));
+    pfd = calloc(nlisteners, sizeof(*pfd));
+    received = calloc(nlisteners, sizeof(*received));
+    if (!listeners || !pfd || !received)
+        return 1;
+    for (i = 0; i < nlisteners; i++) {
+        listeners[i] = connect_listener();
+        if (!listeners[i]) {
+            fprintf(stderr, "Failed to connect listener %d\n", i);
+            return 1;
+        }
+        pfd[i].fd = xcb_get_file_descriptor(listeners[i]);
+        pfd[i].events = POLLIN;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (sent = 0, done = 0; done < nlisteners;) {
+        if (sent < nevents) {
+            int n = nevents - sent < BATCH ? nevents - sent : BATCH;
+
+            for (i = 0; i < n; i++, sent++)
+                xcb_test_fake_input(c, XCB_MOTION_NOTIFY, 0, XCB_CURRENT_TIME,
+                                    screen->root, 10 + (sent & 1), 10, 0);
+            xcb_flush(c);
+        }
+
+        ready = poll(pfd, nlisteners, sent < nevents ? 0 : 1000);
+        for (done = 0, i = 0; i < nlisteners; i++) {
+            received[i] += drain(listeners[i]);
+            if (received[i] >= nevents)
+                done++;
+        }
+
+        if (sent == nevents && ready == 0 && done < nlisteners) {
+            fprintf(stderr, "Timed out, listener 0 got %d of %d events\n",
+                    received[0], nevents);
+            return 1;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%d motion events, %d listeners, %d nested windows: "
+           "%.3f s, %.0f events/s, %.0f deliveries/s\n",
+           nevents, nlisteners, depth, secs, nevents / secs,
+           (double) nevents * nlisteners / secs);
+
+    for (i = 0; i < nlisteners; i++)
+        xcb_disconnect(listeners[i]);
+    xcb_disconnect(c);
+
+    return 0;
+}
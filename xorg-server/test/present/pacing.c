@@ -0,0 +1,187 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * Frame pacing on the software vblank clock: several clients each present
+ * a pixmap every frame, queueing the next one for the MSC after each
+ * completion.  Checks that clients hit consecutive MSCs and that every
+ * completion timestamp sits on the same MSC grid.
+ *
+ * Usage: present-pacing [clients] [frames]
+ */
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <xcb/xcb.h>
+#include <xcb/present.h>
+
+struct client {
+    xcb_connection_t *c;
+    xcb_window_t window;
+    xcb_pixmap_t pixmap;
+    uint8_t present_opcode;
+    int frames;
+    int missed;
+    uint64_t *ust;
+    uint64_t *msc;
+};
+
+static int
+setup_client(struct client *cl, int nframes)
+{
+    xcb_screen_t *screen;
+    const xcb_query_extension_reply_t *ext;
+
+    cl->c = xcb_connect(NULL, NULL);
+    if (xcb_connection_has_error(cl->c))
+        return 1;
+    ext = xcb_get_extension_data(cl->c, &xcb_present_id);
+    if (!ext->present)
+        return 77;
+    cl->present_opcode = ext->major_opcode;
+    screen = xcb_setup_roots_iterator(xcb_get_setup(cl->c)).data;
+
+    cl->window = xcb_generate_id(cl->c);
+    xcb_create_window(cl->c, XCB_COPY_FROM_PARENT, cl->window, screen->root,
+                      0, 0, 64, 64, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                      XCB_COPY_FROM_PARENT, 0, NULL);
+    xcb_map_window(cl->c, cl->window);
+
+    cl->pixmap = xcb_generate_id(cl->c);
+    xcb_create_pixmap(cl->c, screen->root_depth, cl->pixmap, cl->window,
+                      64, 64);
+
+    xcb_present_select_input(cl->c, xcb_generate_id(cl->c), cl->window,
+                             XCB_PRESENT_EVENT_MASK_COMPLETE_NOTIFY);
+
+    cl->ust = calloc(nframes, sizeof(uint64_t));
+    cl->msc = calloc(nframes, sizeof(uint64_t));
+    if (!cl->ust || !cl->msc)
+        return 1;
+    return 0;
+}
+
+static void
+present(struct client *cl, uint64_t target_msc)
+{
+    xcb_present_pixmap(cl->c, cl->window, cl->pixmap, cl->frames,
+                       XCB_NONE, XCB_NONE, 0, 0, XCB_NONE, XCB_NONE, XCB_NONE,
+                       XCB_PRESENT_OPTION_NONE, target_msc, 0, 0, 0, NULL);
+    xcb_flush(cl->c);
+}
+
+/* Handle pending events, return the number of frames completed */
+static int
+drain(struct client *cl, int nframes)
+{
+    xcb_generic_event_t *ev;
+    int n = 0;
+
+    while ((ev = xcb_poll_for_event(cl->c))) {
+        xcb_present_complete_notify_event_t *ce = (void *) ev;
+
+        if ((ev->response_type & ~0x80) == XCB_GE_GENERIC &&
+            ce->extension == cl->present_opcode &&
+            ce->event_type == XCB_PRESENT_COMPLETE_NOTIFY &&
+            ce->kind == XCB_PRESENT_COMPLETE_KIND_PIXMAP &&
+            cl->frames < nframes) {
+            cl->ust[cl->frames] = ce->ust;
+            cl->msc[cl->frames] = ce->msc;
+            if (cl->frames && ce->msc != cl->msc[cl->frames - 1] + 1)
+                cl->missed++;
+            cl->frames++;
+            n++;
+            if (cl->frames < nframes)
+                present(cl, ce->msc + 1);
+        }
+        free(ev);
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    int nclients = argc > 1 ? atoi(argv[1]) : 8;
+    int nframes = argc > 2 ? atoi(argv[2]) : 120;
+    struct client *clients = calloc(nclients, sizeof(*clients));
+    struct pollfd *pfd = calloc(nclients, sizeof(*pfd));
+    uint64_t interval, worst = 0;
+    int done = 0, failed = 0, i, f, ret;
+
+    if (!clients || !pfd || nframes < 2)
+        return 1;
+
+    for (i = 0; i < nclients; i++) {
+        ret = setup_client(&clients[i], nframes);
+        if (ret) {
+            fprintf(stderr, "Failed to set up client %d\n", i);
+            return ret;
+        }
+        pfd[i].fd = xcb_get_file_descriptor(clients[i].c);
+        pfd[i].events = POLLIN;
+    }
+    for (i = 0; i < nclients; i++)
+        present(&clients[i], 0);
+
+    while (done < nclients) {
+        if (poll(pfd, nclients, 1000) <= 0) {
+            fprintf(stderr, "Timed out waiting for PresentCompleteNotify\n");
+            return 1;
+        }
+        for (done = 0, i = 0; i < nclients; i++) {
+            drain(&clients[i], nframes);
+            if (clients[i].frames == nframes)
+                done++;
+        }
+    }
+
+    /* The MSC period, from the first client's whole run */
+    interval = (clients[0].ust[nframes - 1] - clients[0].ust[0]) /
+        (clients[0].msc[nframes - 1] - clients[0].msc[0]);
+
+    for (i = 0; i < nclients; i++) {
+        struct client *cl = &clients[i];
+
+        for (f = 1; f < nframes; f++) {
+            uint64_t expect = (cl->msc[f] - cl->msc[f - 1]) * interval;
+            uint64_t got = cl->ust[f] - cl->ust[f - 1];
+            uint64_t jitter = got > expect ? got - expect : expect - got;
+
+            if (jitter > worst)
+                worst = jitter;
+        }
+        printf("client %d: %d frames, %d missed\n", i, nframes, cl->missed);
+        if (cl->missed > nframes / 10)
+            failed = 1;
+    }
+    printf("MSC interval %llu us, worst UST jitter %llu us\n",
+           (unsigned long long) interval, (unsigned long long) worst);
+    if (worst > 1)
+        failed = 1;
+
+    for (i = 0; i < nclients; i++)
+        xcb_disconnect(clients[i].c);
+
+    return failed;
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * RECORD throughput benchmark: one client floods the server with requests
+ * while another records all core requests of all new clients, either
+ * through ordinary EnableContext replies or through the shared memory
+ * ring of the server's private VcXsrv-RecordShm extension.  Reports how long the flood took and how fast the recorder kept
+ * up.
+ *
+ * Usage: record-flood [requests] [reply|shm-drop|shm-fallback] [ring size]
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/uio.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+#include <xcb/record.h>
+#include <xcb/shm.h>
+
+/* From recordconst.h, xcb-proto has no names for these */
+#define XRecordFromClient 1
+#define XRecordStartOfData 4
+#define XRecordEndOfData 5
+
+/* From the server's record/recordshm.h */
+#define X_RecordShmEnableContext 1
+#define XRecordShmWakeup 0x80
+#define XRecordShmDropNewest 0
+#define XRecordShmFallback 1
+
+static xcb_extension_t record_shm_id = { "VcXsrv-RecordShm", 0 };
+
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t sequence;
+    uint32_t dropped;
+    uint32_t pad[2];
+} shm_ring_t;
+
+typedef struct {
+    uint8_t major_opcode;
+    uint8_t minor_opcode;
+    uint16_t length;
+    uint32_t context;
+    uint32_t shmseg;
+    uint32_t offset;
+    uint32_t size;
+    uint8_t drop_policy;
+    uint8_t pad[3];
+} enable_context_shm_req_t;
+
+struct recorder {
+    xcb_record_context_t context;
+    int use_shm;
+    int drop_policy;
+    uint32_t ring_size;
+
+    /* results */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int started;
+    uint64_t records;
+    uint64_t bytes;
+    uint32_t dropped;
+    uint64_t wakeups;
+    struct timespec done;
+};
+
+static double
+elapsed(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) +
+        (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void
+started(struct recorder *r)
+{
+    pthread_mutex_lock(&r->lock);
+    r->started = 1;
+    pthread_cond_signal(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
+
+static void
+count_reply(struct recorder *r, xcb_record_enable_context_reply_t *reply)
+{
+    if (reply->category == XRecordFromClient) {
+        r->records++;
+        r->bytes += 32 + reply->length * 4;
+    }
+}
+
+/* Consume everything published in the ring */
+static void
+drain_ring(struct recorder *r, shm_ring_t *ring)
+{
+    char *data = (char *) &ring[1];
+    uint32_t mask = ring->size - 1;
+    uint32_t tail = ring->tail;
+    uint32_t head;
+
+    while ((head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) != tail) {
+        while (tail != head) {
+            xcb_record_enable_context_reply_t reply;
+            uint32_t off = tail & mask;
+            uint32_t n = sizeof(reply) < ring->size - off ?
+                sizeof(reply) : ring->size - off;
+
+            memcpy(&reply, data + off, n);
+            memcpy((char *) &reply + n, data, sizeof(reply) - n);
+            count_reply(r, &reply);
+            tail += 32 + reply.length * 4;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+    r->dropped = ring->dropped;
+}
+
+static void *
+record_thread(void *closure)
+{
+    struct recorder *r = closure;
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_record_enable_context_cookie_t cookie;
+    xcb_record_enable_context_reply_t *reply;
+    shm_ring_t *ring = NULL;
+    int shmid = -1;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "Failed to connect recorder\n");
+        exit(1);
+    }
+
+    if (r->use_shm) {
+        xcb_shm_seg_t seg = xcb_generate_id(c);
+        enable_context_shm_req_t req = { 0 };
+        struct iovec parts[4];
+        xcb_protocol_request_t xcb_req = {
+            .count = 2,
+            .ext = &record_shm_id,
+            .opcode = X_RecordShmEnableContext,
+            .isvoid = 0,
+        };
+
+        shmid = shmget(IPC_PRIVATE, sizeof(*ring) + r->ring_size,
+                       IPC_CREAT | 0600);
+        if (shmid < 0 || (ring = shmat(shmid, NULL, 0)) == (void *) -1) {
+            perror("shm");
+            exit(1);
+        }
+        xcb_shm_attach(c, seg, shmid, 0);
+
+        req.context = r->context;
+        req.shmseg = seg;
+        req.offset = 0;
+        req.size = r->ring_size;
+        req.drop_policy = r->drop_policy;
+        parts[2].iov_base = (char *) &req;
+        parts[2].iov_len = sizeof(req);
+        parts[3].iov_base = NULL;
+        parts[3].iov_len = 0;
+        cookie.sequence = xcb_send_request(c, XCB_REQUEST_CHECKED,
+                                           parts + 2, &xcb_req);
+    }
+    else
+        cookie = xcb_record_enable_context(c, r->context);
+
+    while ((reply = xcb_record_enable_context_reply(c, cookie, NULL))) {
+        int category = reply->category;
+
+        if (category == XRecordStartOfData)
+            started(r);
+        else if (category == XRecordShmWakeup)
+            r->wakeups++;
+        else
+            count_reply(r, reply);
+        free(reply);
+
+        if (ring)
+            drain_ring(r, ring);
+        if (category == XRecordEndOfData)
+            break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &r->done);
+
+    if (ring) {
+        shmdt(ring);
+        shmctl(shmid, IPC_RMID, NULL);
+    }
+    xcb_disconnect(c);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int nrequests = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char *mode = argc > 2 ? argv[2] : "shm-drop";
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    xcb_connection_t *flood;
+    xcb_record_client_spec_t spec = XCB_RECORD_CS_FUTURE_CLIENTS;
+    xcb_record_range_t range = { 0 };
+    struct recorder r = { 0 };
+    struct timespec start, end;
+    pthread_t thread;
+    int i;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "Failed to connect to the server\n");
+        return 1;
+    }
+    if (!xcb_get_extension_data(c, &xcb_record_id)->present) {
+        fprintf(stderr, "RECORD not available\n");
+        return 77;
+    }
+
+    r.ring_size = argc > 3 ? strtoul(argv[3], NULL, 0) : 1 << 22;
+    r.use_shm = strncmp(mode, "shm", 3) == 0;
+    r.drop_policy = strcmp(mode, "shm-fallback") == 0 ?
+        XRecordShmFallback : XRecordShmDropNewest;
+    if (r.use_shm && !xcb_get_extension_data(c, &record_shm_id)->present) {
+        fprintf(stderr, "VcXsrv-RecordShm not available\n");
+        return 77;
+    }
+    pthread_mutex_init(&r.lock, NULL);
+    pthread_cond_init(&r.cond, NULL);
+
+    range.core_requests.first = 1;
+    range.core_requests.last = 127;
+    r.context = xcb_generate_id(c);
+    xcb_record_create_context(c, r.context, 0, 1, 1, &spec, &range);
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+    pthread_create(&thread, NULL, record_thread, &r);
+    pthread_mutex_lock(&r.lock);
+    while (!r.started)
+        pthread_cond_wait(&r.cond, &r.lock);
+    pthread_mutex_unlock(&r.lock);
+
+    flood = xcb_connect(NULL, NULL);
+    if (xcb_connection_has_error(flood)) {
+        fprintf(stderr, "Failed to connect flood client\n");
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < nrequests; i++)
+        xcb_no_operation(flood);
+    free(xcb_get_input_focus_reply(flood, xcb_get_input_focus(flood), NULL));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    xcb_record_disable_context(c, r.context);
+    xcb_flush(c);
+    pthread_join(thread, NULL);
+
+    printf("%s: %d requests flooded in %.3f s (%.0f requests/s), "
+           "recorder done after %.3f s, %llu records (%.1f MB), "
+           "%u dropped, %llu wakeups\n",
+           mode, nrequests, elapsed(&start, &end),
+           nrequests / elapsed(&start, &end), elapsed(&start, &r.done),
+           (unsigned long long) r.records, r.bytes / 1048576.0, r.dropped,
+           (unsigned long long) r.wakeups);
+
+    xcb_record_free_context(c, r.context);
+    xcb_disconnect(flood);
+    xcb_disconnect(c);
+
+    return 0;
+}
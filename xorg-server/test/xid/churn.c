@@ -0,0 +1,150 @@
+/*
+ * Copyright © 2026 The X.Org Foundation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/*
+ * XC-MISC GetXIDRange under resource churn: a client holds pixmaps spread
+ * evenly over its XID space, so that free IDs only come in short runs,
+ * and between GetXIDRange requests frees and recreates some of them.
+ * Reports the time per GetXIDRange round trip and checks that each range
+ * is free by creating pixmaps at both of its ends.  The time only means
+ * something next to a run of the same binary against another server build.
+ *
+ * Usage: xid-churn [pixmaps] [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/xc_misc.h>
+
+#define CHURN_PER_ROUND 100
+
+static double
+elapsed(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) +
+        (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Creates a pixmap at id, returning 0 if the server refused the ID */
+static int
+create_checked(xcb_connection_t *c, xcb_drawable_t root, uint32_t id)
+{
+    xcb_generic_error_t *error;
+
+    error = xcb_request_check(c, xcb_create_pixmap_checked(c, 1, id, root,
+                                                           1, 1));
+    free(error);
+    return error == NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int npixmaps = argc > 1 ? atoi(argv[1]) : 100000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 1000;
+    xcb_connection_t *c = xcb_connect(NULL, NULL);
+    const xcb_setup_t *setup;
+    xcb_drawable_t root;
+    uint32_t *ids, step, inc;
+    uint64_t range_ids = 0;
+    struct timespec start, end;
+    double total = 0;
+    int i, r, bad = 0;
+
+    if (xcb_connection_has_error(c)) {
+        fprintf(stderr, "Failed to connect to the server\n");
+        return 1;
+    }
+    if (!xcb_get_extension_data(c, &xcb_xc_misc_id)->present) {
+        fprintf(stderr, "XC-MISC not available\n");
+        return 77;
+    }
+    setup = xcb_get_setup(c);
+    root = xcb_setup_roots_iterator(setup).data->root;
+    inc = setup->resource_id_mask & -setup->resource_id_mask;
+    step = (setup->resource_id_mask / inc + 1) / npixmaps * inc;
+    if (step < 2 * inc) {
+        fprintf(stderr, "Too many pixmaps for the XID space\n");
+        return 1;
+    }
+
+    ids = calloc(npixmaps, sizeof(uint32_t));
+    if (!ids)
+        return 1;
+    for (i = 0; i < npixmaps; i++) {
+        ids[i] = setup->resource_id_base | (inc + i * step);
+        xcb_create_pixmap(c, 1, ids[i], root, 1, 1);
+    }
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+    srand(1);
+    for (r = 0; r < rounds; r++) {
+        xcb_xc_misc_get_xid_range_reply_t *range;
+        uint32_t first, last;
+
+        for (i = 0; i < CHURN_PER_ROUND; i++) {
+            uint32_t id = ids[rand() % npixmaps];
+
+            xcb_free_pixmap(c, id);
+            xcb_create_pixmap(c, 1, id, root, 1, 1);
+        }
+        free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        range = xcb_xc_misc_get_xid_range_reply(c,
+                    xcb_xc_misc_get_xid_range(c), NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        total += elapsed(&start, &end);
+        if (!range || range->count == 0 ||
+            (range->start_id == 0 && range->count == 1)) {
+            fprintf(stderr, "No XID range in round %d\n", r);
+            free(range);
+            return 1;
+        }
+        first = range->start_id;
+        last = first + (range->count - 1) * inc;
+        range_ids += range->count;
+        free(range);
+
+        /* Both ends must be free, then give them back */
+        if (!create_checked(c, root, first))
+            bad++;
+        else
+            xcb_free_pixmap(c, first);
+        if (last != first) {
+            if (!create_checked(c, root, last))
+                bad++;
+            else
+                xcb_free_pixmap(c, last);
+        }
+    }
+
+    printf("%d pixmaps: %.1f us per GetXIDRange, %.0f IDs per range, "
+           "%d ranges in use\n", npixmaps, total / rounds * 1e6,
+           (double) range_ids / rounds, bad);
+
+    free(ids);
+    xcb_disconnect(c);
+    return bad != 0;
+}